@@ -63,6 +63,33 @@ SYNFIG_LAYER_SET_VERSION(XORPattern,"0.1");
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+class GeneratorXORPattern: public rendering::TaskProcedural::Generator
+{
+public:
+	Point origin;
+	Point size;
+
+	GeneratorXORPattern(const Point &origin, const Point &size):
+		origin(origin), size(size) { }
+
+	virtual Color get_color(const Vector &point, const Vector &/*pixel_size*/) const
+	{
+		unsigned int a=(unsigned int)floor((point[0]-origin[0])/size[0]), b=(unsigned int)floor((point[1]-origin[1])/size[1]);
+		unsigned char rindex=(a^b);
+		unsigned char gindex=(a^(~b))*4;
+		unsigned char bindex=~(a^b)*2;
+
+		return Color((Color::value_type)rindex/(Color::value_type)255.0,
+					 (Color::value_type)gindex/(Color::value_type)255.0,
+					 (Color::value_type)bindex/(Color::value_type)255.0,
+					 1.0);
+	}
+};
+
+}
+
 /* === M E T H O D S ======================================================= */
 
 XORPattern::XORPattern():
@@ -101,21 +128,10 @@ XORPattern::get_param(const String & param)const
 Color
 XORPattern::get_color(Context context, const Point &point)const
 {
-	Point origin=param_origin.get(Point());
-	Point size=param_size.get(Point());
-	
 	if(get_amount()==0.0)
 		return context.get_color(point);
 
-	unsigned int a=(unsigned int)floor((point[0]-origin[0])/size[0]), b=(unsigned int)floor((point[1]-origin[1])/size[1]);
-	unsigned char rindex=(a^b);
-	unsigned char gindex=(a^(~b))*4;
-	unsigned char bindex=~(a^b)*2;
-
-	Color color((Color::value_type)rindex/(Color::value_type)255.0,
-				(Color::value_type)gindex/(Color::value_type)255.0,
-				(Color::value_type)bindex/(Color::value_type)255.0,
-				1.0);
+	Color color(create_generator()->get_color(point, Vector()));
 
 	if(get_amount() == 1 && get_blend_method() == Color::BLEND_STRAIGHT)
 		return color;
@@ -155,3 +171,19 @@ XORPattern::hit_check(Context context, const Point &getpos)const
 
 	return const_cast<XORPattern*>(this);
 }
+
+rendering::TaskProcedural::Generator::Handle
+XORPattern::create_generator()const
+{
+	return new GeneratorXORPattern(
+		param_origin.get(Point()),
+		param_size.get(Point()) );
+}
+
+rendering::Task::Handle
+XORPattern::build_composite_task_vfunc(ContextParams /*context_params*/)const
+{
+	rendering::TaskProcedural::Handle task(new rendering::TaskProcedural());
+	task->generator = create_generator();
+	return task;
+}
@@ -36,6 +36,7 @@
 #include <synfig/color.h>
 #include <synfig/context.h>
 #include <synfig/vector.h>
+#include <synfig/rendering/common/task/taskprocedural.h>
 
 /* === M A C R O S ========================================================= */
 
@@ -60,6 +61,8 @@ private:
 	//! Parameter: (Point)
 	ValueBase param_size;
 
+	rendering::TaskProcedural::Generator::Handle create_generator()const;
+
 public:
 	XORPattern();
 
@@ -68,6 +71,9 @@ public:
 	virtual Color get_color(Context context, const Point &pos)const;
 	virtual Vocab get_param_vocab()const;
 	virtual Layer::Handle hit_check(Context context, const Point &point)const;
+
+protected:
+	virtual rendering::Task::Handle build_composite_task_vfunc(ContextParams context_params)const;
 };
 
 }; // END of namespace lyr_std
@@ -33,6 +33,8 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+
 #include <synfig/localization.h>
 
 #include <synfig/string.h>
@@ -60,6 +62,60 @@ SYNFIG_LAYER_SET_VERSION(Metaballs,"0.1");
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+class GeneratorMetaballs: public rendering::TaskProcedural::Generator
+{
+public:
+	Gradient gradient;
+	std::vector<synfig::Point> centers;
+	std::vector<synfig::Real> radii;
+	std::vector<synfig::Real> weights;
+	synfig::Real threshold;
+	synfig::Real threshold2;
+	bool positive;
+
+	GeneratorMetaballs(): threshold(), threshold2(), positive() { }
+
+	Real densityfunc(const synfig::Point &p, const synfig::Point &c, Real R)const
+	{
+		const Real dx = p[0] - c[0];
+		const Real dy = p[1] - c[1];
+
+		const Real n = (1 - (dx*dx + dy*dy)/(R*R));
+		if (positive && n < 0) return 0;
+		return (n*n*n);
+
+		/*
+		f(d) = (1 - d^2)^3
+		f'(d) = -6d * (1 - d^2)^2
+
+		could use this too...
+		f(d) = (1 - d^2)^2
+		f'(d) = -6d * (1 - d^2)
+		*/
+	}
+
+	Real totaldensity(const Point &pos)const
+	{
+		Real density = 0;
+
+		//sum up weighted functions
+		for(unsigned int i=0;i<centers.size();i++)
+			density += weights[i] * densityfunc(pos,centers[i], radii[i]);
+
+		return (density - threshold) / (threshold2 - threshold);
+	}
+
+	virtual Color get_color(const Vector &point, const Vector &/*pixel_size*/) const
+		{ return gradient(totaldensity(point)); }
+
+	virtual Real get_pixel_cost() const
+		{ return std::max<Real>(1.0, centers.size()*0.25); }
+};
+
+}
+
 /* === M E T H O D S ======================================================= */
 
 /* === E N T R Y P O I N T ================================================= */
@@ -158,7 +214,7 @@ Metaballs::get_param_vocab()const
 synfig::Layer::Handle
 Metaballs::hit_check(synfig::Context context, const synfig::Point &point)const
 {
-	Real density(totaldensity(point));
+	Real density(etl::handle<GeneratorMetaballs>::cast_static(create_generator())->totaldensity(point));
 
 	if (density <= 0 || density > 1)
 		return context.hit_check(point);
@@ -172,90 +228,34 @@ Metaballs::hit_check(synfig::Context context, const synfig::Point &point)const
 	return const_cast<Metaballs*>(this);
 }
 
-Real
-Metaballs::densityfunc(const synfig::Point &p, const synfig::Point &c, Real R)const
-{
-	bool positive=param_positive.get(bool());
-	
-	const Real dx = p[0] - c[0];
-	const Real dy = p[1] - c[1];
-
-	const Real n = (1 - (dx*dx + dy*dy)/(R*R));
-	if (positive && n < 0) return 0;
-	return (n*n*n);
-
-	/*
-	f(d) = (1 - d^2)^3
-	f'(d) = -6d * (1 - d^2)^2
-
-	could use this too...
-	f(d) = (1 - d^2)^2
-	f'(d) = -6d * (1 - d^2)
-	*/
-}
-
-Real
-Metaballs::totaldensity(const Point &pos)const
-{
-	std::vector<synfig::Point> centers(param_centers.get_list_of(synfig::Point()));
-	std::vector<synfig::Real> radii(param_radii.get_list_of(synfig::Real()));
-	std::vector<synfig::Real> weights(param_weights.get_list_of(synfig::Real()));
-	synfig::Real threshold=param_threshold.get(Real());
-	synfig::Real threshold2=param_threshold2.get(Real());
-
-	Real density = 0;
-
-	//sum up weighted functions
-	for(unsigned int i=0;i<centers.size();i++)
-		density += weights[i] * densityfunc(pos,centers[i], radii[i]);
-
-	return (density - threshold) / (threshold2 - threshold);
-}
-
 Color
 Metaballs::get_color(Context context, const Point &pos)const
 {
-	Gradient gradient=param_gradient.get(Gradient());
+	Color color(create_generator()->get_color(pos, Vector()));
 	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-		return gradient(totaldensity(pos));
+		return color;
 	else
-		return Color::blend(gradient(totaldensity(pos)),context.get_color(pos),get_amount(),get_blend_method());
+		return Color::blend(color,context.get_color(pos),get_amount(),get_blend_method());
 }
 
-
-
-bool
-Metaballs::accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const
+rendering::TaskProcedural::Generator::Handle
+Metaballs::create_generator()const
 {
-	RENDER_TRANSFORMED_IF_NEED(__FILE__, __LINE__)
-
-	Gradient gradient=param_gradient.get(Gradient());
-	
-	// Width and Height of a pixel
-	const Point /*br(renddesc.get_br()),*/ tl(renddesc.get_tl());
-	const int 	 w(renddesc.get_w()), 	h(renddesc.get_h());
-	const Real	pw(renddesc.get_pw()), ph(renddesc.get_ph());
-
-	SuperCallback supercb(cb,0,9000,10000);
-
-	Point pos(tl[0],tl[1]);
-
-	if(!context.accelerated_render(surface,quality,renddesc,&supercb))
-	{
-		if(cb)cb->error(strprintf(__FILE__"%d: Accelerated Renderer Failure",__LINE__));
-		return false;
-	}
-
-	for(int y = 0; y < h; y++, pos[1] += ph)
-	{
-		pos[0] = tl[0];
-		for(int x = 0; x < w; x++, pos[0] += pw)
-			(*surface)[y][x] = Color::blend(gradient(totaldensity(pos)),(*surface)[y][x],get_amount(),get_blend_method());
-	}
-
-	// Mark our progress as finished
-	if(cb && !cb->amount_complete(10000,10000))
-		return false;
+	etl::handle<GeneratorMetaballs> generator(new GeneratorMetaballs());
+	generator->gradient = param_gradient.get(Gradient());
+	generator->centers = param_centers.get_list_of(synfig::Point());
+	generator->radii = param_radii.get_list_of(synfig::Real());
+	generator->weights = param_weights.get_list_of(synfig::Real());
+	generator->threshold = param_threshold.get(Real());
+	generator->threshold2 = param_threshold2.get(Real());
+	generator->positive = param_positive.get(bool());
+	return generator;
+}
 
-	return true;
+rendering::Task::Handle
+Metaballs::build_composite_task_vfunc(ContextParams /*context_params*/)const
+{
+	rendering::TaskProcedural::Handle task(new rendering::TaskProcedural());
+	task->generator = create_generator();
+	return task;
 }
@@ -35,6 +35,7 @@
 #include <synfig/gradient.h>
 #include <synfig/vector.h>
 #include <synfig/value.h>
+#include <synfig/rendering/common/task/taskprocedural.h>
 #include <vector>
 
 /* === M A C R O S ========================================================= */
@@ -62,9 +63,7 @@ private:
 	//! Parameter: (bool)
 	synfig::ValueBase param_positive;
 
-	synfig::Real densityfunc(const synfig::Point &p, const synfig::Point &c, synfig::Real R)const;
-
-	synfig::Real totaldensity(const synfig::Point &pos)const;
+	synfig::rendering::TaskProcedural::Generator::Handle create_generator()const;
 
 public:
 
@@ -76,11 +75,12 @@ public:
 
 	virtual synfig::Color get_color(synfig::Context context, const synfig::Point &pos)const;
 
-	virtual bool accelerated_render(synfig::Context context,synfig::Surface *surface,int quality, const synfig::RendDesc &renddesc, synfig::ProgressCallback *cb)const;
-
 	virtual Vocab get_param_vocab()const;
 
 	virtual synfig::Layer::Handle hit_check(synfig::Context context, const synfig::Point &point)const;
+
+protected:
+	virtual synfig::rendering::Task::Handle build_composite_task_vfunc(synfig::ContextParams context_params)const;
 }; // END of class Metaballs
 
 /* === E N D =============================================================== */
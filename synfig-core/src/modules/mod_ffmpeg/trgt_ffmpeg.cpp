@@ -73,7 +73,11 @@ ffmpeg_trgt::ffmpeg_trgt(const char *Filename, const synfig::TargetParam &params
 	pipe(nullptr),
 	filename(Filename),
 	sound_filename(""),
-	bitrate()
+	bitrate(),
+	scanline(0),
+	frame_pending(false),
+	writer_stop(false),
+	writer_failed(false)
 {
 	// Set default video codec and bitrate if they weren't given.
 	if (params.video_codec == "none")
@@ -94,6 +98,8 @@ ffmpeg_trgt::ffmpeg_trgt(const char *Filename, const synfig::TargetParam &params
 
 ffmpeg_trgt::~ffmpeg_trgt()
 {
+	stop_writer();
+
 	if(pipe)
 	{
 		pipe->close();
@@ -108,6 +114,41 @@ ffmpeg_trgt::~ffmpeg_trgt()
 	}
 }
 
+void
+ffmpeg_trgt::write_frames()
+{
+	std::unique_lock<std::mutex> lock(writer_mutex);
+	while(true)
+	{
+		writer_cond.wait(lock, [this]() { return frame_pending || writer_stop; });
+		if (!frame_pending)
+			break;
+
+		lock.unlock();
+		bool success = pipe->write(pending_buffer.data(), 1, pending_buffer.size()) == pending_buffer.size();
+		pipe->flush();
+		lock.lock();
+
+		if (!success)
+			writer_failed = true;
+		frame_pending = false;
+		writer_cond.notify_all();
+	}
+}
+
+void
+ffmpeg_trgt::stop_writer()
+{
+	if (!writer.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(writer_mutex);
+		writer_stop = true;
+	}
+	writer_cond.notify_all();
+	writer.join();
+}
+
 bool
 ffmpeg_trgt::set_rend_desc(RendDesc *given_desc)
 {
@@ -223,10 +264,14 @@ ffmpeg_trgt::init(ProgressCallback* cb = nullptr)
 		vargs.push_back("-i");
 		vargs.push_back(filesystem::Path(sound_filename));
 	}
+	// raw pixels need no encoding and no headers,
+	// conversion to yuv for the codec is left to ffmpeg
 	vargs.push_back("-f");
-	vargs.push_back("image2pipe");
-	vargs.push_back("-vcodec");
-	vargs.push_back(use_alpha ? "pam" : "ppm");
+	vargs.push_back("rawvideo");
+	vargs.push_back("-pix_fmt");
+	vargs.push_back(use_alpha ? "rgba" : "rgb24");
+	vargs.push_back("-s");
+	vargs.push_back(strprintf("%dx%d", desc.get_w(), desc.get_h()));
 	vargs.push_back("-r");
 	{
 		// this should avoid conflicts with locale settings
@@ -288,14 +333,25 @@ ffmpeg_trgt::init(ProgressCallback* cb = nullptr)
 
 	synfig::info(_("Running async command: %s"), pipe->get_command().c_str());
 
+	writer_stop = false;
+	writer_failed = false;
+	frame_pending = false;
+	writer = std::thread(&ffmpeg_trgt::write_frames, this);
+
 	return true;
 }
 
 void
 ffmpeg_trgt::end_frame()
 {
-	//pipe->print(" ");
-	pipe->flush();
+	// wait while the previous frame is written, and pass the current one to the writer
+	{
+		std::unique_lock<std::mutex> lock(writer_mutex);
+		writer_cond.wait(lock, [this]() { return !frame_pending; });
+		std::swap(frame_buffer, pending_buffer);
+		frame_pending = true;
+	}
+	writer_cond.notify_all();
 	imagecount++;
 }
 
@@ -307,31 +363,24 @@ ffmpeg_trgt::start_frame(synfig::ProgressCallback */*callback*/)
 	if(!pipe || !pipe->is_writable())
 		return false;
 
-	const bool use_alpha = get_alpha_mode() == TARGET_ALPHA_MODE_KEEP;
-
-	if (!use_alpha) {
-		pipe->printf("P6\n");
-		pipe->printf("%zu %zu\n", w, h);
-		pipe->printf("%d\n", 255);
-	} else {
-		pipe->printf("P7\n");
-		pipe->printf("WIDTH %zu\n", w);
-		pipe->printf("HEIGHT %zu\n", h);
-		pipe->printf("DEPTH 4\n");
-		pipe->printf("MAXVAL %d\n", 255);
-		pipe->printf("TUPLTYPE RGB_ALPHA\n");
-		pipe->printf("ENDHDR\n");
+	{
+		std::lock_guard<std::mutex> lock(writer_mutex);
+		if (writer_failed)
+			return false;
 	}
 
-	buffer.resize(w * (use_alpha ? 4 : 3));
+	const bool use_alpha = get_alpha_mode() == TARGET_ALPHA_MODE_KEEP;
+
+	frame_buffer.resize(w * h * (use_alpha ? 4 : 3));
 	color_buffer.resize(w);
 
 	return true;
 }
 
 Color *
-ffmpeg_trgt::start_scanline(int /*scanline*/)
+ffmpeg_trgt::start_scanline(int scanline)
 {
+	this->scanline = scanline;
 	return color_buffer.data();
 }
 
@@ -345,10 +394,11 @@ ffmpeg_trgt::end_scanline()
 	if(get_alpha_mode() == TARGET_ALPHA_MODE_KEEP)
 		format |= PF_A;
 
-	color_to_pixelformat(buffer.data(), color_buffer.data(), format, 0, desc.get_w());
-
-	if(!pipe->write(buffer.data(),1,buffer.size()))
+	const std::size_t row_size = desc.get_w() * pixel_size(format);
+	if (scanline < 0 || (scanline + 1) * row_size > frame_buffer.size())
 		return false;
 
+	color_to_pixelformat(frame_buffer.data() + scanline * row_size, color_buffer.data(), format, 0, desc.get_w());
+
 	return true;
 }
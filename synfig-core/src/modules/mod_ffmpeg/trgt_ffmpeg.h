@@ -31,6 +31,10 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include <synfig/os.h>
 #include <synfig/string.h>
 #include <synfig/target_scanline.h>
@@ -53,13 +57,27 @@ private:
 	synfig::OS::RunPipe::Handle pipe;
 	synfig::String filename;
 	synfig::String sound_filename;
-	std::vector<unsigned char> buffer;
 	std::vector<synfig::Color> color_buffer;
 	std::string video_codec;
 	int bitrate;
 
+	//! Frames are written to ffmpeg as raw pixels, while the next frame is rendering.
+	//! frame_buffer is filled by scanlines, pending_buffer is written by writer thread.
+	std::vector<unsigned char> frame_buffer;
+	std::vector<unsigned char> pending_buffer;
+	int scanline;
+	std::thread writer;
+	std::mutex writer_mutex;
+	std::condition_variable writer_cond;
+	bool frame_pending;
+	bool writer_stop;
+	bool writer_failed;
+
 	bool does_video_codec_support_alpha_channel(const synfig::String& video_codec) const;
 
+	void write_frames();
+	void stop_writer();
+
 public:
 
 	ffmpeg_trgt(const char *filename,
@@ -61,6 +61,41 @@ SYNFIG_LAYER_SET_VERSION(ConicalGradient,"0.1");
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+class GeneratorConicalGradient: public rendering::TaskProcedural::Generator
+{
+public:
+	Point center;
+	Angle angle;
+	CompiledGradient gradient;
+
+	GeneratorConicalGradient(const Point &center, const Angle &angle, const CompiledGradient &gradient):
+		center(center), angle(angle), gradient(gradient) { }
+
+	Real calc_supersample(const Point &centered, const Vector &pixel_size) const
+	{
+		if (pixel_size[0] <= 0.0)
+			return 0.0;
+		if (std::fabs(centered[0]) < pixel_size[0]*0.5 && std::fabs(centered[1]) < pixel_size[1]*0.5)
+			return 0.5;
+		return (pixel_size[0]/centered.mag())/(PI*2);
+	}
+
+	virtual Color get_color(const Vector &point, const Vector &pixel_size) const
+	{
+		const Point centered(point - center);
+		Angle::rot a = Angle::tan(-centered[1],centered[0]).mod();
+		a += angle;
+		Real dist(a.mod().get());
+
+		Real supersample = 0.5*calc_supersample(centered, pixel_size);
+		return gradient.average(dist - supersample, dist + supersample);
+	}
+};
+
+}
+
 /* === M E T H O D S ======================================================= */
 
 /* === E N T R Y P O I N T ================================================= */
@@ -139,32 +174,6 @@ ConicalGradient::compile()
 		param_symmetric.get(bool()) );
 }
 
-inline Color
-ConicalGradient::color_func(const Point &pos, Real supersample)const
-{
-	Point center = param_center.get(Point());
-	Angle angle = param_angle.get(Angle());
-	
-	const Point centered(pos-center);
-	Angle::rot a = Angle::tan(-centered[1],centered[0]).mod();
-	a += angle;
-	Real dist(a.mod().get());
-
-	supersample *= 0.5;
-	return compiled_gradient.average(dist - supersample, dist + supersample);
-}
-
-Real
-ConicalGradient::calc_supersample(const synfig::Point &x, Real pw, Real ph)const
-{
-	Point center=param_center.get(Point());
-
-	Point adj(x-center);
-	if(std::fabs(adj[0])<std::fabs(pw*0.5) && std::fabs(adj[1])<std::fabs(ph*0.5))
-		return 0.5;
-	return (pw/Point(x-center).mag())/(PI*2);
-}
-
 synfig::Layer::Handle
 ConicalGradient::hit_check(synfig::Context context, const synfig::Point &point)const
 {
@@ -176,7 +185,7 @@ ConicalGradient::hit_check(synfig::Context context, const synfig::Point &point)c
 
 	if(get_blend_method()==Color::BLEND_STRAIGHT && get_amount()>=0.5)
 		return const_cast<ConicalGradient*>(this);
-	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE) && color_func(point).get_a()>0.5)
+	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE) && create_generator()->get_color(point, Vector()).get_a()>0.5)
 		return const_cast<ConicalGradient*>(this);
 	return context.hit_check(point);
 }
@@ -184,7 +193,7 @@ ConicalGradient::hit_check(synfig::Context context, const synfig::Point &point)c
 Color
 ConicalGradient::get_color(Context context, const Point &pos)const
 {
-	const Color color(color_func(pos));
+	const Color color(create_generator()->get_color(pos, Vector()));
 
 	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
 		return color;
@@ -192,69 +201,19 @@ ConicalGradient::get_color(Context context, const Point &pos)const
 		return Color::blend(color,context.get_color(pos),get_amount(),get_blend_method());
 }
 
-bool
-ConicalGradient::accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const
+rendering::TaskProcedural::Generator::Handle
+ConicalGradient::create_generator()const
 {
-	RENDER_TRANSFORMED_IF_NEED(__FILE__, __LINE__)
-
-	SuperCallback supercb(cb,0,9500,10000);
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		surface->set_wh(renddesc.get_w(),renddesc.get_h());
-	}
-	else
-	{
-		if(!context.accelerated_render(surface,quality,renddesc,&supercb))
-			return false;
-		if(get_amount()==0)
-			return true;
-	}
-
-
-	int x,y;
-
-	Surface::pen pen(surface->begin());
-	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
-	const int w(surface->get_w());
-	const int h(surface->get_h());
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		if(quality<9)
-		{
-			for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-				for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-					pen.put_value(color_func(pos,calc_supersample(pos,pw,ph)));
-		}
-		else
-		{
-			for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-				for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-					pen.put_value(color_func(pos,0));
-		}
-	}
-	else
-	{
-		if(quality<9)
-		{
-			for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-				for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-					pen.put_value(Color::blend(color_func(pos,calc_supersample(pos,pw,ph)),pen.get_value(),get_amount(),get_blend_method()));
-		}
-		else
-		{
-			for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-				for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-					pen.put_value(Color::blend(color_func(pos,0),pen.get_value(),get_amount(),get_blend_method()));
-		}
-	}
-
-	// Mark our progress as finished
-	if(cb && !cb->amount_complete(10000,10000))
-		return false;
+	return new GeneratorConicalGradient(
+		param_center.get(Point()),
+		param_angle.get(Angle()),
+		compiled_gradient );
+}
 
-	return true;
+rendering::Task::Handle
+ConicalGradient::build_composite_task_vfunc(ContextParams /*context_params*/)const
+{
+	rendering::TaskProcedural::Handle task(new rendering::TaskProcedural());
+	task->generator = create_generator();
+	return task;
 }
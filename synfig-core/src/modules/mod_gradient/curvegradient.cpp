@@ -194,6 +194,232 @@ find_closest(bool fast, const std::vector<synfig::BLinePoint>& bline,const Point
 	return ret;
 }
 
+namespace {
+
+//! parameters are copied once, so bline is not copied for every pixel
+class GeneratorCurveGradient: public rendering::TaskProcedural::Generator
+{
+public:
+	Point origin;
+	Real width;
+	std::vector<synfig::BLinePoint> bline;
+	bool bline_loop;
+	bool loop;
+	bool perpendicular;
+	bool fast;
+	Real curve_length_;
+	int quality;
+	CompiledGradient compiled_gradient;
+
+	GeneratorCurveGradient():
+		width(), bline_loop(), loop(), perpendicular(), fast(), curve_length_(), quality() { }
+
+	Color color_func(const Point &point_, Real supersample)const
+	{
+		Vector tangent;
+		Vector diff;
+		Point p1;
+		Real thickness;
+		Real dist;
+
+		Real perp_dist = 0;
+		bool edge_case = false;
+
+		if(bline.size()==0)
+			return Color::alpha();
+		else if(bline.size()==1)
+		{
+			tangent=bline.front().get_tangent1();
+			p1=bline.front().get_vertex();
+			thickness=bline.front().get_width();
+		}
+		else
+		{
+			Real t;
+			Point point(point_-origin);
+
+			std::vector<synfig::BLinePoint>::const_iterator iter,next;
+
+			// Figure out the BLinePoints we will be using,
+			// Taking into account looping.
+			if(perpendicular)
+			{
+				next=find_closest(fast,bline,point,t,bline_loop,&perp_dist);
+				perp_dist/=curve_length_;
+			}
+			else					// not perpendicular
+			{
+				next=find_closest(fast,bline,point,t,bline_loop);
+			}
+
+			iter=next++;
+			if(next==bline.end()) next=bline.begin();
+
+			// Setup the curve
+			hermite<Vector> curve(
+				iter->get_vertex(),
+				next->get_vertex(),
+				iter->get_tangent2(),
+				next->get_tangent1()
+				);
+
+			int search_iterations(7);
+
+			/*if(quality==0)search_iterations=8;
+			  else if(quality<=2)search_iterations=10;
+			  else if(quality<=4)search_iterations=8;
+			*/
+			if(perpendicular)
+			{
+				if(quality>7)
+					search_iterations=4;
+			}
+			else					// not perpendicular
+			{
+				if(quality<=6)search_iterations=7;
+				else if(quality<=7)search_iterations=6;
+				else if(quality<=8)search_iterations=5;
+				else search_iterations=4;
+			}
+
+			// Figure out the closest point on the curve
+			if (fast)
+				t = curve.find_closest(fast, point,search_iterations);
+
+			// Calculate our values
+			p1=curve(t);                 // the closest point on the curve
+			tangent=curve.derivative(t); // the tangent at that point
+
+			// if the point we're nearest to is at either end of the
+			// bline, our distance from the curve is the distance from the
+			// point on the curve.  we need to know which side of the
+			// curve we're on, so find the average of the two tangents at
+			// this point
+			if (t<0.00001 || t>0.99999)
+			{
+				bool zero_tangent = (tangent[0] == 0 && tangent[1] == 0);
+
+				if (t<0.5)
+				{
+					if (iter->get_split_tangent_angle() || iter->get_split_tangent_radius() || zero_tangent)
+					{
+						// fake the current tangent if we need to
+						if (zero_tangent) tangent = curve(FAKE_TANGENT_STEP) - curve(0);
+
+						// calculate the other tangent
+						Vector other_tangent(iter->get_tangent1());
+						if (other_tangent[0] == 0 && other_tangent[1] == 0)
+						{
+							// find the previous blinepoint
+							std::vector<synfig::BLinePoint>::const_iterator prev;
+							if (iter != bline.begin()) (prev = iter)--;
+							else if (loop) (prev = bline.end())--;
+							else prev = iter;
+
+							hermite<Vector> other_curve(prev->get_vertex(), iter->get_vertex(), prev->get_tangent2(), iter->get_tangent1());
+							other_tangent = other_curve(1) - other_curve(1-FAKE_TANGENT_STEP);
+						}
+
+						// normalise and sum the two tangents
+						tangent=(other_tangent.norm()+tangent.norm());
+						edge_case=true;
+					}
+				}
+				else
+				{
+					if (next->get_split_tangent_angle() || next->get_split_tangent_radius() || zero_tangent)
+					{
+						// fake the current tangent if we need to
+						if (zero_tangent) tangent = curve(1) - curve(1-FAKE_TANGENT_STEP);
+
+						// calculate the other tangent
+						Vector other_tangent(next->get_tangent2());
+						if (other_tangent[0] == 0 && other_tangent[1] == 0)
+						{
+							// find the next blinepoint
+							std::vector<synfig::BLinePoint>::const_iterator next2(next);
+							if (++next2 == bline.end())
+							{
+								if (loop) next2 = bline.begin();
+								else next2 = next;
+							}
+
+							hermite<Vector> other_curve(next->get_vertex(), next2->get_vertex(), next->get_tangent2(), next2->get_tangent1());
+							other_tangent = other_curve(FAKE_TANGENT_STEP) - other_curve(0);
+						}
+
+						// normalise and sum the two tangents
+						tangent=(other_tangent.norm()+tangent.norm());
+						edge_case=true;
+					}
+				}
+			}
+			tangent = tangent.norm();
+
+			if(perpendicular)
+			{
+				tangent*=curve_length_;
+				p1-=tangent*perp_dist;
+				tangent=-tangent.perp();
+			}
+			else					// not perpendicular
+				// the width of the bline at the closest point on the curve
+				thickness=(next->get_width()-iter->get_width())*t+iter->get_width();
+		}
+
+		if (perpendicular && bline.size() > 1)
+		{
+			if(quality>7)
+			{
+				dist=perp_dist;
+	/*			diff=tangent.perp();
+				const Real mag(diff.inv_mag());
+				supersample=supersample*mag;
+	*/
+				supersample=0;
+			}
+			else
+			{
+				diff=tangent.perp();
+				//p1-=diff*0.5;
+				const Real mag(diff.inv_mag());
+				supersample=supersample*mag;
+				diff*=mag*mag;
+				dist=(point_-origin - p1)*diff;
+			}
+		}
+		else						// not perpendicular
+		{
+			if (edge_case)
+			{
+				diff=(p1-(point_-origin));
+				if(diff*tangent.perp()<0) diff=-diff;
+				diff=diff.norm()*thickness*width;
+			}
+			else
+				diff=tangent.perp()*thickness*width;
+
+			p1-=diff*0.5;
+			const Real mag(diff.inv_mag());
+			supersample=supersample*mag;
+			diff*=mag*mag;
+			dist=(point_-origin - p1)*diff;
+		}
+
+		supersample *= 0.5;
+		return compiled_gradient.average(dist - supersample, dist + supersample);
+	}
+
+	virtual Color get_color(const Vector &point, const Vector &pixel_size) const
+		{ return color_func(point, pixel_size[0]); }
+
+	//! closest point on the curve is searched for every pixel
+	virtual Real get_pixel_cost() const
+		{ return 8.0; }
+};
+
+}
+
 /* === M E T H O D S ======================================================= */
 
 inline void
@@ -246,216 +472,6 @@ CurveGradient::CurveGradient():
 	SET_STATIC_DEFAULTS();
 }
 
-inline Color
-CurveGradient::color_func(const Point &point_, int quality, Real supersample)const
-{
-	Point origin=param_origin.get(Point());
-	Real width=param_width.get(Real());
-	std::vector<synfig::BLinePoint> bline(param_bline.get_list_of(BLinePoint()));
-	bool loop=param_loop.get(bool());
-	bool perpendicular=param_perpendicular.get(bool());
-	bool fast=param_fast.get(bool());
-
-	Vector tangent;
-	Vector diff;
-	Point p1;
-	Real thickness;
-	Real dist;
-
-	Real perp_dist = 0;
-	bool edge_case = false;
-
-	if(bline.size()==0)
-		return Color::alpha();
-	else if(bline.size()==1)
-	{
-		tangent=bline.front().get_tangent1();
-		p1=bline.front().get_vertex();
-		thickness=bline.front().get_width();
-	}
-	else
-	{
-		Real t;
-		Point point(point_-origin);
-
-		std::vector<synfig::BLinePoint>::const_iterator iter,next;
-
-		// Figure out the BLinePoints we will be using,
-		// Taking into account looping.
-		if(perpendicular)
-		{
-			next=find_closest(fast,bline,point,t,bline_loop,&perp_dist);
-			perp_dist/=curve_length_;
-		}
-		else					// not perpendicular
-		{
-			next=find_closest(fast,bline,point,t,bline_loop);
-		}
-
-		iter=next++;
-		if(next==bline.end()) next=bline.begin();
-
-		// Setup the curve
-		hermite<Vector> curve(
-			iter->get_vertex(),
-			next->get_vertex(),
-			iter->get_tangent2(),
-			next->get_tangent1()
-			);
-
-		int search_iterations(7);
-
-		/*if(quality==0)search_iterations=8;
-		  else if(quality<=2)search_iterations=10;
-		  else if(quality<=4)search_iterations=8;
-		*/
-		if(perpendicular)
-		{
-			if(quality>7)
-				search_iterations=4;
-		}
-		else					// not perpendicular
-		{
-			if(quality<=6)search_iterations=7;
-			else if(quality<=7)search_iterations=6;
-			else if(quality<=8)search_iterations=5;
-			else search_iterations=4;
-		}
-
-		// Figure out the closest point on the curve
-		if (fast)
-			t = curve.find_closest(fast, point,search_iterations);
-
-		// Calculate our values
-		p1=curve(t);                 // the closest point on the curve
-		tangent=curve.derivative(t); // the tangent at that point
-
-		// if the point we're nearest to is at either end of the
-		// bline, our distance from the curve is the distance from the
-		// point on the curve.  we need to know which side of the
-		// curve we're on, so find the average of the two tangents at
-		// this point
-		if (t<0.00001 || t>0.99999)
-		{
-			bool zero_tangent = (tangent[0] == 0 && tangent[1] == 0);
-
-			if (t<0.5)
-			{
-				if (iter->get_split_tangent_angle() || iter->get_split_tangent_radius() || zero_tangent)
-				{
-					// fake the current tangent if we need to
-					if (zero_tangent) tangent = curve(FAKE_TANGENT_STEP) - curve(0);
-
-					// calculate the other tangent
-					Vector other_tangent(iter->get_tangent1());
-					if (other_tangent[0] == 0 && other_tangent[1] == 0)
-					{
-						// find the previous blinepoint
-						std::vector<synfig::BLinePoint>::const_iterator prev;
-						if (iter != bline.begin()) (prev = iter)--;
-						else if (loop) (prev = bline.end())--;
-						else prev = iter;
-
-						hermite<Vector> other_curve(prev->get_vertex(), iter->get_vertex(), prev->get_tangent2(), iter->get_tangent1());
-						other_tangent = other_curve(1) - other_curve(1-FAKE_TANGENT_STEP);
-					}
-
-					// normalise and sum the two tangents
-					tangent=(other_tangent.norm()+tangent.norm());
-					edge_case=true;
-				}
-			}
-			else
-			{
-				if (next->get_split_tangent_angle() || next->get_split_tangent_radius() || zero_tangent)
-				{
-					// fake the current tangent if we need to
-					if (zero_tangent) tangent = curve(1) - curve(1-FAKE_TANGENT_STEP);
-
-					// calculate the other tangent
-					Vector other_tangent(next->get_tangent2());
-					if (other_tangent[0] == 0 && other_tangent[1] == 0)
-					{
-						// find the next blinepoint
-						std::vector<synfig::BLinePoint>::const_iterator next2(next);
-						if (++next2 == bline.end())
-						{
-							if (loop) next2 = bline.begin();
-							else next2 = next;
-						}
-
-						hermite<Vector> other_curve(next->get_vertex(), next2->get_vertex(), next->get_tangent2(), next2->get_tangent1());
-						other_tangent = other_curve(FAKE_TANGENT_STEP) - other_curve(0);
-					}
-
-					// normalise and sum the two tangents
-					tangent=(other_tangent.norm()+tangent.norm());
-					edge_case=true;
-				}
-			}
-		}
-		tangent = tangent.norm();
-
-		if(perpendicular)
-		{
-			tangent*=curve_length_;
-			p1-=tangent*perp_dist;
-			tangent=-tangent.perp();
-		}
-		else					// not perpendicular
-			// the width of the bline at the closest point on the curve
-			thickness=(next->get_width()-iter->get_width())*t+iter->get_width();
-	}
-
-	if (perpendicular && bline.size() > 1)
-	{
-		if(quality>7)
-		{
-			dist=perp_dist;
-/*			diff=tangent.perp();
-			const Real mag(diff.inv_mag());
-			supersample=supersample*mag;
-*/
-			supersample=0;
-		}
-		else
-		{
-			diff=tangent.perp();
-			//p1-=diff*0.5;
-			const Real mag(diff.inv_mag());
-			supersample=supersample*mag;
-			diff*=mag*mag;
-			dist=(point_-origin - p1)*diff;
-		}
-	}
-	else						// not perpendicular
-	{
-		if (edge_case)
-		{
-			diff=(p1-(point_-origin));
-			if(diff*tangent.perp()<0) diff=-diff;
-			diff=diff.norm()*thickness*width;
-		}
-		else
-			diff=tangent.perp()*thickness*width;
-
-		p1-=diff*0.5;
-		const Real mag(diff.inv_mag());
-		supersample=supersample*mag;
-		diff*=mag*mag;
-		dist=(point_-origin - p1)*diff;
-	}
-
-	supersample *= 0.5;
-	return compiled_gradient.average(dist - supersample, dist + supersample);
-}
-
-Real
-CurveGradient::calc_supersample(const synfig::Point &/*x*/, Real pw, Real /*ph*/)const
-{
-	return pw;
-}
-
 synfig::Layer::Handle
 CurveGradient::hit_check(synfig::Context context, const synfig::Point &point)const
 {
@@ -467,7 +483,7 @@ CurveGradient::hit_check(synfig::Context context, const synfig::Point &point)con
 
 	if(get_blend_method()==Color::BLEND_STRAIGHT && get_amount()>=0.5)
 		return const_cast<CurveGradient*>(this);
-	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE|| get_blend_method()==Color::BLEND_ONTO) && color_func(point).get_a()>0.5)
+	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE|| get_blend_method()==Color::BLEND_ONTO) && create_generator(10)->get_color(point, Vector()).get_a()>0.5)
 		return const_cast<CurveGradient*>(this);
 	return context.hit_check(point);
 }
@@ -563,7 +579,7 @@ CurveGradient::get_param_vocab()const
 Color
 CurveGradient::get_color(Context context, const Point &point)const
 {
-	const Color color(color_func(point,0));
+	const Color color(create_generator(0)->get_color(point, Vector()));
 
 	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
 		return color;
@@ -571,52 +587,28 @@ CurveGradient::get_color(Context context, const Point &point)const
 		return Color::blend(color,context.get_color(point),get_amount(),get_blend_method());
 }
 
-bool
-CurveGradient::accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const
+rendering::TaskProcedural::Generator::Handle
+CurveGradient::create_generator(int quality)const
 {
-	RENDER_TRANSFORMED_IF_NEED(__FILE__, __LINE__)
-
-	SuperCallback supercb(cb,0,9500,10000);
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		surface->set_wh(renddesc.get_w(),renddesc.get_h());
-	}
-	else
-	{
-		if(!context.accelerated_render(surface,quality,renddesc,&supercb))
-			return false;
-		if(get_amount()==0)
-			return true;
-	}
-
-
-	int x,y;
-
-	Surface::pen pen(surface->begin());
-	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
-	const int w(surface->get_w());
-	const int h(surface->get_h());
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(color_func(pos,quality,calc_supersample(pos,pw,ph)));
-	}
-	else
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(Color::blend(color_func(pos,quality,calc_supersample(pos,pw,ph)),pen.get_value(),get_amount(),get_blend_method()));
-	}
-
-	// Mark our progress as finished
-	if(cb && !cb->amount_complete(10000,10000))
-		return false;
-
-	return true;
+	etl::handle<GeneratorCurveGradient> generator(new GeneratorCurveGradient());
+	generator->origin = param_origin.get(Point());
+	generator->width = param_width.get(Real());
+	generator->bline = param_bline.get_list_of(BLinePoint());
+	generator->bline_loop = bline_loop;
+	generator->loop = param_loop.get(bool());
+	generator->perpendicular = param_perpendicular.get(bool());
+	generator->fast = param_fast.get(bool());
+	generator->curve_length_ = curve_length_;
+	generator->quality = quality;
+	generator->compiled_gradient = compiled_gradient;
+	return generator;
 }
 
+rendering::Task::Handle
+CurveGradient::build_composite_task_vfunc(ContextParams /*context_params*/)const
+{
+	rendering::TaskProcedural::Handle task(new rendering::TaskProcedural());
+	// the same quality as the layer had when it was rendered by the old renderer
+	task->generator = create_generator(4);
+	return task;
+}
@@ -58,16 +58,48 @@ SYNFIG_LAYER_SET_VERSION(LinearGradient,"0.0");
 
 /* === P R O C E D U R E S ================================================= */
 
-/* === M E T H O D S ======================================================= */
+namespace {
 
-inline void
-LinearGradient::Params::calc_diff()
+class GeneratorLinearGradient: public rendering::TaskProcedural::Generator
 {
-	diff=(p2-p1);
-	Real mag_squared = diff.mag_squared();
-	if (mag_squared > 0.0) diff /= mag_squared;
+public:
+	Point p1;
+	Point diff;
+	Real length;
+	CompiledGradient gradient;
+
+	GeneratorLinearGradient(const Point &p1, const Point &p2, const CompiledGradient &gradient):
+		p1(p1), diff(p2 - p1), length(diff.mag()), gradient(gradient)
+	{
+		Real mag_squared = diff.mag_squared();
+		if (mag_squared > 0.0) diff /= mag_squared;
+	}
+
+	Real calc_supersample(const Vector &pixel_size) const
+		{ return length > 0.0 ? 0.5*pixel_size[0]/length : 0.0; }
+
+	virtual Color get_color(const Vector &point, const Vector &pixel_size) const
+	{
+		Real dist = (point - p1)*diff;
+		Real supersample = calc_supersample(pixel_size);
+		return gradient.average(dist - supersample, dist + supersample);
+	}
+
+	//! distance along the gradient changes by the same value for every pixel of row
+	virtual void fill_row(Color *row, int count, const Vector &point, const Vector &step, const Vector &pixel_size) const
+	{
+		Real dist = (point - p1)*diff;
+		Real dist_step = step*diff;
+		Real supersample = calc_supersample(pixel_size);
+		for(Color *end = row + count; row < end; ++row, dist += dist_step)
+			*row = gradient.average(dist - supersample, dist + supersample);
+	}
+};
+
 }
 
+/* === M E T H O D S ======================================================= */
+
 
 LinearGradient::LinearGradient():
 	Layer_Composite(1.0,Color::BLEND_COMPOSITE),
@@ -81,31 +113,15 @@ LinearGradient::LinearGradient():
 	SET_STATIC_DEFAULTS();
 }
 
-inline void
-LinearGradient::fill_params(Params &params)const
-{
-	params.p1=param_p1.get(Point());
-	params.p2=param_p2.get(Point());
-	params.loop=param_loop.get(bool());
-	params.zigzag=param_zigzag.get(bool());
-	params.gradient.set(param_gradient.get(Gradient()), params.loop, params.zigzag);
-	params.calc_diff();
-}
-
-inline Color
-LinearGradient::color_func(const Params &params, const Point &point, synfig::Real supersample)const
+rendering::TaskProcedural::Generator::Handle
+LinearGradient::create_generator()const
 {
-	Real dist(point*params.diff - params.p1*params.diff);
-	supersample *= 0.5;
-	return params.gradient.average(dist - supersample, dist + supersample);
-}
-
-inline synfig::Real
-LinearGradient::calc_supersample(const Params &params, synfig::Real pw, synfig::Real /*ph*/)const
-{
-	// it's copy of code
-	// see also other calc_supersample overload
-	return pw/(params.p2-params.p1).mag();
+	bool loop = param_loop.get(bool());
+	bool zigzag = param_zigzag.get(bool());
+	return new GeneratorLinearGradient(
+		param_p1.get(Point()),
+		param_p2.get(Point()),
+		CompiledGradient(param_gradient.get(Gradient()), loop, zigzag) );
 }
 
 synfig::Layer::Handle
@@ -120,10 +136,7 @@ LinearGradient::hit_check(synfig::Context context, const synfig::Point &point)co
 	if(get_blend_method()==Color::BLEND_STRAIGHT && get_amount()>=0.5)
 		return const_cast<LinearGradient*>(this);
 
-	Params params;
-	fill_params(params);
-
-	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE) && color_func(params, point).get_a()>0.5)
+	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE) && create_generator()->get_color(point, Vector()).get_a()>0.5)
 		return const_cast<LinearGradient*>(this);
 	return context.hit_check(point);
 }
@@ -189,10 +202,7 @@ LinearGradient::get_param_vocab()const
 Color
 LinearGradient::get_color(Context context, const Point &point)const
 {
-	Params params;
-	fill_params(params);
-
-	const Color color(color_func(params, point));
+	const Color color(create_generator()->get_color(point, Vector()));
 
 	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
 		return color;
@@ -200,75 +210,10 @@ LinearGradient::get_color(Context context, const Point &point)const
 		return Color::blend(color,context.get_color(point),get_amount(),get_blend_method());
 }
 
-bool
-LinearGradient::accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const
+rendering::Task::Handle
+LinearGradient::build_composite_task_vfunc(ContextParams /*context_params*/)const
 {
-	Params params;
-	fill_params(params);
-
-	if (!renddesc.get_transformation_matrix().is_identity())
-	{
-		Point origin = params.p1;
-		Point axis_x = params.p2 - origin;
-		Point axis_y = axis_x.perp();
-		origin = renddesc.get_transformation_matrix().get_transformed(origin);
-		axis_x = renddesc.get_transformation_matrix().get_transformed(axis_x, false);
-		axis_y = renddesc.get_transformation_matrix().get_transformed(axis_y, false);
-
-		Point valid_axis_x = -axis_y.perp();
-		Real mag_squared = valid_axis_x.mag_squared();
-		if (mag_squared > 0.0)
-			valid_axis_x *= (valid_axis_x * axis_x)/mag_squared;
-		else
-			valid_axis_x = axis_x;
-
-		params.p1 = origin;
-		params.p2 = origin + valid_axis_x;
-		params.calc_diff();
-	}
-
-	SuperCallback supercb(cb,0,9500,10000);
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		surface->set_wh(renddesc.get_w(),renddesc.get_h());
-	}
-	else
-	{
-		if(!context.accelerated_render(surface,quality,renddesc,&supercb))
-			return false;
-		if(get_amount()==0)
-			return true;
-	}
-
-
-	int x,y;
-
-	Surface::pen pen(surface->begin());
-	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
-	const int w(surface->get_w());
-	const int h(surface->get_h());
-	synfig::Real supersample = calc_supersample(params, pw, ph);
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(color_func(params,pos,supersample));
-	}
-	else
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(Color::blend(color_func(params,pos,supersample),pen.get_value(),get_amount(),get_blend_method()));
-	}
-
-	// Mark our progress as finished
-	if(cb && !cb->amount_complete(10000,10000))
-		return false;
-
-	return true;
+	rendering::TaskProcedural::Handle task(new rendering::TaskProcedural());
+	task->generator = create_generator();
+	return task;
 }
-
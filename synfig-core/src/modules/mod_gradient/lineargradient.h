@@ -34,6 +34,7 @@
 #include <synfig/vector.h>
 #include <synfig/layers/layer_composite.h>
 #include <synfig/gradient.h>
+#include <synfig/rendering/common/task/taskprocedural.h>
 
 /* === M A C R O S ========================================================= */
 
@@ -57,20 +58,7 @@ private:
 	//! Parameter: (bool)
 	ValueBase param_zigzag;
 
-	struct Params {
-		Point p1;
-		Point p2;
-		Point diff;
-		CompiledGradient gradient;
-		bool loop;
-		bool zigzag;
-		inline Params(): loop(false), zigzag(false) { }
-		void calc_diff();
-	};
-
-	void fill_params(Params &params)const;
-	synfig::Color color_func(const Params &params, const synfig::Point &x, synfig::Real supersample = 0.0)const;
-	synfig::Real calc_supersample(const Params &params, synfig::Real pw, synfig::Real ph)const;
+	rendering::TaskProcedural::Generator::Handle create_generator()const;
 
 public:
 	LinearGradient();
@@ -78,11 +66,13 @@ public:
 	virtual bool set_param(const String &param, const ValueBase &value);
 	virtual ValueBase get_param(const String &param)const;
 	virtual Color get_color(Context context, const Point &pos)const;
-	virtual bool accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
 
 	synfig::Layer::Handle hit_check(synfig::Context context, const synfig::Point &point)const;
 
 	virtual Vocab get_param_vocab()const;
+
+protected:
+	virtual rendering::Task::Handle build_composite_task_vfunc(ContextParams context_params)const;
 };
 
 /* === E N D =============================================================== */
@@ -61,6 +61,28 @@ SYNFIG_LAYER_SET_VERSION(RadialGradient,"0.1");
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+class GeneratorRadialGradient: public rendering::TaskProcedural::Generator
+{
+public:
+	Point center;
+	Real radius;
+	CompiledGradient gradient;
+
+	GeneratorRadialGradient(const Point &center, Real radius, const CompiledGradient &gradient):
+		center(center), radius(radius), gradient(gradient) { }
+
+	virtual Color get_color(const Vector &point, const Vector &pixel_size) const
+	{
+		Real dist = (point - center).mag()/radius;
+		Real supersample = 0.6*pixel_size[0]/radius;
+		return gradient.average(dist - supersample, dist + supersample);
+	}
+};
+
+}
+
 /* === M E T H O D S ======================================================= */
 
 /* === E N T R Y P O I N T ================================================= */
@@ -149,26 +171,6 @@ RadialGradient::compile()
 		param_zigzag.get(bool()) );
 }
 
-inline Color
-RadialGradient::color_func(const Point &point, Real supersample)const
-{
-	Point center = param_center.get(Point());
-	Real radius = param_radius.get(Real());
-
-	Real dist((point-center).mag()/radius);
-
-	supersample *= 0.5;
-	return compiled_gradient.average(dist - supersample, dist + supersample);
-}
-
-
-Real
-RadialGradient::calc_supersample(const synfig::Point &/*x*/, Real pw, Real /*ph*/)const
-{
-	Real radius=param_radius.get(Real());
-//	return sqrt(pw*pw+ph*ph)/radius;
-	return 1.2*pw/radius;
-}
 
 synfig::Layer::Handle
 RadialGradient::hit_check(synfig::Context context, const synfig::Point &point)const
@@ -181,7 +183,7 @@ RadialGradient::hit_check(synfig::Context context, const synfig::Point &point)co
 
 	if(get_blend_method()==Color::BLEND_STRAIGHT && get_amount()>=0.5)
 		return const_cast<RadialGradient*>(this);
-	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE) && color_func(point).get_a()>0.5)
+	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE) && create_generator()->get_color(point, Vector()).get_a()>0.5)
 		return const_cast<RadialGradient*>(this);
 	return context.hit_check(point);
 }
@@ -189,7 +191,7 @@ RadialGradient::hit_check(synfig::Context context, const synfig::Point &point)co
 Color
 RadialGradient::get_color(Context context, const Point &pos)const
 {
-	const Color color(color_func(pos));
+	const Color color(create_generator()->get_color(pos, Vector()));
 
 	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
 		return color;
@@ -197,53 +199,19 @@ RadialGradient::get_color(Context context, const Point &pos)const
 		return Color::blend(color,context.get_color(pos),get_amount(),get_blend_method());
 }
 
-bool
-RadialGradient::accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const
+rendering::TaskProcedural::Generator::Handle
+RadialGradient::create_generator()const
 {
-	RENDER_TRANSFORMED_IF_NEED(__FILE__, __LINE__)
-
-	SuperCallback supercb(cb,0,9500,10000);
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		surface->set_wh(renddesc.get_w(),renddesc.get_h());
-	}
-	else
-	{
-		if(!context.accelerated_render(surface,quality,renddesc,&supercb))
-			return false;
-		if(get_amount()==0)
-			return true;
-	}
-
-
-	int x,y;
-
-	Surface::pen pen(surface->begin());
-	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
-	const int w(surface->get_w());
-	const int h(surface->get_h());
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(color_func(pos,calc_supersample(pos,pw,ph)));
-	}
-	else
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(Color::blend(color_func(pos,calc_supersample(pos,pw,ph)),pen.get_value(),get_amount(),get_blend_method()));
-	}
-
-	// Mark our progress as finished
-	if(cb && !cb->amount_complete(10000,10000))
-		return false;
-
-	return true;
+	return new GeneratorRadialGradient(
+		param_center.get(Point()),
+		param_radius.get(Real()),
+		compiled_gradient );
 }
 
-
+rendering::Task::Handle
+RadialGradient::build_composite_task_vfunc(ContextParams /*context_params*/)const
+{
+	rendering::TaskProcedural::Handle task(new rendering::TaskProcedural());
+	task->generator = create_generator();
+	return task;
+}
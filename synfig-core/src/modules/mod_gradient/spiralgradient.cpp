@@ -61,6 +61,44 @@ SYNFIG_LAYER_SET_VERSION(SpiralGradient,"0.1");
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+class GeneratorSpiralGradient: public rendering::TaskProcedural::Generator
+{
+public:
+	Point center;
+	Real radius;
+	Angle angle;
+	bool clockwise;
+	CompiledGradient gradient;
+
+	GeneratorSpiralGradient(const Point &center, Real radius, const Angle &angle, bool clockwise, const CompiledGradient &gradient):
+		center(center), radius(radius), angle(angle), clockwise(clockwise), gradient(gradient) { }
+
+	virtual Color get_color(const Vector &point, const Vector &pixel_size) const
+	{
+		const Point centered(point - center);
+		Angle a(angle);
+		a += Angle::tan(-centered[1],centered[0]).mod();
+
+		Real dist(centered.mag()/radius);
+		if(clockwise)
+			dist+=Angle::rot(a.mod()).get();
+		else
+			dist-=Angle::rot(a.mod()).get();
+
+		Real supersample = pixel_size[0] > 0.0
+		                 ? (1.41421*pixel_size[0]/radius+(1.41421*pixel_size[0]/centered.mag())/(PI*2))*0.5
+		                 : 0.0;
+		if(supersample<0.00001)supersample=0.00001;
+
+		supersample *= 0.5;
+		return gradient.average(dist - supersample, dist + supersample);
+	}
+};
+
+}
+
 /* === M E T H O D S ======================================================= */
 
 /* === E N T R Y P O I N T ================================================= */
@@ -145,39 +183,6 @@ void
 SpiralGradient::compile()
 	{ compiled_gradient.set(param_gradient.get(Gradient()), true); }
 
-inline Color
-SpiralGradient::color_func(const Point &pos, Real supersample)const
-{
-	Point center=param_center.get(Point());
-	Real radius=param_radius.get(Real());
-	Angle angle=param_angle.get(Angle());
-	bool clockwise=param_clockwise.get(bool());
-	
-	const Point centered(pos-center);
-	Angle a(angle);
-	a += Angle::tan(-centered[1],centered[0]).mod();
-
-	if(supersample<0.00001)supersample=0.00001;
-
-	Real dist((pos-center).mag()/radius);
-	if(clockwise)
-		dist+=Angle::rot(a.mod()).get();
-	else
-		dist-=Angle::rot(a.mod()).get();
-
-	supersample *= 0.5;
-	return compiled_gradient.average(dist - supersample, dist + supersample);
-}
-
-Real
-SpiralGradient::calc_supersample(const synfig::Point &x, Real pw, Real /*ph*/)const
-{
-	Point center=param_center.get(Point());
-	Real radius=param_radius.get(Real());
-
-	return (1.41421*pw/radius+(1.41421*pw/Point(x-center).mag())/(PI*2))*0.5;
-}
-
 synfig::Layer::Handle
 SpiralGradient::hit_check(synfig::Context context, const synfig::Point &point)const
 {
@@ -189,7 +194,7 @@ SpiralGradient::hit_check(synfig::Context context, const synfig::Point &point)co
 
 	if(get_blend_method()==Color::BLEND_STRAIGHT && get_amount()>=0.5)
 		return const_cast<SpiralGradient*>(this);
-	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE) && color_func(point).get_a()>0.5)
+	if((get_blend_method()==Color::BLEND_STRAIGHT || get_blend_method()==Color::BLEND_COMPOSITE) && create_generator()->get_color(point, Vector()).get_a()>0.5)
 		return const_cast<SpiralGradient*>(this);
 	return context.hit_check(point);
 }
@@ -197,7 +202,7 @@ SpiralGradient::hit_check(synfig::Context context, const synfig::Point &point)co
 Color
 SpiralGradient::get_color(Context context, const Point &pos)const
 {
-	const Color color(color_func(pos));
+	const Color color(create_generator()->get_color(pos, Vector()));
 
 	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
 		return color;
@@ -205,55 +210,21 @@ SpiralGradient::get_color(Context context, const Point &pos)const
 		return Color::blend(color,context.get_color(pos),get_amount(),get_blend_method());
 }
 
-bool
-SpiralGradient::accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const
+rendering::TaskProcedural::Generator::Handle
+SpiralGradient::create_generator()const
 {
-	RENDER_TRANSFORMED_IF_NEED(__FILE__, __LINE__)
-
-	SuperCallback supercb(cb,0,9500,10000);
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		surface->set_wh(renddesc.get_w(),renddesc.get_h());
-	}
-	else
-	{
-		if(!context.accelerated_render(surface,quality,renddesc,&supercb))
-			return false;
-		if(get_amount()==0)
-			return true;
-	}
-
-
-	int x,y;
-
-	Surface::pen pen(surface->begin());
-	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
-	const int w(surface->get_w());
-	const int h(surface->get_h());
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(color_func(pos,calc_supersample(pos,pw,ph)));
-	}
-	else
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(Color::blend(color_func(pos,calc_supersample(pos,pw,ph)),pen.get_value(),get_amount(),get_blend_method()));
-	}
-
-	// Mark our progress as finished
-	if(cb && !cb->amount_complete(10000,10000))
-		return false;
-
-	return true;
+	return new GeneratorSpiralGradient(
+		param_center.get(Point()),
+		param_radius.get(Real()),
+		param_angle.get(Angle()),
+		param_clockwise.get(bool()),
+		compiled_gradient );
 }
 
-
-
-
+rendering::Task::Handle
+SpiralGradient::build_composite_task_vfunc(ContextParams /*context_params*/)const
+{
+	rendering::TaskProcedural::Handle task(new rendering::TaskProcedural());
+	task->generator = create_generator();
+	return task;
+}
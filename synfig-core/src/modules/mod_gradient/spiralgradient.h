@@ -35,6 +35,7 @@
 #include <synfig/vector.h>
 #include <synfig/value.h>
 #include <synfig/gradient.h>
+#include <synfig/rendering/common/task/taskprocedural.h>
 #include <synfig/angle.h>
 
 /* === M A C R O S ========================================================= */
@@ -64,8 +65,7 @@ private:
 	CompiledGradient compiled_gradient;
 
 	void compile();
-	Color color_func(const Point &x, Real supersample=0)const;
-	Real calc_supersample(const Point &x, Real pw, Real ph)const;
+	rendering::TaskProcedural::Generator::Handle create_generator()const;
 
 public:
 
@@ -77,10 +77,12 @@ public:
 
 	virtual Color get_color(Context context, const Point &pos)const;
 
-	virtual bool accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
 	Layer::Handle hit_check(Context context, const Point &point)const;
 
 	virtual Vocab get_param_vocab()const;
+
+protected:
+	virtual rendering::Task::Handle build_composite_task_vfunc(ContextParams context_params)const;
 }; // END of class SpiralGradient
 
 /* === E N D =============================================================== */
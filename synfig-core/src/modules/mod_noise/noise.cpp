@@ -45,6 +45,7 @@
 #include <synfig/renddesc.h>
 #include <synfig/surface.h>
 #include <synfig/value.h>
+#include <algorithm>
 #include <ctime>
 
 #endif
@@ -63,145 +64,156 @@ SYNFIG_LAYER_SET_VERSION(Noise,"0.0");
 
 /* === P R O C E D U R E S ================================================= */
 
-/* === M E T H O D S ======================================================= */
-
-Noise::Noise():
-	Layer_Composite(1.0,Color::BLEND_COMPOSITE),
-	param_gradient(ValueBase(Gradient(Color::black(), Color::white()))),
-	param_random(ValueBase(int(time(nullptr)))),
-	param_size(ValueBase(Vector(1,1))),
-	param_smooth(ValueBase(int(RandomNoise::SMOOTH_COSINE))),
-	param_detail(ValueBase(int(4))),
-	param_speed(ValueBase(Real(0))),
-	param_turbulent(ValueBase(bool(false))),
-	param_do_alpha(ValueBase(bool(false))),
-	param_super_sample(ValueBase(bool(false)))
-{
-	//displacement=Vector(1,1);
-	//do_displacement=false;
-	SET_INTERPOLATION_DEFAULTS();
-	SET_STATIC_DEFAULTS();
-}
-
-
-
-void
-Noise::compile()
-	{ compiled_gradient.set(param_gradient.get(Gradient()) ); }
+namespace {
 
-inline Color
-Noise::color_func(const Point &point, float pixel_size,Context /*context*/)const
+class GeneratorNoise: public rendering::TaskProcedural::Generator
 {
-	Vector size=param_size.get(Vector());
+public:
+	Vector size;
 	RandomNoise random;
-	random.set_seed(param_random.get(int()));
-	int smooth_=param_smooth.get(int());
-	int detail=param_detail.get(int());
-	Real speed=param_speed.get(Real());
-	bool turbulent=param_turbulent.get(bool());
-	bool do_alpha=param_do_alpha.get(bool());
-	bool super_sample=param_super_sample.get(bool());
-	
-
-	Color ret(0,0,0,0);
+	int smooth_;
+	int detail;
+	Real speed;
+	bool turbulent;
+	bool do_alpha;
+	bool super_sample;
+	Time time_mark;
+	CompiledGradient compiled_gradient;
+
+	GeneratorNoise():
+		smooth_(), detail(), speed(), turbulent(), do_alpha(), super_sample() { }
+
+	Color color_func(const Point &point, float pixel_size)const
+	{
+		Color ret(0,0,0,0);
 
-	float x(point[0]/size[0]*(1<<detail));
-	float y(point[1]/size[1]*(1<<detail));
-	float x2(0),y2(0);
+		float x(point[0]/size[0]*(1<<detail));
+		float y(point[1]/size[1]*(1<<detail));
+		float x2(0),y2(0);
 
-	if(super_sample&&pixel_size)
-	{
-		x2=(point[0]+pixel_size)/size[0]*(1<<detail);
-		y2=(point[1]+pixel_size)/size[1]*(1<<detail);
-	}
+		if(super_sample&&pixel_size)
+		{
+			x2=(point[0]+pixel_size)/size[0]*(1<<detail);
+			y2=(point[1]+pixel_size)/size[1]*(1<<detail);
+		}
 
-	int i;
-	Time time;
-	time=speed*get_time_mark();
-	int smooth((!speed && smooth_ == (int)RandomNoise::SMOOTH_SPLINE) ? (int)RandomNoise::SMOOTH_FAST_SPLINE : smooth_);
+		int i;
+		Time time;
+		time=speed*time_mark;
+		int smooth((!speed && smooth_ == (int)RandomNoise::SMOOTH_SPLINE) ? (int)RandomNoise::SMOOTH_FAST_SPLINE : smooth_);
 
-	float ftime(time);
+		float ftime(time);
 
-	{
-		float amount=0.0f;
-		float amount2=0.0f;
-		float amount3=0.0f;
-		float alpha=0.0f;
-		for(i=0;i<detail;i++)
 		{
-			amount=random(RandomNoise::SmoothType(smooth),0+(detail-i)*5,x,y,ftime)+amount*0.5;
-			if (amount < -1) amount = -1;
-			if (amount >  1) amount =  1;
-
-			if(super_sample&&pixel_size)
+			float amount=0.0f;
+			float amount2=0.0f;
+			float amount3=0.0f;
+			float alpha=0.0f;
+			for(i=0;i<detail;i++)
 			{
-				amount2=random(RandomNoise::SmoothType(smooth),0+(detail-i)*5,x2,y,ftime)+amount2*0.5;
-				if (amount2 < -1) amount2 = -1;
-				if (amount2 >  1) amount2 =  1;
+				amount=random(RandomNoise::SmoothType(smooth),0+(detail-i)*5,x,y,ftime)+amount*0.5;
+				if (amount < -1) amount = -1;
+				if (amount >  1) amount =  1;
 
-				amount3=random(RandomNoise::SmoothType(smooth),0+(detail-i)*5,x,y2,ftime)+amount3*0.5;
-				if (amount3 < -1) amount3 = -1;
-				if (amount3 >  1) amount3 =  1;
+				if(super_sample&&pixel_size)
+				{
+					amount2=random(RandomNoise::SmoothType(smooth),0+(detail-i)*5,x2,y,ftime)+amount2*0.5;
+					if (amount2 < -1) amount2 = -1;
+					if (amount2 >  1) amount2 =  1;
+
+					amount3=random(RandomNoise::SmoothType(smooth),0+(detail-i)*5,x,y2,ftime)+amount3*0.5;
+					if (amount3 < -1) amount3 = -1;
+					if (amount3 >  1) amount3 =  1;
+
+					if(turbulent)
+					{
+						amount2=std::fabs(amount2);
+						amount3=std::fabs(amount3);
+					}
+
+					x2*=0.5f;
+					y2*=0.5f;
+				}
+
+				if(do_alpha)
+				{
+					alpha=random(RandomNoise::SmoothType(smooth),3+(detail-i)*5,x,y,ftime)+alpha*0.5;
+					if (alpha < -1) alpha = -1;
+					if (alpha > 1) alpha = 1;
+				}
 
 				if(turbulent)
 				{
-					amount2=std::fabs(amount2);
-					amount3=std::fabs(amount3);
+					amount=std::fabs(amount);
+					alpha=std::fabs(alpha);
 				}
 
-				x2*=0.5f;
-				y2*=0.5f;
+				x*=0.5f;
+				y*=0.5f;
+				//ftime*=0.5f;
 			}
 
-			if(do_alpha)
+			if(!turbulent)
 			{
-				alpha=random(RandomNoise::SmoothType(smooth),3+(detail-i)*5,x,y,ftime)+alpha*0.5;
-				if (alpha < -1) alpha = -1;
-				if (alpha > 1) alpha = 1;
+				amount=amount/2.0f+0.5f;
+				alpha=alpha/2.0f+0.5f;
+
+				if(super_sample&&pixel_size)
+				{
+					amount2=amount2/2.0f+0.5f;
+					amount3=amount3/2.0f+0.5f;
+				}
 			}
 
-			if(turbulent)
-			{
-				amount=std::fabs(amount);
-				alpha=std::fabs(alpha);
+			if(super_sample && pixel_size) {
+				Real da = std::max(amount3, std::max(amount,amount2)) - std::min(amount3, std::min(amount,amount2));
+				ret = compiled_gradient.average(amount - da, amount + da);
+			} else {
+				ret = compiled_gradient.color(amount);
 			}
 
-			x*=0.5f;
-			y*=0.5f;
-			//ftime*=0.5f;
+			if(do_alpha)
+				ret.set_a(ret.get_a()*(alpha));
 		}
+		return ret;
+	}
 
-		if(!turbulent)
-		{
-			amount=amount/2.0f+0.5f;
-			alpha=alpha/2.0f+0.5f;
-
-			if(super_sample&&pixel_size)
-			{
-				amount2=amount2/2.0f+0.5f;
-				amount3=amount3/2.0f+0.5f;
-			}
-		}
+	virtual Color get_color(const Vector &point, const Vector &pixel_size) const
+		{ return color_func(point, (pixel_size[0] + pixel_size[1])*0.5); }
 
-		if(super_sample && pixel_size) {
-			Real da = std::max(amount3, std::max(amount,amount2)) - std::min(amount3, std::min(amount,amount2));
-			ret = compiled_gradient.average(amount - da, amount + da);
-		} else {
-			ret = compiled_gradient.color(amount);
-		}
+	//! every level of detail needs the random values
+	virtual Real get_pixel_cost() const
+		{ return std::max(1, detail)*((super_sample ? 3.0 : 1.0) + (do_alpha ? 1.0 : 0.0)); }
+};
 
-		if(do_alpha)
-			ret.set_a(ret.get_a()*(alpha));
-	}
-	return ret;
 }
 
-inline float
-Noise::calc_supersample(const synfig::Point &/*x*/, float /*pw*/,float /*ph*/)const
+/* === M E T H O D S ======================================================= */
+
+Noise::Noise():
+	Layer_Composite(1.0,Color::BLEND_COMPOSITE),
+	param_gradient(ValueBase(Gradient(Color::black(), Color::white()))),
+	param_random(ValueBase(int(time(nullptr)))),
+	param_size(ValueBase(Vector(1,1))),
+	param_smooth(ValueBase(int(RandomNoise::SMOOTH_COSINE))),
+	param_detail(ValueBase(int(4))),
+	param_speed(ValueBase(Real(0))),
+	param_turbulent(ValueBase(bool(false))),
+	param_do_alpha(ValueBase(bool(false))),
+	param_super_sample(ValueBase(bool(false)))
 {
-	return 0.0f;
+	//displacement=Vector(1,1);
+	//do_displacement=false;
+	SET_INTERPOLATION_DEFAULTS();
+	SET_STATIC_DEFAULTS();
 }
 
+
+
+void
+Noise::compile()
+	{ compiled_gradient.set(param_gradient.get(Gradient()) ); }
+
 synfig::Layer::Handle
 Noise::hit_check(synfig::Context context, const synfig::Point &point)const
 {
@@ -213,7 +225,7 @@ Noise::hit_check(synfig::Context context, const synfig::Point &point)const
 
 	if(get_blend_method()==Color::BLEND_STRAIGHT && get_amount()>=0.5)
 		return const_cast<Noise*>(this);
-	if(color_func(point,0,context).get_a()>0.5)
+	if(create_generator()->get_color(point, Vector()).get_a()>0.5)
 		return const_cast<Noise*>(this);
 	return synfig::Layer::Handle();
 }
@@ -315,7 +327,7 @@ Noise::get_param_vocab()const
 Color
 Noise::get_color(Context context, const Point &point)const
 {
-	const Color color(color_func(point,0,context));
+	const Color color(create_generator()->get_color(point, Vector()));
 
 	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
 		return color;
@@ -323,55 +335,27 @@ Noise::get_color(Context context, const Point &point)const
 		return Color::blend(color,context.get_color(point),get_amount(),get_blend_method());
 }
 
-
-bool
-Noise::accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const
+rendering::TaskProcedural::Generator::Handle
+Noise::create_generator()const
 {
-	RENDER_TRANSFORMED_IF_NEED(__FILE__, __LINE__)
-
-	SuperCallback supercb(cb,0,9500,10000);
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		surface->set_wh(renddesc.get_w(),renddesc.get_h());
-	}
-	else
-	{
-		if(!context.accelerated_render(surface,quality,renddesc,&supercb))
-			return false;
-		if(get_amount()==0)
-			return true;
-	}
-
-
-	int x,y;
-
-	Surface::pen pen(surface->begin());
-	const Real pw(renddesc.get_pw()),ph(renddesc.get_ph());
-	Point pos;
-	Point tl(renddesc.get_tl());
-	const int w(surface->get_w());
-	const int h(surface->get_h());
-	float supersampleradius((std::fabs(pw)+std::fabs(ph))*0.5f);
-	if(quality>=8)
-		supersampleradius=0;
-
-	if(get_amount()==1.0 && get_blend_method()==Color::BLEND_STRAIGHT)
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(color_func(pos,supersampleradius,context));
-	}
-	else
-	{
-		for(y=0,pos[1]=tl[1];y<h;y++,pen.inc_y(),pen.dec_x(x),pos[1]+=ph)
-			for(x=0,pos[0]=tl[0];x<w;x++,pen.inc_x(),pos[0]+=pw)
-				pen.put_value(Color::blend(color_func(pos,supersampleradius,context),pen.get_value(),get_amount(),get_blend_method()));
-	}
-
-	// Mark our progress as finished
-	if(cb && !cb->amount_complete(10000,10000))
-		return false;
+	etl::handle<GeneratorNoise> generator(new GeneratorNoise());
+	generator->size = param_size.get(Vector());
+	generator->random.set_seed(param_random.get(int()));
+	generator->smooth_ = param_smooth.get(int());
+	generator->detail = param_detail.get(int());
+	generator->speed = param_speed.get(Real());
+	generator->turbulent = param_turbulent.get(bool());
+	generator->do_alpha = param_do_alpha.get(bool());
+	generator->super_sample = param_super_sample.get(bool());
+	generator->time_mark = get_time_mark();
+	generator->compiled_gradient = compiled_gradient;
+	return generator;
+}
 
-	return true;
+rendering::Task::Handle
+Noise::build_composite_task_vfunc(ContextParams /*context_params*/)const
+{
+	rendering::TaskProcedural::Handle task(new rendering::TaskProcedural());
+	task->generator = create_generator();
+	return task;
 }
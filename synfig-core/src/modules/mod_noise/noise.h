@@ -38,6 +38,7 @@
 #include <synfig/layers/layer_composite.h>
 #include <synfig/gradient.h>
 #include <synfig/time.h>
+#include <synfig/rendering/common/task/taskprocedural.h>
 #include "random_noise.h"
 
 /* === M A C R O S ========================================================= */
@@ -73,8 +74,7 @@ private:
 	synfig::CompiledGradient compiled_gradient;
 
 	void compile();
-	synfig::Color color_func(const synfig::Point &x, float supersample,synfig::Context context)const;
-	float calc_supersample(const synfig::Point &x, float pw,float ph)const;
+	synfig::rendering::TaskProcedural::Generator::Handle create_generator()const;
 
 public:
 	Noise();
@@ -82,9 +82,11 @@ public:
 	virtual bool set_param(const synfig::String &param, const synfig::ValueBase &value);
 	virtual synfig::ValueBase get_param(const synfig::String &param)const;
 	virtual synfig::Color get_color(synfig::Context context, const synfig::Point &pos)const;
-	virtual bool accelerated_render(synfig::Context context,synfig::Surface *surface,int quality, const synfig::RendDesc &renddesc, synfig::ProgressCallback *cb)const;
 	synfig::Layer::Handle hit_check(synfig::Context context, const synfig::Point &point)const;
 	virtual Vocab get_param_vocab()const;
+
+protected:
+	virtual synfig::rendering::Task::Handle build_composite_task_vfunc(synfig::ContextParams context_params)const;
 };
 
 /* === E N D =============================================================== */
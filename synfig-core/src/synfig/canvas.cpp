@@ -33,6 +33,7 @@
 #	include <config.h>
 #endif
 
+#include <atomic>
 #include <cassert>
 #include <cstring>
 
@@ -68,15 +69,15 @@ namespace synfig { extern Canvas::Handle open_canvas_as(const FileSystem::Identi
 
 struct _CanvasCounter
 {
-	static int counter;
+	static std::atomic<int> counter;
 	~_CanvasCounter()
 	{
 		if(counter)
-			synfig::error("%d canvases not yet deleted!",counter);
+			synfig::error("%d canvases not yet deleted!",(int)counter);
 	}
 } _canvas_counter;
 
-int _CanvasCounter::counter(0);
+std::atomic<int> _CanvasCounter::counter(0);
 
 /* === G L O B A L S ======================================================= */
 
@@ -87,6 +88,8 @@ int _CanvasCounter::counter(0);
 Canvas::Canvas(const String &id):
 	id_			(id),
 	version_	(CURRENT_CANVAS_VERSION),
+	children_index_size_(0),
+	children_index_valid_(false),
 	cur_time_	(0),
 	is_inline_	(false),
 	is_dirty_	(true),
@@ -426,6 +429,8 @@ Canvas::set_id(const String &x)
 	if(!valid_id(x))
 		throw std::runtime_error("Invalid ID");
 	id_=x;
+	if(parent_)
+		parent_->invalidate_children_index();
 	signal_id_changed_();
 }
 
@@ -491,6 +496,7 @@ Canvas::set_time(Time t)const
 		const_cast<Canvas&>(*this).cur_time_=t;
 
 		is_dirty_=false;
+		ValueNode::Cache::Scope cache_scope;
 		get_independent_context().set_time(t);
 	}
 	is_dirty_=false;
@@ -784,13 +790,11 @@ Canvas::surefind_canvas(const String &id, String &warnings)
 	// request is for this immediate canvas
 	if(id.find_first_of(':')==std::string::npos)
 	{
-		Children::iterator iter;
-
 		// Search for the image in the image list,
 		// and return it if it is found
-		for(iter=children().begin();iter!=children().end();iter++)
-			if(id==(*iter)->get_id())
-				return *iter;
+		Children::const_iterator iter = find_child_canvas(id);
+		if(iter!=children_.end())
+			return *iter;
 
 		// Create a new canvas and return it
 		//synfig::warning("Implicitly creating canvas named "+id);
@@ -870,13 +874,11 @@ Canvas::find_canvas(const String &id, String &warnings)const
 	// request is for this immediate canvas
 	if(id.find_first_of(':')==std::string::npos)
 	{
-		Children::const_iterator iter;
-
 		// Search for the image in the image list,
 		// and return it if it is found
-		for(iter=children().begin();iter!=children().end();iter++)
-			if(id==(*iter)->get_id())
-				return *iter;
+		Children::const_iterator iter = find_child_canvas(id);
+		if(iter!=children_.end())
+			return *iter;
 
 		throw Exception::IDNotFound("Child Canvas in Parent Canvas: (child)"+id);
 	}
@@ -1080,8 +1082,9 @@ Canvas::new_child_canvas()
 		return parent_->new_child_canvas();
 
 	// Create a new canvas
-	children().push_back(create());
-	Canvas::Handle canvas(children().back());
+	children_.push_back(create());
+	Canvas::Handle canvas(children_.back());
+	add_child_canvas_to_index();
 
 	canvas->rend_desc()=rend_desc();
 	canvas->set_parent(this);
@@ -1096,10 +1099,11 @@ Canvas::new_child_canvas(const String &id)
 		return parent_->new_child_canvas(id);
 
 	// Create a new canvas
-	children().push_back(create());
-	Canvas::Handle canvas(children().back());
+	children_.push_back(create());
+	Canvas::Handle canvas(children_.back());
 
 	canvas->set_id(id);
+	add_child_canvas_to_index();
 	canvas->rend_desc()=rend_desc();
 	canvas->set_parent(this);
 
@@ -1129,7 +1133,8 @@ Canvas::add_child_canvas(Canvas::Handle child_canvas, const synfig::String& id)
 		if(child_canvas->is_inline())
 			child_canvas->is_inline_=false;
 		child_canvas->id_=id;
-		children().push_back(child_canvas);
+		children_.push_back(child_canvas);
+		add_child_canvas_to_index();
 		child_canvas->set_parent(this);
 	}
 
@@ -1145,13 +1150,64 @@ Canvas::remove_child_canvas(Canvas::Handle child_canvas)
 	if(child_canvas->parent_!=this)
 		throw std::runtime_error("Given child does not belong to me");
 
-	if(find(children().begin(),children().end(),child_canvas)==children().end())
+	if(find(children_.begin(),children_.end(),child_canvas)==children_.end())
 		throw Exception::IDNotFound(child_canvas->get_id());
 
-	children().remove(child_canvas);
+	children_.remove(child_canvas);
+	invalidate_children_index();
 	child_canvas->set_parent(nullptr);
 }
 
+Canvas::Children::const_iterator
+Canvas::find_child_canvas(const String &id)const
+{
+	// lookups are const and may be called by several threads at once
+	std::lock_guard<std::mutex> lock(children_index_mutex_);
+	while(true)
+	{
+		// list of children may be changed outside (see children()),
+		// also ids of children may be changed by set_id()
+		if(!children_index_valid_ || children_index_size_!=children_.size())
+		{
+			children_index_.clear();
+			for(Children::const_iterator iter=children_.begin();iter!=children_.end();++iter)
+				children_index_.insert(std::make_pair((*iter)->get_id(), iter)); // keep the first one like linear search did
+			children_index_size_=children_.size();
+			children_index_valid_=true;
+		}
+
+		std::unordered_map<String, Children::const_iterator>::const_iterator i = children_index_.find(id);
+		if(i==children_index_.end())
+			return children_.end();
+		if((*i->second)->get_id()==id)
+			return i->second;
+		children_index_valid_=false;
+	}
+}
+
+void
+Canvas::add_child_canvas_to_index()
+{
+	std::lock_guard<std::mutex> lock(children_index_mutex_);
+	if(children_index_valid_ && children_index_size_+1==children_.size())
+	{
+		Children::const_iterator iter = --children_.end();
+		children_index_.insert(std::make_pair((*iter)->get_id(), iter));
+		children_index_size_=children_.size();
+	}
+	else
+	{
+		children_index_valid_=false;
+	}
+}
+
+void
+Canvas::invalidate_children_index()
+{
+	std::lock_guard<std::mutex> lock(children_index_mutex_);
+	children_index_valid_=false;
+}
+
 void
 Canvas::set_parent(const Canvas::LooseHandle &parent)
 {
@@ -1166,7 +1222,7 @@ Canvas::on_parent_set()
 {
 	// parent canvas is important field,
 	// so assume that canvas replaced for layers
-	for(std::list<Handle>::iterator i = children().begin(); i != children().end(); ++i)
+	for(std::list<Handle>::iterator i = children_.begin(); i != children_.end(); ++i)
 		(*i)->on_parent_set();
 	for(iterator i = begin(); *i; ++i)
 		(*i)->on_canvas_set();
@@ -33,6 +33,8 @@
 
 #include <map>
 #include <list>
+#include <mutex>
+#include <unordered_map>
 #include <ETL/handle>
 #include <sigc++/signal.h>
 #include <sigc++/connection.h>
@@ -234,6 +236,13 @@ private:
 	/*!	\see children() */
 	Children children_;
 
+	//! Index of child Canvases by ID
+	/*!	\see find_child_canvas() */
+	mutable std::mutex children_index_mutex_;
+	mutable std::unordered_map<String, Children::const_iterator> children_index_;
+	mutable size_t children_index_size_;
+	mutable bool children_index_valid_;
+
 	//! Render Description for Canvas
 	/*!	\see rend_desc() */
 	RendDesc desc_;
@@ -461,7 +470,8 @@ public:
 	LooseHandle get_non_inline_ancestor()const;
 
 	//! Returns a list of all child canvases in this canvas
-	std::list<Handle> &children() { return children_; }
+	//! (list may be changed by caller, so index of children is rebuilt)
+	std::list<Handle> &children() { invalidate_children_index(); return children_; }
 
 	//! Returns a list of all child canvases in this canvas
 	const std::list<Handle> &children()const { return children_; }
@@ -697,6 +707,13 @@ public:
 private:
 	//! Sets parent and raises on_parent_set event
 	void set_parent(const Canvas::LooseHandle &parent);
+	//! Finds the immediate child Canvas by \a id in children_index_,
+	//! index is rebuilt when it is outdated
+	Children::const_iterator find_child_canvas(const String &id)const;
+	//! Adds the last child Canvas into children_index_
+	void add_child_canvas_to_index();
+	//! Marks children_index_ as outdated
+	void invalidate_children_index();
 	//! Adds a \layer to a group given by its \group string to the group
 	//! database
 	void add_group_pair(String group, etl::handle<Layer> layer);
@@ -0,0 +1,779 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file canvasbinary.cpp
+**	\brief Compact binary form of the canvas document
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+
+#include <glib.h>
+#include <glibmm/convert.h>
+#include <libxml++/libxml++.h>
+
+#include "canvasbinary.h"
+
+#include "general.h"
+#include "guid.h"
+#include "interpolation.h"
+#include "time.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+namespace {
+
+const char signature[4] = { 'S', 'I', 'F', 'B' };
+const uint32_t byte_order_mark = 0x01020304;
+
+//! File starts with the header, then follow arrays of values, waypoints, GUIDs,
+//! nodes, attributes, links, string offsets and the string data,
+//! all in the byte order of the writer.
+//! Arrays of records with doubles go first, so they are aligned in the mapped file.
+struct Header
+{
+	char signature[4];
+	uint32_t byte_order;
+	uint32_t version;
+	uint32_t node_count;
+	uint32_t attribute_count;
+	uint32_t value_count;
+	uint32_t waypoint_count;
+	uint32_t link_count;
+	uint32_t guid_count;
+	uint32_t string_count;
+	uint32_t string_data_size;
+	uint32_t reserved;
+};
+
+//! Links of the composite of <bline> point, only points with all of them are stored as records
+const char* const bline_point_links[] = {
+	"point", "width", "origin", "split", "t1", "t2", "split_radius", "split_angle" };
+
+/* === P R O C E D U R E S ================================================= */
+
+bool
+parse_interpolation(const std::string &x, int32_t &interpolation)
+{
+	if      (x == "halt")     interpolation = INTERPOLATION_HALT;
+	else if (x == "constant") interpolation = INTERPOLATION_CONSTANT;
+	else if (x == "linear")   interpolation = INTERPOLATION_LINEAR;
+	else if (x == "manual")   interpolation = INTERPOLATION_MANUAL;
+	else if (x == "auto")     interpolation = INTERPOLATION_TCB;
+	else if (x == "clamped")  interpolation = INTERPOLATION_CLAMPED;
+	else return false;
+	return true;
+}
+
+//! Collects child elements, returns false if there are other children than elements and whitespace
+bool
+get_child_elements(const xmlpp::Element *element, std::vector<xmlpp::Element*> &children)
+{
+	const xmlpp::Node::NodeList list = element->get_children();
+	for(xmlpp::Node::NodeList::const_iterator i = list.begin(); i != list.end(); ++i) {
+		if (xmlpp::Element *child = dynamic_cast<xmlpp::Element*>(*i))
+			children.push_back(child);
+		else
+		if (xmlpp::TextNode *text = dynamic_cast<xmlpp::TextNode*>(*i)) {
+			if (!text->is_white_space())
+				return false;
+		} else
+			return false;
+	}
+	return true;
+}
+
+//! Returns true if the element contains nothing but one text node
+bool
+get_text(const xmlpp::Element *element, std::string &text)
+{
+	const xmlpp::Node::NodeList list = element->get_children();
+	if (list.size() != 1)
+		return false;
+	const xmlpp::TextNode *node = dynamic_cast<const xmlpp::TextNode*>(list.front());
+	if (!node)
+		return false;
+	text = node->get_content();
+	return true;
+}
+
+class Writer
+{
+public:
+	std::vector<CanvasBinary::Node> nodes;
+	std::vector<CanvasBinary::Attribute> attributes;
+	std::vector<CanvasBinary::Value> values;
+	std::vector<CanvasBinary::Waypoint> waypoints;
+	std::vector<CanvasBinary::Link> links;
+	std::vector<CanvasBinary::Guid> guids;
+	std::vector<uint32_t> string_offsets;
+	std::string strings;
+	std::unordered_map<std::string, uint32_t> string_indices;
+	//! Frame rates of canvases which contain the current node, times are stored in seconds
+	std::vector<float> frame_rates;
+
+	uint32_t add_string(const std::string &x)
+	{
+		std::unordered_map<std::string, uint32_t>::const_iterator i = string_indices.find(x);
+		if (i != string_indices.end())
+			return i->second;
+		uint32_t index = (uint32_t)string_offsets.size();
+		string_offsets.push_back((uint32_t)strings.size());
+		strings.append(x.c_str(), x.size() + 1);
+		string_indices[x] = index;
+		return index;
+	}
+
+	void add_attribute(const std::string &name, const std::string &value)
+	{
+		CanvasBinary::Attribute attribute = { };
+		attribute.name = add_string(name);
+		if (name == "guid") {
+			GUID guid(value);
+			CanvasBinary::Guid record = { guid.get_hi(), guid.get_lo() };
+			attribute.type = CanvasBinary::ATTRIBUTE_GUID;
+			attribute.value = (uint32_t)guids.size();
+			guids.push_back(record);
+		} else {
+			attribute.type = CanvasBinary::ATTRIBUTE_STRING;
+			attribute.value = add_string(value);
+		}
+		attributes.push_back(attribute);
+	}
+
+	//! Adds the node of element, attributes with names from \a skip are not added
+	uint32_t begin_element(const xmlpp::Element *element, CanvasBinary::NodeType type, const char* const *skip = nullptr)
+	{
+		uint32_t index = (uint32_t)nodes.size();
+		CanvasBinary::Node node = { };
+		node.type = type;
+		node.name = add_string(element->get_name());
+		node.line = (uint32_t)std::max(0, element->get_line());
+		node.first_attribute = (uint32_t)attributes.size();
+		nodes.push_back(node);
+
+		const xmlpp::Element::AttributeList attribute_list = element->get_attributes();
+		for(xmlpp::Element::AttributeList::const_iterator i = attribute_list.begin(); i != attribute_list.end(); ++i) {
+			const std::string name = (*i)->get_name();
+			bool skipped = false;
+			for(const char* const *s = skip; s && *s && !skipped; ++s)
+				skipped = name == *s;
+			if (!skipped)
+				add_attribute(name, (*i)->get_value());
+		}
+		nodes[index].attribute_count = (uint32_t)attributes.size() - nodes[index].first_attribute;
+		return index;
+	}
+
+	void add_leaf(CanvasBinary::NodeType type, const std::string &content)
+	{
+		CanvasBinary::Node node = { };
+		node.type = type;
+		node.name = add_string(content);
+		node.first_attribute = (uint32_t)attributes.size();
+		node.end = (uint32_t)nodes.size() + 1;
+		nodes.push_back(node);
+	}
+
+	//! Stores element of basic type as Value record, returns false if it has unusual form
+	bool add_value(const xmlpp::Element *element)
+	{
+		static const char* const skip[] = { "value", "static", "interpolation", nullptr };
+
+		const std::string name = element->get_name();
+		CanvasBinary::Value value = { };
+		value.interpolation = INTERPOLATION_UNDEFINED;
+		if      (name == "real")    value.type = CanvasBinary::VALUE_REAL;
+		else if (name == "integer") value.type = CanvasBinary::VALUE_INTEGER;
+		else if (name == "bool")    value.type = CanvasBinary::VALUE_BOOL;
+		else if (name == "angle")   value.type = CanvasBinary::VALUE_ANGLE;
+		else if (name == "time")    value.type = CanvasBinary::VALUE_TIME;
+		else if (name == "vector")  value.type = CanvasBinary::VALUE_VECTOR;
+		else if (name == "color")   value.type = CanvasBinary::VALUE_COLOR;
+		else if (name == "string")  value.type = CanvasBinary::VALUE_STRING;
+		else return false;
+
+		const xmlpp::Attribute *number = element->get_attribute("value");
+		if (const xmlpp::Attribute *attribute = element->get_attribute("static")) {
+			if (attribute->get_value() == "true")
+				value.flags |= CanvasBinary::VALUE_STATIC;
+			else
+			if (attribute->get_value() != "false")
+				return false;
+		}
+		if (const xmlpp::Attribute *attribute = element->get_attribute("interpolation"))
+			if (!parse_interpolation(attribute->get_value(), value.interpolation))
+				return false;
+
+		switch(value.type) {
+		case CanvasBinary::VALUE_REAL:
+		case CanvasBinary::VALUE_INTEGER:
+		case CanvasBinary::VALUE_BOOL:
+		case CanvasBinary::VALUE_ANGLE:
+		case CanvasBinary::VALUE_TIME: {
+			if (!number || !element->get_children().empty())
+				return false;
+			const std::string x = number->get_value();
+			if (value.type == CanvasBinary::VALUE_INTEGER)
+				value.data[0] = atoi(x.c_str());
+			else
+			if (value.type == CanvasBinary::VALUE_BOOL) {
+				if (x != "true" && x != "false")
+					return false;
+				value.data[0] = x == "true" ? 1.0 : 0.0;
+			} else
+			if (value.type == CanvasBinary::VALUE_TIME) {
+				if (frame_rates.empty())
+					return false;
+				value.data[0] = Time(x, frame_rates.back());
+			} else
+				value.data[0] = atof(x.c_str());
+			break;
+		}
+		case CanvasBinary::VALUE_VECTOR:
+		case CanvasBinary::VALUE_COLOR: {
+			static const char* const vector_names[] = { "x", "y", nullptr };
+			static const char* const color_names[] = { "r", "g", "b", "a", nullptr };
+			const char* const *names = value.type == CanvasBinary::VALUE_VECTOR ? vector_names : color_names;
+			std::vector<xmlpp::Element*> children;
+			if (number || !get_child_elements(element, children))
+				return false;
+			int found = 0, count = 0;
+			for(std::vector<xmlpp::Element*>::const_iterator i = children.begin(); i != children.end(); ++i) {
+				int component = 0;
+				while(names[component] && (*i)->get_name() != names[component])
+					++component;
+				std::string x;
+				if ( !names[component]
+				  || (found & (1 << component))
+				  || !(*i)->get_attributes().empty()
+				  || !get_text(*i, x) )
+					return false;
+				found |= 1 << component;
+				value.data[component] = atof(x.c_str());
+			}
+			while(names[count])
+				++count;
+			if (found != (1 << count) - 1)
+				return false;
+			break;
+		}
+		case CanvasBinary::VALUE_STRING: {
+			std::string x;
+			if (number || (!element->get_children().empty() && !get_text(element, x)))
+				return false;
+			value.string = add_string(x);
+			break;
+		}
+		}
+
+		uint32_t index = begin_element(element, CanvasBinary::NODE_VALUE, skip);
+		nodes[index].first_record = (uint32_t)values.size();
+		nodes[index].record_count = 1;
+		nodes[index].end = index + 1;
+		values.push_back(value);
+		return true;
+	}
+
+	//! Stores waypoints of <animated> as Waypoint records, returns false if they have unusual form
+	bool add_animated(const xmlpp::Element *element)
+	{
+		std::vector<xmlpp::Element*> children;
+		if (element->get_name() != "animated" || frame_rates.empty() || !get_child_elements(element, children))
+			return false;
+
+		std::vector<CanvasBinary::Waypoint> records;
+		std::vector<xmlpp::Element*> contents;
+		for(std::vector<xmlpp::Element*>::const_iterator i = children.begin(); i != children.end(); ++i) {
+			std::vector<xmlpp::Element*> content;
+			if ((*i)->get_name() != "waypoint" || !(*i)->get_attribute("time") || !get_child_elements(*i, content) || content.size() != 1)
+				return false;
+
+			CanvasBinary::Waypoint waypoint = { };
+			const xmlpp::Element::AttributeList attribute_list = (*i)->get_attributes();
+			for(xmlpp::Element::AttributeList::const_iterator j = attribute_list.begin(); j != attribute_list.end(); ++j) {
+				const std::string name = (*j)->get_name();
+				const std::string x = (*j)->get_value();
+				if (name == "time")
+					waypoint.time = Time(x, frame_rates.back());
+				else
+				if (name == "tension")
+					{ waypoint.tension = atof(x.c_str()); waypoint.flags |= CanvasBinary::WAYPOINT_TENSION; }
+				else
+				if (name == "continuity")
+					{ waypoint.continuity = atof(x.c_str()); waypoint.flags |= CanvasBinary::WAYPOINT_CONTINUITY; }
+				else
+				if (name == "bias")
+					{ waypoint.bias = atof(x.c_str()); waypoint.flags |= CanvasBinary::WAYPOINT_BIAS; }
+				else
+				if (name == "temporal-tension")
+					{ waypoint.temporal_tension = atof(x.c_str()); waypoint.flags |= CanvasBinary::WAYPOINT_TEMPORAL_TENSION; }
+				else
+				if (name == "before" && parse_interpolation(x, waypoint.before))
+					waypoint.flags |= CanvasBinary::WAYPOINT_BEFORE;
+				else
+				if (name == "after" && parse_interpolation(x, waypoint.after))
+					waypoint.flags |= CanvasBinary::WAYPOINT_AFTER;
+				else
+					return false;
+			}
+			records.push_back(waypoint);
+			contents.push_back(content.front());
+		}
+
+		uint32_t index = begin_element(element, CanvasBinary::NODE_ANIMATED);
+		nodes[index].first_record = (uint32_t)waypoints.size();
+		nodes[index].record_count = (uint32_t)records.size();
+		waypoints.insert(waypoints.end(), records.begin(), records.end());
+		for(std::vector<xmlpp::Element*>::const_iterator i = contents.begin(); i != contents.end(); ++i)
+			add_node(*i);
+		nodes[index].end = (uint32_t)nodes.size();
+		return true;
+	}
+
+	//! Stores composite points of <bline> as Link records, returns false if they have unusual form
+	bool add_bline(const xmlpp::Element *element)
+	{
+		const int link_count = sizeof(bline_point_links)/sizeof(bline_point_links[0]);
+
+		std::vector<xmlpp::Element*> entries;
+		if (element->get_name() != "bline" || !get_child_elements(element, entries))
+			return false;
+
+		std::vector<CanvasBinary::Link> records;
+		std::vector<xmlpp::Element*> contents;
+		for(uint32_t point = 0; point < entries.size(); ++point) {
+			std::vector<xmlpp::Element*> composites, children;
+			if ( entries[point]->get_name() != "entry"
+			  || !entries[point]->get_attributes().empty()
+			  || !get_child_elements(entries[point], composites)
+			  || composites.size() != 1
+			  || composites.front()->get_name() != "composite"
+			  || composites.front()->get_attributes().size() != 1
+			  || !composites.front()->get_attribute("type")
+			  || composites.front()->get_attribute("type")->get_value() != "bline_point"
+			  || !get_child_elements(composites.front(), children)
+			  || children.size() != link_count )
+				return false;
+
+			int found = 0;
+			for(std::vector<xmlpp::Element*>::const_iterator i = children.begin(); i != children.end(); ++i) {
+				int link = 0;
+				while(link < link_count && (*i)->get_name() != bline_point_links[link])
+					++link;
+				std::vector<xmlpp::Element*> content;
+				if ( link == link_count
+				  || (found & (1 << link))
+				  || !(*i)->get_attributes().empty()
+				  || !get_child_elements(*i, content)
+				  || content.size() != 1 )
+					return false;
+				found |= 1 << link;
+
+				CanvasBinary::Link record = { point, add_string(bline_point_links[link]) };
+				records.push_back(record);
+				contents.push_back(content.front());
+			}
+		}
+
+		uint32_t index = begin_element(element, CanvasBinary::NODE_BLINE);
+		nodes[index].first_record = (uint32_t)links.size();
+		nodes[index].record_count = (uint32_t)records.size();
+		links.insert(links.end(), records.begin(), records.end());
+		for(std::vector<xmlpp::Element*>::const_iterator i = contents.begin(); i != contents.end(); ++i)
+			add_node(*i);
+		nodes[index].end = (uint32_t)nodes.size();
+		return true;
+	}
+
+	void add_node(const xmlpp::Node *x)
+	{
+		if (const xmlpp::Element *element = dynamic_cast<const xmlpp::Element*>(x)) {
+			const xmlpp::Attribute *fps = element->get_name() == "canvas" ? element->get_attribute("fps") : nullptr;
+			if (fps)
+				frame_rates.push_back(atof(fps->get_value().c_str()));
+
+			if (!add_value(element) && !add_animated(element) && !add_bline(element)) {
+				uint32_t index = begin_element(element, CanvasBinary::NODE_ELEMENT);
+				xmlpp::Node::NodeList children = element->get_children();
+				for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+					add_node(*i);
+				nodes[index].end = (uint32_t)nodes.size();
+			}
+
+			if (fps)
+				frame_rates.pop_back();
+		} else
+		if (const xmlpp::CommentNode *comment = dynamic_cast<const xmlpp::CommentNode*>(x)) {
+			add_leaf(CanvasBinary::NODE_COMMENT, comment->get_content());
+		} else
+		if (dynamic_cast<const xmlpp::TextNode*>(x) || dynamic_cast<const xmlpp::CdataNode*>(x)) {
+			// CanvasParser does not distinguish text and CDATA
+			add_leaf(CanvasBinary::NODE_TEXT, static_cast<const xmlpp::ContentNode*>(x)->get_content());
+		}
+		// entity references and processing instructions are not used by sif
+	}
+};
+
+void
+set_element_line(xmlpp::Element *element, uint32_t line)
+{
+	// xmlpp has no setter for it, but line numbers are needed for error messages of CanvasParser
+	element->cobj()->line = (unsigned short)std::min(line, (uint32_t)65535);
+}
+
+} // END of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+CanvasBinary::CanvasBinary():
+	mapped_file(nullptr),
+	nodes(nullptr),
+	node_count(0),
+	attributes(nullptr),
+	attribute_count(0),
+	values(nullptr),
+	value_count(0),
+	waypoints(nullptr),
+	waypoint_count(0),
+	links(nullptr),
+	link_count(0),
+	guids(nullptr),
+	guid_count(0),
+	string_offsets(nullptr),
+	string_count(0),
+	strings(nullptr)
+{ }
+
+CanvasBinary::~CanvasBinary()
+	{ close(); }
+
+void
+CanvasBinary::close()
+{
+	nodes = nullptr;
+	node_count = 0;
+	attributes = nullptr;
+	attribute_count = 0;
+	values = nullptr;
+	value_count = 0;
+	waypoints = nullptr;
+	waypoint_count = 0;
+	links = nullptr;
+	link_count = 0;
+	guids = nullptr;
+	guid_count = 0;
+	string_offsets = nullptr;
+	string_count = 0;
+	strings = nullptr;
+	if (mapped_file)
+		g_mapped_file_unref(mapped_file);
+	mapped_file = nullptr;
+	buffer.clear();
+	buffer.shrink_to_fit();
+}
+
+bool
+CanvasBinary::init(const char *data, size_t size)
+{
+	if (!data || size < sizeof(Header))
+		return false;
+
+	Header header;
+	memcpy(&header, data, sizeof(header));
+	if ( memcmp(header.signature, signature, sizeof(signature))
+	  || header.byte_order != byte_order_mark
+	  || header.version != version
+	  || !header.node_count
+	  || !header.string_count
+	  || !header.string_data_size )
+		return false;
+
+	const uint64_t values_pos = sizeof(Header);
+	const uint64_t waypoints_pos = values_pos + uint64_t(header.value_count)*sizeof(Value);
+	const uint64_t guids_pos = waypoints_pos + uint64_t(header.waypoint_count)*sizeof(Waypoint);
+	const uint64_t nodes_pos = guids_pos + uint64_t(header.guid_count)*sizeof(Guid);
+	const uint64_t attributes_pos = nodes_pos + uint64_t(header.node_count)*sizeof(Node);
+	const uint64_t links_pos = attributes_pos + uint64_t(header.attribute_count)*sizeof(Attribute);
+	const uint64_t offsets_pos = links_pos + uint64_t(header.link_count)*sizeof(Link);
+	const uint64_t strings_pos = offsets_pos + uint64_t(header.string_count)*sizeof(uint32_t);
+	if (strings_pos + header.string_data_size != size)
+		return false;
+
+	const Value *file_values = reinterpret_cast<const Value*>(data + values_pos);
+	const Waypoint *file_waypoints = reinterpret_cast<const Waypoint*>(data + waypoints_pos);
+	const Guid *file_guids = reinterpret_cast<const Guid*>(data + guids_pos);
+	const Node *file_nodes = reinterpret_cast<const Node*>(data + nodes_pos);
+	const Attribute *file_attributes = reinterpret_cast<const Attribute*>(data + attributes_pos);
+	const Link *file_links = reinterpret_cast<const Link*>(data + links_pos);
+	const uint32_t *file_offsets = reinterpret_cast<const uint32_t*>(data + offsets_pos);
+	const char *file_strings = data + strings_pos;
+
+	// every string must be terminated by zero
+	if (file_strings[header.string_data_size - 1])
+		return false;
+	for(uint32_t i = 0; i < header.string_count; ++i)
+		if ( file_offsets[i] >= header.string_data_size
+		  || (file_offsets[i] && file_strings[file_offsets[i] - 1]) )
+			return false;
+
+	for(uint32_t i = 0; i < header.attribute_count; ++i)
+		if ( file_attributes[i].name >= header.string_count
+		  || file_attributes[i].type > ATTRIBUTE_GUID
+		  || file_attributes[i].value >= (file_attributes[i].type == ATTRIBUTE_GUID ? header.guid_count : header.string_count) )
+			return false;
+
+	for(uint32_t i = 0; i < header.value_count; ++i)
+		if ( file_values[i].type < VALUE_REAL || file_values[i].type > VALUE_STRING
+		  || file_values[i].interpolation < INTERPOLATION_TCB || file_values[i].interpolation > INTERPOLATION_CLAMPED
+		  || (file_values[i].type == VALUE_STRING && file_values[i].string >= header.string_count) )
+			return false;
+
+	for(uint32_t i = 0; i < header.waypoint_count; ++i)
+		if ( file_waypoints[i].before < INTERPOLATION_TCB || file_waypoints[i].before > INTERPOLATION_CLAMPED
+		  || file_waypoints[i].after < INTERPOLATION_TCB || file_waypoints[i].after > INTERPOLATION_CLAMPED )
+			return false;
+
+	for(uint32_t i = 0; i < header.link_count; ++i)
+		if (file_links[i].name >= header.string_count)
+			return false;
+
+	// root must be the element which contains all other nodes,
+	// and every subtree must be inside of the subtree of its parent
+	if (file_nodes[0].type != NODE_ELEMENT || file_nodes[0].end != header.node_count)
+		return false;
+	std::vector<uint32_t> ends;
+	for(uint32_t i = 0; i < header.node_count; ++i) {
+		const Node &node = file_nodes[i];
+		if ( node.type < NODE_ELEMENT || node.type > NODE_BLINE
+		  || node.name >= header.string_count
+		  || uint64_t(node.first_attribute) + node.attribute_count > header.attribute_count
+		  || node.end <= i
+		  || node.end > header.node_count )
+			return false;
+		if ((node.type == NODE_TEXT || node.type == NODE_COMMENT) && (node.end != i + 1 || node.attribute_count))
+			return false;
+		while(!ends.empty() && ends.back() <= i)
+			ends.pop_back();
+		if (!ends.empty() && node.end > ends.back())
+			return false;
+		ends.push_back(node.end);
+
+		// records must exist, and every child of <animated> and <bline> must be the value of one record
+		uint32_t records = 0;
+		switch(node.type) {
+		case NODE_VALUE:    records = header.value_count;    break;
+		case NODE_ANIMATED: records = header.waypoint_count; break;
+		case NODE_BLINE:    records = header.link_count;     break;
+		}
+		if (uint64_t(node.first_record) + node.record_count > records)
+			return false;
+		if (node.type == NODE_VALUE && (node.end != i + 1 || node.record_count != 1))
+			return false;
+		if (node.type == NODE_ANIMATED || node.type == NODE_BLINE) {
+			uint32_t count = 0;
+			for(uint32_t j = i + 1; j < node.end; j = file_nodes[j].end, ++count)
+				if ( file_nodes[j].end <= j || file_nodes[j].end > node.end
+				  || file_nodes[j].type == NODE_TEXT || file_nodes[j].type == NODE_COMMENT )
+					return false;
+			if (count != node.record_count)
+				return false;
+		}
+		if (node.type == NODE_BLINE)
+			for(uint32_t j = 0; j < node.record_count; ++j) {
+				uint32_t point = file_links[node.first_record + j].point;
+				uint32_t prev = j ? file_links[node.first_record + j - 1].point : 0;
+				if (point != prev && point != prev + 1)
+					return false;
+				if (!j && point)
+					return false;
+			}
+	}
+
+	nodes = file_nodes;
+	node_count = header.node_count;
+	attributes = file_attributes;
+	attribute_count = header.attribute_count;
+	values = file_values;
+	value_count = header.value_count;
+	waypoints = file_waypoints;
+	waypoint_count = header.waypoint_count;
+	links = file_links;
+	link_count = header.link_count;
+	guids = file_guids;
+	guid_count = header.guid_count;
+	string_offsets = file_offsets;
+	string_count = header.string_count;
+	strings = file_strings;
+	return true;
+}
+
+bool
+CanvasBinary::open(const FileSystem::Identifier &identifier)
+{
+	close();
+
+	// map the file if it is in the native file system
+	String uri = identifier.file_system ? identifier.file_system->get_real_uri(identifier.filename) : String();
+	if (!uri.empty()) {
+		std::string filename;
+		try { filename = Glib::filename_from_uri(uri); } catch(...) { }
+		GError *error = nullptr;
+		if (!filename.empty())
+			mapped_file = g_mapped_file_new(filename.c_str(), FALSE, &error);
+		if (error)
+			g_error_free(error);
+		if (mapped_file) {
+			if (init(g_mapped_file_get_contents(mapped_file), g_mapped_file_get_length(mapped_file)))
+				return true;
+			close();
+			return false;
+		}
+	}
+
+	// or read it into memory
+	FileSystem::ReadStream::Handle stream = identifier.get_read_stream();
+	if (!stream)
+		return false;
+	buffer.assign(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+	stream.reset();
+	if (init(buffer.data(), buffer.size()))
+		return true;
+	close();
+	return false;
+}
+
+const CanvasBinary::Guid*
+CanvasBinary::find_guid(const Node &node) const
+{
+	for(uint32_t i = node.first_attribute; i < node.first_attribute + node.attribute_count; ++i)
+		if (attributes[i].type == ATTRIBUTE_GUID)
+			return &guids[attributes[i].value];
+	return nullptr;
+}
+
+void
+CanvasBinary::fill_element(xmlpp::Element *element, uint32_t index, Placeholders &placeholders) const
+{
+	const Node &node = nodes[index];
+	set_element_line(element, node.line);
+
+	bool placeholder = node.type != NODE_ELEMENT;
+	for(uint32_t i = node.first_attribute; i < node.first_attribute + node.attribute_count; ++i) {
+		const Attribute &attribute = attributes[i];
+		if (attribute.type == ATTRIBUTE_GUID)
+			placeholder = true;
+		else
+			element->set_attribute(get_string(attribute.name), get_string(attribute.value));
+	}
+
+	if (node.type == NODE_ELEMENT) {
+		if (!strcmp(get_string(node.name), "canvas")) {
+			placeholder = true;
+		} else {
+			for(uint32_t i = index + 1; i < node.end; i = nodes[i].end) {
+				const Node &child = nodes[i];
+				switch(child.type) {
+				case NODE_TEXT:
+					element->add_child_text(get_string(child.name));
+					break;
+				case NODE_COMMENT:
+					element->add_child_comment(get_string(child.name));
+					break;
+				default:
+					fill_element(element->add_child(get_string(child.name)), i, placeholders);
+					break;
+				}
+			}
+		}
+	}
+
+	if (placeholder)
+		placeholders[element] = index;
+}
+
+xmlpp::Element*
+CanvasBinary::materialize(xmlpp::Document &document, uint32_t index, Placeholders &placeholders) const
+{
+	assert(index < node_count && nodes[index].type != NODE_TEXT && nodes[index].type != NODE_COMMENT);
+	xmlpp::Element *element = document.create_root_node(get_string(nodes[index].name));
+	fill_element(element, index, placeholders);
+	return element;
+}
+
+bool
+CanvasBinary::write(const xmlpp::Document &document, std::ostream &stream)
+{
+	xmlpp::Element *root = document.get_root_node();
+	if (!root)
+		return false;
+
+	// numbers are converted like in CanvasParser
+	ChangeLocale change_locale(LC_NUMERIC, "C");
+
+	Writer writer;
+	writer.add_node(root);
+
+	Header header = { };
+	memcpy(header.signature, signature, sizeof(signature));
+	header.byte_order = byte_order_mark;
+	header.version = version;
+	header.node_count = (uint32_t)writer.nodes.size();
+	header.attribute_count = (uint32_t)writer.attributes.size();
+	header.value_count = (uint32_t)writer.values.size();
+	header.waypoint_count = (uint32_t)writer.waypoints.size();
+	header.link_count = (uint32_t)writer.links.size();
+	header.guid_count = (uint32_t)writer.guids.size();
+	header.string_count = (uint32_t)writer.string_offsets.size();
+	header.string_data_size = (uint32_t)writer.strings.size();
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.write(reinterpret_cast<const char*>(writer.values.data()), writer.values.size()*sizeof(Value));
+	stream.write(reinterpret_cast<const char*>(writer.waypoints.data()), writer.waypoints.size()*sizeof(Waypoint));
+	stream.write(reinterpret_cast<const char*>(writer.guids.data()), writer.guids.size()*sizeof(Guid));
+	stream.write(reinterpret_cast<const char*>(writer.nodes.data()), writer.nodes.size()*sizeof(Node));
+	stream.write(reinterpret_cast<const char*>(writer.attributes.data()), writer.attributes.size()*sizeof(Attribute));
+	stream.write(reinterpret_cast<const char*>(writer.links.data()), writer.links.size()*sizeof(Link));
+	stream.write(reinterpret_cast<const char*>(writer.string_offsets.data()), writer.string_offsets.size()*sizeof(uint32_t));
+	stream.write(writer.strings.data(), writer.strings.size());
+	return (bool)stream;
+}
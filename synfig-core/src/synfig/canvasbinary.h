@@ -0,0 +1,250 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file canvasbinary.h
+**	\brief Compact binary form of the canvas document
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_CANVASBINARY_H
+#define __SYNFIG_CANVASBINARY_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "filesystem.h"
+#include "string.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace xmlpp { class Document; class Element; };
+typedef struct _GMappedFile GMappedFile;
+
+namespace synfig {
+
+/*!	\class CanvasBinary
+**	\brief Reads and writes .sifb files
+**
+**	A .sifb file stores the tree of elements, attributes, text and comments
+**	of the .sif document, except the content which is parsed most often:
+**	values of basic types, waypoints of <animated> and points of <bline>
+**	are stored in flat arrays of typed records, and GUIDs are stored as numbers.
+**	CanvasParser reads typed records directly, without parsing of text.
+**	All strings (names, values, text) are stored once in the string table,
+**	nodes and attributes are stored in flat arrays in document order.
+**	Every node knows the end of its subtree, so subtrees are skipped
+**	or materialized into DOM one by one, without building the whole document.
+**	Files from the native file system are memory-mapped.
+*/
+class CanvasBinary
+{
+public:
+	static const uint32_t version = 2;
+
+	enum NodeType
+	{
+		NODE_ELEMENT  = 1,
+		NODE_TEXT     = 2,
+		NODE_COMMENT  = 3,
+		//! Element of the value of basic type, its content is the Value record
+		NODE_VALUE    = 4,
+		//! <animated> element, its children are values of Waypoint records
+		NODE_ANIMATED = 5,
+		//! <bline> element, its children are values of Link records of composite points
+		NODE_BLINE    = 6
+	};
+
+	struct Node
+	{
+		uint32_t type;
+		//! String index of name of element or content of text and comment
+		uint32_t name;
+		uint32_t line;
+		uint32_t first_attribute;
+		uint32_t attribute_count;
+		//! Index of the node after the last descendant of this node
+		uint32_t end;
+		//! Index of the first record of NODE_VALUE, NODE_ANIMATED or NODE_BLINE
+		uint32_t first_record;
+		uint32_t record_count;
+	};
+
+	enum AttributeType
+	{
+		ATTRIBUTE_STRING = 0,
+		//! Value is the index of Guid record
+		ATTRIBUTE_GUID   = 1
+	};
+
+	struct Attribute
+	{
+		uint32_t type;
+		uint32_t name;
+		uint32_t value;
+	};
+
+	enum ValueType
+	{
+		VALUE_REAL    = 1,
+		VALUE_INTEGER = 2,
+		VALUE_BOOL    = 3,
+		//! Angle in degrees
+		VALUE_ANGLE   = 4,
+		//! Time in seconds
+		VALUE_TIME    = 5,
+		VALUE_VECTOR  = 6,
+		VALUE_COLOR   = 7,
+		VALUE_STRING  = 8
+	};
+
+	enum ValueFlags
+	{
+		VALUE_STATIC = 1
+	};
+
+	struct Value
+	{
+		uint32_t type;
+		uint32_t flags;
+		//! Interpolation, INTERPOLATION_UNDEFINED if it is not set
+		int32_t interpolation;
+		//! String index of VALUE_STRING
+		uint32_t string;
+		//! Components of number, vector or color
+		double data[4];
+	};
+
+	enum WaypointFlags
+	{
+		WAYPOINT_TENSION          = 1,
+		WAYPOINT_CONTINUITY       = 2,
+		WAYPOINT_BIAS             = 4,
+		WAYPOINT_TEMPORAL_TENSION = 8,
+		WAYPOINT_BEFORE           = 16,
+		WAYPOINT_AFTER            = 32
+	};
+
+	struct Waypoint
+	{
+		//! Time in seconds
+		double time;
+		double tension;
+		double continuity;
+		double bias;
+		double temporal_tension;
+		int32_t before;
+		int32_t after;
+		uint32_t flags;
+		uint32_t reserved;
+	};
+
+	//! Link of the composite point of <bline>
+	struct Link
+	{
+		//! Index of point in the <bline>, links of one point follow each other
+		uint32_t point;
+		//! String index of name of link
+		uint32_t name;
+	};
+
+	struct Guid
+	{
+		uint64_t hi;
+		uint64_t lo;
+	};
+
+	//! Elements created by materialize() with the indices of their nodes.
+	//! Content of these elements is not materialized and must be read from records.
+	typedef std::unordered_map<const xmlpp::Element*, uint32_t> Placeholders;
+
+private:
+	GMappedFile *mapped_file;
+	std::vector<char> buffer;
+
+	const Node *nodes;
+	uint32_t node_count;
+	const Attribute *attributes;
+	uint32_t attribute_count;
+	const Value *values;
+	uint32_t value_count;
+	const Waypoint *waypoints;
+	uint32_t waypoint_count;
+	const Link *links;
+	uint32_t link_count;
+	const Guid *guids;
+	uint32_t guid_count;
+	const uint32_t *string_offsets;
+	uint32_t string_count;
+	const char *strings;
+
+	bool init(const char *data, size_t size);
+
+	void fill_element(xmlpp::Element *element, uint32_t index, Placeholders &placeholders) const;
+
+public:
+	CanvasBinary();
+	~CanvasBinary();
+
+	CanvasBinary(const CanvasBinary&) = delete;
+	CanvasBinary& operator=(const CanvasBinary&) = delete;
+
+	//! Opens and validates the file, returns false if file can not be read or it is not a valid .sifb
+	bool open(const FileSystem::Identifier &identifier);
+	void close();
+	bool is_open() const { return node_count != 0; }
+
+	uint32_t get_node_count() const { return node_count; }
+	const Node& get_node(uint32_t index) const { return nodes[index]; }
+	const Attribute& get_attribute(uint32_t index) const { return attributes[index]; }
+	const Value& get_value(uint32_t index) const { return values[index]; }
+	const Waypoint& get_waypoint(uint32_t index) const { return waypoints[index]; }
+	const Link& get_link(uint32_t index) const { return links[index]; }
+	const Guid& get_guid(uint32_t index) const { return guids[index]; }
+	const char* get_string(uint32_t index) const { return strings + string_offsets[index]; }
+
+	//! Returns the "guid" attribute of the node or null
+	const Guid* find_guid(const Node &node) const;
+
+	//! Creates the element \a index with its descendants as root of the \a document.
+	//! Elements of NODE_VALUE, NODE_ANIMATED, NODE_BLINE, elements with GUID
+	//! and <canvas> elements are added to \a placeholders.
+	//! Typed content, GUIDs and children of <canvas> are not materialized,
+	//! so canvases are materialized child by child when they are parsed.
+	xmlpp::Element* materialize(xmlpp::Document &document, uint32_t index, Placeholders &placeholders) const;
+
+	//! Writes the \a document in binary form
+	static bool write(const xmlpp::Document &document, std::ostream &stream);
+}; // END of class CanvasBinary
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
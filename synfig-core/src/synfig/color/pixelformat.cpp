@@ -76,6 +76,21 @@ namespace {
 	}
 
 
+	ColorReal clamp(ColorReal c)
+		{ return c > ColorReal(0.0) ? (c < ColorReal(1.0) ? c : ColorReal(1.0)): ColorReal(0.0); }
+
+
+	//! Same as Color::clamped() for one channel, but may be inlined and vectorized by compiler
+	inline unsigned char
+	clamp_to_byte(ColorReal c, ColorReal nan_value)
+	{
+		c = c != c ? nan_value : c;
+		c = c < ColorReal(0.0) ? ColorReal(0.0) : c;
+		c = c > ColorReal(1.0) ? ColorReal(1.0) : c;
+		return (unsigned char)(c*ColorReal(255.9));
+	}
+
+
 	template<
 		bool bgr,
 		bool alpha,
@@ -86,35 +101,29 @@ namespace {
 		const Color &src,
 		const Gamma* )
 	{
-		const Color color = src.clamped();
-
 		// put alpha before color channels if need
 		if (alpha && alpha_start)
-			*dst = (unsigned char)(color.get_a()*ColorReal(255.9)), ++dst;
+			*dst = clamp_to_byte(src.get_a(), ColorReal(1.0)), ++dst;
 
 		// put color channels
 		if (bgr) {
-			*dst = (unsigned char)(color.get_b()*ColorReal(255.9)), ++dst;
-			*dst = (unsigned char)(color.get_g()*ColorReal(255.9)), ++dst;
-			*dst = (unsigned char)(color.get_r()*ColorReal(255.9)), ++dst;
+			*dst = clamp_to_byte(src.get_b(), ColorReal(0.5)), ++dst;
+			*dst = clamp_to_byte(src.get_g(), ColorReal(0.5)), ++dst;
+			*dst = clamp_to_byte(src.get_r(), ColorReal(0.5)), ++dst;
 		} else {
-			*dst = (unsigned char)(color.get_r()*ColorReal(255.9)), ++dst;
-			*dst = (unsigned char)(color.get_g()*ColorReal(255.9)), ++dst;
-			*dst = (unsigned char)(color.get_b()*ColorReal(255.9)), ++dst;
+			*dst = clamp_to_byte(src.get_r(), ColorReal(0.5)), ++dst;
+			*dst = clamp_to_byte(src.get_g(), ColorReal(0.5)), ++dst;
+			*dst = clamp_to_byte(src.get_b(), ColorReal(0.5)), ++dst;
 		}
 
 		// put alpha after color channels if need
 		if (alpha && !alpha_start)
-			*dst = (unsigned char)(color.get_a()*ColorReal(255.9)), ++dst;
+			*dst = clamp_to_byte(src.get_a(), ColorReal(1.0)), ++dst;
 
 		return dst;
 	}
 
 
-	ColorReal clamp(ColorReal c)
-		{ return c > ColorReal(0.0) ? (c < ColorReal(1.0) ? c : ColorReal(1.0)): ColorReal(0.0); }
-
-
 	template<
 		bool with_gamma,
 		bool gray,
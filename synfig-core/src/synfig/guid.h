@@ -65,6 +65,9 @@ public:
 
 	GUID(const String& str);
 
+	GUID(uint64_t hi, uint64_t lo)
+		{ data.u_64.a = hi; data.u_64.b = lo; }
+
 	static GUID zero() { return GUID(0); }
 	static GUID hasher(const String& str);
 	static GUID hasher(int i);
@@ -612,7 +612,7 @@ Layer::set_time(IndependentContext context, Time time)const
 	Layer::DynamicParamList::const_iterator iter;
 	// For each parameter of the layer sets the time by the operator()(time)
 	for(iter=dynamic_param_list().begin();iter!=dynamic_param_list().end();iter++)
-		params[iter->first]=(*iter->second)(time);
+		params[iter->first]=iter->second->get_value_cached(time);
 	// Sets the modified parameter list to the current context layer
 	const_cast<Layer*>(this)->set_param_list(params);
 
@@ -175,32 +175,74 @@ Layer_SkeletonDeformation::prepare_mask()
 	this->mask = mask;
 }
 
-struct Layer_SkeletonDeformation::GridPoint {
-	Vector initial_position;
-	Vector summary_position;
-	Real summary_depth;
-	Real summary_weight;
-	Real average_depth;
-	bool used;
-
-	inline GridPoint():
-		summary_depth(0.0), summary_weight(0.0), average_depth(0.0), used(false) { }
-	inline explicit GridPoint(const Vector &initial_position):
-		initial_position(initial_position), summary_depth(0.0), summary_weight(0.0), average_depth(0.0), used(false) { }
-	static bool compare_triagles(
-		const std::pair<Real, rendering::Mesh::Triangle> &a,
-		const std::pair<Real, rendering::Mesh::Triangle> &b )
+struct Layer_SkeletonDeformation::BindPose {
+	// grid and rest shapes of bones, weights are valid while they are not changed
+	Point grid_p0;
+	Point grid_p1;
+	int grid_side_count_x;
+	int grid_side_count_y;
+	std::vector<Bone::Shape> shapes;
+
+	//! transformations into the space of the rest bones
+	std::vector<Matrix> into_bone;
+	//! initial positions of grid vertices
+	std::vector<Vector> positions;
+	//! influences of vertex i are [offsets[i], offsets[i+1]), they are ordered by bones
+	std::vector<int> offsets;
+	std::vector<int> bones;
+	std::vector<Real> weights;
+	std::vector<Real> summary_weights;
+	std::vector<bool> used;
+
+	rendering::Contour::Handle mask;
+
+	//! triangles sorted by depth, they are sorted again only when depths of bones are changed
+	std::vector<Real> depths;
+	std::vector<rendering::Mesh::Triangle> triangles;
+	bool triangles_valid;
+
+	BindPose(): grid_side_count_x(), grid_side_count_y(), triangles_valid() { }
+
+	static bool equal_shapes(const Bone::Shape &a, const Bone::Shape &b)
 	{
-		return a.first < b.first ? false
-			 : b.first < a.first ? true
-			 : a.second.vertices[0] < b.second.vertices[0] ? true
-			 : b.second.vertices[0] < a.second.vertices[0] ? false
-			 : a.second.vertices[1] < b.second.vertices[1] ? true
-			 : b.second.vertices[1] < a.second.vertices[1] ? false
-			 : a.second.vertices[2] < b.second.vertices[2];
+		return a.p0[0] == b.p0[0] && a.p0[1] == b.p0[1] && a.r0 == b.r0
+		    && a.p1[0] == b.p1[0] && a.p1[1] == b.p1[1] && a.r1 == b.r1;
+	}
+
+	bool is_valid_for(
+		const Point &grid_p0,
+		const Point &grid_p1,
+		int grid_side_count_x,
+		int grid_side_count_y,
+		const std::vector<Bone::Shape> &shapes ) const
+	{
+		if ( this->grid_p0[0] != grid_p0[0] || this->grid_p0[1] != grid_p0[1]
+		  || this->grid_p1[0] != grid_p1[0] || this->grid_p1[1] != grid_p1[1]
+		  || this->grid_side_count_x != grid_side_count_x
+		  || this->grid_side_count_y != grid_side_count_y
+		  || this->shapes.size() != shapes.size() )
+			return false;
+		for(size_t i = 0; i < shapes.size(); ++i)
+			if (!equal_shapes(this->shapes[i], shapes[i]))
+				return false;
+		return true;
 	}
 };
 
+bool
+Layer_SkeletonDeformation::compare_triangles(
+	const std::pair<Real, rendering::Mesh::Triangle> &a,
+	const std::pair<Real, rendering::Mesh::Triangle> &b )
+{
+	return a.first < b.first ? false
+		 : b.first < a.first ? true
+		 : a.second.vertices[0] < b.second.vertices[0] ? true
+		 : b.second.vertices[0] < a.second.vertices[0] ? false
+		 : a.second.vertices[1] < b.second.vertices[1] ? true
+		 : b.second.vertices[1] < a.second.vertices[1] ? false
+		 : a.second.vertices[2] < b.second.vertices[2];
+}
+
 Real Layer_SkeletonDeformation::distance_to_line(const Vector &p0, const Vector &p1, const Vector &x)
 {
 	const Real epsilon = 1e-10;
@@ -223,11 +265,11 @@ Real Layer_SkeletonDeformation::distance_to_line(const Vector &p0, const Vector
 }
 
 void
-Layer_SkeletonDeformation::prepare_mesh()
+Layer_SkeletonDeformation::prepare_bind_pose(const std::vector<Bone::Shape> &shapes)
 {
 	static const Real precision = 1e-10;
 
-	rendering::Mesh::Handle mesh(new rendering::Mesh());
+	std::shared_ptr<BindPose> pose = std::make_shared<BindPose>();
 
 	// TODO: build grid with dynamic size
 
@@ -240,107 +282,189 @@ Layer_SkeletonDeformation::prepare_mesh()
 	const Real grid_step_y = (grid_p1[1] - grid_p0[1]) / (Real)(grid_side_count_y - 1);
 	const Real grid_step_diagonal = sqrt(grid_step_x*grid_step_x + grid_step_y*grid_step_y);
 
+	pose->grid_p0 = grid_p0;
+	pose->grid_p1 = grid_p1;
+	pose->grid_side_count_x = grid_side_count_x;
+	pose->grid_side_count_y = grid_side_count_y;
+	pose->shapes = shapes;
+
 	// build grid
-	std::vector<GridPoint> grid;
-	grid.reserve(grid_side_count_x * grid_side_count_y);
+	const int count = grid_side_count_x * grid_side_count_y;
+	pose->positions.reserve(count);
 	for(int j = 0; j < grid_side_count_y; ++j)
 		for(int i = 0; i < grid_side_count_x; ++i)
-			grid.push_back(GridPoint(Vector(
+			pose->positions.push_back(Vector(
 				grid_p0[0] + i*grid_step_x,
-				grid_p0[1] + j*grid_step_y )));
+				grid_p0[1] + j*grid_step_y ));
+
+	// calculate weights of bones
+	std::vector< std::vector< std::pair<int, Real> > > influences(shapes.size());
+	pose->into_bone.reserve(shapes.size());
+	for(size_t b = 0; b < shapes.size(); ++b)
+	{
+		const Bone::Shape &shape0 = shapes[b];
+		Bone::Shape expandedShape0 = shape0;
+		expandedShape0.r0 += 2.0*grid_step_diagonal;
+		expandedShape0.r1 += 2.0*grid_step_diagonal;
+
+		Matrix into_bone(
+			shape0.p1[0] - shape0.p0[0], shape0.p1[1] - shape0.p0[1], 0.0,
+			shape0.p0[1] - shape0.p1[1], shape0.p1[0] - shape0.p0[0], 0.0,
+			shape0.p0[0], shape0.p0[1], 1.0
+		);
+		into_bone.invert();
+		pose->into_bone.push_back(into_bone);
+
+		for(int v = 0; v < count; ++v)
+		{
+			const Vector &position = pose->positions[v];
+			Real percent = Bone::distance_to_shape_center_percent(expandedShape0, position);
+			if (percent > precision) {
+				Real distance = distance_to_line(shape0.p0, shape0.p1, position);
+				if (distance < precision) distance = precision;
+				Real weight =
+					percent/(distance*distance);
+					// 1.0/distance;
+					// 1.0/(distance*distance);
+					// 1.0/(distance*distance*distance);
+					// exp(-4.0*distance);
+				influences[b].push_back(std::make_pair(v, weight));
+			}
+		}
+	}
 
-	// apply deformation
+	// pack influences by vertices, keeping the order of bones
+	pose->offsets.assign(count + 1, 0);
+	for(size_t b = 0; b < influences.size(); ++b)
+		for(std::vector< std::pair<int, Real> >::const_iterator i = influences[b].begin(); i != influences[b].end(); ++i)
+			++pose->offsets[i->first + 1];
+	for(int v = 0; v < count; ++v)
+		pose->offsets[v + 1] += pose->offsets[v];
+
+	pose->bones.resize(pose->offsets.back());
+	pose->weights.resize(pose->offsets.back());
+	pose->summary_weights.assign(count, 0.0);
+	pose->used.assign(count, false);
+	std::vector<int> positions(pose->offsets.begin(), pose->offsets.end() - 1);
+	for(size_t b = 0; b < influences.size(); ++b)
+		for(std::vector< std::pair<int, Real> >::const_iterator i = influences[b].begin(); i != influences[b].end(); ++i) {
+			int k = positions[i->first]++;
+			pose->bones[k] = (int)b;
+			pose->weights[k] = i->second;
+			pose->summary_weights[i->first] += i->second;
+			pose->used[i->first] = true;
+		}
+
+	prepare_mask();
+	pose->mask = mask;
+	bind_pose = pose;
+}
+
+void
+Layer_SkeletonDeformation::prepare_mesh()
+{
+	static const Real precision = 1e-10;
+
+	std::vector<const BonePair*> bone_pairs;
+	std::vector<Bone::Shape> shapes;
 	if (param_bones.can_get(ValueBase::List()))
 	{
 		const ValueBase::List &bones = param_bones.get_list();
 		for(ValueBase::List::const_iterator i = bones.begin(); i != bones.end(); ++i)
-		{
 			if (i->can_get(BonePair()))
 			{
 				const BonePair &bone_pair = i->get(BonePair());
-				Bone::Shape shape0 = bone_pair.first.get_shape();
-				Bone::Shape shape1 = bone_pair.second.get_shape();
-				Bone::Shape expandedShape0 = shape0;
-				expandedShape0.r0 += 2.0*grid_step_diagonal;
-				expandedShape0.r1 += 2.0*grid_step_diagonal;
-				Real depth = bone_pair.second.get_depth();
-
-				Matrix into_bone(
-					shape0.p1[0] - shape0.p0[0], shape0.p1[1] - shape0.p0[1], 0.0,
-					shape0.p0[1] - shape0.p1[1], shape0.p1[0] - shape0.p0[0], 0.0,
-					shape0.p0[0], shape0.p0[1], 1.0
-				);
-				into_bone.invert();
-				Matrix from_bone(
-					shape1.p1[0] - shape1.p0[0], shape1.p1[1] - shape1.p0[1], 0.0,
-					shape1.p0[1] - shape1.p1[1], shape1.p1[0] - shape1.p0[0], 0.0,
-					shape1.p0[0], shape1.p0[1], 1.0
-				);
-				Matrix matrix = from_bone * into_bone;
-
-				for(std::vector<GridPoint>::iterator j = grid.begin(); j != grid.end(); ++j)
-				{
-					Real percent = Bone::distance_to_shape_center_percent(expandedShape0, j->initial_position);
-					if (percent > precision) {
-						Real distance = distance_to_line(shape0.p0, shape0.p1, j->initial_position);
-						if (distance < precision) distance = precision;
-						Real weight =
-							percent/(distance*distance);
-							// 1.0/distance;
-							// 1.0/(distance*distance);
-							// 1.0/(distance*distance*distance);
-							// exp(-4.0*distance);
-						j->summary_position += matrix.get_transformed(j->initial_position) * weight;
-						j->summary_depth += depth * weight;
-						j->summary_weight += weight;
-						j->used = true;
-					}
-				}
+				bone_pairs.push_back(&bone_pair);
+				shapes.push_back(bone_pair.first.get_shape());
 			}
-		}
 	}
 
-	// build vertices
-	mesh->vertices.reserve(grid.size());
-	for(std::vector<GridPoint>::iterator i = grid.begin(); i != grid.end(); ++i) {
-		Vector average_position = i->summary_weight > precision ? i->summary_position/i->summary_weight : i->initial_position;
-		i->average_depth = i->summary_weight > precision ? i->summary_depth/i->summary_weight : 0.0;
+	const int grid_side_count_x = std::max(1, param_x_subdivisions.get(int())) + 1;
+	const int grid_side_count_y = std::max(1, param_y_subdivisions.get(int())) + 1;
+	if ( !bind_pose
+	  || !bind_pose->is_valid_for(param_point1.get(Point()), param_point2.get(Point()), grid_side_count_x, grid_side_count_y, shapes) )
+		prepare_bind_pose(shapes);
+	else
+		mask = bind_pose->mask;
+	BindPose &pose = *bind_pose;
+
+	// transformations of bones from the rest position to the pose
+	std::vector<Matrix> matrices(bone_pairs.size());
+	std::vector<Real> depths(bone_pairs.size());
+	for(size_t b = 0; b < bone_pairs.size(); ++b)
+	{
+		Bone::Shape shape1 = bone_pairs[b]->second.get_shape();
+		Matrix from_bone(
+			shape1.p1[0] - shape1.p0[0], shape1.p1[1] - shape1.p0[1], 0.0,
+			shape1.p0[1] - shape1.p1[1], shape1.p1[0] - shape1.p0[0], 0.0,
+			shape1.p0[0], shape1.p0[1], 1.0
+		);
+		matrices[b] = from_bone * pose.into_bone[b];
+		depths[b] = bone_pairs[b]->second.get_depth();
+	}
+
+	// blend transformations of bones for each vertex (matrices are affine)
+	const int count = (int)pose.positions.size();
+	std::vector<Real> average_depths(count);
+	rendering::Mesh::Handle mesh(new rendering::Mesh());
+	mesh->vertices.reserve(count);
+	for(int v = 0; v < count; ++v) {
+		const Vector &initial_position = pose.positions[v];
+		const Real x = initial_position[0];
+		const Real y = initial_position[1];
+		Real summary_x = 0.0, summary_y = 0.0, summary_depth = 0.0;
+		for(int k = pose.offsets[v], end = pose.offsets[v + 1]; k < end; ++k) {
+			const Matrix &m = matrices[pose.bones[k]];
+			const Real weight = pose.weights[k];
+			summary_x += (x*m.m00 + y*m.m10 + m.m20)*weight;
+			summary_y += (x*m.m01 + y*m.m11 + m.m21)*weight;
+			summary_depth += depths[pose.bones[k]]*weight;
+		}
+
+		const Real summary_weight = pose.summary_weights[v];
+		Vector average_position = summary_weight > precision ? Vector(summary_x, summary_y)/summary_weight : initial_position;
+		average_depths[v] = summary_weight > precision ? summary_depth/summary_weight : 0.0;
 		mesh->vertices.push_back( rendering::Mesh::Vertex(
-			average_position, i->initial_position ));
+			average_position, initial_position ));
 	}
 
-	// build triangles
-	std::vector< std::pair<Real, rendering::Mesh::Triangle> > triangles;
-	triangles.reserve(2*(grid_side_count_x-1)*(grid_side_count_y-1));
-	for(int j = 1; j < grid_side_count_y; ++j)
+	// build and sort triangles
+	if (!pose.triangles_valid || pose.depths != depths)
 	{
-		for(int i = 1; i < grid_side_count_x; ++i)
+		std::vector< std::pair<Real, rendering::Mesh::Triangle> > triangles;
+		triangles.reserve(2*(grid_side_count_x-1)*(grid_side_count_y-1));
+		for(int j = 1; j < grid_side_count_y; ++j)
 		{
-			int v[] = {
-				(j-1)*grid_side_count_x + (i-1),
-				(j-1)*grid_side_count_x +  i,
-				 j   *grid_side_count_x +  i,
-				 j   *grid_side_count_x + (i-1),
-			};
-			if (grid[v[0]].used && grid[v[1]].used && grid[v[2]].used && grid[v[3]].used)
+			for(int i = 1; i < grid_side_count_x; ++i)
 			{
-				Real depth = 0.25*(grid[v[0]].average_depth
-						         + grid[v[1]].average_depth
-								 + grid[v[2]].average_depth
-								 + grid[v[3]].average_depth);
-				triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[0], v[1], v[3])));
-				triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[1], v[2], v[3])));
+				int v[] = {
+					(j-1)*grid_side_count_x + (i-1),
+					(j-1)*grid_side_count_x +  i,
+					 j   *grid_side_count_x +  i,
+					 j   *grid_side_count_x + (i-1),
+				};
+				if (pose.used[v[0]] && pose.used[v[1]] && pose.used[v[2]] && pose.used[v[3]])
+				{
+					Real depth = 0.25*(average_depths[v[0]]
+							         + average_depths[v[1]]
+									 + average_depths[v[2]]
+									 + average_depths[v[3]]);
+					triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[0], v[1], v[3])));
+					triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[1], v[2], v[3])));
+				}
 			}
 		}
-	}
 
-	// sort triangles
-	std::sort(triangles.begin(), triangles.end(), GridPoint::compare_triagles);
-	mesh->triangles.reserve(triangles.size());
-	for(std::vector< std::pair<Real, rendering::Mesh::Triangle> >::iterator i = triangles.begin(); i != triangles.end(); ++i)
-		mesh->triangles.push_back(i->second);
+		std::sort(triangles.begin(), triangles.end(), compare_triangles);
+		pose.triangles.clear();
+		pose.triangles.reserve(triangles.size());
+		for(std::vector< std::pair<Real, rendering::Mesh::Triangle> >::iterator i = triangles.begin(); i != triangles.end(); ++i)
+			pose.triangles.push_back(i->second);
+		pose.depths = depths;
+		pose.triangles_valid = true;
+	}
+	mesh->triangles = pose.triangles;
 
-	prepare_mask();
 	this->mesh = mesh;
 }
 
@@ -30,6 +30,8 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <memory>
+
 #include "layer_meshtransform.h"
 #include <synfig/pair.h>
 #include <synfig/bone.h>
@@ -60,8 +62,15 @@ private:
 	//! Parameter: (Integer)
 	synfig::ValueBase param_y_subdivisions;
 
-	struct GridPoint;
+	struct BindPose;
+	//! Weights of bones for the grid vertices, they depend only on the grid and on the rest
+	//! positions of bones, so they are kept while only the pose of bones is changed
+	std::shared_ptr<BindPose> bind_pose;
+
 	static Real distance_to_line(const Vector &p0, const Vector &p1, const Vector &x);
+	static bool compare_triangles(
+		const std::pair<Real, rendering::Mesh::Triangle> &a,
+		const std::pair<Real, rendering::Mesh::Triangle> &b );
 
 public:
 	typedef etl::handle<Layer_SkeletonDeformation> Handle;
@@ -85,6 +94,7 @@ public:
 	virtual Vocab get_param_vocab()const;
 
 	void prepare_mask();
+	void prepare_bind_pose(const std::vector<Bone::Shape> &shapes);
 	void prepare_mesh();
 }; // END of class SkeletonDeformation
 
@@ -37,11 +37,13 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <vector>
 #include <stdexcept>
@@ -57,6 +59,7 @@
 #include "localization.h"
 
 #include "blur.h"
+#include "canvasbinary.h"
 #include "dashitem.h"
 #include "exception.h"
 #include "gradient.h"
@@ -102,6 +105,31 @@ inline bool is_whitespace(char x) { return ((x)=='\n' || (x)=='\t' || (x)==' ');
 inline bool is_true(const std::string& s) { return s=="1" || s=="true" || s=="TRUE" || s=="True"; }
 inline bool is_false(const std::string& s) { return s=="0" || s=="false" || s=="FALSE" || s=="False"; }
 
+namespace {
+
+//! Sets the .sifb file which is parsed by CanvasParser
+class BinaryScope
+{
+	const CanvasBinary *&binary;
+	const CanvasBinary *prev;
+public:
+	BinaryScope(const CanvasBinary *&binary, const CanvasBinary &x):
+		binary(binary), prev(binary) { binary = &x; }
+	~BinaryScope() { binary = prev; }
+};
+
+//! Makes placeholders of the materialized document visible to CanvasParser
+class PlaceholdersScope
+{
+	std::vector<const CanvasBinary::Placeholders*> &stack;
+public:
+	PlaceholdersScope(std::vector<const CanvasBinary::Placeholders*> &stack, const CanvasBinary::Placeholders &placeholders):
+		stack(stack) { stack.push_back(&placeholders); }
+	~PlaceholdersScope() { stack.pop_back(); }
+};
+
+} // END of anonymous namespace
+
 std::set<FileSystem::Identifier> CanvasParser::loading_;
 
 /* === P R O C E D U R E S ================================================= */
@@ -152,6 +180,8 @@ synfig::open_canvas_as(const FileSystem::Identifier &identifier,const String &as
 	Canvas::Handle canvas;
 	CanvasParser parser;
 	parser.set_allow_errors(true);
+	if (const char *s = getenv("SYNFIG_LOAD_CANVAS_DOM"))
+		parser.set_streaming(atoi(s) == 0);
 
 	try
 	{
@@ -261,6 +291,9 @@ CanvasParser::parse_real(xmlpp::Element *element)
 {
 	assert(element->get_name()=="real");
 
+	if(const CanvasBinary::Value *value = find_binary_value(element))
+		return value->data[0];
+
 	if(!element->get_children().empty())
 		warning(element, strprintf(_("<%s> should not contain anything"),"real"));
 
@@ -280,6 +313,9 @@ CanvasParser::parse_time(xmlpp::Element *element,Canvas::Handle canvas)
 {
 	assert(element->get_name()=="time");
 
+	if(const CanvasBinary::Value *value = find_binary_value(element))
+		return Time(value->data[0]);
+
 	if(!element->get_children().empty())
 		warning(element, strprintf(_("<%s> should not contain anything"),"time"));
 
@@ -299,6 +335,9 @@ CanvasParser::parse_integer(xmlpp::Element *element)
 {
 	assert(element->get_name()=="integer");
 
+	if(const CanvasBinary::Value *value = find_binary_value(element))
+		return (int)value->data[0];
+
 	if(!element->get_children().empty())
 		warning(element, strprintf(_("<%s> should not contain anything"),"integer"));
 
@@ -337,6 +376,9 @@ CanvasParser::parse_vector(xmlpp::Element *element)
 {
 	assert(element->get_name()=="vector");
 
+	if(const CanvasBinary::Value *value = find_binary_value(element))
+		return Vector(value->data[0], value->data[1]);
+
 	if(element->get_children().empty())
 	{
 		error(element, "Undefined value in <vector>");
@@ -385,6 +427,9 @@ CanvasParser::parse_color(xmlpp::Element *element)
 {
 	assert(element->get_name()=="color");
 
+	if(const CanvasBinary::Value *value = find_binary_value(element))
+		return Color(value->data[0], value->data[1], value->data[2], value->data[3]);
+
 	if(element->get_children().empty())
 	{
 		error(element, "Undefined value in <color>");
@@ -453,6 +498,8 @@ synfig::String
 CanvasParser::parse_string(xmlpp::Element *element)
 {
 	assert(element->get_name()=="string");
+	if(const CanvasBinary::Value *value = find_binary_value(element))
+		return binary_->get_string(value->string);
 	if(element->get_children().empty())
 		return synfig::String();
 	return element->get_child_text()->get_content();
@@ -463,6 +510,9 @@ CanvasParser::parse_bool(xmlpp::Element *element)
 {
 	assert(element->get_name()=="bool");
 
+	if(const CanvasBinary::Value *value = find_binary_value(element))
+		return value->data[0] != 0.0;
+
 	if(!element->get_children().empty())
 		warning(element, strprintf(_("<%s> should not contain anything"),"bool"));
 
@@ -1244,6 +1294,9 @@ CanvasParser::parse_angle(xmlpp::Element *element)
 {
 	assert(element->get_name()=="angle");
 
+	if(const CanvasBinary::Value *value = find_binary_value(element))
+		return Angle::deg(value->data[0]);
+
 	if(!element->get_children().empty())
 		warning(element, strprintf(_("<%s> should not contain anything"),"angle"));
 
@@ -1461,6 +1514,9 @@ CanvasParser::parse_static(xmlpp::Element *element)
 ValueBase
 CanvasParser::parse_value(xmlpp::Element *element,Canvas::Handle canvas)
 {
+	if(const CanvasBinary::Value *value = find_binary_value(element))
+		return parse_binary_value(*value);
+
 	if(element->get_name()=="real")
 	{
 		ValueBase ret;
@@ -1656,6 +1712,11 @@ CanvasParser::parse_animated(xmlpp::Element *element,Canvas::Handle canvas)
 		value_node->set_interpolation(parse_interpolation(element, "interpolation"));
 	}
 
+	// waypoints of .sifb are stored as records, element has no children then
+	uint32_t binary_index;
+	if(find_binary_node(element, binary_index) && binary_->get_node(binary_index).type == CanvasBinary::NODE_ANIMATED)
+		parse_binary_waypoints(element, binary_index, value_node, canvas);
+
 	xmlpp::Element::NodeList list = element->get_children();
 	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
 	{
@@ -2352,6 +2413,14 @@ CanvasParser::parse_dynamic_list(xmlpp::Element *element,Canvas::Handle canvas)
 	if (is_bool_attribute_true(element, "loop"))
 		value_node->set_loop(true);
 
+	// points of <bline> of .sifb are stored as records
+	uint32_t binary_index;
+	if(find_binary_node(element, binary_index) && binary_->get_node(binary_index).type == CanvasBinary::NODE_BLINE)
+	{
+		parse_binary_bline_points(element, binary_index, value_node, canvas, must_rotate_point_list);
+		return value_node;
+	}
+
 	xmlpp::Element::NodeList list = element->get_children();
 
 	if (must_rotate_point_list) {
@@ -2546,9 +2615,9 @@ CanvasParser::parse_value_node(xmlpp::Element *element,Canvas::Handle canvas)
 
 	GUID guid;
 
-	if(element->get_attribute("guid"))
+	if(has_guid(element))
 	{
-		guid=GUID(element->get_attribute("guid")->get_value())^canvas->get_root()->get_guid();
+		guid=parse_guid_attribute(element)^canvas->get_root()->get_guid();
 		DEBUG_LOG("SYNFIG_DEBUG_LOAD_CANVAS", "%s:%d got guid %s\n", __FILE__, __LINE__, guid.get_string().c_str());
 		DEBUG_LOG("SYNFIG_DEBUG_LOAD_CANVAS", "%s:%d and element name = '%s'\n", __FILE__, __LINE__, element->get_name().c_str());
 		value_node=guid_cast<ValueNode>(guid);
@@ -2929,7 +2998,7 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 
 			// If we recognize the element name as a
 			// ValueBase, then treat is at one
-			if(/*(*iter)->get_name()!="canvas" && */ValueBase::ident_type((*iter)->get_name()) != type_nil && !dynamic_cast<xmlpp::Element*>(*iter)->get_attribute("guid"))
+			if(/*(*iter)->get_name()!="canvas" && */ValueBase::ident_type((*iter)->get_name()) != type_nil && !has_guid(dynamic_cast<xmlpp::Element*>(*iter)))
 			{
 				data=parse_value(dynamic_cast<xmlpp::Element*>(*iter),canvas);
 
@@ -3114,8 +3183,9 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 }
 
 Canvas::Handle
-CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename)
+CanvasParser::parse_canvas_header(xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename,bool &existing)
 {
+	existing=false;
 
 	if(element->get_name()!="canvas")
 	{
@@ -3158,11 +3228,14 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 		canvas->rend_desc().clear_flags();
 	}
 
-	if(element->get_attribute("guid"))
+	if(has_guid(element))
 	{
-		GUID guid(element->get_attribute("guid")->get_value());
+		GUID guid(parse_guid_attribute(element));
 		if(guid_cast<Canvas>(guid))
+		{
+			existing=true;
 			return guid_cast<Canvas>(guid);
+		}
 		else
 			canvas->set_guid(guid);
 	}
@@ -3282,151 +3355,149 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 
 	canvas->rend_desc().set_flags(RendDesc::PX_ASPECT|RendDesc::IM_SPAN);
 
-	std::list<ValueNode::Handle> bone_list;
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	return canvas;
+}
+
+void
+CanvasParser::parse_canvas_child(xmlpp::Element *child,Canvas::Handle canvas,std::list<ValueNode::Handle> &bone_list)
+{
+	if(child->get_name()=="defs")
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(child)
+		if(canvas->is_inline())
+			error(child,_("Group canvases cannot have a <defs> section"));
+		parse_canvas_defs(child, canvas);
+	}
+	else
+	if(child->get_name()=="bones")
+	{
+		if(canvas->is_inline())
+			error(child,_("Inline canvas cannot have a <bones> section"));
+		bone_list = parse_canvas_bones(child, canvas);
+	}
+	else
+	if(child->get_name()=="keyframe")
+	{
+		if(canvas->is_inline())
 		{
-			if(child->get_name()=="defs")
-			{
-				if(canvas->is_inline())
-					error(child,_("Group canvases cannot have a <defs> section"));
-				parse_canvas_defs(child, canvas);
-			}
-			else
-			if(child->get_name()=="bones")
-			{
-				if(canvas->is_inline())
-					error(child,_("Inline canvas cannot have a <bones> section"));
-				bone_list = parse_canvas_bones(child, canvas);
-			}
-			else
-			if(child->get_name()=="keyframe")
-			{
-				if(canvas->is_inline())
-				{
-					warning(child,_("Group canvases cannot have keyframes"));
-					continue;
-				}
+			warning(child,_("Group canvases cannot have keyframes"));
+			return;
+		}
 
-				canvas->keyframe_list().add(parse_keyframe(child,canvas));
-				canvas->keyframe_list().sync();
-			}
-			else
-			if(child->get_name()=="meta")
-			{
-				if(canvas->is_inline())
-				{
-					warning(child,_("Group canvases cannot have metadata"));
-					continue;
-				}
+		canvas->keyframe_list().add(parse_keyframe(child,canvas));
+		canvas->keyframe_list().sync();
+	}
+	else
+	if(child->get_name()=="meta")
+	{
+		if(canvas->is_inline())
+		{
+			warning(child,_("Group canvases cannot have metadata"));
+			return;
+		}
 
-				if(!child->get_attribute("name"))
-				{
-					warning(child,_("<meta> must have a name"));
-					continue;
-				}
+		if(!child->get_attribute("name"))
+		{
+			warning(child,_("<meta> must have a name"));
+			return;
+		}
 
-				if(!child->get_attribute("content"))
-				{
-					warning(child,_("<meta> must have content"));
-					continue;
-				}
-				
-				// In Synfig prior to version 1.0 we have messed decimal separator:
-				// some files use ".", but other ones use ","/
-				// Let's try to put a workaround for that.
-				std::vector<String> replacelist;
-				replacelist.push_back("background_first_color");
-				replacelist.push_back("background_second_color");
-				replacelist.push_back("background_size");
-				replacelist.push_back("grid_color");
-				replacelist.push_back("grid_size");
-				replacelist.push_back("jack_offset");
-				String content;
-				content=child->get_attribute("content")->get_value();
-				if(std::find(replacelist.begin(), replacelist.end(), child->get_attribute("name")->get_value()) != replacelist.end()) 
-				{
-					size_t index = 0;
-					while (true) {
-					     /* Locate the substring to replace. */
-					     index = content.find(',', index);
-					     if (index == std::string::npos) break;
+		if(!child->get_attribute("content"))
+		{
+			warning(child,_("<meta> must have content"));
+			return;
+		}
+		
+		// In Synfig prior to version 1.0 we have messed decimal separator:
+		// some files use ".", but other ones use ","/
+		// Let's try to put a workaround for that.
+		std::vector<String> replacelist;
+		replacelist.push_back("background_first_color");
+		replacelist.push_back("background_second_color");
+		replacelist.push_back("background_size");
+		replacelist.push_back("grid_color");
+		replacelist.push_back("grid_size");
+		replacelist.push_back("jack_offset");
+		String content;
+		content=child->get_attribute("content")->get_value();
+		if(std::find(replacelist.begin(), replacelist.end(), child->get_attribute("name")->get_value()) != replacelist.end()) 
+		{
+			size_t index = 0;
+			while (true) {
+			     /* Locate the substring to replace. */
+			     index = content.find(',', index);
+			     if (index == std::string::npos) break;
 
-					     /* Make the replacement. */
-					     content.replace(index, 1, ".");
+			     /* Make the replacement. */
+			     content.replace(index, 1, ".");
 
-					     /* Advance index forward so the next iteration doesn't pick it up as well. */
-					     index += 1;
-					}
-					
-				}
-				canvas->set_meta_data(child->get_attribute("name")->get_value(),content);
+			     /* Advance index forward so the next iteration doesn't pick it up as well. */
+			     index += 1;
 			}
-			else if(child->get_name()=="name")
-			{
-				xmlpp::Element::NodeList list = child->get_children();
+			
+		}
+		canvas->set_meta_data(child->get_attribute("name")->get_value(),content);
+	}
+	else if(child->get_name()=="name")
+	{
+		xmlpp::Element::NodeList list = child->get_children();
 
-				// If we don't have any name, warn
-				if(list.empty())
-					warning(child,_("blank \"name\" entity"));
+		// If we don't have any name, warn
+		if(list.empty())
+			warning(child,_("blank \"name\" entity"));
 
-				std::string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_name(tmp);
-			}
-			else
-			if(child->get_name()=="desc")
-			{
+		std::string tmp;
+		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+			if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
+		canvas->set_name(tmp);
+	}
+	else
+	if(child->get_name()=="desc")
+	{
 
-				xmlpp::Element::NodeList list = child->get_children();
+		xmlpp::Element::NodeList list = child->get_children();
 
-				// If we don't have any description, warn
-				if(list.empty())
-					warning(child,_("blank \"desc\" entity"));
+		// If we don't have any description, warn
+		if(list.empty())
+			warning(child,_("blank \"desc\" entity"));
 
-				std::string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_description(tmp);
-			}
-			else
-			if(child->get_name()=="author")
-			{
+		std::string tmp;
+		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+			if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
+		canvas->set_description(tmp);
+	}
+	else
+	if(child->get_name()=="author")
+	{
 
-				xmlpp::Element::NodeList list = child->get_children();
+		xmlpp::Element::NodeList list = child->get_children();
 
-				// If we don't have any description, warn
-				if(list.empty())
-					warning(child,_("blank \"author\" entity"));
+		// If we don't have any description, warn
+		if(list.empty())
+			warning(child,_("blank \"author\" entity"));
 
-				std::string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_author(tmp);
-			}
-			else
-			if(child->get_name()=="layer")
-			{
-				//if(canvas->is_inline())
-				//	canvas->push_front(parse_layer(child,canvas->parent()));
-				//else
-					canvas->push_front(parse_layer(child,canvas));
-			}
-			else
-			{
-				printf("%s:%d\n", __FILE__, __LINE__);
-				error_unexpected_element(child,child->get_name());
-			}
-		}
-//		else
-//		if((child->get_name()=="text"||child->get_name()=="comment") && child->has_child_text())
-//			continue;
+		std::string tmp;
+		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+			if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
+		canvas->set_author(tmp);
+	}
+	else
+	if(child->get_name()=="layer")
+	{
+		//if(canvas->is_inline())
+		//	canvas->push_front(parse_layer(child,canvas->parent()));
+		//else
+			canvas->push_front(parse_layer(child,canvas));
 	}
+	else
+	{
+		printf("%s:%d\n", __FILE__, __LINE__);
+		error_unexpected_element(child,child->get_name());
+	}
+}
 
+Canvas::Handle
+CanvasParser::parse_canvas_footer(xmlpp::Element *element,Canvas::Handle canvas)
+{
 	if(canvas->value_node_list().placeholder_count())
 	{
 		String nodes;
@@ -3446,6 +3517,268 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 	return canvas;
 }
 
+Canvas::Handle
+CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename)
+{
+	bool existing;
+	Canvas::Handle canvas = parse_canvas_header(element, parent, inline_, identifier, filename, existing);
+	if(!canvas || existing)
+		return canvas;
+
+	// children of <canvas> of .sifb are materialized when they are parsed
+	uint32_t binary_index;
+	if(find_binary_node(element, binary_index))
+	{
+		parse_binary_canvas_children(binary_index, canvas);
+		return parse_canvas_footer(element, canvas);
+	}
+
+	std::list<ValueNode::Handle> bone_list;
+	xmlpp::Element::NodeList list = element->get_children();
+	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+		if(xmlpp::Element *child = dynamic_cast<xmlpp::Element*>(*iter))
+			parse_canvas_child(child, canvas, bone_list);
+
+	return parse_canvas_footer(element, canvas);
+}
+
+Canvas::Handle
+CanvasParser::parse_canvas_stream(xmlpp::TextReader &reader,const FileSystem::Identifier &identifier,String filename)
+{
+	// find the root element
+	bool more = reader.read();
+	while(more && reader.get_node_type() != xmlpp::TextReader::Element)
+		more = reader.read();
+	if(!more)
+		return Canvas::Handle();
+
+	// the reader keeps ancestors of the current node,
+	// so root element with its attributes is valid until the end of document
+	xmlpp::Element *element = dynamic_cast<xmlpp::Element*>(reader.get_current_node());
+	if(!element)
+		return Canvas::Handle();
+
+	bool existing;
+	Canvas::Handle canvas = parse_canvas_header(element, 0, false, identifier, filename, existing);
+	if(!canvas || existing)
+		return canvas;
+
+	if(!reader.is_empty_element())
+	{
+		// build the DOM tree only for one child at once, and drop it when child is parsed
+		const int depth = reader.get_depth();
+		std::list<ValueNode::Handle> bone_list;
+		more = reader.read();
+		while(more && reader.get_depth() > depth)
+		{
+			if(reader.get_node_type() == xmlpp::TextReader::Element)
+			{
+				if(xmlpp::Element *child = dynamic_cast<xmlpp::Element*>(reader.expand()))
+					parse_canvas_child(child, canvas, bone_list);
+				more = reader.next();
+			}
+			else
+			{
+				more = reader.read();
+			}
+		}
+	}
+
+	return parse_canvas_footer(element, canvas);
+}
+
+Canvas::Handle
+CanvasParser::parse_canvas_binary(const CanvasBinary &binary,const FileSystem::Identifier &identifier,String filename)
+{
+	BinaryScope binary_scope(binary_, binary);
+
+	// root element with attributes only, children are materialized one by one like in parse_canvas_stream()
+	xmlpp::Document root_document;
+	CanvasBinary::Placeholders placeholders;
+	PlaceholdersScope placeholders_scope(binary_placeholders_, placeholders);
+	xmlpp::Element *element = binary.materialize(root_document, 0, placeholders);
+
+	bool existing;
+	Canvas::Handle canvas = parse_canvas_header(element, 0, false, identifier, filename, existing);
+	if(!canvas || existing)
+		return canvas;
+
+	parse_binary_canvas_children(0, canvas);
+	return parse_canvas_footer(element, canvas);
+}
+
+void
+CanvasParser::parse_binary_canvas_children(uint32_t index,Canvas::Handle canvas)
+{
+	std::list<ValueNode::Handle> bone_list;
+	const uint32_t end = binary_->get_node(index).end;
+	for(uint32_t i = index + 1; i < end; i = binary_->get_node(i).end)
+	{
+		const uint32_t type = binary_->get_node(i).type;
+		if(type == CanvasBinary::NODE_TEXT || type == CanvasBinary::NODE_COMMENT)
+			continue;
+		xmlpp::Document document;
+		CanvasBinary::Placeholders placeholders;
+		PlaceholdersScope scope(binary_placeholders_, placeholders);
+		parse_canvas_child(binary_->materialize(document, i, placeholders), canvas, bone_list);
+	}
+}
+
+bool
+CanvasParser::find_binary_node(xmlpp::Element *element,uint32_t &index)const
+{
+	for(std::vector<const CanvasBinary::Placeholders*>::const_reverse_iterator i = binary_placeholders_.rbegin(); i != binary_placeholders_.rend(); ++i)
+	{
+		CanvasBinary::Placeholders::const_iterator j = (*i)->find(element);
+		if(j != (*i)->end())
+		{
+			index = j->second;
+			return true;
+		}
+	}
+	return false;
+}
+
+const CanvasBinary::Value*
+CanvasParser::find_binary_value(xmlpp::Element *element)const
+{
+	uint32_t index;
+	if(!find_binary_node(element, index))
+		return nullptr;
+	const CanvasBinary::Node &node = binary_->get_node(index);
+	return node.type == CanvasBinary::NODE_VALUE ? &binary_->get_value(node.first_record) : nullptr;
+}
+
+bool
+CanvasParser::has_guid(xmlpp::Element *element)const
+{
+	uint32_t index;
+	if(find_binary_node(element, index) && binary_->find_guid(binary_->get_node(index)))
+		return true;
+	return element->get_attribute("guid") != nullptr;
+}
+
+GUID
+CanvasParser::parse_guid_attribute(xmlpp::Element *element)const
+{
+	uint32_t index;
+	if(find_binary_node(element, index))
+		if(const CanvasBinary::Guid *guid = binary_->find_guid(binary_->get_node(index)))
+			return GUID(guid->hi, guid->lo);
+	return GUID(element->get_attribute("guid")->get_value());
+}
+
+ValueBase
+CanvasParser::parse_binary_value(const CanvasBinary::Value &value)
+{
+	ValueBase ret;
+	switch(value.type)
+	{
+	case CanvasBinary::VALUE_REAL:    ret.set(Real(value.data[0])); break;
+	case CanvasBinary::VALUE_INTEGER: ret.set((int)value.data[0]); break;
+	case CanvasBinary::VALUE_BOOL:    ret.set(value.data[0] != 0.0); break;
+	case CanvasBinary::VALUE_ANGLE:   ret.set(Angle::deg(value.data[0])); break;
+	case CanvasBinary::VALUE_TIME:    ret.set(Time(value.data[0])); break;
+	case CanvasBinary::VALUE_VECTOR:  ret.set(Vector(value.data[0], value.data[1])); break;
+	case CanvasBinary::VALUE_COLOR:   ret.set(Color(value.data[0], value.data[1], value.data[2], value.data[3])); break;
+	case CanvasBinary::VALUE_STRING:  ret.set(String(binary_->get_string(value.string))); break;
+	}
+	ret.set_static(value.flags & CanvasBinary::VALUE_STATIC);
+	ret.set_interpolation((Interpolation)value.interpolation);
+	return ret;
+}
+
+ValueNode::Handle
+CanvasParser::parse_binary_value_node(uint32_t index,Canvas::Handle canvas)
+{
+	// plain constant does not need any element, like <real value="1"/> without guid and id
+	const CanvasBinary::Node &node = binary_->get_node(index);
+	if(node.type == CanvasBinary::NODE_VALUE && !node.attribute_count)
+	{
+		ValueNode::Handle value_node = ValueNode_Const::create(parse_binary_value(binary_->get_value(node.first_record)));
+		value_node->set_root_canvas(canvas->get_root());
+		return value_node;
+	}
+
+	xmlpp::Document document;
+	CanvasBinary::Placeholders placeholders;
+	PlaceholdersScope scope(binary_placeholders_, placeholders);
+	return parse_value_node(binary_->materialize(document, index, placeholders), canvas);
+}
+
+void
+CanvasParser::parse_binary_waypoints(xmlpp::Element *element,uint32_t index,ValueNode_Animated::Handle value_node,Canvas::Handle canvas)
+{
+	const CanvasBinary::Node &node = binary_->get_node(index);
+	uint32_t child = index + 1;
+	for(uint32_t i = 0; i < node.record_count; ++i, child = binary_->get_node(child).end)
+	{
+		const CanvasBinary::Waypoint &record = binary_->get_waypoint(node.first_record + i);
+
+		ValueNode::Handle waypoint_value_node = parse_binary_value_node(child, canvas);
+		if(!waypoint_value_node)
+		{
+			error(element,_("Bad data for <waypoint>"));
+			continue;
+		}
+
+		try
+		{
+			ValueNode_Animated::WaypointList::iterator waypoint=value_node->new_waypoint(Time(record.time),waypoint_value_node);
+			if(record.flags & CanvasBinary::WAYPOINT_TENSION)
+				waypoint->set_tension(record.tension);
+			if(record.flags & CanvasBinary::WAYPOINT_TEMPORAL_TENSION)
+				waypoint->set_temporal_tension(record.temporal_tension);
+			if(record.flags & CanvasBinary::WAYPOINT_CONTINUITY)
+				waypoint->set_continuity(record.continuity);
+			if(record.flags & CanvasBinary::WAYPOINT_BIAS)
+				waypoint->set_bias(record.bias);
+			if(record.flags & CanvasBinary::WAYPOINT_BEFORE)
+				waypoint->set_before((Interpolation)record.before);
+			if(record.flags & CanvasBinary::WAYPOINT_AFTER)
+				waypoint->set_after((Interpolation)record.after);
+		}
+		catch(Exception::BadTime& x)
+		{
+			warning(element, x.what());
+		}
+	}
+}
+
+void
+CanvasParser::parse_binary_bline_points(xmlpp::Element *element,uint32_t index,handle<ValueNode_DynamicList> value_node,Canvas::Handle canvas,bool rotate)
+{
+	const CanvasBinary::Node &node = binary_->get_node(index);
+	std::vector<ValueNode::Handle> points;
+	uint32_t child = index + 1;
+	for(uint32_t i = 0; i < node.record_count; )
+	{
+		const uint32_t point = binary_->get_link(node.first_record + i).point;
+		handle<LinkableValueNode> composite = ValueNodeRegistry::create("composite", type_bline_point);
+		for(; i < node.record_count && binary_->get_link(node.first_record + i).point == point; ++i, child = binary_->get_node(child).end)
+		{
+			const char *name = binary_->get_string(binary_->get_link(node.first_record + i).name);
+			ValueNode::Handle link = parse_binary_value_node(child, canvas);
+			if(!link || !composite->set_link(composite->get_link_index_from_name(name), link))
+				error(element,strprintf(_("Parse of '%s' failed"), name));
+		}
+		composite->set_root_canvas(canvas->get_root());
+		points.push_back(composite);
+	}
+
+	// see parse_dynamic_list()
+	if(rotate && !points.empty())
+		std::rotate(points.begin(), points.end() - 1, points.end());
+
+	for(std::vector<ValueNode::Handle>::const_iterator i = points.begin(); i != points.end(); ++i)
+	{
+		ValueNode_DynamicList::ListEntry list_entry;
+		list_entry.value_node = *i;
+		value_node->add(list_entry);
+		value_node->set_link(value_node->link_count()-1,list_entry.value_node);
+	}
+}
+
 void
 CanvasParser::register_canvas_in_map(Canvas::Handle canvas, String as)
 {
@@ -3487,40 +3820,59 @@ CanvasParser::parse_from_file_as(const FileSystem::Identifier &identifier,const
 		total_warnings_=0;
 		
 		synfig::info(String("Loading file: ") + filename);
-		FileSystem::ReadStream::Handle stream = identifier.get_read_stream();
-		if (stream)
+		Canvas::Handle canvas;
+		if (filename_extension(identifier.filename) == ".sifb")
+		{
+			CanvasBinary binary;
+			if (!binary.open(identifier))
+				throw std::runtime_error(String("  * ") + _("Can't open file") + " \"" + identifier.filename + "\"");
+			canvas=parse_canvas_binary(binary,identifier,as);
+		}
+		else
 		{
+			FileSystem::ReadStream::Handle stream = identifier.get_read_stream();
+			if (!stream)
+				throw std::runtime_error(String("  * ") + _("Can't find linked file") + " \"" + identifier.filename + "\"");
+
 			if (filename_extension(identifier.filename) == ".sifz")
 				stream = FileSystem::ReadStream::Handle(new ZReadStream(stream, zstreambuf::compression::gzip));
 
-			xmlpp::DomParser parser;
-			parser.parse_stream(*stream);
-			stream.reset();
-			if(parser)
+			if(streaming_)
+			{
+				// the text of the document is much smaller than its DOM tree
+				std::string data((std::istreambuf_iterator<char>(*stream)), std::istreambuf_iterator<char>());
+				stream.reset();
+				xmlpp::TextReader reader(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+				canvas=parse_canvas_stream(reader,identifier,as);
+			}
+			else
 			{
-				Canvas::Handle canvas(parse_canvas(parser.get_document()->get_root_node(),0,false,identifier,as));
-				if (!canvas) return canvas;
-				register_canvas_in_map(canvas, as);
+				xmlpp::DomParser parser;
+				parser.parse_stream(*stream);
+				stream.reset();
+				if(parser)
+					canvas=parse_canvas(parser.get_document()->get_root_node(),0,false,identifier,as);
+			}
+		}
 
-				const ValueNodeList& value_node_list(canvas->value_node_list());
+		if (!canvas) return canvas;
+		register_canvas_in_map(canvas, as);
 
-				again:
-				ValueNodeList::const_iterator iter;
-				for(iter=value_node_list.begin();iter!=value_node_list.end();++iter)
-				{
-					ValueNode::Handle value_node(*iter);
-					if(value_node->is_exported() && value_node->get_id().find("Unnamed")==0)
-					{
-						canvas->remove_value_node(value_node, true);
-						goto again;
-					}
-				}
+		const ValueNodeList& value_node_list(canvas->value_node_list());
 
-				return canvas;
+		again:
+		ValueNodeList::const_iterator iter;
+		for(iter=value_node_list.begin();iter!=value_node_list.end();++iter)
+		{
+			ValueNode::Handle value_node(*iter);
+			if(value_node->is_exported() && value_node->get_id().find("Unnamed")==0)
+			{
+				canvas->remove_value_node(value_node, true);
+				goto again;
 			}
-		} else {
-			throw std::runtime_error(String("  * ") + _("Can't find linked file") + " \"" + identifier.filename + "\"");
 		}
+
+		return canvas;
 	}
 	catch(Exception::BadLinkName&) { synfig::error("BadLinkName Thrown"); }
 	catch(Exception::BadType&) { synfig::error("BadType Thrown"); }
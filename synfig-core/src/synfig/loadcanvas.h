@@ -34,6 +34,7 @@
 
 #include "string.h"
 #include "canvas.h"
+#include "canvasbinary.h"
 #include "valuenode.h"
 #include "vector.h"
 #include "value.h"
@@ -52,7 +53,7 @@
 
 /* === C L A S S E S & S T R U C T S ======================================= */
 
-namespace xmlpp { class Node; class Element; };
+namespace xmlpp { class Node; class Element; class TextReader; };
 
 namespace synfig {
 
@@ -87,6 +88,12 @@ private:
 	GUID guid_;
 	//
 	bool in_bones_section;
+	//! True if files are read by xmlpp::TextReader instead of building the whole DOM tree
+	bool streaming_;
+	//! The .sifb file which is parsed now
+	const CanvasBinary *binary_;
+	//! Placeholder elements of documents materialized from binary_, innermost last
+	std::vector<const CanvasBinary::Placeholders*> binary_placeholders_;
 
 	/*
  --	** -- C O N S T R U C T O R S ---------------------------------------------
@@ -99,7 +106,9 @@ public:
 		total_warnings_	(0),
 		total_errors_	(0),
 		allow_errors_	(false),
-		in_bones_section(false)
+		in_bones_section(false),
+		streaming_		(true),
+		binary_			(nullptr)
 	{ }
 
 	/*
@@ -111,6 +120,12 @@ public:
 	//! Sets allow errors variable
 	CanvasParser &set_allow_errors(bool x) { allow_errors_=x; return *this; }
 
+	//! Sets streaming mode, when disabled parse_from_file_as() builds the DOM tree of the whole file
+	CanvasParser &set_streaming(bool x) { streaming_=x; return *this; }
+
+	//! Returns true if streaming mode is enabled
+	bool get_streaming()const { return streaming_; }
+
 	//! Sets the maximum number of warnings before a fatal error is thrown
 	CanvasParser &set_max_warnings(int i) { max_warnings_=i; return *this; }
 
@@ -167,6 +182,42 @@ private:
 
 	//! Canvas Parsing Function
 	Canvas::Handle parse_canvas(xmlpp::Element *node,Canvas::Handle parent=0,bool inline_=false,const FileSystem::Identifier &identifier = FileSystemNative::instance()->get_identifier(std::string()),String path=".");
+
+	//! Parse the root Canvas from the reader, children of canvas are expanded and parsed one by one
+	Canvas::Handle parse_canvas_stream(xmlpp::TextReader &reader,const FileSystem::Identifier &identifier,String path);
+
+	//! Parse the root Canvas from the .sifb file, children of canvas are materialized and parsed one by one
+	Canvas::Handle parse_canvas_binary(const CanvasBinary &binary,const FileSystem::Identifier &identifier,String path);
+
+	//! Parse children of the <canvas> node of binary_ one by one
+	void parse_binary_canvas_children(uint32_t index,Canvas::Handle canvas);
+
+	//! Finds the node of binary_ which is represented by the placeholder \a node
+	bool find_binary_node(xmlpp::Element *node,uint32_t &index)const;
+	//! Returns the typed value of the placeholder \a node or null
+	const CanvasBinary::Value* find_binary_value(xmlpp::Element *node)const;
+	//! Returns true if the \a node has the "guid" attribute, it is not materialized for placeholders
+	bool has_guid(xmlpp::Element *node)const;
+	//! Returns the "guid" attribute of the \a node
+	GUID parse_guid_attribute(xmlpp::Element *node)const;
+
+	//! ValueBase from the typed value of binary_
+	ValueBase parse_binary_value(const CanvasBinary::Value &value);
+	//! ValueNode from the node of binary_, typed values are converted without DOM
+	ValueNode::Handle parse_binary_value_node(uint32_t index,Canvas::Handle canvas);
+	//! Adds waypoints from the records of <animated> node of binary_
+	void parse_binary_waypoints(xmlpp::Element *node,uint32_t index,etl::handle<ValueNode_Animated> value_node,Canvas::Handle canvas);
+	//! Adds composite points from the records of <bline> node of binary_
+	void parse_binary_bline_points(xmlpp::Element *node,uint32_t index,etl::handle<ValueNode_DynamicList> value_node,Canvas::Handle canvas,bool rotate);
+
+	//! Creates the Canvas from the attributes of the canvas element, \a existing is set when Canvas with the same GUID is already loaded
+	Canvas::Handle parse_canvas_header(xmlpp::Element *node,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String path,bool &existing);
+
+	//! Parse one child element of the canvas element
+	void parse_canvas_child(xmlpp::Element *node,Canvas::Handle canvas,std::list<ValueNode::Handle> &bone_list);
+
+	//! Checks the Canvas when all children are parsed
+	Canvas::Handle parse_canvas_footer(xmlpp::Element *node,Canvas::Handle canvas);
 	//! Canvas definitions Parsing Function (exported value nodes and exported canvases)
 	void parse_canvas_defs(xmlpp::Element *node,Canvas::Handle canvas);
 
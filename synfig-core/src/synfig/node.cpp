@@ -36,7 +36,8 @@
 #include "node.h"
 
 #include <cstdlib>
-#include <map>
+#include <mutex>
+#include <unordered_map>
 
 #include "synfig/general.h"
 
@@ -51,40 +52,58 @@ using namespace synfig;
 /* === G L O B A L S ======================================================= */
 
 namespace {
+	//! Map is split into the shards with own mutexes, so threads which create and destroy
+	//! nodes (cloning of canvases, for example) are rarely waiting for each other.
+	//! GUIDs are random, so the high bits select the shard and the low bits are hashed.
 	class GlobalNodeMap {
 	public:
-		typedef std::map<GUID, Node*> Map;
-	
+		struct Hash {
+			size_t operator() (const GUID &guid) const
+				{ return (size_t)guid.get_lo(); }
+		};
+
+		typedef std::unordered_map<GUID, Node*, Hash> Map;
+
 	private:
-		std::mutex mutex;
-		Map map;
-	
+		enum { shard_bits = 6, shards_count = 1 << shard_bits };
+
+		//! shards are aligned to cache lines, so locking of one shard does not slow down others
+		struct alignas(64) Shard {
+			std::mutex mutex;
+			Map map;
+		};
+
+		Shard shards[shards_count];
+
+		Shard& shard(const GUID &guid)
+			{ return shards[guid.get_hi() >> (64 - shard_bits)]; }
+
 	public:
 		Node* get(const GUID &guid) {
-			std::lock_guard<std::mutex> lock(mutex);
-			Map::iterator i = map.find(guid);
-			return i == map.end() ? nullptr : i->second;
+			Shard &s = shard(guid);
+			std::lock_guard<std::mutex> lock(s.mutex);
+			Map::iterator i = s.map.find(guid);
+			return i == s.map.end() ? nullptr : i->second;
 		}
 
 		bool add(const GUID &guid, Node *node) {
 			assert(guid);
 			assert(node);
-			
-			std::lock_guard<std::mutex> lock(mutex);
-			if (map.count(guid) > 0)
-				return false;
-			map[guid] = node;
-			return true;
+
+			Shard &s = shard(guid);
+			std::lock_guard<std::mutex> lock(s.mutex);
+			return s.map.insert(Map::value_type(guid, node)).second;
 		}
 
 		void remove(const GUID &guid, Node *node) {
 			assert(guid);
 			assert(node);
-			
-			std::lock_guard<std::mutex> lock(mutex);
-			Map::iterator i = map.find(guid);
-			assert(i != map.end() && i->second == node);
-			map.erase(i);
+
+			Shard &s = shard(guid);
+			std::lock_guard<std::mutex> lock(s.mutex);
+			Map::iterator i = s.map.find(guid);
+			assert(i != s.map.end() && i->second == node);
+			s.map.erase(i);
 		}
 
 		void move(const GUID &guid, const GUID &oldguid, Node *node) {
@@ -95,14 +114,23 @@ namespace {
 				return;
 			}
 			assert(oldguid);
-			
-			std::lock_guard<std::mutex> lock(mutex);
-			Map::iterator i = map.find(oldguid);
-			assert(i != map.end() && i->second == node);
-			map.erase(i);
-			
-			assert(!map.count(guid));
-			map[guid] = node;
+
+			// both shards are locked, so node is never missing from the map
+			Shard &s = shard(guid);
+			Shard &old_s = shard(oldguid);
+			std::unique_lock<std::mutex> lock(s.mutex, std::defer_lock);
+			std::unique_lock<std::mutex> old_lock(old_s.mutex, std::defer_lock);
+			if (&s == &old_s)
+				lock.lock();
+			else
+				std::lock(lock, old_lock);
+
+			Map::iterator i = old_s.map.find(oldguid);
+			assert(i != old_s.map.end() && i->second == node);
+			old_s.map.erase(i);
+
+			assert(!s.map.count(guid));
+			s.map[guid] = node;
 		}
 	};
 }
@@ -0,0 +1,188 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/optimizer/optimizercache.cpp
+**	\brief OptimizerCache
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <synfig/debug/log.h>
+
+#include "optimizercache.h"
+
+#include "../task/taskcache.h"
+#include "../../renderer.h"
+#include "../../resultcache.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+const int OptimizerCache::min_area;
+
+OptimizerCache::OptimizerCache()
+{
+	category_id = CATEGORY_ID_COORDS;
+	depends_from = CATEGORY_BEGIN;
+	for_list = true;
+}
+
+const OptimizerCache::HashInfo&
+OptimizerCache::calc_hash(Context &context, const Task::Handle &task) const
+{
+	std::pair<std::map<const Task*, HashInfo>::iterator, bool> i =
+		context.hashes.insert(std::make_pair(task.get(), HashInfo()));
+	HashInfo &info = i.first->second;
+	if (!i.second)
+		return info;
+
+	// results of the same tasks may differ for different renderers,
+	// so the optimizer of renderer is a part of key too
+	Hash hash;
+	hash.add((const void*)this);
+	hash.add((const void*)task->get_token().operator->());
+	if (!task->add_params_to_hash(hash))
+		return info;
+	hash.add(task->source_rect);
+	hash.add(task->target_rect.get_width()).add(task->target_rect.get_height());
+	hash.add(task->sub_tasks.size());
+	for(Task::List::const_iterator j = task->sub_tasks.begin(); j != task->sub_tasks.end(); ++j) {
+		if (!*j) { hash.add(false); continue; }
+		const HashInfo &sub_info = calc_hash(context, *j);
+		if (!sub_info.valid)
+			return info;
+		hash.add(true).add(sub_info.hash);
+	}
+
+	info.valid = true;
+	info.hash = hash.get();
+	return info;
+}
+
+Task::Handle
+OptimizerCache::process_sub_tasks(Context &context, const Task::Handle &task, bool allow_store) const
+{
+	Task::Handle new_task = task;
+	for(Task::List::const_iterator i = task->sub_tasks.begin(); i != task->sub_tasks.end(); ++i) {
+		if (!*i) continue;
+		Task::Handle sub_task = process(context, *i, allow_store);
+		if (sub_task != *i) {
+			if (new_task == task) new_task = task->clone();
+			new_task->sub_tasks[i - task->sub_tasks.begin()] = sub_task;
+		}
+	}
+	return new_task;
+}
+
+Task::Handle
+OptimizerCache::process(Context &context, const Task::Handle &task, bool allow_store) const
+{
+	if (!task || task.type_is<TaskCache>() || task.type_is<TaskSurface>())
+		return task;
+
+	const HashInfo &info = calc_hash(context, task);
+	if ( !info.valid
+	  || !task->is_valid()
+	  || task->target_rect.get_width()*task->target_rect.get_height() < min_area )
+		return process_sub_tasks(context, task, allow_store);
+
+	ResultCache &cache = ResultCache::instance();
+
+	RectInt cached_rect;
+	if (SurfaceResource::Handle surface = cache.find(info.hash, cached_rect)) {
+		++context.hits;
+		TaskCache::Handle cache_task = new TaskCache();
+		cache_task->assign_target(*task);
+		cache_task->hash = info.hash;
+		cache_task->task_bounds = task->get_bounds();
+		cache_task->cached_surface = surface;
+		cache_task->cached_rect = cached_rect;
+		return cache_task;
+	}
+
+	if (allow_store && cache.check_seen(info.hash, context.generation)) {
+		++context.stores;
+		TaskCache::Handle cache_task = new TaskCache();
+		cache_task->assign_target(*task);
+		cache_task->hash = info.hash;
+		cache_task->task_bounds = task->get_bounds();
+
+		// move sub-tree to the separate surface, TaskCache will copy it into the original target
+		cache_task->target_surface = new SurfaceResource();
+		cache_task->target_surface->create(task->target_surface->get_size());
+		Task::Handle sub_task = process_sub_tasks(context, task, false);
+		cache_task->sub_task() = replace_target(cache_task, task->target_surface, sub_task);
+		cache_task->target_surface = task->target_surface;
+		return cache_task;
+	}
+
+	++context.misses;
+	return process_sub_tasks(context, task, allow_store);
+}
+
+void
+OptimizerCache::run(const RunParams &params) const
+{
+	ResultCache &cache = ResultCache::instance();
+	if (!params.list || !cache.get_max_cached())
+		return;
+
+	// root tasks are not cached, they are usually write to the external target surface
+	Context context(cache.next_generation());
+	for(Task::List::iterator i = params.list->begin(); i != params.list->end(); ++i) {
+		if (!*i) continue;
+		Task::Handle task = process_sub_tasks(context, *i, true);
+		if (task != *i) { *i = task; apply(params); }
+	}
+
+	const String &logfile = Renderer::get_debug_options().cache_log;
+	if (!logfile.empty()) {
+		ResultCache::Statistics statistics = cache.get_statistics();
+		debug::Log::info(logfile,
+			"render cache: generation %lld, hits %d, stores %d, misses %d, cached %.1f MB, evictions %d",
+			context.generation,
+			context.hits,
+			context.stores,
+			context.misses,
+			statistics.bytes_cached/(1024.0*1024.0),
+			(int)statistics.evictions );
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
@@ -0,0 +1,95 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/optimizer/optimizercache.h
+**	\brief OptimizerCache Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_OPTIMIZERCACHE_H
+#define __SYNFIG_RENDERING_OPTIMIZERCACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstdint>
+#include <map>
+
+#include "../../optimizer.h"
+#include "../../task.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+//! Replaces the sub-trees of tasks which results are kept in ResultCache by TaskCache.
+//! Sub-tree is identified by the hash of parameters, coordinates and sub-tasks
+//! (see Task::add_params_to_hash()), so only sub-trees where all tasks are hashable are cached.
+//! Sub-trees which are seen in previous frames are wrapped by TaskCache to put result into cache.
+//! Statistics is written to the log when SYNFIG_RENDERING_DEBUG_CACHE_LOG is set.
+class OptimizerCache: public Optimizer
+{
+public:
+	//! smaller tasks are rendered faster than copied from cache
+	static const int min_area = 32*32;
+
+private:
+	struct HashInfo
+	{
+		bool valid;
+		uint64_t hash;
+		HashInfo(): valid(), hash() { }
+	};
+
+	struct Context
+	{
+		long long generation;
+		std::map<const Task*, HashInfo> hashes;
+		int hits;
+		int stores;
+		int misses;
+		explicit Context(long long generation):
+			generation(generation), hits(), stores(), misses() { }
+	};
+
+	const HashInfo& calc_hash(Context &context, const Task::Handle &task) const;
+	Task::Handle process(Context &context, const Task::Handle &task, bool allow_store) const;
+	Task::Handle process_sub_tasks(Context &context, const Task::Handle &task, bool allow_store) const;
+
+public:
+	OptimizerCache();
+	virtual void run(const RunParams &params) const;
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
@@ -32,8 +32,12 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
+
 #include <synfig/general.h>
 #include <synfig/localization.h>
+#include <synfig/color.h>
 
 #include "optimizersplit.h"
 
@@ -46,11 +50,92 @@ using namespace rendering;
 
 /* === G L O B A L S ======================================================= */
 
+namespace {
+
+//! cache of processor (L2) available for one thread, in bytes
+const Real cache_size = 256*1024;
+//! parts for each thread, so threads which are finished early can take the parts of others
+const int parts_per_thread = 4;
+//! cheaper parts are not worth the separate task (in pixels of unit cost)
+const Real min_part_cost = 64*64*4;
+//! total overhead of parts must not exceed this fraction of the useful work
+const Real max_overhead = 0.25;
+
+}
+
 /* === P R O C E D U R E S ================================================= */
 
+//! target and every source which is not the target
+static int
+count_surfaces(const Task &task)
+{
+	int count = 1;
+	for(Task::List::const_iterator i = task.sub_tasks.begin(); i != task.sub_tasks.end(); ++i)
+		if (*i && (*i)->is_valid() && (*i)->target_surface != task.target_surface)
+			++count;
+	return count;
+}
+
+static int
+calc_parts_count(const Task &task, const TaskInterfaceSplit &split, int threads)
+{
+	Real area = (Real)task.target_rect.get_width()*(Real)task.target_rect.get_height();
+	Real cost = area*split.get_split_pixel_cost();
+	Real overhead = split.get_split_overhead();
+
+	// enough parts for all threads, and every part should fit into the cache
+	Real parts = std::max(
+		Real(threads*parts_per_thread),
+		area*count_surfaces(task)*sizeof(Color)/cache_size );
+	// but parts should not be too cheap
+	parts = std::min(parts, cost/min_part_cost);
+	if (overhead > 0.0)
+		parts = std::min(parts, max_overhead*cost/overhead);
+	return parts < 2.0 ? 1 : (int)parts;
+}
+
+//! nearly square parts, rather wider than higher because rows are contiguous in memory
+static void
+split_rect(const RectInt &rect, int parts, std::vector<RectInt> &out)
+{
+	int w = rect.get_width(), h = rect.get_height();
+	Real side = std::sqrt((Real)w*(Real)h/parts);
+	int cols = std::max(1, std::min(w, (int)std::floor(w/side)));
+	int rows = std::max(1, std::min(h, (parts + cols - 1)/cols));
+	for(int r = 0; r < rows; ++r)
+	{
+		int y0 = rect.miny + (int)((long long)h*r/rows);
+		int y1 = rect.miny + (int)((long long)h*(r + 1)/rows);
+		for(int c = 0; c < cols; ++c)
+		{
+			int x0 = rect.minx + (int)((long long)w*c/cols);
+			int x1 = rect.minx + (int)((long long)w*(c + 1)/cols);
+			out.push_back(RectInt(x0, y0, x1, y1));
+		}
+	}
+}
+
+static Task::Handle
+create_part(const Task::Handle &task, const RectInt &rect)
+{
+	Task::Handle part = task->clone();
+	part->trunc_target_rect(rect);
+
+	// sub-tasks which are drawing into the same surface (see TaskInterfaceTargetAsSource)
+	// should be truncated too, otherwise parts will wait for each other
+	for(Task::List::iterator i = part->sub_tasks.begin(); i != part->sub_tasks.end(); ++i)
+		if (*i && (*i)->target_surface == part->target_surface)
+		{
+			*i = (*i)->clone();
+			(*i)->trunc_target_rect(rect);
+		}
+	return part;
+}
+
 /* === M E T H O D S ======================================================= */
 
-OptimizerSplit::OptimizerSplit()
+OptimizerSplit::OptimizerSplit(int threads):
+	threads(std::max(1, threads))
 {
 	category_id = CATEGORY_ID_LIST;
 	depends_from = CATEGORY_SPECIALIZED;
@@ -61,32 +146,31 @@ void
 OptimizerSplit::run(const RunParams &params) const
 {
 	if (!params.list) return;
-	const int min_area = 256*256;
-	for(Task::List::iterator i = params.list->begin(); i != params.list->end(); ++i)
+
+	Task::List list;
+	std::vector<RectInt> rects;
+	bool changed = false;
+	for(Task::List::const_iterator i = params.list->begin(); i != params.list->end(); ++i)
 	{
-		if (TaskInterfaceSplit *split = i->type_pointer<TaskInterfaceSplit>())
-		if (split->is_splittable())
-		{
-			RectInt r = (*i)->target_rect;
-			int w = r.maxx - r.minx;
-			int h = r.maxy - r.miny;
-			int t = std::min(h/10, w*h/min_area);
-			if (t >= 2)
-			{
-				int hh = h/t;
-				int y = r.miny;
-				for(int j = 1; j < t; ++j, y += hh)
-				{
-					Task::Handle task = (*i)->clone();
-					task->trunc_target_rect( RectInt(r.minx, y, r.maxx, y + hh) );
-					i = params.list->insert(i, task);
-					++i;
-				}
-				*i = (*i)->clone();
-				(*i)->trunc_target_rect( RectInt(r.minx, y, r.maxx, r.maxy) );
-				apply(params);
-			}
-		}
+		const Task::Handle &task = *i;
+		const TaskInterfaceSplit *split = task.type_pointer<TaskInterfaceSplit>();
+		int parts = split && split->is_splittable()
+		         && task->is_valid() && task->get_allow_multithreading()
+		          ? calc_parts_count(*task, *split, threads) : 1;
+		if (parts < 2)
+			{ list.push_back(task); continue; }
+
+		rects.clear();
+		split_rect(task->target_rect, parts, rects);
+		for(std::vector<RectInt>::const_iterator j = rects.begin(); j != rects.end(); ++j)
+			list.push_back(create_part(task, *j));
+		changed = true;
+	}
+
+	if (changed)
+	{
+		params.list->swap(list);
+		apply(params);
 	}
 }
 
@@ -43,10 +43,16 @@ namespace synfig
 namespace rendering
 {
 
+//! Splits big tasks into parts which can be processed by different threads at the same time.
+//! Every part is small enough to keep its surfaces in the cache of processor,
+//! and expensive enough to be worth the separate task.
 class OptimizerSplit: public Optimizer
 {
+private:
+	int threads;
+
 public:
-	OptimizerSplit();
+	explicit OptimizerSplit(int threads = 1);
 	virtual void run(const RunParams &params) const;
 };
 
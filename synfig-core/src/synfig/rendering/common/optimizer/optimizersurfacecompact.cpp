@@ -0,0 +1,162 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/optimizer/optimizersurfacecompact.cpp
+**	\brief OptimizerSurfaceCompact
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <map>
+#include <vector>
+
+#include "optimizersurfacecompact.h"
+
+#include "../task/taskblend.h"
+#include "../task/taskblur.h"
+#include "../task/tasksurfaceconvert.h"
+#include "../task/tasktransformation.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+namespace {
+
+//! smaller surfaces are not worth the separate task, in pixels
+const int min_area = 256*256;
+
+struct SurfaceInfo
+{
+	int writer;               //!< index of the last task which writes into surface
+	std::vector<int> readers; //!< indices of tasks which read surface, in order of list
+	bool compatible;          //!< all readers are able to read the compact format
+
+	SurfaceInfo(): writer(-1), compatible(true) { }
+};
+
+typedef std::map<SurfaceResource::Handle, SurfaceInfo> SurfaceMap;
+
+}
+
+/* === P R O C E D U R E S ================================================= */
+
+//! sources which are read by the software tasks without conversion back to synfig::Color
+static bool
+is_compact_reader(const Task::Handle &task, int index)
+{
+	if (task.type_is<TaskBlend>())
+		return index == 1;
+	if (task.type_is<TaskTransformationAffine>() || task.type_is<TaskBlur>())
+		return index == 0;
+	return false;
+}
+
+/* === M E T H O D S ======================================================= */
+
+OptimizerSurfaceCompact::OptimizerSurfaceCompact(const Surface::Token::Handle &format):
+	format(format)
+{
+	category_id = CATEGORY_ID_LIST;
+	depends_from = CATEGORY_SPECIALIZED;
+	for_list = true;
+}
+
+void
+OptimizerSurfaceCompact::run(const RunParams &params) const
+{
+	if (!params.list || !format) return;
+	const Task::List &list = *params.list;
+
+	SurfaceMap surfaces;
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i)
+	{
+		const Task::Handle &task = *i;
+		if (!task || !task->is_valid()) continue;
+		for(Task::List::const_iterator j = task->sub_tasks.begin(); j != task->sub_tasks.end(); ++j)
+			if (*j && (*j)->is_valid() && (*j)->target_surface != task->target_surface)
+			{
+				SurfaceInfo &info = surfaces[(*j)->target_surface];
+				info.readers.push_back(i - list.begin());
+				if (!is_compact_reader(task, j - task->sub_tasks.begin()))
+					info.compatible = false;
+			}
+		surfaces[task->target_surface].writer = i - list.begin();
+	}
+
+	// conversions by index of the last writer
+	std::vector<Task::Handle> converts(list.size());
+	bool changed = false;
+	for(SurfaceMap::const_iterator i = surfaces.begin(); i != surfaces.end(); ++i)
+	{
+		const SurfaceInfo &info = i->second;
+		if ( !info.compatible
+		  || info.writer < 0
+		  || info.readers.empty()
+		  || info.readers.front() <= info.writer ) continue;
+
+		const Task::Handle &writer = list[info.writer];
+		if (writer.type_is<TaskSurfaceConvert>()) continue; // already converted
+		VectorInt size = i->first->get_size();
+		if (size[0]*size[1] < min_area) continue;
+
+		ModeToken::Handle mode = writer->get_mode();
+		bool same_mode = (bool)mode;
+		for(std::vector<int>::const_iterator j = info.readers.begin(); same_mode && j != info.readers.end(); ++j)
+			same_mode = list[*j]->get_mode() == mode;
+		if (!same_mode) continue;
+
+		TaskSurfaceConvert convert;
+		convert.assign_target(*writer);
+		convert.target_rect = RectInt(VectorInt::zero(), size);
+		convert.format = format;
+		if (Task::Handle task = convert.convert_to(mode))
+			{ converts[info.writer] = task; changed = true; }
+	}
+
+	if (changed)
+	{
+		Task::List new_list;
+		new_list.reserve(list.size() + converts.size());
+		for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i)
+		{
+			new_list.push_back(*i);
+			if (const Task::Handle &convert = converts[i - list.begin()])
+				new_list.push_back(convert);
+		}
+		params.list->swap(new_list);
+		apply(params);
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
@@ -0,0 +1,66 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/optimizer/optimizersurfacecompact.h
+**	\brief OptimizerSurfaceCompact Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_OPTIMIZERSURFACECOMPACT_H
+#define __SYNFIG_RENDERING_OPTIMIZERSURFACECOMPACT_H
+
+/* === H E A D E R S ======================================================= */
+
+#include "../../optimizer.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+//! Stores intermediate surfaces in the compact format (half floats or bytes),
+//! when all the tasks which read the surface can read this format directly.
+//! TaskSurfaceConvert is inserted after the last task which writes the surface,
+//! so the big buffer of synfig::Color is freed before the surface is read.
+//! Used by the renderers which don't need the full precision of colors.
+class OptimizerSurfaceCompact: public Optimizer
+{
+private:
+	Surface::Token::Handle format;
+
+public:
+	explicit OptimizerSurfaceCompact(const Surface::Token::Handle &format);
+	virtual void run(const RunParams &params) const;
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
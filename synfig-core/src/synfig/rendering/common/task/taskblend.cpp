@@ -84,4 +84,11 @@ TaskBlend::calc_bounds() const
 	return bounds;
 }
 
+bool
+TaskBlend::add_params_to_hash(Hash &hash) const
+{
+	hash.add(blend_method).add(amount);
+	return true;
+}
+
 /* === E N T R Y P O I N T ================================================= */
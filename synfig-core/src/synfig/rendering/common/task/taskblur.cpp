@@ -69,6 +69,13 @@ TaskBlur::calc_bounds() const
 	return bounds;
 }
 
+bool
+TaskBlur::add_params_to_hash(Hash &hash) const
+{
+	hash.add(blur.type).add(blur.size);
+	return true;
+}
+
 void
 TaskBlur::set_coords_sub_tasks()
 {
@@ -61,6 +61,7 @@ public:
 
 	virtual Rect calc_bounds() const;
 	virtual void set_coords_sub_tasks();
+	virtual bool add_params_to_hash(Hash &hash) const;
 };
 
 } /* end namespace rendering */
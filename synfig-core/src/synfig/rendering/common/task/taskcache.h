@@ -0,0 +1,79 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/task/taskcache.h
+**	\brief TaskCache Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_TASKCACHE_H
+#define __SYNFIG_RENDERING_TASKCACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../../task.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+//! Replaces the sub-tree of tasks which result is kept in ResultCache (see OptimizerCache).
+//! When cached_surface is set, task copies it into cached_rect of target and has no sub-tasks.
+//! Otherwise task copies the result of sub-task into target and puts the copy into cache.
+class TaskCache: public Task
+{
+public:
+	typedef etl::handle<TaskCache> Handle;
+	SYNFIG_EXPORT static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	uint64_t hash;
+	Rect task_bounds; //!< bounds of the replaced sub-tree
+	SurfaceResource::Handle cached_surface; //!< has the size of cached_rect
+	RectInt cached_rect; //!< area covered by cached_surface, relative to target_rect
+
+	TaskCache(): hash(), task_bounds(Rect::infinite()) { }
+
+	const Task::Handle& sub_task() const { return Task::sub_task(0); }
+	Task::Handle& sub_task() { return Task::sub_task(0); }
+
+	virtual Rect calc_bounds() const
+		{ return task_bounds; }
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
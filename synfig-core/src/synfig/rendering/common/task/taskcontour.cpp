@@ -60,4 +60,20 @@ TaskContour::calc_bounds() const
          :                   contour->calc_bounds(transformation->matrix);
 }
 
+bool
+TaskContour::add_params_to_hash(Hash &hash) const
+{
+	if (!contour)
+		return false;
+	hash.add(contour->calc_hash())
+		.add(contour->invert)
+		.add(contour->antialias)
+		.add(contour->winding_style)
+		.add(contour->color)
+		.add(detail)
+		.add(allow_antialias)
+		.add(transformation->matrix);
+	return true;
+}
+
 /* === E N T R Y P O I N T ================================================= */
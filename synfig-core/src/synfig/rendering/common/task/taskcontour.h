@@ -61,6 +61,7 @@ public:
 	TaskContour(): detail(1.0), allow_antialias(true) { }
 
 	virtual Rect calc_bounds() const;
+	virtual bool add_params_to_hash(Hash &hash) const;
 
 	virtual Transformation::Handle get_transformation() const
 		{ return transformation.handle(); }
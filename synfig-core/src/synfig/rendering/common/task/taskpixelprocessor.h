@@ -100,12 +100,19 @@ public:
 	Gamma gamma;
 	TaskPixelGamma() { }
 
+	//! pow() for every channel, mostly by table (see software::PowTable)
+	virtual Real get_split_pixel_cost() const
+		{ return 2.0; }
+
 	virtual bool is_transparent() const
 	{
 		return approximate_equal_lp(gamma.get_r(), ColorReal(1.0))
 			&& approximate_equal_lp(gamma.get_g(), ColorReal(1.0))
 			&& approximate_equal_lp(gamma.get_b(), ColorReal(1.0));
 	}
+
+	virtual bool add_params_to_hash(Hash &hash) const
+		{ hash.add(gamma.get_r()).add(gamma.get_g()).add(gamma.get_b()); return true; }
 };
 
 
@@ -118,6 +125,9 @@ public:
 
 	ColorMatrix matrix;
 
+	virtual Real get_split_pixel_cost() const
+		{ return 2.0; }
+
 	virtual bool is_zero() const
 		{ return matrix.is_transparent(); }
 	virtual bool is_transparent() const
@@ -126,6 +136,9 @@ public:
 		{ return matrix.is_constant(); }
 	virtual bool is_affects_transparent() const
 		{ return matrix.is_affects_transparent(); }
+
+	virtual bool add_params_to_hash(Hash &hash) const
+		{ hash.add(matrix.c); return true; }
 };
 
 
@@ -0,0 +1,75 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/task/taskprocedural.cpp
+**	\brief TaskProcedural
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "taskprocedural.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+
+SYNFIG_EXPORT Task::Token TaskProcedural::token(
+	DescAbstract<TaskProcedural>("Procedural") );
+
+
+TaskProcedural::Generator::~Generator() { }
+
+void
+TaskProcedural::Generator::fill_row(Color *row, int count, const Vector &point, const Vector &step, const Vector &pixel_size) const
+{
+	Vector p = point;
+	for(Color *end = row + count; row < end; ++row, p += step)
+		*row = get_color(p, pixel_size);
+}
+
+Rect
+TaskProcedural::calc_bounds() const
+{
+	if (!generator)
+		return Rect::zero();
+	Rect bounds = generator->get_bounds();
+	return bounds.is_full_infinite() ? bounds
+	     : transformation->transform_bounds(bounds).rect;
+}
+
+/* === E N T R Y P O I N T ================================================= */
@@ -0,0 +1,100 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/task/taskprocedural.h
+**	\brief TaskProcedural Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_TASKPROCEDURAL_H
+#define __SYNFIG_RENDERING_TASKPROCEDURAL_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/color.h>
+
+#include "../../task.h"
+#include "tasktransformation.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+//! Fills the target by color which is a function of the position,
+//! used by gradients, noises and other layers which does not depend on the context.
+//! Task is splittable, so big targets are rendered by several threads.
+class TaskProcedural: public Task, public TaskInterfaceTransformation
+{
+public:
+	typedef etl::handle<TaskProcedural> Handle;
+	SYNFIG_EXPORT static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	//! Source of colors.
+	//! Parts of task are rendered at the same time, so all methods must be thread-safe,
+	//! usually generator keeps the copy of layer parameters and never changes them.
+	class Generator: public etl::shared_object
+	{
+	public:
+		typedef etl::handle<Generator> Handle;
+
+		virtual ~Generator();
+
+		//! Color at the point (in units of layer),
+		//! pixel_size is the size of pixel in the same units, zero if pixel is not known.
+		virtual Color get_color(const Vector &point, const Vector &pixel_size) const = 0;
+
+		//! Fills 'count' pixels of the row, every next pixel is placed at 'step' from the previous one.
+		//! Override it when the row may be calculated faster than the separate pixels.
+		virtual void fill_row(Color *row, int count, const Vector &point, const Vector &step, const Vector &pixel_size) const;
+
+		//! Pixels outside of bounds are transparent
+		virtual Rect get_bounds() const
+			{ return Rect::infinite(); }
+
+		//! Estimated time to calculate one pixel, relative to the simple blending
+		virtual Real get_pixel_cost() const
+			{ return 1.0; }
+	};
+
+	Generator::Handle generator;
+	Holder<TransformationAffine> transformation;
+
+	virtual Rect calc_bounds() const;
+
+	virtual Transformation::Handle get_transformation() const
+		{ return transformation.handle(); }
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
@@ -0,0 +1,64 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/task/tasksurfaceconvert.h
+**	\brief TaskSurfaceConvert Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_TASKSURFACECONVERT_H
+#define __SYNFIG_RENDERING_TASKSURFACECONVERT_H
+
+/* === H E A D E R S ======================================================= */
+
+#include "../../task.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+//! Converts the target surface into the given format and drops all other formats,
+//! so the memory of surface is freed until the surface will be requested in other format.
+//! Task has no sub-tasks, it works with the surface which was already rendered.
+class TaskSurfaceConvert: public Task
+{
+public:
+	typedef etl::handle<TaskSurfaceConvert> Handle;
+	SYNFIG_EXPORT static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	Surface::Token::Handle format;
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
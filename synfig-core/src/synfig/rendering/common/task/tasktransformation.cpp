@@ -137,4 +137,11 @@ TaskTransformationAffine::get_pass_subtask_index() const
 	return TaskTransformation::get_pass_subtask_index();
 }
 
+bool
+TaskTransformationAffine::add_params_to_hash(Hash &hash) const
+{
+	hash.add(interpolation).add(supersample).add(transformation->matrix);
+	return true;
+}
+
 /* === E N T R Y P O I N T ================================================= */
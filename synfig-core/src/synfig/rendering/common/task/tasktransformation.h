@@ -103,6 +103,7 @@ public:
 		{ return transformation.handle(); }
 
 	virtual int get_pass_subtask_index() const;
+	virtual bool add_params_to_hash(Hash &hash) const;
 };
 
 
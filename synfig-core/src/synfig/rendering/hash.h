@@ -0,0 +1,89 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/hash.h
+**	\brief Hash Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_HASH_H
+#define __SYNFIG_RENDERING_HASH_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <synfig/rect.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+//! Accumulates FNV-1a hash of the raw bytes of values.
+//! Values should not have padding bytes (Real, Vector, Rect, Matrix, Color, enums etc).
+class Hash
+{
+private:
+	uint64_t value;
+
+public:
+	Hash(): value(14695981039346656037ull) { }
+
+	void add_bytes(const void *data, size_t size)
+	{
+		const unsigned char *c = (const unsigned char*)data;
+		for(const unsigned char *end = c + size; c != end; ++c)
+			value = (value ^ *c) * 1099511628211ull;
+	}
+
+	template<typename T>
+	Hash& add(const T &x)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be hashed by bytes");
+		add_bytes(&x, sizeof(x));
+		return *this;
+	}
+
+	Hash& add(const Rect &x)
+		{ return add(x.minx).add(x.miny).add(x.maxx).add(x.maxy); }
+	Hash& add(const RectInt &x)
+		{ return add(x.minx).add(x.miny).add(x.maxx).add(x.maxy); }
+
+	uint64_t get() const
+		{ return value; }
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
@@ -34,6 +34,7 @@
 
 #include <algorithm>
 
+#include "../hash.h"
 #include "intersector.h"
 
 #include "contour.h"
@@ -583,6 +584,20 @@ Contour::calc_bounds(const Matrix &transform_matrix) const
 	return bounds;
 }
 
+uint64_t
+Contour::calc_hash(const ChunkList &chunks)
+{
+	Hash hash;
+	for(ChunkList::const_iterator i = chunks.begin(); i != chunks.end(); ++i) {
+		hash.add(i->type).add(i->p1);
+		if (i->type == CONIC || i->type == CUBIC)
+			hash.add(i->pp0);
+		if (i->type == CUBIC)
+			hash.add(i->pp1);
+	}
+	return hash.get();
+}
+
 Rect
 Contour::get_bounds() const
 {
@@ -30,6 +30,7 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <cstdint>
 #include <vector>
 
 #include <ETL/handle>
@@ -168,6 +169,11 @@ public:
 
 	const ChunkList& get_chunks() const { return chunks; }
 
+	//! hash of the chunks content, equal chunks have equal hashes
+	static uint64_t calc_hash(const ChunkList &chunks);
+	uint64_t calc_hash() const
+		{ return calc_hash(chunks); }
+
 	Rect calc_bounds() const;
 	Rect calc_bounds(const Matrix &transform_matrix) const;
 
@@ -156,11 +156,62 @@ Polyspan::sort_marks()
 		addcurrent();
 		current.setcover(0,0);
 
-		std::sort(covers.begin() + open_index,covers.end());
+		// stable sort keeps the order of marks of the same pixel,
+		// so their cover is summed in the same order as in software::Contour::render_polyspan_bands()
+		std::stable_sort(covers.begin() + open_index,covers.end());
 		flags &= ~NotSorted;
 	}
 }
 
+//add the current cell to the marks without sorting
+void
+Polyspan::flush_marks()
+{
+	finish_line();
+	addcurrent();
+	current.setcover(0,0);
+}
+
+//replace all marks by the sorted marks moved by (dx, dy) and clipped by window
+void
+Polyspan::assign_marks(const cover_array &sorted_marks, int dx, int dy)
+{
+	covers.clear();
+	covers.reserve(sorted_marks.size());
+	cur_x = cur_y = close_x = close_y = 0;
+	open_index = 0;
+	current.set(0, 0, 0, 0);
+	flags = 0;
+
+	cover_array::const_iterator i = sorted_marks.begin();
+	cover_array::const_iterator end = sorted_marks.end();
+	while(i != end)
+	{
+		int y = i->y + dy;
+		if (y < window.miny) { ++i; continue; }
+		if (y >= window.maxy) break;
+
+		//the cover of marks to the left is going to the left border, area has no effect there
+		bool has_left = false;
+		Real left = 0;
+		for(; i != end && i->y + dy == y && i->x + dx < window.minx; ++i)
+			{ left += i->cover; has_left = true; }
+		if (has_left)
+			covers.push_back(PenMark(window.minx, y, left, 0));
+
+		for(; i != end && i->y + dy == y && i->x + dx < window.maxx; ++i)
+			covers.push_back(PenMark(i->x + dx, y, i->cover, i->area));
+
+		//mark at the right border terminates the span
+		bool has_right = false;
+		Real right = 0;
+		for(; i != end && i->y + dy == y; ++i)
+			{ right += i->cover; has_right = true; }
+		if (has_right)
+			covers.push_back(PenMark(window.maxx, y, right, 0));
+	}
+}
+
 //encapsulate the current sublist of marks (used for drawing)
 void
 Polyspan::encapsulate_current()
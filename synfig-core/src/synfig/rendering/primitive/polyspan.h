@@ -138,6 +138,7 @@ public:
 
 	const RectInt& get_window() const { return window; }
 	const cover_array& get_covers() const { return covers; }
+	bool is_sorted() const { return !(flags & NotSorted); }
 
 	bool notclosed() const
 		{ return (flags & NotClosed) || (cur_x != close_x) || (cur_y != close_y); }
@@ -164,6 +165,13 @@ public:
 	//will sort the marks if they are not sorted
 	void sort_marks();
 
+	//finish the current cell, so all marks are in get_covers() (not sorted)
+	void flush_marks();
+
+	//replace all marks by the sorted marks moved by (dx, dy) and clipped by window,
+	//marks out of window are merged at its borders like the clipped primitives
+	void assign_marks(const cover_array &sorted_marks, int dx, int dy);
+
 	//encapsulate the current sublist of marks (used for drawing)
 	void encapsulate_current();
 
@@ -53,6 +53,7 @@
 #include "software/rendererpreviewsw.h"
 #include "software/rendererlowressw.h"
 #include "software/renderersafe.h"
+#include "software/function/polyspancache.h"
 #ifdef WITH_OPENGL
 #include "opengl/renderergl.h"
 #include "opengl/task/taskgl.h"
@@ -838,6 +839,10 @@ Renderer::enqueue(const Task::List &list, const TaskEvent::Handle &finish_event_
 	if (!quiet && !get_debug_options().task_list_log.empty())
 		log(get_debug_options().task_list_log, list, "input list");
 
+	// sub queues are the parts of the same frame
+	if (!finish_event_task->renderer_data.priority_event)
+		software::PolyspanCache::instance().next_generation();
+
 	Task::List optimized_list(list);
 	optimize(optimized_list);
 	find_deps(optimized_list, ++last_batch_index);
@@ -851,9 +856,16 @@ Renderer::enqueue(const Task::List &list, const TaskEvent::Handle &finish_event_
 
 	if (finish_event_task)
 	{
+		// tasks of sub queue have priority of the task which created them
+		const TaskEvent *priority_event = finish_event_task->renderer_data.priority_event;
+		if (!priority_event) priority_event = finish_event_task.get();
+		finish_event_task->renderer_data.priority_event = priority_event;
+
 		finish_event_task->renderer_data.deps.insert(optimized_list.begin(), optimized_list.end());
-		for(Task::List::const_iterator i = optimized_list.begin(); i != optimized_list.end(); ++i)
+		for(Task::List::const_iterator i = optimized_list.begin(); i != optimized_list.end(); ++i) {
 			(*i)->renderer_data.back_deps.insert(finish_event_task);
+			(*i)->renderer_data.priority_event = priority_event;
+		}
 		optimized_list.push_back(finish_event_task);
 	}
 
@@ -869,6 +881,9 @@ void Renderer::cancel(const Task::Handle &task)
 void Renderer::cancel(const Task::List &list)
 	{ if (queue) queue->cancel(list); }
 
+void Renderer::set_priority(const TaskEvent::Handle &event, int priority)
+	{ if (queue) queue->set_priority(event, priority); else if (event) event->set_priority(priority); }
+
 void
 Renderer::log(
 	const String &logfile,
@@ -936,7 +951,7 @@ Renderer::log(
 				t->get_bounds().maxx, t->get_bounds().maxy )
 			  : "" )
 			+ ( t->target_surface
-              ? strprintf(" source (%f, %f)-(%f, %f) target (%d, %d)-(%d, %d) surface [%s] (%dx%d) id %d",
+              ? strprintf(" source (%f, %f)-(%f, %f) target (%d, %d)-(%d, %d) surface [%s] (%dx%d) id %llu",
 				t->source_rect.minx, t->source_rect.miny,
 				t->source_rect.maxx, t->source_rect.maxy,
 				t->target_rect.minx, t->target_rect.miny,
@@ -944,7 +959,7 @@ Renderer::log(
 				surfaces.c_str(),
 				t->target_surface->get_width(),
 				t->target_surface->get_height(),
-				t->target_surface->get_id() )
+				(unsigned long long)t->target_surface->get_id() )
 		      : "" ));
 		for(Task::List::const_iterator i = t->sub_tasks.begin(); i != t->sub_tasks.end(); ++i)
 			log(logfile, *i, use_stack ? optimization_stack : nullptr, level+1);
@@ -989,6 +1004,8 @@ Renderer::initialize()
 		debug_options.task_list_optimized_log = s;
 	if (const char *s = getenv("SYNFIG_RENDERING_DEBUG_RESULT_IMAGE"))
 		debug_options.result_image = s;
+	if (const char *s = getenv("SYNFIG_RENDERING_DEBUG_CACHE_LOG"))
+		debug_options.cache_log = s;
 
 	renderers = new std::map<String, Handle>();
 	queue = new RenderQueue();
@@ -60,6 +60,7 @@ public:
 		String task_list_log;
 		String task_list_optimized_log;
 		String result_image;
+		String cache_log;
 	};
 
 private:
@@ -165,6 +166,8 @@ public:
 
 	static void cancel(const Task::Handle &task);
 	static void cancel(const Task::List &list);
+	//! Changes priority of the finish event of the enqueued batch
+	static void set_priority(const TaskEvent::Handle &event, int priority);
 
 	// function to use in signals
 	static void enqueue_task_func(Renderer::Handle renderer, Task::Handle task, TaskEvent::Handle finish_event_task, bool quiet)
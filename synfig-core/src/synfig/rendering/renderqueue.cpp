@@ -32,9 +32,9 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
 #include <cstdlib>
 
-
 #include <synfig/general.h>
 #include <synfig/localization.h>
 #include <synfig/debug/debugsurface.h>
@@ -86,13 +86,25 @@ Task::Token TaskSubQueue::token(
 } // end of anonimous namespace
 
 
-RenderQueue::RenderQueue(): started(false) { start(); }
+RenderQueue::ThreadQueue::ThreadQueue():
+	last_order(0),
+	priority_version(0),
+	top_priority(INT_MIN)
+	{ }
+
+RenderQueue::RenderQueue():
+	started(false),
+	ready_count(0),
+	sleeping_count(0),
+	next_queue(0),
+	priority_version(0)
+	{ start(); }
+
 RenderQueue::~RenderQueue() { stop(); }
 
 void
 RenderQueue::start()
 {
-	std::lock_guard<std::mutex> lock(mutex);
 	if (started) return;
 
 	// one thread reserved for non-multithreading tasks (OpenGL)
@@ -110,23 +122,28 @@ RenderQueue::start()
 	if (count > SYNFIG_RENDERING_MAX_THREADS) count = SYNFIG_RENDERING_MAX_THREADS;
 	if (count < 2) count = 2;
 
+	// queues must exist before threads are started
+	for(unsigned int i = 1; i < count; ++i)
+		queues.push_back(std::unique_ptr<ThreadQueue>(new ThreadQueue()));
+	started = true;
+
 	for(unsigned int i = 0; i < count; ++i)
 		threads.push_back(
 			std::thread(
 				sigc::bind(sigc::mem_fun(*this, &RenderQueue::process), i) ));
 	info("rendering threads %d", count);
-	started = true;
 }
 
 void
 RenderQueue::stop()
 {
 	{
-		std::lock_guard<std::mutex> lock(mutex);
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		std::lock_guard<std::mutex> single_lock(single_queue.mutex);
 		started = false;
-		cond.notify_all();
-		single_cond.notify_all();
 	}
+	cond.notify_all();
+	single_cond.notify_all();
 	while(!threads.empty())
 		{ threads.front().join(); threads.pop_front(); }
 }
@@ -136,13 +153,8 @@ RenderQueue::process(int thread_index)
 {
 	while(Task::Handle task = get(thread_index))
 	{
-		#ifdef DEBUG_THREAD_TASK
-		info( "thread %d: begin task #%05d-%04d '%s'",
-			  thread_index,
-			  task->renderer_data.batch_index,
-			  task->renderer_data.index,
-			  task->get_token()->name.c_str() );
-		#endif
+		// all deps are done, references to them are not needed anymore
+		task->renderer_data.deps.clear();
 
 		if (TaskSubQueue::Handle task_sub_queue = TaskSubQueue::Handle::cast_dynamic(task))
 		{
@@ -151,6 +163,21 @@ RenderQueue::process(int thread_index)
 			continue;
 		}
 
+		// nobody waits for the result, but back deps still must be released
+		if (!is_required(*task))
+		{
+			done(thread_index, task);
+			continue;
+		}
+
+		#ifdef DEBUG_THREAD_TASK
+		info( "thread %d: begin task #%05d-%04d '%s'",
+			  thread_index,
+			  task->renderer_data.batch_index,
+			  task->renderer_data.index,
+			  task->get_token()->name.c_str() );
+		#endif
+
 		bool success = false;
 		try {
 			success = task->run(task->renderer_data.params);
@@ -162,10 +189,10 @@ RenderQueue::process(int thread_index)
 		debug::DebugSurface::save_to_file(
 			task->target_surface,
 			strprintf(
-				"task-%05d-%04d-%05d",
+				"task-%05d-%04d-%05llu",
 				task->renderer_data.batch_index,
 				task->renderer_data.index,
-				task->target_surface ? task->target_surface->get_id() : 0 ));
+				(unsigned long long)(task->target_surface ? task->target_surface->get_id() : 0) ));
 		#endif
 
 		#ifdef DEBUG_THREAD_TASK
@@ -182,6 +209,7 @@ RenderQueue::process(int thread_index)
 			{
 				TaskSubQueue::Handle task_sub_queue(new TaskSubQueue());
 				task_sub_queue->sub_task() = task;
+				task_sub_queue->renderer_data.priority_event = task->renderer_data.priority_event;
 				task->renderer_data.params.renderer->enqueue(task->renderer_data.params.sub_queue, task_sub_queue, true);
 				continue;
 			}
@@ -192,74 +220,197 @@ RenderQueue::process(int thread_index)
 	}
 }
 
+int
+RenderQueue::get_priority(const Task &task)
+{
+	const TaskEvent *event = task.renderer_data.priority_event;
+	return event ? event->get_priority() : 0;
+}
+
+void
+RenderQueue::push_locked(ThreadQueue &queue, const Task::Handle &task)
+{
+	Entry entry;
+	entry.task = task;
+	entry.priority = get_priority(*task);
+	entry.batch_index = task->renderer_data.batch_index;
+	entry.order = ++queue.last_order;
+	queue.tasks.push_back(entry);
+	std::push_heap(queue.tasks.begin(), queue.tasks.end(), EntryLess());
+	queue.top_priority = queue.tasks.front().priority;
+}
+
+void
+RenderQueue::refresh_locked(ThreadQueue &queue)
+{
+	// priorities were changed, so heap is rebuilt (it's rare, when user moves the time cursor)
+	int version = priority_version;
+	if (queue.priority_version == version)
+		return;
+	queue.priority_version = version;
+	for(TaskQueue::iterator i = queue.tasks.begin(); i != queue.tasks.end(); ++i)
+		i->priority = get_priority(*i->task);
+	std::make_heap(queue.tasks.begin(), queue.tasks.end(), EntryLess());
+	queue.top_priority = queue.tasks.empty() ? INT_MIN : queue.tasks.front().priority;
+}
+
+Task::Handle
+RenderQueue::pop_locked(ThreadQueue &queue)
+{
+	refresh_locked(queue);
+	if (queue.tasks.empty())
+		return Task::Handle();
+
+	std::pop_heap(queue.tasks.begin(), queue.tasks.end(), EntryLess());
+	Task::Handle task = queue.tasks.back().task;
+	queue.tasks.pop_back();
+	queue.top_priority = queue.tasks.empty() ? INT_MIN : queue.tasks.front().priority;
+	return task;
+}
+
+Task::Handle
+RenderQueue::pop(ThreadQueue &queue)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	Task::Handle task = pop_locked(queue);
+	if (task)
+		--ready_count;
+	return task;
+}
+
+bool
+RenderQueue::push(int thread_index, const Task::Handle &task)
+{
+	if (!task->get_allow_multithreading())
+	{
+		std::lock_guard<std::mutex> lock(single_queue.mutex);
+		push_locked(single_queue, task);
+		return false;
+	}
+
+	// worker keeps new tasks for itself, other threads spread them between workers
+	int index = thread_index > 0
+	          ? thread_index - 1
+	          : (int)(next_queue++ % queues.size());
+	ThreadQueue &queue = *queues[index];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		push_locked(queue, task);
+	}
+	++ready_count;
+	return true;
+}
+
+void
+RenderQueue::wakeup(int count, bool single)
+{
+	if (single)
+		single_cond.notify_one();
+
+	if (count > 0 && sleeping_count > 0)
+	{
+		// sleeping thread checks ready_count under this lock
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		for(int i = std::min(count, sleeping_count.load()); i > 0; --i)
+			cond.notify_one();
+	}
+}
+
 void
 RenderQueue::done(int thread_index, const Task::Handle &task)
 {
 	assert(task);
-	int single_signals = 0;
 	int signals = 0;
-	std::lock_guard<std::mutex> lock(mutex);
+	bool single_signal = false;
 	for(Task::Set::iterator i = task->renderer_data.back_deps.begin(); i != task->renderer_data.back_deps.end(); ++i)
 	{
 		assert(*i);
-		(*i)->renderer_data.deps.erase(task);
-		if ((*i)->renderer_data.deps.empty())
+		if (--(*i)->renderer_data.deps_count == 0)
 		{
-			bool mt = (*i)->get_allow_multithreading();
-			TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-			TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-			wait.erase(*i);
-			queue.push_back(*i);
-			++(mt ? signals : single_signals);
+			if (push(thread_index, *i))
+				++signals;
+			else
+				single_signal = true;
 		}
 	}
 	task->renderer_data.back_deps.clear();
-	assert( tasks_in_process.count(thread_index) == 1 );
-	tasks_in_process.erase(thread_index);
-	//info("rendering threads used %d", tasks_in_process.size());
-
-	// limit signals count
-	int threads = get_threads_count() - 1;
-	if (signals > threads) signals = threads;
-	if (single_signals > 1) single_signals = 1;
 
 	// we don't need to wakeup the current thread
-	--(thread_index ? signals : single_signals);
+	if (thread_index > 0 && signals > 0)
+		--signals;
 
-	// wake up
-	while(signals-- > 0) cond.notify_one();
-	while(single_signals-- > 0) single_cond.notify_one();
+	wakeup(signals, single_signal);
+}
+
+Task::Handle
+RenderQueue::pop(int thread_index)
+{
+	if (ready_count <= 0)
+		return Task::Handle();
+
+	// choose the queue with the most urgent task, own queue if there is no more urgent tasks
+	const int count = (int)queues.size();
+	const int own = thread_index - 1;
+
+	// every thread keeps priorities of its own queue actual
+	if (queues[own]->priority_version != priority_version)
+	{
+		std::lock_guard<std::mutex> lock(queues[own]->mutex);
+		refresh_locked(*queues[own]);
+	}
+
+	int best = own;
+	int best_priority = queues[own]->top_priority;
+	for(int i = 1; i < count; ++i)
+	{
+		int index = (own + i) % count;
+		int priority = queues[index]->top_priority;
+		if (priority > best_priority)
+			{ best = index; best_priority = priority; }
+	}
+
+	if (best_priority != INT_MIN)
+		if (Task::Handle task = pop(*queues[best]))
+			return task;
+
+	// queue was changed by other thread, take anything
+	for(int i = 0; i < count; ++i)
+		if (Task::Handle task = pop(*queues[(own + i) % count]))
+			return task;
+
+	return Task::Handle();
 }
 
 Task::Handle
 RenderQueue::get(int thread_index)
 {
-	std::unique_lock<std::mutex> lock(mutex);
+	if (thread_index == 0)
+	{
+		std::unique_lock<std::mutex> lock(single_queue.mutex);
+		while(started)
+		{
+			if (Task::Handle task = pop_locked(single_queue))
+				return task;
+			single_cond.wait(lock);
+		}
+		return Task::Handle();
+	}
 
-	TaskQueue &queue  = thread_index == 0 ? single_ready_tasks     : ready_tasks;
-	TaskQueue &queue2 = thread_index != 0 ? single_ready_tasks     : ready_tasks;
-	TaskSet   &wait   = thread_index == 0 ? single_not_ready_tasks : not_ready_tasks;
 	while(started)
 	{
-		if (!queue.empty())
-		{
-			Task::Handle task = queue.front();
-			queue.pop_front();
-			if (!task) continue;
-			assert( tasks_in_process.count(thread_index) == 0 );
-			tasks_in_process[thread_index] = task;
-			//info("rendering threads used %d", tasks_in_process.size());
+		if (Task::Handle task = pop(thread_index))
 			return task;
-		}
 
-		#ifdef DEBUG_THREAD_WAIT
-		if (!wait.empty())
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		++sleeping_count;
+		while(started && ready_count <= 0)
+		{
+			#ifdef DEBUG_THREAD_WAIT
 			info("thread %d: rendering wait for task", thread_index);
-		#endif
-
-		assert( wait.empty() || !tasks_in_process.empty() || !queue2.empty() );
-
-		(thread_index ? cond : single_cond).wait(lock);
+			#endif
+			cond.wait(lock);
+		}
+		--sleeping_count;
 	}
 	return Task::Handle();
 }
@@ -267,94 +418,51 @@ RenderQueue::get(int thread_index)
 void
 RenderQueue::fix_task(const Task &task, const Task::RunParams &params)
 {
-	//for(Task::List::iterator i = task.back_deps.begin(); i != task.back_deps.end();)
-	//	if (*i) ++i; else i = (*i)->back_deps.erase(i);
 	task.renderer_data.params = params;
 	task.renderer_data.params.sub_queue.clear();
 	task.renderer_data.success = true;
-}
-
-int
-RenderQueue::get_threads_count() const
-{
-	return threads.size();
+	task.renderer_data.deps_count = (int)task.renderer_data.deps.size();
 }
 
 bool
-RenderQueue::remove_if_orphan(const Task::Handle &task, bool in_queue)
+RenderQueue::is_required(const Task &task)
 {
-	// mutex must be already locked
-
-	if (!task)
-		return true;
-
-	TaskSet* tasks = nullptr;
-	TaskSet::iterator ii;
-	if (!in_queue) {
-		bool mt = task->get_allow_multithreading();
-		tasks = mt ? &not_ready_tasks : &single_not_ready_tasks;
-		ii = tasks->find(task);
-		if (ii == tasks->end())
-			return true;
-	}
-
-	if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(task))
-		if (!task_event->is_finished())
-			return false;
-
-	if (!task->renderer_data.back_deps.empty())
-		return false;
-		
-	for(TaskSet::iterator i = task->renderer_data.deps.begin(); i != task->renderer_data.deps.end(); ++i)
-		if (*i) {
-			(*i)->renderer_data.back_deps.erase(task);
-			if ((*i)->renderer_data.back_deps.empty())
-				remove_if_orphan(*i, false);
+	if (const TaskSubQueue *task_sub_queue = dynamic_cast<const TaskSubQueue*>(&task))
+		return task_sub_queue->sub_task() && is_required(*task_sub_queue->sub_task());
+	if (const TaskEvent *task_event = dynamic_cast<const TaskEvent*>(&task))
+		return !task_event->is_finished();
+
+	// every task of batch is a dep of finish event of the batch,
+	// so other back deps are checked only when there is no events
+	// (back deps of the waiting task are not changed by other threads)
+	bool events_found = false;
+	for(Task::Set::const_iterator i = task.renderer_data.back_deps.begin(); i != task.renderer_data.back_deps.end(); ++i)
+		if (*i && dynamic_cast<const TaskEvent*>(i->get())) {
+			if (is_required(**i)) return true;
+			events_found = true;
 		}
-	task->renderer_data.deps.clear();
+	if (events_found)
+		return false;
 
-	// don't remove task if 'in_queue' is set (it will removed by caller)
-	if (tasks) tasks->erase(ii);
-	return true;
+	for(Task::Set::const_iterator i = task.renderer_data.back_deps.begin(); i != task.renderer_data.back_deps.end(); ++i)
+		if (*i && is_required(**i))
+			return true;
+	return false;
 }
 
-void
-RenderQueue::remove_orphans()
+int
+RenderQueue::get_threads_count() const
 {
-	// mutex must be already locked
-
-	for(TaskQueue::iterator i = ready_tasks.begin(); i != ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) ready_tasks.erase(i++); else ++i;
-	for(TaskQueue::iterator i = single_ready_tasks.begin(); i != single_ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) single_ready_tasks.erase(i++); else ++i;
-
-	for(TaskSet::iterator i = not_ready_tasks.begin(); i != not_ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) not_ready_tasks.erase(i++); else ++i;
-	for(TaskSet::iterator i = single_not_ready_tasks.begin(); i != single_not_ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) single_not_ready_tasks.erase(i++); else ++i;
+	return threads.size();
 }
 
-
 void
 RenderQueue::enqueue(const Task::Handle &task, const Task::RunParams &params)
 {
 	if (!task) return;
 	fix_task(*task, params);
-	std::lock_guard<std::mutex> lock(mutex);
-
-	bool mt = task->get_allow_multithreading();
-	TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-	TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-	if (task->renderer_data.deps.empty()) {
-		queue.push_back(task);
-		(mt ? cond : single_cond).notify_one();
-	}
-	else
-	{
-		wait.insert(task);
-	}
-
-	remove_orphans();
+	if (task->renderer_data.deps.empty())
+		wakeup(push(-1, task) ? 1 : 0, !task->get_allow_multithreading());
 }
 
 void
@@ -362,75 +470,31 @@ RenderQueue::enqueue(const Task::List &tasks, const Task::RunParams &params)
 {
 	Task::RunParams p(params);
 	p.sub_queue.clear();
-	int count = 0;
-	for(Task::List::const_iterator i = tasks.begin(); i != tasks.end(); ++i)
-		if (*i) { fix_task(**i, p); ++count; }
-	if (!count) return;
 
-	std::lock_guard<std::mutex> lock(mutex);
-	int single_signals = 0;
-	int signals = 0;
+	// all counters must be set before the first task is started,
+	// and task may be already started by another thread when its deps are checked here
+	Task::List ready;
 	for(Task::List::const_iterator i = tasks.begin(); i != tasks.end(); ++i)
-	{
-		if (*i)
-		{
-			bool mt = (*i)->get_allow_multithreading();
-			TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-			TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-			if ((*i)->renderer_data.deps.empty()) {
-				queue.push_back(*i);
-				++(mt ? signals : single_signals);
-			} else {
-				wait.insert(*i);
-			}
+		if (*i) {
+			fix_task(**i, p);
+			if ((*i)->renderer_data.deps.empty())
+				ready.push_back(*i);
 		}
-	}
-
-	// limit signals count
-	int threads = get_threads_count() - 1;
-	if (signals > threads) signals = threads;
-	if (single_signals > 1) single_signals = 1;
 
-	// wake up
-	while(signals-- > 0) cond.notify_one();
-	while(single_signals-- > 0) single_cond.notify_one();
-
-	remove_orphans();
-}
-
-bool
-RenderQueue::remove_task(const Task::Handle &task)
-{
-	bool found = false;
-	if (task) {
-		bool mt = task->get_allow_multithreading();
-		TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-		TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-
-		for(TaskQueue::iterator i = queue.begin(); i != queue.end(); ) {
-			if (*i == task) {
-				found = true;
-				i = queue.erase(i);
-			} else {
-				++i;
-			}
-		}
-		if (wait.erase(task)) found = true;
-	}
-	return found;
+	int signals = 0;
+	bool single_signal = false;
+	for(Task::List::const_iterator i = ready.begin(); i != ready.end(); ++i)
+		if (push(-1, *i))
+			++signals;
+		else
+			single_signal = true;
+
+	wakeup(signals, single_signal);
 }
 
 void
 RenderQueue::cancel(const Task::Handle &task)
 {
-	if (!task) return;
-
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		if (remove_task(task))
-			remove_orphans();
-	}
-
 	if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(task))
 		task_event->finish(false);
 }
@@ -438,34 +502,31 @@ RenderQueue::cancel(const Task::Handle &task)
 void
 RenderQueue::cancel(const Task::List &list)
 {
-	if (list.empty()) return;
-
-	TaskEvent::List events;
-
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		bool found = false;
-		for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i) {
-			if (remove_task(*i))
-				found = true;
-			if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(*i))
-				events.push_back(task_event);
-		}
-		if (found) remove_orphans();
-	}
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i)
+		cancel(*i);
+}
 
-	for(TaskEvent::List::const_iterator i = events.begin(); i != events.end(); ++i)
-		(*i)->finish(false);
+void
+RenderQueue::set_priority(const TaskEvent::Handle &event, int priority)
+{
+	if (!event || event->get_priority() == priority) return;
+	event->set_priority(priority);
+	++priority_version;
 }
 
 void
 RenderQueue::clear()
 {
-	std::lock_guard<std::mutex> lock(mutex);
-	ready_tasks.clear();
-	single_ready_tasks.clear();
-	not_ready_tasks.clear();
-	single_not_ready_tasks.clear();
+	for(ThreadQueueList::iterator i = queues.begin(); i != queues.end(); ++i)
+	{
+		std::lock_guard<std::mutex> lock((*i)->mutex);
+		ready_count -= (int)(*i)->tasks.size();
+		(*i)->tasks.clear();
+		(*i)->top_priority = INT_MIN;
+	}
+	std::lock_guard<std::mutex> lock(single_queue.mutex);
+	single_queue.tasks.clear();
+	single_queue.top_priority = INT_MIN;
 }
 
 /* === E N T R Y P O I N T ================================================= */
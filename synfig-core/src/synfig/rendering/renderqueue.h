@@ -30,11 +30,14 @@
 
 /* === H E A D E R S ======================================================= */
 
-#include <map>
-
+#include <atomic>
+#include <climits>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <vector>
 
 #include "task.h"
 
@@ -49,31 +52,84 @@ namespace synfig
 namespace rendering
 {
 
+/*!	\class RenderQueue
+**	\brief Runs tasks in threads when their deps are done
+**
+**	Thread 0 runs tasks which don't allow multithreading (OpenGL),
+**	every other thread has its own queue of ready tasks.
+**	Thread puts the tasks which became ready into its own queue,
+**	and takes the task from the queue with the most urgent task,
+**	so idle threads steal tasks from queues of other threads.
+**	Tasks are ordered by priority of the finish event of their batch,
+**	then older batches go first, and the newest task of batch goes first
+**	(its data is still in cache).
+**	Deps are counted by atomic Task::RendererData::deps_count,
+**	so the whole queue is never locked.
+**	Tasks which are not required anymore (finish event of its batch is cancelled)
+**	are not removed from the queue, they are skipped when they become ready.
+*/
 class RenderQueue
 {
 public:
 	typedef std::list<std::thread> ThreadList;
-	typedef std::map<int, Task::Handle> ThreadTaskMap;
-	typedef std::set<Task::Handle> TaskSet;
-	typedef std::list<Task::Handle> TaskQueue;
 
 private:
-	static int last_batch_index;
+	struct Entry
+	{
+		Task::Handle task;
+		int priority;
+		int batch_index;
+		long long order;
+	};
+
+	//! Compares entries for heap, the most urgent entry is the greatest one
+	struct EntryLess
+	{
+		bool operator() (const Entry &a, const Entry &b) const {
+			if (a.priority != b.priority) return a.priority < b.priority;
+			if (a.batch_index != b.batch_index) return a.batch_index > b.batch_index;
+			return a.order < b.order;
+		}
+	};
+
+	typedef std::vector<Entry> TaskQueue;
+
+	struct ThreadQueue
+	{
+		std::mutex mutex;
+		//! heap ordered by EntryLess
+		TaskQueue tasks;
+		long long last_order;
+		//! priorities in entries are actual for this priority_version of RenderQueue
+		std::atomic<int> priority_version;
+		//! priority of the top entry, to choose queue without locking
+		std::atomic<int> top_priority;
+
+		ThreadQueue();
+	};
+
+	typedef std::vector< std::unique_ptr<ThreadQueue> > ThreadQueueList;
+
+	std::atomic<bool> started;
 
-	std::mutex mutex;
-	std::mutex threads_mutex;
-	std::condition_variable cond;
-	std::condition_variable single_cond;
+	ThreadList threads;
 
-	TaskQueue ready_tasks;
-	TaskQueue single_ready_tasks;
-	TaskSet not_ready_tasks;
-	TaskSet single_not_ready_tasks;
+	//! queues of threads 1..N, index in list is thread_index - 1
+	ThreadQueueList queues;
+	//! queue for thread 0
+	ThreadQueue single_queue;
 
-	bool started;
+	//! count of tasks in 'queues'
+	std::atomic<int> ready_count;
+	//! threads from 'queues' which wait for tasks
+	std::atomic<int> sleeping_count;
+	std::atomic<unsigned int> next_queue;
+	//! changed when priority of enqueued event is changed
+	std::atomic<int> priority_version;
 
-	ThreadList threads;
-	ThreadTaskMap tasks_in_process;
+	std::mutex sleep_mutex;
+	std::condition_variable cond;
+	std::condition_variable single_cond;
 
 	void start();
 	void stop();
@@ -82,10 +138,21 @@ private:
 	void done(int thread_index, const Task::Handle &task);
 	Task::Handle get(int thread_index);
 
+	static int get_priority(const Task &task);
+	//! queue mutex must be locked
+	void push_locked(ThreadQueue &queue, const Task::Handle &task);
+	//! queue mutex must be locked
+	void refresh_locked(ThreadQueue &queue);
+	//! queue mutex must be locked
+	Task::Handle pop_locked(ThreadQueue &queue);
+	Task::Handle pop(ThreadQueue &queue);
+	Task::Handle pop(int thread_index);
+	//! \return true if task was put into queue of threads 1..N
+	bool push(int thread_index, const Task::Handle &task);
+	void wakeup(int count, bool single);
+
 	static void fix_task(const Task &task, const Task::RunParams &params);
-	bool remove_if_orphan(const Task::Handle &task, bool in_queue);
-	void remove_orphans();
-	bool remove_task(const Task::Handle &task);
+	static bool is_required(const Task &task);
 
 public:
 	RenderQueue();
@@ -94,8 +161,11 @@ public:
 	int get_threads_count() const;
 	void enqueue(const Task::Handle &task, const Task::RunParams &params);
 	void enqueue(const Task::List &tasks, const Task::RunParams &params);
+	//! Cancels TaskEvents, tasks required only by them will be skipped
 	void cancel(const Task::Handle &task);
 	void cancel(const Task::List &list);
+	//! Changes priority of the enqueued event and its tasks
+	void set_priority(const TaskEvent::Handle &event, int priority);
 	void clear();
 };
 
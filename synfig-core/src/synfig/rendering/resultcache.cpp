@@ -0,0 +1,174 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/resultcache.cpp
+**	\brief ResultCache
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "resultcache.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+#define DEF_MAX_CACHED_MB 0
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+const size_t ResultCache::max_seen;
+
+ResultCache::ResultCache():
+	max_cached((size_t)DEF_MAX_CACHED_MB*1024*1024),
+	last_generation()
+{
+	if (const char *s = getenv("SYNFIG_RENDER_CACHE_MAX_MEMORY_MB"))
+		max_cached = (size_t)std::max(0, atoi(s))*1024*1024;
+}
+
+void
+ResultCache::remove_last()
+{
+	map.erase(entries.back().hash);
+	statistics.bytes_cached -= entries.back().size;
+	++statistics.evictions;
+	entries.pop_back();
+}
+
+long long
+ResultCache::next_generation()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return ++last_generation;
+}
+
+SurfaceResource::Handle
+ResultCache::find(uint64_t hash, RectInt &out_rect)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	++statistics.lookups;
+	Map::iterator i = map.find(hash);
+	if (i == map.end())
+		return SurfaceResource::Handle();
+	++statistics.hits;
+	entries.splice(entries.begin(), entries, i->second);
+	out_rect = i->second->rect;
+	return i->second->surface;
+}
+
+bool
+ResultCache::check_seen(uint64_t hash, long long generation)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (seen.size() >= max_seen)
+		seen.clear();
+	std::pair<SeenMap::iterator, bool> i = seen.insert(SeenMap::value_type(hash, generation));
+	if (i.second)
+		return false;
+	bool found = i.first->second != generation;
+	i.first->second = generation;
+	return found;
+}
+
+void
+ResultCache::insert(uint64_t hash, const SurfaceResource::Handle &surface, const RectInt &rect)
+{
+	if (!surface || !surface->is_exists() || surface->get_size() != rect.get_size())
+		return;
+
+	VectorInt size = surface->get_size();
+	Entry entry;
+	entry.hash = hash;
+	entry.surface = surface;
+	entry.rect = rect;
+	entry.size = sizeof(Entry) + (size_t)size[0]*(size_t)size[1]*sizeof(Color);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (entry.size > max_cached || map.count(hash))
+		return;
+	entries.push_front(entry);
+	map[hash] = entries.begin();
+	statistics.bytes_cached += entry.size;
+	++statistics.stores;
+	while(statistics.bytes_cached > max_cached)
+		remove_last();
+}
+
+void
+ResultCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	map.clear();
+	entries.clear();
+	seen.clear();
+	statistics.bytes_cached = 0;
+}
+
+void
+ResultCache::set_max_cached(size_t size)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	max_cached = size;
+	while(statistics.bytes_cached > max_cached)
+		remove_last();
+}
+
+size_t
+ResultCache::get_max_cached() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return max_cached;
+}
+
+ResultCache::Statistics
+ResultCache::get_statistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+ResultCache&
+ResultCache::instance()
+{
+	static ResultCache *cache = new ResultCache();
+	return *cache;
+}
+
+/* === E N T R Y P O I N T ================================================= */
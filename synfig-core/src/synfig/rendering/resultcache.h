@@ -0,0 +1,140 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/resultcache.h
+**	\brief ResultCache Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_RESULTCACHE_H
+#define __SYNFIG_RENDERING_RESULTCACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "surface.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+//! Keeps the rendered results of sub-trees of tasks between frames (see OptimizerCache).
+//! Key is the hash of the sub-tree: parameters of tasks, hashes of sub-tasks and coordinates.
+//! Only results of the sub-trees which are found in two different generations (frames) are kept,
+//! so the sub-trees which are changed every frame are not copied into cache.
+//! Entries are found by hash only and are not verified, so cache is disabled by default
+//! and it is used only by the preview and draft renderers.
+//! Least recently used entries are evicted when the memory limit is reached.
+//! Settings are taken from environment:
+//!   SYNFIG_RENDER_CACHE_MAX_MEMORY_MB - limit of memory kept by cache (0 disables cache, default)
+class ResultCache
+{
+public:
+	//! all sizes are in bytes
+	struct Statistics
+	{
+		size_t lookups;      //!< count of the cacheable sub-trees
+		size_t hits;         //!< sub-trees taken from cache
+		size_t stores;       //!< results put into cache
+		size_t evictions;    //!< entries removed because of the memory limit
+		size_t bytes_cached; //!< memory of entries kept by cache
+
+		Statistics():
+			lookups(), hits(), stores(), evictions(), bytes_cached() { }
+	};
+
+	//! hashes seen in previous generations are forgotten when this count is reached
+	static const size_t max_seen = 65536;
+
+private:
+	struct Entry
+	{
+		uint64_t hash;
+		SurfaceResource::Handle surface;
+		RectInt rect;
+		size_t size;
+	};
+
+	typedef std::list<Entry> List;
+	typedef std::unordered_map<uint64_t, List::iterator> Map;
+	typedef std::unordered_map<uint64_t, long long> SeenMap;
+
+	mutable std::mutex mutex;
+	List entries; //!< recently used entries are first
+	Map map;
+	SeenMap seen; //!< generation when hash was seen last time
+	size_t max_cached;
+	long long last_generation;
+	Statistics statistics;
+
+	ResultCache();
+	ResultCache(const ResultCache&) = delete;
+	ResultCache& operator=(const ResultCache&) = delete;
+
+	void remove_last();
+
+public:
+	//! Returns index of new generation, usually one generation per each optimization of task list
+	long long next_generation();
+
+	//! Returns the cached surface, or null handle.
+	//! \a out_rect is set to the area of result which is covered by surface
+	SurfaceResource::Handle find(uint64_t hash, RectInt &out_rect);
+
+	//! Remembers the hash for the given generation.
+	//! \return true if the same hash was seen in one of previous generations
+	bool check_seen(uint64_t hash, long long generation);
+
+	//! Puts the rendered surface into cache, surface should not be changed after that.
+	//! \a rect is the area of result covered by surface, pixels outside of it are not rendered
+	void insert(uint64_t hash, const SurfaceResource::Handle &surface, const RectInt &rect);
+
+	//! Removes all entries
+	void clear();
+
+	void set_max_cached(size_t size);
+	size_t get_max_cached() const;
+
+	Statistics get_statistics() const;
+
+	static ResultCache& instance();
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
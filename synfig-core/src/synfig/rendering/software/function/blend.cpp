@@ -0,0 +1,448 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/blend.cpp
+**	\brief Blend
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <synfig/color/colorblendingfunctions.h>
+
+#include "blend.h"
+
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define BLEND_SSE2
+#	include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#	define BLEND_NEON
+#	include <arm_neon.h>
+#endif
+
+#if defined(BLEND_SSE2) || defined(BLEND_NEON)
+#	define BLEND_SIMD
+#endif
+
+using namespace synfig;
+using namespace rendering;
+using namespace software;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+typedef Color (*ScalarFunc)(Color&, Color&, float);
+
+// Reference implementation: the same scalar templates as in Color::blend(),
+// but the blend method is resolved at compile time instead of per pixel
+template<ScalarFunc func>
+void
+row_scalar(Color *dest, const Color *src, int count, ColorReal amount)
+{
+	// the same shortcut as in Color::blend()
+	if (std::fabs(amount) <= COLOR_EPSILON) return;
+	for(Color *end = dest + count; dest < end; ++dest, ++src) {
+		Color a = *src;
+		Color b = *dest;
+		*dest = func(a, b, amount);
+	}
+}
+
+
+#ifdef BLEND_SIMD
+
+// One RGBA pixel in the SIMD register.
+// All of the kernels below repeat the operations of scalar templates
+// in the same order, so results are the same as in Color::blend()
+
+#ifdef BLEND_SSE2
+
+class Pixel
+{
+public:
+	__m128 v;
+
+	Pixel() { }
+	explicit Pixel(__m128 v): v(v) { }
+	explicit Pixel(float x): v(_mm_set1_ps(x)) { }
+
+	static Pixel load(const Color *c)
+		{ return Pixel(_mm_loadu_ps(reinterpret_cast<const float*>(c))); }
+	void store(Color *c) const
+		{ _mm_storeu_ps(reinterpret_cast<float*>(c), v); }
+
+	Pixel operator+(const Pixel &x) const { return Pixel(_mm_add_ps(v, x.v)); }
+	Pixel operator-(const Pixel &x) const { return Pixel(_mm_sub_ps(v, x.v)); }
+	Pixel operator*(const Pixel &x) const { return Pixel(_mm_mul_ps(v, x.v)); }
+	Pixel operator/(const Pixel &x) const { return Pixel(_mm_div_ps(v, x.v)); }
+
+	//! alpha channel copied to all lanes
+	Pixel alpha() const
+		{ return Pixel(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+	//! color channels of this pixel and alpha channel of x
+	Pixel with_alpha(const Pixel &x) const {
+		const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+		return Pixel(_mm_or_ps(_mm_andnot_ps(mask, v), _mm_and_ps(mask, x.v)));
+	}
+	Pixel abs() const
+		{ return Pixel(_mm_andnot_ps(_mm_set1_ps(-0.f), v)); }
+
+	static Pixel greater(const Pixel &a, const Pixel &b)
+		{ return Pixel(_mm_cmpgt_ps(a.v, b.v)); }
+	static Pixel equal(const Pixel &a, const Pixel &b)
+		{ return Pixel(_mm_cmpeq_ps(a.v, b.v)); }
+	//! a where mask is set, b otherwise
+	static Pixel select(const Pixel &mask, const Pixel &a, const Pixel &b)
+		{ return Pixel(_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))); }
+};
+
+#else // BLEND_NEON
+
+class Pixel
+{
+public:
+	float32x4_t v;
+
+	Pixel() { }
+	explicit Pixel(float32x4_t v): v(v) { }
+	explicit Pixel(float x): v(vdupq_n_f32(x)) { }
+
+	static Pixel load(const Color *c)
+		{ return Pixel(vld1q_f32(reinterpret_cast<const float*>(c))); }
+	void store(Color *c) const
+		{ vst1q_f32(reinterpret_cast<float*>(c), v); }
+
+	Pixel operator+(const Pixel &x) const { return Pixel(vaddq_f32(v, x.v)); }
+	Pixel operator-(const Pixel &x) const { return Pixel(vsubq_f32(v, x.v)); }
+	Pixel operator*(const Pixel &x) const { return Pixel(vmulq_f32(v, x.v)); }
+	Pixel operator/(const Pixel &x) const { return Pixel(vdivq_f32(v, x.v)); }
+
+	//! alpha channel copied to all lanes
+	Pixel alpha() const
+		{ return Pixel(vdupq_laneq_f32(v, 3)); }
+	//! color channels of this pixel and alpha channel of x
+	Pixel with_alpha(const Pixel &x) const
+		{ return Pixel(vsetq_lane_f32(vgetq_lane_f32(x.v, 3), v, 3)); }
+	Pixel abs() const
+		{ return Pixel(vabsq_f32(v)); }
+
+	static Pixel greater(const Pixel &a, const Pixel &b)
+		{ return Pixel(vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v))); }
+	static Pixel equal(const Pixel &a, const Pixel &b)
+		{ return Pixel(vreinterpretq_f32_u32(vceqq_f32(a.v, b.v))); }
+	//! a where mask is set, b otherwise
+	static Pixel select(const Pixel &mask, const Pixel &a, const Pixel &b)
+		{ return Pixel(vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)); }
+};
+
+#endif
+
+
+const Color transparent_color = Color::alpha();
+
+// see blendfunc_COMPOSITE
+inline Pixel
+pixel_composite(const Pixel &src, const Pixel &dest, const Pixel &amount)
+{
+	const Pixel one(1.f);
+	Pixel a_src = src.alpha()*amount;
+	Pixel a_dest = dest.alpha();
+	Pixel k = one - a_src;
+	Pixel a = a_src + a_dest*k;
+	Pixel c = src*a_src + dest*a_dest*k;
+	c = (c*(one/a)).with_alpha(a);
+	return Pixel::select(Pixel::greater(a.abs(), Pixel(COLOR_EPSILON)), c, Pixel::load(&transparent_color));
+}
+
+// see blendfunc_STRAIGHT
+inline Pixel
+pixel_straight(const Pixel &src, const Pixel &dest, const Pixel &amount)
+{
+	const Pixel one(1.f);
+	Pixel a_src = src.alpha();
+	Pixel a_dest = dest.alpha();
+	Pixel a = (a_src - a_dest)*amount + a_dest;
+	Pixel c = ((src*a_src - dest*a_dest)*amount + dest*a_dest)*(one/a);
+	c = c.with_alpha(a);
+	return Pixel::select(Pixel::greater(a.abs(), Pixel(COLOR_EPSILON)), c, Pixel::load(&transparent_color));
+}
+
+// see blendfunc_ONTO
+inline Pixel
+pixel_onto(const Pixel &src, const Pixel &dest, const Pixel &amount)
+	{ return pixel_composite(src, dest.with_alpha(Pixel(1.f)), amount).with_alpha(dest); }
+
+// see blendfunc_BEHIND
+inline Pixel
+pixel_behind(const Pixel &src, const Pixel &dest, const Pixel &amount)
+{
+	Pixel a_src = src.alpha();
+	a_src = Pixel::select(
+		Pixel::equal(a_src, Pixel(0.f)),
+		Pixel(COLOR_EPSILON)*amount,
+		a_src*amount );
+	return pixel_composite(dest, src.with_alpha(a_src), Pixel(1.f));
+}
+
+// see blendfunc_ADD
+inline Pixel
+pixel_add(const Pixel &src, const Pixel &dest, const Pixel &amount)
+	{ return (dest*dest.alpha() + src*(src.alpha()*amount)).with_alpha(dest); }
+
+// see blendfunc_SUBTRACT
+inline Pixel
+pixel_subtract(const Pixel &src, const Pixel &dest, const Pixel &amount)
+	{ return (dest*dest.alpha() - src*(src.alpha()*amount)).with_alpha(dest); }
+
+// see blendfunc_MULTIPLY, only for non-negative amount
+inline Pixel
+pixel_multiply(const Pixel &src, const Pixel &dest, const Pixel &amount)
+	{ return ((dest*src - dest)*(amount*src.alpha()) + dest).with_alpha(dest); }
+
+template<Pixel func(const Pixel&, const Pixel&, const Pixel&)>
+void
+row_simd(Color *dest, const Color *src, int count, ColorReal amount)
+{
+	// the same shortcut as in Color::blend()
+	if (std::fabs(amount) <= COLOR_EPSILON) return;
+	const Pixel a(amount);
+	for(Color *end = dest + count; dest < end; ++dest, ++src)
+		func(Pixel::load(src), Pixel::load(dest), a).store(dest);
+}
+
+void
+row_simd_multiply(Color *dest, const Color *src, int count, ColorReal amount)
+{
+	// negative amount inverts the color, leave it for scalar version
+	if (amount < 0)
+		row_scalar< blendfunc_MULTIPLY<Color> >(dest, src, count, amount);
+	else
+		row_simd<pixel_multiply>(dest, src, count, amount);
+}
+
+#endif // BLEND_SIMD
+
+
+const Blend::RowFunc reference_row_funcs[Color::BLEND_END] = {
+	row_scalar< blendfunc_COMPOSITE<Color> >,      // 0
+	row_scalar< blendfunc_STRAIGHT<Color> >,
+	row_scalar< blendfunc_BRIGHTEN<Color> >,
+	row_scalar< blendfunc_DARKEN<Color> >,
+	row_scalar< blendfunc_ADD<Color> >,
+	row_scalar< blendfunc_SUBTRACT<Color> >,       // 5
+	row_scalar< blendfunc_MULTIPLY<Color> >,
+	row_scalar< blendfunc_DIVIDE<Color> >,
+	row_scalar< blendfunc_COLOR<Color> >,
+	row_scalar< blendfunc_HUE<Color> >,
+	row_scalar< blendfunc_SATURATION<Color> >,     // 10
+	row_scalar< blendfunc_LUMINANCE<Color> >,
+	row_scalar< blendfunc_BEHIND<Color> >,
+	row_scalar< blendfunc_ONTO<Color> >,
+	row_scalar< blendfunc_ALPHA_BRIGHTEN<Color> >,
+	row_scalar< blendfunc_ALPHA_DARKEN<Color> >,   // 15
+	row_scalar< blendfunc_SCREEN<Color> >,
+	row_scalar< blendfunc_HARD_LIGHT<Color> >,
+	row_scalar< blendfunc_DIFFERENCE<Color> >,
+	row_scalar< blendfunc_ALPHA_OVER<Color> >,
+	row_scalar< blendfunc_OVERLAY<Color> >,        // 20
+	row_scalar< blendfunc_STRAIGHT_ONTO<Color> >,
+	row_scalar< blendfunc_ADD_COMPOSITE<Color> >,
+	row_scalar< blendfunc_ALPHA<Color> >,
+};
+
+struct RowFuncTable
+{
+	Blend::RowFunc funcs[Color::BLEND_END];
+	bool vectorized[Color::BLEND_END];
+
+	void set(Color::BlendMethod method, Blend::RowFunc func)
+		{ funcs[method] = func; vectorized[method] = true; }
+
+	RowFuncTable()
+	{
+		for(int i = 0; i < Color::BLEND_END; ++i)
+			{ funcs[i] = reference_row_funcs[i]; vectorized[i] = false; }
+
+		#ifdef BLEND_SIMD
+		set(Color::BLEND_COMPOSITE, row_simd<pixel_composite>);
+		set(Color::BLEND_STRAIGHT,  row_simd<pixel_straight>);
+		set(Color::BLEND_ONTO,      row_simd<pixel_onto>);
+		set(Color::BLEND_BEHIND,    row_simd<pixel_behind>);
+		set(Color::BLEND_ADD,       row_simd<pixel_add>);
+		set(Color::BLEND_SUBTRACT,  row_simd<pixel_subtract>);
+		set(Color::BLEND_MULTIPLY,  row_simd_multiply);
+		#endif
+	}
+};
+
+const RowFuncTable row_func_table;
+
+template<typename T>
+void
+blend_compact(
+	synfig::Surface &dest,
+	const RectInt &dest_rect,
+	const CompactSurface<T> &src,
+	const VectorInt &src_offset,
+	Color::BlendMethod method,
+	ColorReal amount )
+{
+	if (!dest_rect.is_valid()) return;
+
+	assert( 0 <= dest_rect.minx && dest_rect.maxx <= dest.get_w()
+		 && 0 <= dest_rect.miny && dest_rect.maxy <= dest.get_h() );
+	assert( 0 <= dest_rect.minx + src_offset[0] && dest_rect.maxx + src_offset[0] <= src.get_w()
+		 && 0 <= dest_rect.miny + src_offset[1] && dest_rect.maxy + src_offset[1] <= src.get_h() );
+
+	const int w = dest_rect.get_width();
+	const int sx = dest_rect.minx + src_offset[0];
+
+	// straight blending with full amount is a plain copy
+	if (method == Color::BLEND_STRAIGHT && std::fabs(amount - 1.f) < 0.00001f) {
+		for(int y = dest_rect.miny; y < dest_rect.maxy; ++y)
+			src.get_row(&dest[y][dest_rect.minx], sx, y + src_offset[1], w);
+		return;
+	}
+
+	std::vector<Color> row(w);
+	Blend::RowFunc func = Blend::get_row_func(method);
+	for(int y = dest_rect.miny; y < dest_rect.maxy; ++y) {
+		src.get_row(&row.front(), sx, y + src_offset[1], w);
+		func(&dest[y][dest_rect.minx], &row.front(), w, amount);
+	}
+}
+
+} // end of anonimous namespace
+
+/* === M E T H O D S ======================================================= */
+
+Blend::RowFunc
+Blend::get_row_func(Color::BlendMethod method)
+{
+	assert(method >= 0 && method < Color::BLEND_END);
+	return row_func_table.funcs[method];
+}
+
+Blend::RowFunc
+Blend::get_reference_row_func(Color::BlendMethod method)
+{
+	assert(method >= 0 && method < Color::BLEND_END);
+	return reference_row_funcs[method];
+}
+
+bool
+Blend::is_vectorized(Color::BlendMethod method)
+{
+	assert(method >= 0 && method < Color::BLEND_END);
+	return row_func_table.vectorized[method];
+}
+
+void
+Blend::blend(
+	synfig::Surface &dest,
+	const RectInt &dest_rect,
+	const synfig::Surface &src,
+	const VectorInt &src_offset,
+	Color::BlendMethod method,
+	ColorReal amount )
+{
+	if (!dest_rect.is_valid()) return;
+
+	assert( 0 <= dest_rect.minx && dest_rect.maxx <= dest.get_w()
+		 && 0 <= dest_rect.miny && dest_rect.maxy <= dest.get_h() );
+	assert( 0 <= dest_rect.minx + src_offset[0] && dest_rect.maxx + src_offset[0] <= src.get_w()
+		 && 0 <= dest_rect.miny + src_offset[1] && dest_rect.maxy + src_offset[1] <= src.get_h() );
+
+	const int w = dest_rect.get_width();
+	const int sx = dest_rect.minx + src_offset[0];
+
+	// straight blending with full amount is a plain copy (see Surface::blit_to)
+	if (method == Color::BLEND_STRAIGHT && std::fabs(amount - 1.f) < 0.00001f) {
+		for(int y = dest_rect.miny; y < dest_rect.maxy; ++y)
+			memcpy(&dest[y][dest_rect.minx], &src[y + src_offset[1]][sx], w*sizeof(Color));
+		return;
+	}
+
+	RowFunc func = get_row_func(method);
+	for(int y = dest_rect.miny; y < dest_rect.maxy; ++y)
+		func(&dest[y][dest_rect.minx], &src[y + src_offset[1]][sx], w, amount);
+}
+
+void
+Blend::blend(
+	synfig::Surface &dest,
+	const RectInt &dest_rect,
+	const HalfSurface &src,
+	const VectorInt &src_offset,
+	Color::BlendMethod method,
+	ColorReal amount )
+	{ blend_compact(dest, dest_rect, src, src_offset, method, amount); }
+
+void
+Blend::blend(
+	synfig::Surface &dest,
+	const RectInt &dest_rect,
+	const ByteSurface &src,
+	const VectorInt &src_offset,
+	Color::BlendMethod method,
+	ColorReal amount )
+	{ blend_compact(dest, dest_rect, src, src_offset, method, amount); }
+
+void
+Blend::fill(
+	synfig::Surface &dest,
+	const RectInt &dest_rect,
+	const Color &color,
+	Color::BlendMethod method,
+	ColorReal amount )
+{
+	if (!dest_rect.is_valid()) return;
+
+	assert( 0 <= dest_rect.minx && dest_rect.maxx <= dest.get_w()
+		 && 0 <= dest_rect.miny && dest_rect.maxy <= dest.get_h() );
+
+	const int w = dest_rect.get_width();
+	const std::vector<Color> row(w, color);
+
+	RowFunc func = get_row_func(method);
+	for(int y = dest_rect.miny; y < dest_rect.maxy; ++y)
+		func(&dest[y][dest_rect.minx], &row.front(), w, amount);
+}
+
+/* === E N T R Y P O I N T ================================================= */
@@ -0,0 +1,113 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/blend.h
+**	\brief Blend Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_SOFTWARE_BLEND_H
+#define __SYNFIG_RENDERING_SOFTWARE_BLEND_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/color.h>
+#include <synfig/rect.h>
+#include <synfig/surface.h>
+
+#include "compactsurface.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+namespace software
+{
+
+class Blend
+{
+public:
+	//! Blends \a count pixels of \a src onto \a dest, result is the same as
+	//! dest[i] = Color::blend(src[i], dest[i], amount, method)
+	typedef void (*RowFunc)(Color *dest, const Color *src, int count, ColorReal amount);
+
+	//! Row function for the blend method,
+	//! vectorized (SSE2 or NEON) if available for this method
+	static RowFunc get_row_func(Color::BlendMethod method);
+
+	//! Row function for the blend method built from
+	//! the scalar templates in color/colorblendingfunctions.h
+	static RowFunc get_reference_row_func(Color::BlendMethod method);
+
+	//! Returns true if get_row_func() is vectorized for this method
+	static bool is_vectorized(Color::BlendMethod method);
+
+	//! Blends the \a dest_rect region of \a src surface onto the same region of \a dest,
+	//! \a src_offset is position of the dest_rect in the coordinates of \a src
+	static void blend(
+		synfig::Surface &dest,
+		const RectInt &dest_rect,
+		const synfig::Surface &src,
+		const VectorInt &src_offset,
+		Color::BlendMethod method,
+		ColorReal amount );
+
+	//! The same for the surfaces with compact pixels,
+	//! pixels are unpacked row by row, without the intermediate synfig::Surface
+	static void blend(
+		synfig::Surface &dest,
+		const RectInt &dest_rect,
+		const HalfSurface &src,
+		const VectorInt &src_offset,
+		Color::BlendMethod method,
+		ColorReal amount );
+
+	static void blend(
+		synfig::Surface &dest,
+		const RectInt &dest_rect,
+		const ByteSurface &src,
+		const VectorInt &src_offset,
+		Color::BlendMethod method,
+		ColorReal amount );
+
+	//! Blends the solid \a color onto the \a dest_rect region of \a dest
+	static void fill(
+		synfig::Surface &dest,
+		const RectInt &dest_rect,
+		const Color &color,
+		Color::BlendMethod method,
+		ColorReal amount );
+};
+
+} /* end namespace software */
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
@@ -36,12 +36,17 @@
 
 #include <algorithm>
 #include <functional>
+#include <thread>
+
+#include <sigc++/bind.h>
 
 #include "blur.h"
 
 #include "blurtemplates.h"
 #include "fft.h"
 //#include "blur_iir_coefficients.cpp"
+
+#include <synfig/threadpool.h>
 #endif
 
 using namespace synfig;
@@ -51,8 +56,173 @@ using namespace rendering;
 
 /* === G L O B A L S ======================================================= */
 
+namespace {
+
+const int channels = 4;
+
+//! parts for each thread, so threads which are finished early can take the parts of others
+const int parts_per_thread = 2;
+//! smaller parts are not worth of the thread switching
+const int min_part_pixels = 16384;
+//! columns are processed by blocks, so the rows of block which are touched by the filter
+//! are kept in cache, and all of the columns of the block are going through one loop
+const int column_block = 32;
+
+//! Pass of separable blur over the surface with interleaved premultiplied RGBA pixels.
+//! Row passes are processed by the groups of rows, column passes - by the blocks of columns.
+struct Pass
+{
+	ColorReal *data;          //!< surface to process (or destination of pattern blur)
+	const ColorReal *src;     //!< source of pattern blur
+	int rows, cols;
+	int size;                 //!< half size of box
+	const ColorReal *pattern; //!< half pattern, pattern[0] is the center
+	int pattern_size;
+
+	Pass(): data(), src(), rows(), cols(), size(), pattern(), pattern_size() { }
+};
+
+}
+
 /* === P R O C E D U R E S ================================================= */
 
+template<typename T>
+static void
+read_source(const software::Array<T, 3> &dst, const software::Blur::Params &params)
+{
+	const software::Blur::Source &src = params.src;
+	if (src.surface)
+		software::BlurTemplates::surface_read(dst, *src.surface, VectorInt(0, 0), params.src_rect);
+	else
+	if (src.half)
+		software::BlurTemplates::surface_read(dst, *src.half, VectorInt(0, 0), params.src_rect);
+	else
+	if (src.byte)
+		software::BlurTemplates::surface_read(dst, *src.byte, VectorInt(0, 0), params.src_rect);
+}
+
+namespace {
+
+//! Box blur of the several parallel lines at once (like BlurTemplates::blur_box_discrete()),
+//! 'step' is a distance between the neighbour pixels of line,
+//! pixels of the different lines are going one after another,
+//! so all channels of all lines are processed by the same instructions.
+void
+box_lines(ColorReal *x, int count, int step, int lines, int size, std::vector<ColorReal> &buffer)
+{
+	if (size == 0) return;
+
+	int s = std::abs(size);
+	int full_size = 1 + 2*s;
+	if (count < full_size) return;
+
+	const int width = lines*channels;
+	buffer.assign(width*(full_size + 1), ColorReal(0.0));
+	ColorReal *sum = &buffer.front();
+	ColorReal *queue = sum + width;
+	ColorReal w(ColorReal(1.0)/ColorReal(full_size));
+
+	for(int i = 0; i < full_size; ++i) {
+		const ColorReal *p = x + i*step;
+		ColorReal *q = queue + i*width;
+		for(int l = 0; l < width; ++l)
+			{ q[l] = p[l]; sum[l] += p[l]; }
+	}
+
+	int front = 0;
+	for(int i = full_size, j = s; i < count; ++i, ++j) {
+		const ColorReal *p = x + i*step;
+		ColorReal *d = x + j*step;
+		ColorReal *q = queue + front*width;
+		for(int l = 0; l < width; ++l) {
+			d[l] = w*sum[l];
+			sum[l] += p[l] - q[l];
+			q[l] = p[l];
+		}
+		if (++front == full_size) front = 0;
+	}
+}
+
+//! Blur of the several parallel lines by pattern (like BlurTemplates::blur_pattern()),
+//! result is added to the destination, lines are arranged like in box_lines()
+void
+pattern_lines(ColorReal *dst, const ColorReal *src, int count, int step, int lines, const ColorReal *pattern, int pattern_size)
+{
+	const int width = lines*channels;
+	int end = count - pattern_size;
+	for(int i = pattern_size; i < end; ++i) {
+		ColorReal *d = dst + i*step;
+		const ColorReal *c = src + i*step;
+		for(int l = 0; l < width; ++l)
+			d[l] += c[l]*pattern[0];
+		for(int k = 1; k <= pattern_size; ++k) {
+			const ColorReal *a = c - k*step;
+			const ColorReal *b = c + k*step;
+			for(int l = 0; l < width; ++l)
+				d[l] += (a[l] + b[l])*pattern[k];
+		}
+	}
+}
+
+void
+box_blur_rows(const Pass *pass, int begin, int end)
+{
+	std::vector<ColorReal> buffer;
+	for(int r = begin; r < end; ++r)
+		box_lines(pass->data + r*pass->cols*channels, pass->cols, channels, 1, pass->size, buffer);
+}
+
+void
+box_blur_cols(const Pass *pass, int begin, int end)
+{
+	std::vector<ColorReal> buffer;
+	for(int c = begin; c < end; c += column_block)
+		box_lines(pass->data + c*channels, pass->rows, pass->cols*channels, std::min(column_block, end - c), pass->size, buffer);
+}
+
+void
+pattern_blur_rows(const Pass *pass, int begin, int end)
+{
+	for(int r = begin; r < end; ++r) {
+		int offset = r*pass->cols*channels;
+		pattern_lines(pass->data + offset, pass->src + offset, pass->cols, channels, 1, pass->pattern, pass->pattern_size);
+	}
+}
+
+void
+pattern_blur_cols(const Pass *pass, int begin, int end)
+{
+	for(int c = begin; c < end; c += column_block) {
+		int offset = c*channels;
+		pattern_lines(
+			pass->data + offset, pass->src + offset, pass->rows, pass->cols*channels,
+			std::min(column_block, end - c), pass->pattern, pass->pattern_size );
+	}
+}
+
+//! Splits 'count' rows (or columns) into the parts and calls func for each part by its own thread,
+//! parts are aligned by 'align' items
+void
+run_parts(void (*func)(const Pass*, int, int), const Pass &pass, int count, int item_pixels, int align)
+{
+	int threads = std::min(ThreadPool::instance().get_max_threads(), (int)std::thread::hardware_concurrency());
+	int parts = std::min(
+		threads*parts_per_thread,
+		std::min(
+			(int)((long long)count*item_pixels/min_part_pixels),
+			(count + align - 1)/align ));
+	if (parts < 2)
+		{ func(&pass, 0, count); return; }
+
+	int part_size = ((count + parts - 1)/parts + align - 1)/align*align;
+	ThreadPool::Group group;
+	for(int begin = 0; begin < count; begin += part_size)
+		group.enqueue( sigc::bind(sigc::ptr_fun(func), &pass, begin, std::min(count, begin + part_size)) );
+	group.run();
+}
+
+}
+
 /* === M E T H O D S ======================================================= */
 
 bool
@@ -65,7 +235,7 @@ software::Blur::Params::validate()
 
 	if ( !dest->is_valid()
 	  || !dest_rect.valid()
-	  || !src->is_valid() ) return false;
+	  || !src.is_valid() ) return false;
 
 	amplified_size = size*get_size_amplifier(type);
 	amplified_size[0] = fabs(amplified_size[0]);
@@ -83,7 +253,7 @@ software::Blur::Params::validate()
 	src_rect.maxx += extra_size[0];
 	src_rect.maxy += extra_size[1];
 	if (!src_rect.valid()) return false;
-	rect_set_intersect(src_rect, src_rect, RectInt(0, 0, src->get_w(), src->get_h()));
+	rect_set_intersect(src_rect, src_rect, RectInt(0, 0, src.get_w(), src.get_h()));
 	if (!src_rect.valid()) return false;
 
 	dest_rect = src_rect - offset;
@@ -163,7 +333,6 @@ void
 software::Blur::blur_pattern(const Params &params)
 {
 	// init
-	const int channels = 4;
 	int rows = params.src_rect.get_size()[1];
 	int cols = params.src_rect.get_size()[0];
 	int pattern_rows = params.extra_size[1] + 1;
@@ -199,7 +368,7 @@ software::Blur::blur_pattern(const Params &params)
 		.set_dim(pattern_rows, 1);
 
 	// prepare surface (apply alpha)
-	BlurTemplates::surface_read(arr_src_surface, *params.src, VectorInt(0, 0), params.src_rect);
+	read_source(arr_src_surface, params);
 
 	// alloc memory
 	switch(params.type)
@@ -263,32 +432,31 @@ software::Blur::blur_pattern(const Params &params)
 		BlurTemplates::normalize_half_pattern( arr_row_pattern );
 		BlurTemplates::normalize_half_pattern( arr_col_pattern );
 
-		Array<ColorReal, 3> arr_src_surface_rows(arr_src_surface.reorder(2, 0, 1));
-		Array<ColorReal, 3> arr_src_surface_cols(arr_src_surface_rows.reorder(0, 2, 1));
-
-		Array<ColorReal, 3> arr_dst_surface_rows(arr_dst_surface.reorder(2, 0, 1));
-		Array<ColorReal, 3> arr_dst_surface_cols(arr_dst_surface_rows.reorder(0, 2, 1));
-
 		if (cross)
 		{
 			arr_row_pattern.process< std::multiplies<ColorReal> >(0.5);
 			arr_col_pattern.process< std::multiplies<ColorReal> >(0.5);
 		}
 
-		for(Array<ColorReal, 3>::Iterator src_channel(arr_src_surface_rows), dst_channel(arr_dst_surface_rows); dst_channel; ++src_channel, ++dst_channel)
-			for(Array<ColorReal, 2>::Iterator sr(*src_channel), dr(*dst_channel); dr; ++sr, ++dr)
-				BlurTemplates::blur_pattern(*dr, *sr, arr_row_pattern);
+		Pass pass;
+		pass.data = &dst_surface.front();
+		pass.src = &src_surface.front();
+		pass.rows = rows;
+		pass.cols = cols;
+		pass.pattern = &row_pattern.front();
+		pass.pattern_size = pattern_cols - 1;
+
+		run_parts(&pattern_blur_rows, pass, rows, cols, 1);
 
 		if (!cross)
 		{
-			std::swap(arr_src_surface_cols.pointer, arr_dst_surface_cols.pointer);
-			std::swap(arr_src_surface.pointer, arr_dst_surface.pointer);
-			memset(&src_surface.front(), 0, sizeof(src_surface.front())*src_surface.size());
+			pass.src = pass.data;
+			pass.data = &src_surface.front();
+			memset(pass.data, 0, sizeof(src_surface.front())*src_surface.size());
+			arr_dst_surface.pointer = pass.data;
 		}
 
-		for(Array<ColorReal, 3>::Iterator src_channel(arr_src_surface_cols), dst_channel(arr_dst_surface_cols); dst_channel; ++src_channel, ++dst_channel)
-			for(Array<ColorReal, 2>::Iterator sr(*src_channel), dr(*dst_channel); dr; ++sr, ++dr)
-				BlurTemplates::blur_pattern(*dr, *sr, arr_row_pattern);
+		run_parts(&pattern_blur_cols, pass, cols, rows, column_block);
 	}
 
 	// copy result surface and restore alpha
@@ -338,7 +506,7 @@ software::Blur::blur_fft(const Params &params)
 		.set_dim(2, 1);
 
 	// convert surface to complex
-	BlurTemplates::surface_read(arr_surface.reorder(0, 1, 2), *params.src, VectorInt(0, 0), params.src_rect);
+	read_source(arr_surface.reorder(0, 1, 2), params);
 
 	// alloc memory
 	switch(params.type)
@@ -465,8 +633,6 @@ software::Blur::blur_fft(const Params &params)
 void
 software::Blur::blur_box(const Params &params)
 {
-	const Real precision(1e-5);
-	const int channels = 4;
 	int rows = params.src_rect.get_size()[1];
 	int cols = params.src_rect.get_size()[0];
 
@@ -476,11 +642,10 @@ software::Blur::blur_box(const Params &params)
 		.set_dim(rows, cols*channels)
 		.set_dim(cols, channels)
 		.set_dim(channels, 1);
-	BlurTemplates::surface_read(arr_surface, *params.src, VectorInt(0, 0), params.src_rect);
+	read_source(arr_surface, params);
 
 	Vector size = params.amplified_size;
 	bool cross = false;
-	bool count = 1;
 	switch(params.type)
 	{
 	case rendering::Blur::BOX:
@@ -488,7 +653,6 @@ software::Blur::blur_box(const Params &params)
 	case rendering::Blur::GAUSSIAN:
 	case rendering::Blur::FASTGAUSSIAN:
 		size *= 1.662155813;
-		count = 2;
 		break;
 	case rendering::Blur::CROSS:
 		cross = true;
@@ -498,44 +662,30 @@ software::Blur::blur_box(const Params &params)
 		return;
 	}
 
-	std::deque<ColorReal> q;
-	std::vector<ColorReal> surface_copy;
-	Array<ColorReal, 3> arr_surface_rows(arr_surface.reorder(2, 0, 1));
-	Array<ColorReal, 3> arr_surface_cols(arr_surface_rows.reorder(0, 2, 1));
+	Pass row_pass;
+	row_pass.data = &surface.front();
+	row_pass.rows = rows;
+	row_pass.cols = cols;
+	row_pass.size = (int)round(size[0]);
 
+	Pass col_pass = row_pass;
+	col_pass.size = (int)round(size[1]);
+
+	std::vector<ColorReal> surface_copy;
 	if (cross)
 	{
-		arr_surface.process< std::multiplies<ColorReal> >(0.5);
+		for(std::vector<ColorReal>::iterator i = surface.begin(); i != surface.end(); ++i)
+			*i *= ColorReal(0.5);
 		surface_copy = surface;
-		arr_surface_cols.pointer = &surface_copy.front();
+		col_pass.data = &surface_copy.front();
 	}
 
-	if (true || fabs(size[0] - round(size[0])) < precision)
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator r(*channel); r; ++r)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_discrete(*r, q, (int)round(size[0]));
-	else
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator r(*channel); r; ++r)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_aa(*r, q, (ColorReal)size[0]);
-
-	if (true || fabs(size[1] - round(size[1])) < precision)
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator c(*channel); c; ++c)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_discrete(*c, q, (int)round(size[1]));
-	else
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator c(*channel); c; ++c)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_aa(*c, q, (ColorReal)size[1]);
+	run_parts(&box_blur_rows, row_pass, rows, cols, 1);
+	run_parts(&box_blur_cols, col_pass, cols, rows, column_block);
 
 	if (cross)
-		arr_surface_rows
-			.process< std::plus<ColorReal> >(
-				arr_surface_cols.reorder(0, 2, 1) );
+		for(std::vector<ColorReal>::iterator i = surface.begin(), j = surface_copy.begin(); i != surface.end(); ++i, ++j)
+			*i += *j;
 
 	BlurTemplates::surface_write(
 		*params.dest,
@@ -616,7 +766,7 @@ software::Blur::blur_iir(const Params &params)
 		arr_surface );
 	
 	
-	BlurTemplates::surface_read(arr_surface, *params.src, VectorInt(0, 0), params.src_rect);
+	read_source(arr_surface, params);
 
 	switch(params.type)
 	{
@@ -38,6 +38,8 @@
 #include <synfig/surface.h>
 #include <synfig/vector.h>
 
+#include "compactsurface.h"
+
 /* === M A C R O S ========================================================= */
 
 /* === T Y P E D E F S ===================================================== */
@@ -54,11 +56,31 @@ namespace software
 class Blur
 {
 public:
+	//! Source of blur, synfig::Surface or one of the surfaces with compact pixels
+	class Source {
+	public:
+		const synfig::Surface *surface;
+		const HalfSurface *half;
+		const ByteSurface *byte;
+
+		Source(): surface(), half(), byte() { }
+		Source(const synfig::Surface &surface): surface(&surface), half(), byte() { }
+		Source(const HalfSurface &half): surface(), half(&half), byte() { }
+		Source(const ByteSurface &byte): surface(), half(), byte(&byte) { }
+
+		bool is_valid() const
+			{ return surface ? surface->is_valid() : half ? half->is_valid() : byte && byte->is_valid(); }
+		int get_w() const
+			{ return surface ? surface->get_w() : half ? half->get_w() : byte ? byte->get_w() : 0; }
+		int get_h() const
+			{ return surface ? surface->get_h() : half ? half->get_h() : byte ? byte->get_h() : 0; }
+	};
+
 	class Params {
 	public:
 		synfig::Surface *dest;
 		RectInt dest_rect;
-		const synfig::Surface *src;
+		Source src;
 		VectorInt src_offset;
 		RectInt src_rect;
 		rendering::Blur::Type type = rendering::Blur::BOX;
@@ -69,11 +91,11 @@ public:
 		Color::BlendMethod blend_method;
 		ColorReal amount;
 
-		Params(): dest(), src(), blend(), blend_method(), amount() { }
+		Params(): dest(), blend(), blend_method(), amount() { }
 		Params(
 			synfig::Surface &dest,
 			const RectInt &dest_rect,
-			const synfig::Surface &src,
+			const Source &src,
 			const VectorInt src_offset,
 			rendering::Blur::Type type,
 			const Vector &size,
@@ -83,7 +105,7 @@ public:
 		):
 			dest(&dest),
 			dest_rect(dest_rect),
-			src(&src),
+			src(src),
 			src_offset(src_offset),
 			type(type),
 			size(size),
@@ -34,8 +34,10 @@
 
 #include <algorithm>
 #include <deque>
+#include <vector>
 
 #include "array.h"
+#include "compactsurface.h"
 
 #include <synfig/angle.h>
 #include <synfig/surface.h>
@@ -574,6 +576,37 @@ public:
 		surface_read(dst_range, src_range);
 	}
 
+	template<typename T, typename P>
+	static void surface_read(
+		const Array<T, 3> &dst,
+		const CompactSurface<P> &src,
+		const VectorInt &dst_offset,
+		const RectInt &src_rect )
+	{
+		RectInt dst_rect = src_rect - src_rect.get_min() + dst_offset;
+		Array<T, 3> dst_range = dst.get_range(1, dst_rect.minx, dst_rect.maxx)
+		                           .get_range(0, dst_rect.miny, dst_rect.maxy);
+		assert(dst_range.count == src_rect.maxy - src_rect.miny);
+		assert(dst_range.sub().count == src_rect.maxx - src_rect.minx);
+		assert(dst_range.sub().sub().count == 4);
+
+		// pixels are unpacked directly with premultiplied alpha
+		std::vector<Color> row(src_rect.maxx - src_rect.minx);
+		int y = src_rect.miny;
+		for(typename Array<T, 3>::Iterator r(dst_range); r; ++r, ++y)
+		{
+			src.get_row_cooked(&row.front(), src_rect.minx, y, (int)row.size());
+			std::vector<Color>::const_iterator cc = row.begin();
+			for(typename Array<T, 2>::Iterator c(*r); c; ++c, ++cc)
+			{
+				(*c)[0] = cc->get_r();
+				(*c)[1] = cc->get_g();
+				(*c)[2] = cc->get_b();
+				(*c)[3] = cc->get_a();
+			}
+		}
+	}
+
 	template<typename T>
 	static void surface_write(
 		const Array<Color, 2> &dst,
@@ -0,0 +1,279 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/compactsurface.h
+**	\brief CompactSurface Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_SOFTWARE_COMPACTSURFACE_H
+#define __SYNFIG_RENDERING_SOFTWARE_COMPACTSURFACE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include <synfig/color.h>
+#include <synfig/surface.h>
+#include <synfig/surfacepool.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+namespace software
+{
+
+//! RGBA pixel of four IEEE 754 half floats, alpha is straight like in synfig::Color
+struct PixelHalf
+{
+	uint16_t channels[4];
+
+	static uint16_t pack(float f)
+	{
+		uint32_t x;
+		memcpy(&x, &f, sizeof(x));
+		uint16_t sign = (x >> 16) & 0x8000;
+		int exp = int((x >> 23) & 0xff);
+		uint32_t mant = x & 0x7fffff;
+
+		if (exp == 0xff) // inf or nan
+			return sign | 0x7c00 | (mant ? 0x200 : 0);
+		exp += 15 - 127;
+		if (exp >= 0x1f) // too big
+			return sign | 0x7c00;
+		if (exp <= 0) { // denormalized
+			if (exp < -10) return sign;
+			mant |= 0x800000;
+			int shift = 14 - exp;
+			return sign | uint16_t((mant + (1u << (shift - 1))) >> shift);
+		}
+		// rounding may carry to exponent, it is correct
+		return sign | uint16_t(((uint32_t(exp) << 10) | (mant >> 13)) + ((mant >> 12) & 1));
+	}
+
+	static float unpack(uint16_t h)
+	{
+		uint32_t sign = uint32_t(h & 0x8000) << 16;
+		uint32_t exp = (h >> 10) & 0x1f;
+		uint32_t mant = h & 0x3ff;
+		uint32_t x;
+		if (exp == 0x1f) {
+			x = sign | 0x7f800000 | (mant << 13);
+		} else
+		if (exp) {
+			x = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+		} else
+		if (mant) {
+			exp = 127 - 15 + 1;
+			while(!(mant & 0x400)) { mant <<= 1; --exp; }
+			x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+		} else {
+			x = sign;
+		}
+		float f;
+		memcpy(&f, &x, sizeof(f));
+		return f;
+	}
+
+	static PixelHalf encode(const Color &c)
+	{
+		PixelHalf p;
+		p.channels[0] = pack(c.get_r());
+		p.channels[1] = pack(c.get_g());
+		p.channels[2] = pack(c.get_b());
+		p.channels[3] = pack(c.get_a());
+		return p;
+	}
+
+	Color decode() const
+		{ return Color(unpack(channels[0]), unpack(channels[1]), unpack(channels[2]), unpack(channels[3])); }
+	Color decode_cooked() const
+		{ return ColorPrep::cook_static(decode()); }
+};
+
+//! RGBA pixel of four bytes with premultiplied alpha,
+//! channels are clamped to [0, 1], so it is suitable for preview only
+struct PixelUInt8
+{
+	uint8_t channels[4];
+
+	//! NaN becomes zero
+	static uint8_t pack(ColorReal x)
+		{ return x > 0.f ? (x < 1.f ? uint8_t(x*255.f + 0.5f) : 255) : 0; }
+	static ColorReal unpack(uint8_t x)
+		{ return ColorReal(x)*(1.f/255.f); }
+
+	static PixelUInt8 encode(const Color &c)
+	{
+		PixelUInt8 p;
+		ColorReal a = c.get_a() > 0.f ? (c.get_a() < 1.f ? c.get_a() : 1.f) : 0.f;
+		p.channels[0] = pack(c.get_r()*a);
+		p.channels[1] = pack(c.get_g()*a);
+		p.channels[2] = pack(c.get_b()*a);
+		p.channels[3] = pack(a);
+		return p;
+	}
+
+	Color decode() const
+	{
+		if (!channels[3]) return Color(0, 0, 0, 0);
+		ColorReal k = 1.f/ColorReal(channels[3]);
+		return Color(channels[0]*k, channels[1]*k, channels[2]*k, unpack(channels[3]));
+	}
+
+	Color decode_cooked() const
+		{ return Color(unpack(channels[0]), unpack(channels[1]), unpack(channels[2]), unpack(channels[3])); }
+};
+
+//! Bitmap with pixels of less than 16 bytes.
+//! It keeps intermediate results of rendering when the precision of synfig::Color is not needed,
+//! so memory and memory bandwidth are saved.
+//! Buffer is taken from SurfacePool like the buffers of synfig::Surface.
+template<typename T>
+class CompactSurface
+{
+public:
+	typedef T Pixel;
+
+private:
+	int width;
+	int height;
+	Pixel *pixels;
+
+	CompactSurface(const CompactSurface&) = delete;
+	CompactSurface& operator=(const CompactSurface&) = delete;
+
+	void allocate(int width, int height)
+	{
+		if (width == this->width && height == this->height && pixels) return;
+		reset();
+		if (width <= 0 || height <= 0) return;
+		pixels = (Pixel*)SurfacePool::instance().allocate(sizeof(Pixel)*width*height);
+		this->width = width;
+		this->height = height;
+	}
+
+public:
+	CompactSurface(): width(), height(), pixels() { }
+	~CompactSurface() { reset(); }
+
+	bool is_valid() const
+		{ return pixels; }
+	int get_width() const
+		{ return width; }
+	int get_height() const
+		{ return height; }
+	int get_w() const
+		{ return width; }
+	int get_h() const
+		{ return height; }
+
+	const Pixel* operator[](int y) const
+		{ assert(pixels && y >= 0 && y < height); return pixels + y*width; }
+
+	//! Creates transparent surface
+	void create(int width, int height)
+		{ allocate(width, height); clear(); }
+
+	void clear()
+		{ if (pixels) memset(static_cast<void*>(pixels), 0, sizeof(Pixel)*width*height); }
+
+	void reset()
+	{
+		if (pixels) SurfacePool::instance().deallocate(pixels);
+		pixels = nullptr;
+		width = height = 0;
+	}
+
+	void assign(const CompactSurface &other)
+	{
+		if (&other == this) return;
+		allocate(other.width, other.height);
+		if (pixels) memcpy(static_cast<void*>(pixels), other.pixels, sizeof(Pixel)*width*height);
+	}
+
+	void set_pixels(const Color *src, int width, int height)
+	{
+		allocate(width, height);
+		for(Pixel *p = pixels, *end = p + width*height; p < end; ++p, ++src)
+			*p = Pixel::encode(*src);
+	}
+
+	void get_pixels(Color *dest) const
+		{ get_rect(dest, width, 0, 0, width, height); }
+
+	//! Reads pixels of row in the format of synfig::Color
+	void get_row(Color *dest, int x, int y, int count) const
+	{
+		assert(x >= 0 && x + count <= width);
+		for(const Pixel *p = (*this)[y] + x, *end = p + count; p < end; ++p, ++dest)
+			*dest = p->decode();
+	}
+
+	//! Reads pixels of row with premultiplied alpha (see ColorPrep)
+	void get_row_cooked(Color *dest, int x, int y, int count) const
+	{
+		assert(x >= 0 && x + count <= width);
+		for(const Pixel *p = (*this)[y] + x, *end = p + count; p < end; ++p, ++dest)
+			*dest = p->decode_cooked();
+	}
+
+	void get_rect(Color *dest, int dest_pitch, int x, int y, int w, int h) const
+	{
+		for(int r = 0; r < h; ++r, dest += dest_pitch)
+			get_row(dest, x, y + r, w);
+	}
+
+	inline static Color reader(const void *surf, int x, int y)
+	{
+		const CompactSurface &s = *(const CompactSurface*)surf;
+		return clamping::clamp(x, s.width) && clamping::clamp(y, s.height)
+		     ? s[y][x].decode() : Color();
+	}
+
+	inline static Color reader_cook(const void *surf, int x, int y)
+	{
+		const CompactSurface &s = *(const CompactSurface*)surf;
+		return clamping::clamp(x, s.width) && clamping::clamp(y, s.height)
+		     ? s[y][x].decode_cooked() : Color();
+	}
+};
+
+typedef CompactSurface<PixelHalf> HalfSurface;
+typedef CompactSurface<PixelUInt8> ByteSurface;
+
+} /* end namespace software */
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
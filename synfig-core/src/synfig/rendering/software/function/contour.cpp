@@ -32,9 +32,15 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <thread>
+
+#include <sigc++/bind.h>
+
 #include "contour.h"
 
 #include <synfig/debug/debugsurface.h>
+#include <synfig/threadpool.h>
 
 #endif
 
@@ -45,14 +51,48 @@ using namespace rendering;
 
 /* === G L O B A L S ======================================================= */
 
+namespace {
+
+//! bands for each thread, so threads which are finished early can take the bands of others
+const int bands_per_thread = 2;
+//! lower bounds of band size, smaller bands are not worth the separate thread
+const int min_band_rows = 16;
+const int min_band_marks = 16384;
+
+}
+
+struct software::Contour::BandParams
+{
+	synfig::Surface *target_surface;
+	const Polyspan *polyspan;
+	bool invert;
+	bool antialias;
+	rendering::Contour::WindingStyle winding_style;
+	Color color;
+	Color::value_type opacity;
+	Color::BlendMethod blend_method;
+	bool sorted;
+	Polyspan::cover_array covers;
+};
+
 /* === P R O C E D U R E S ================================================= */
 
+static int
+band_index(int y, int miny, int rows, int bands)
+{
+	int index = y < miny ? 0 : (y - miny)/rows;
+	return index < bands ? index : bands - 1;
+}
+
 /* === M E T H O D S ======================================================= */
 
 void
-software::Contour::render_polyspan(
+software::Contour::render_marks(
 	synfig::Surface &target_surface,
 	const Polyspan &polyspan,
+	const RectInt &window,
+	Polyspan::cover_array::const_iterator begin,
+	Polyspan::cover_array::const_iterator end,
 	bool invert,
 	bool antialias,
 	rendering::Contour::WindingStyle winding_style,
@@ -65,11 +105,8 @@ software::Contour::render_polyspan(
 
 	synfig::Surface::alpha_pen p(target_surface.begin(), opacity, blend_method);
 	synfig::Surface::pen sp(target_surface.begin());
-	const RectInt &window = polyspan.get_window();
-	const Polyspan::cover_array &covers = polyspan.get_covers();
-
-	Polyspan::cover_array::const_iterator cur_mark = covers.begin();
-	Polyspan::cover_array::const_iterator end_mark = covers.end();
+	Polyspan::cover_array::const_iterator cur_mark = begin;
+	Polyspan::cover_array::const_iterator end_mark = end;
 
 	Real cover = 0, area = 0, alpha = 0;
 	int	y = 0, x = 0;
@@ -141,7 +178,7 @@ software::Contour::render_polyspan(
 		cover += cur_mark->cover;
 
 		// accumulate for the current pixel
-		while(++cur_mark != covers.end())
+		while(++cur_mark != end_mark)
 		{
 			if (y != cur_mark->y || x != cur_mark->x)
 				break;
@@ -278,6 +315,124 @@ software::Contour::render_polyspan(
 	}
 }
 
+void
+software::Contour::render_polyspan(
+	synfig::Surface &target_surface,
+	const Polyspan &polyspan,
+	bool invert,
+	bool antialias,
+	rendering::Contour::WindingStyle winding_style,
+	const Color &color,
+	Color::value_type opacity,
+	Color::BlendMethod blend_method )
+{
+	render_marks(
+		target_surface,
+		polyspan,
+		polyspan.get_window(),
+		polyspan.get_covers().begin(),
+		polyspan.get_covers().end(),
+		invert,
+		antialias,
+		winding_style,
+		color,
+		opacity,
+		blend_method );
+}
+
+void
+software::Contour::render_band(BandParams *band, RectInt window, int begin, int end)
+{
+	if (begin == end && !band->invert)
+		return;
+
+	// stable sort keeps the order of marks of the same pixel,
+	// so coverage is summed in the same order as in Polyspan::sort_marks()
+	Polyspan::cover_array::iterator b = band->covers.begin() + begin;
+	Polyspan::cover_array::iterator e = band->covers.begin() + end;
+	if (!band->sorted)
+		std::stable_sort(b, e);
+
+	render_marks(
+		*band->target_surface,
+		*band->polyspan,
+		window,
+		b,
+		e,
+		band->invert,
+		band->antialias,
+		band->winding_style,
+		band->color,
+		band->opacity,
+		band->blend_method );
+}
+
+void
+software::Contour::render_polyspan_bands(
+	synfig::Surface &target_surface,
+	Polyspan &polyspan,
+	bool invert,
+	bool antialias,
+	rendering::Contour::WindingStyle winding_style,
+	const Color &color,
+	Color::value_type opacity,
+	Color::BlendMethod blend_method,
+	int threads )
+{
+	polyspan.flush_marks();
+	const RectInt &window = polyspan.get_window();
+	const Polyspan::cover_array &covers = polyspan.get_covers();
+
+	// pool keeps at least two threads, even when processor has a single core
+	if (threads <= 0)
+		threads = std::min(ThreadPool::instance().get_max_threads(), (int)std::thread::hardware_concurrency());
+	int bands = threads < 2 ? 0 : std::min(
+		threads*bands_per_thread,
+		std::min(
+			window.get_height()/min_band_rows,
+			(int)(covers.size()/min_band_marks) ));
+	if (bands < 2) {
+		polyspan.sort_marks();
+		render_polyspan(target_surface, polyspan, invert, antialias, winding_style, color, opacity, blend_method);
+		return;
+	}
+
+	// distribute marks by bands keeping their order (counting sort),
+	// marks out of window (if any) are going to the first or to the last band like in the single pass
+	int rows = (window.get_height() + bands - 1)/bands;
+	std::vector<int> offsets(bands + 1);
+	for(Polyspan::cover_array::const_iterator i = covers.begin(); i != covers.end(); ++i)
+		++offsets[ band_index(i->y, window.miny, rows, bands) + 1 ];
+	for(int i = 0; i < bands; ++i)
+		offsets[i + 1] += offsets[i];
+
+	BandParams band;
+	band.target_surface = &target_surface;
+	band.polyspan = &polyspan;
+	band.invert = invert;
+	band.antialias = antialias;
+	band.winding_style = winding_style;
+	band.color = color;
+	band.opacity = opacity;
+	band.blend_method = blend_method;
+	band.sorted = polyspan.is_sorted();
+	band.covers.resize(covers.size());
+
+	std::vector<int> positions(offsets.begin(), offsets.end() - 1);
+	for(Polyspan::cover_array::const_iterator i = covers.begin(); i != covers.end(); ++i)
+		band.covers[ positions[band_index(i->y, window.miny, rows, bands)]++ ] = *i;
+
+	// sort and render every band by its own thread
+	ThreadPool::Group group;
+	for(int i = 0; i < bands; ++i) {
+		RectInt rect(
+			window.minx, std::min(window.maxy, window.miny + i*rows),
+			window.maxx, i + 1 == bands ? window.maxy : std::min(window.maxy, window.miny + (i + 1)*rows) );
+		group.enqueue( sigc::bind(sigc::ptr_fun(&render_band), &band, rect, offsets[i], offsets[i + 1]) );
+	}
+	group.run();
+}
+
 void
 software::Contour::build_polyspan(
 	const rendering::Contour::ChunkList &chunks,
@@ -50,6 +50,25 @@ namespace software
 
 class Contour
 {
+private:
+	struct BandParams;
+
+	//! Renders the rows of window, marks must be sorted
+	static void render_marks(
+		synfig::Surface &target_surface,
+		const Polyspan &polyspan,
+		const RectInt &window,
+		Polyspan::cover_array::const_iterator begin,
+		Polyspan::cover_array::const_iterator end,
+		bool invert,
+		bool antialias,
+		rendering::Contour::WindingStyle winding_style,
+		const Color &color,
+		Color::value_type opacity,
+		Color::BlendMethod blend_method );
+
+	static void render_band(BandParams *band, RectInt window, int begin, int end);
+
 public:
 	static void render_polyspan(
 		synfig::Surface &target_surface,
@@ -61,6 +80,21 @@ public:
 		Color::value_type opacity,
 		Color::BlendMethod blend_method );
 
+	//! Sorts marks and renders polyspan, the result is equal to sort_marks() and render_polyspan().
+	//! Marks of the big polyspan are distributed by horizontal bands of target,
+	//! then bands are sorted and rendered at the same time by the different threads.
+	//! Zero threads means the count of processor cores available for ThreadPool.
+	static void render_polyspan_bands(
+		synfig::Surface &target_surface,
+		Polyspan &polyspan,
+		bool invert,
+		bool antialias,
+		rendering::Contour::WindingStyle winding_style,
+		const Color &color,
+		Color::value_type opacity,
+		Color::BlendMethod blend_method,
+		int threads = 0 );
+
 	static void build_polyspan(
 		const rendering::Contour::ChunkList &chunks,
 		const Matrix &transform_matrix,
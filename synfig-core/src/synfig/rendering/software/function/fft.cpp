@@ -34,17 +34,25 @@
 
 #include <cassert>
 #include <climits>
+#include <cstdlib>
+#include <cstring>
 //#include <ccomplex>
 
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <thread>
 
 #include <vector>
 #include <set>
+#include <stdexcept>
 
 #include <fftw3.h>
 
 #include "fft.h"
 
+#include <synfig/general.h>
 #endif
 
 using namespace synfig;
@@ -58,15 +66,209 @@ using namespace rendering;
 
 /* === M E T H O D S ======================================================= */
 
+//! Plans are created once for each geometry of arrays (sizes, strides, alignment and direction)
+//! and they are executed by fftw_execute_dft() for the new arrays of the same geometry.
+//! Plans can be executed by several threads at once. The map of plans is guarded by its own mutex,
+//! which is never held while the planner works, so long measured planning of a new size
+//! does not block the transforms with the already known sizes.
+//! Settings are taken from environment:
+//!   SYNFIG_FFT_PLANNER       - 'estimate' (default), 'measure' or 'patient',
+//!                              measured plans are faster, but planning of the new size takes time
+//!   SYNFIG_FFT_TIME_LIMIT    - limit of planning time in seconds for measured plans (default 10)
+//!   SYNFIG_FFT_WISDOM_FILE   - file to load FFTW wisdom at startup and to save it on exit,
+//!                              so measured plans are not measured again by the next runs
+//!   SYNFIG_FFT_THREADS       - count of threads for the transforms of large arrays
+//!                              (default 1, works only when FFTW is built with threads)
 class software::FFT::Internal
 {
 public:
+	struct PlanKey
+	{
+		int rank;
+		int howmany_rank;
+		int dims[6]; // n, is, os for each iodim
+		int sign;
+		int alignment;
+
+		bool operator< (const PlanKey &other) const
+		{
+			if (rank != other.rank) return rank < other.rank;
+			if (howmany_rank != other.howmany_rank) return howmany_rank < other.howmany_rank;
+			if (sign != other.sign) return sign < other.sign;
+			if (alignment != other.alignment) return alignment < other.alignment;
+			return memcmp(dims, other.dims, sizeof(dims)) < 0;
+		}
+	};
+
+	class Plan
+	{
+	public:
+		fftw_plan plan;
+		explicit Plan(fftw_plan plan): plan(plan) { }
+		~Plan()
+		{
+			// planner functions are not thread-safe
+			std::lock_guard<std::recursive_mutex> lock(planner_mutex);
+			fftw_destroy_plan(plan);
+		}
+	};
+
+	typedef std::shared_ptr<Plan> PlanPtr;
+	typedef std::map<PlanKey, PlanPtr> PlanMap;
+
+	//! plans for many different sizes are not kept
+	static const size_t max_plans = 1024;
+	//! arrays with less items are transformed by a single thread
+	static const int threaded_min_count = 1 << 20;
+
 	static std::set<int> counts;
-	static std::mutex mutex;
+	//! guards all calls of FFTW planner, plan destruction and wisdom
+	static std::recursive_mutex planner_mutex;
+	//! guards the map of plans, locked after planner_mutex when both are needed
+	static std::mutex plans_mutex;
+	static PlanMap plans;
+	static unsigned int flags;
+	static int threads;
+	static std::string wisdom_file;
+	static bool wisdom_loaded;
+
+	static PlanPtr find_plan(const PlanKey &key);
+
+	static fftw_plan create_plan(
+		int rank, const fftw_iodim *dims,
+		int howmany_rank, const fftw_iodim *howmany_dims,
+		fftw_complex *pointer, int sign, int alignment );
+
+	static PlanPtr get_plan(
+		int rank, const fftw_iodim *dims,
+		int howmany_rank, const fftw_iodim *howmany_dims,
+		fftw_complex *pointer, int sign );
+
+	static void execute(
+		int rank, const fftw_iodim *dims,
+		int howmany_rank, const fftw_iodim *howmany_dims,
+		fftw_complex *pointer, bool invert );
 };
 
 std::set<int> software::FFT::Internal::counts;
-std::mutex software::FFT::Internal::mutex;
+std::recursive_mutex software::FFT::Internal::planner_mutex;
+std::mutex software::FFT::Internal::plans_mutex;
+software::FFT::Internal::PlanMap software::FFT::Internal::plans;
+unsigned int software::FFT::Internal::flags = FFTW_ESTIMATE;
+int software::FFT::Internal::threads = 1;
+std::string software::FFT::Internal::wisdom_file;
+bool software::FFT::Internal::wisdom_loaded = false;
+
+software::FFT::Internal::PlanPtr
+software::FFT::Internal::find_plan(const PlanKey &key)
+{
+	std::lock_guard<std::mutex> lock(plans_mutex);
+	PlanMap::const_iterator i = plans.find(key);
+	return i == plans.end() ? PlanPtr() : i->second;
+}
+
+fftw_plan
+software::FFT::Internal::create_plan(
+	int rank, const fftw_iodim *dims,
+	int howmany_rank, const fftw_iodim *howmany_dims,
+	fftw_complex *pointer, int sign, int alignment )
+{
+	// measuring planner overwrites arrays, so plan is created for the temporary array
+	// with the same extent and alignment
+	fftw_complex *plan_pointer = pointer;
+	void *buffer = nullptr;
+	int count = 1;
+	if (flags != FFTW_ESTIMATE) {
+		size_t extent = 1;
+		for(int i = 0; i < rank; ++i)
+			extent += (size_t)(dims[i].n - 1)*std::abs(dims[i].is);
+		for(int i = 0; i < howmany_rank; ++i)
+			extent += (size_t)(howmany_dims[i].n - 1)*std::abs(howmany_dims[i].is);
+		buffer = fftw_malloc(extent*sizeof(fftw_complex) + 16);
+		if (buffer)
+			plan_pointer = (fftw_complex*)((char*)buffer + alignment);
+	}
+
+	for(int i = 0; i < rank; ++i)
+		count *= dims[i].n;
+	for(int i = 0; i < howmany_rank; ++i)
+		count *= howmany_dims[i].n;
+#ifdef HAVE_FFTW3_THREADS
+	if (threads > 1)
+		fftw_plan_with_nthreads(count < threaded_min_count ? 1 : threads);
+#endif
+
+	fftw_plan plan = nullptr;
+	if (buffer || flags == FFTW_ESTIMATE)
+		plan = fftw_plan_guru_dft(
+			rank, dims, howmany_rank, howmany_dims,
+			plan_pointer, plan_pointer, sign, flags );
+	if (buffer)
+		fftw_free(buffer);
+
+	// estimating planner does not touch the arrays, so the caller's array is used
+	if (!plan && flags != FFTW_ESTIMATE) {
+		synfig::warning("FFT: cannot create measured plan, estimated plan is used");
+		plan = fftw_plan_guru_dft(
+			rank, dims, howmany_rank, howmany_dims,
+			pointer, pointer, sign, FFTW_ESTIMATE );
+	}
+	return plan;
+}
+
+software::FFT::Internal::PlanPtr
+software::FFT::Internal::get_plan(
+	int rank, const fftw_iodim *dims,
+	int howmany_rank, const fftw_iodim *howmany_dims,
+	fftw_complex *pointer, int sign )
+{
+	assert(rank + howmany_rank <= 2);
+
+	PlanKey key;
+	memset(&key, 0, sizeof(key));
+	key.rank = rank;
+	key.howmany_rank = howmany_rank;
+	key.sign = sign;
+	key.alignment = fftw_alignment_of((double*)pointer);
+	int *k = key.dims;
+	for(int i = 0; i < rank; ++i, k += 3)
+		{ k[0] = dims[i].n; k[1] = dims[i].is; k[2] = dims[i].os; }
+	for(int i = 0; i < howmany_rank; ++i, k += 3)
+		{ k[0] = howmany_dims[i].n; k[1] = howmany_dims[i].is; k[2] = howmany_dims[i].os; }
+
+	if (PlanPtr plan = find_plan(key))
+		return plan;
+
+	// only one plan is created at once, other threads still execute the known plans
+	std::lock_guard<std::recursive_mutex> planner_lock(planner_mutex);
+	if (PlanPtr plan = find_plan(key))
+		return plan; // created by other thread while this one waited for the planner
+
+	fftw_plan plan = create_plan(rank, dims, howmany_rank, howmany_dims, pointer, sign, key.alignment);
+	if (!plan)
+		throw std::runtime_error("FFT: cannot create plan");
+	PlanPtr ptr = std::make_shared<Plan>(plan);
+
+	// old plans are destroyed when planner_mutex is locked but plans_mutex is not
+	PlanMap old_plans;
+	{
+		std::lock_guard<std::mutex> lock(plans_mutex);
+		if (plans.size() >= max_plans)
+			old_plans.swap(plans); // plans are still alive while they are executed by other threads
+		plans[key] = ptr;
+	}
+	return ptr;
+}
+
+void
+software::FFT::Internal::execute(
+	int rank, const fftw_iodim *dims,
+	int howmany_rank, const fftw_iodim *howmany_dims,
+	fftw_complex *pointer, bool invert )
+{
+	PlanPtr plan = get_plan(rank, dims, howmany_rank, howmany_dims, pointer, invert ? FFTW_BACKWARD : FFTW_FORWARD);
+	fftw_execute_dft(plan->plan, pointer, pointer);
+}
 
 void
 software::FFT::initialize()
@@ -80,13 +282,66 @@ software::FFT::initialize()
 			for(int c5 = c3; c5 < max5; c5 *= 5)
 				for(int c7 = c5; c7 < max7; c7 *= 7)
 					Internal::counts.insert(c7);
-	fftw_set_timelimit(0.0);
+
+	std::lock_guard<std::recursive_mutex> lock(Internal::planner_mutex);
+
+	Internal::flags = FFTW_ESTIMATE;
+	if (const char *s = getenv("SYNFIG_FFT_PLANNER")) {
+		if (!strcmp(s, "measure"))
+			Internal::flags = FFTW_MEASURE;
+		else
+		if (!strcmp(s, "patient"))
+			Internal::flags = FFTW_PATIENT;
+	}
+
+	if (Internal::flags == FFTW_ESTIMATE) {
+		fftw_set_timelimit(0.0);
+	} else {
+		double time_limit = 10.0;
+		if (const char *s = getenv("SYNFIG_FFT_TIME_LIMIT"))
+			time_limit = atof(s);
+		fftw_set_timelimit(time_limit > 0.0 ? time_limit : FFTW_NO_TIMELIMIT);
+	}
+
+	Internal::threads = 1;
+#ifdef HAVE_FFTW3_THREADS
+	if (const char *s = getenv("SYNFIG_FFT_THREADS"))
+		Internal::threads = std::max(1, std::min(atoi(s), (int)std::thread::hardware_concurrency()));
+	if (Internal::threads > 1 && !fftw_init_threads()) {
+		synfig::warning("FFT: cannot initialize threads");
+		Internal::threads = 1;
+	}
+#endif
+
+	Internal::wisdom_file.clear();
+	Internal::wisdom_loaded = false;
+	if (const char *s = getenv("SYNFIG_FFT_WISDOM_FILE"))
+		Internal::wisdom_file = s;
+	if (!Internal::wisdom_file.empty())
+		Internal::wisdom_loaded = fftw_import_wisdom_from_filename(Internal::wisdom_file.c_str());
 }
 
 void
 software::FFT::deinitialize()
 {
 	Internal::counts.clear();
+
+	std::lock_guard<std::recursive_mutex> lock(Internal::planner_mutex);
+	{
+		// plans are destroyed after plans_mutex is unlocked
+		Internal::PlanMap plans;
+		{
+			std::lock_guard<std::mutex> plans_lock(Internal::plans_mutex);
+			plans.swap(Internal::plans);
+		}
+	}
+	if (!Internal::wisdom_file.empty() && Internal::flags != FFTW_ESTIMATE)
+		if (!fftw_export_wisdom_to_filename(Internal::wisdom_file.c_str()))
+			synfig::warning("FFT: cannot save wisdom to file: %s", Internal::wisdom_file.c_str());
+#ifdef HAVE_FFTW3_THREADS
+	if (Internal::threads > 1)
+		fftw_cleanup_threads();
+#endif
 }
 
 int
@@ -102,6 +357,20 @@ software::FFT::get_valid_count(int x)
 	return 0;
 }
 
+size_t
+software::FFT::get_plan_count()
+{
+	std::lock_guard<std::mutex> lock(Internal::plans_mutex);
+	return Internal::plans.size();
+}
+
+bool
+software::FFT::is_wisdom_loaded()
+{
+	std::lock_guard<std::recursive_mutex> lock(Internal::planner_mutex);
+	return Internal::wisdom_loaded;
+}
+
 bool
 software::FFT::is_valid_count(int x)
 {
@@ -120,15 +389,7 @@ software::FFT::fft(const Array<Complex, 1> &x, bool invert)
 	iodim.is = x.stride;
 	iodim.os = x.stride;
 
-	{
-		std::lock_guard<std::mutex> lock(Internal::mutex);
-		fftw_plan plan = fftw_plan_guru_dft(
-			1, &iodim, 0, nullptr,
-			(fftw_complex*)x.pointer, (fftw_complex*)x.pointer,
-			invert ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
-		fftw_execute(plan);
-		fftw_destroy_plan(plan);
-	}
+	Internal::execute(1, &iodim, 0, nullptr, (fftw_complex*)x.pointer, invert);
 
 	// divide by count to complete back-FFT
 	if (invert)
@@ -155,27 +416,10 @@ software::FFT::fft2d(const Array<Complex, 2> &x, bool invert, bool do_rows, bool
 	iodim[1].is = x.stride;
 	iodim[1].os = x.stride;
 
-	{
-		std::lock_guard<std::mutex> lock(Internal::mutex);
-
-		fftw_plan plan;
-		if (do_rows && do_cols)
-		{
-			plan = fftw_plan_guru_dft(
-				2, iodim, 0, nullptr,
-				(fftw_complex*)x.pointer, (fftw_complex*)x.pointer,
-				invert ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
-		}
-		else
-		{
-			plan = fftw_plan_guru_dft(
-				1, &iodim[do_rows ? 0 : 1], 1, &iodim[do_rows ? 1 : 0],
-				(fftw_complex*)x.pointer, (fftw_complex*)x.pointer,
-				invert ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
-		}
-		fftw_execute(plan);
-		fftw_destroy_plan(plan);
-	}
+	if (do_rows && do_cols)
+		Internal::execute(2, iodim, 0, nullptr, (fftw_complex*)x.pointer, invert);
+	else
+		Internal::execute(1, &iodim[do_rows ? 0 : 1], 1, &iodim[do_rows ? 1 : 0], (fftw_complex*)x.pointer, invert);
 
 	// divide by count to complete back-FFT
 	if (invert)
@@ -58,6 +58,11 @@ public:
 	static void fft(const Array<Complex, 1> &x, bool invert);
 	static void fft2d(const Array<Complex, 2> &x, bool invert, bool do_rows = true, bool do_cols = true);
 
+	//! count of cached plans
+	static size_t get_plan_count();
+	//! true when wisdom is loaded from SYNFIG_FFT_WISDOM_FILE by initialize()
+	static bool is_wisdom_loaded();
+
 	static void initialize();
 	static void deinitialize();
 };
@@ -0,0 +1,320 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/polyspancache.cpp
+**	\brief PolyspanCache
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "polyspancache.h"
+#include "contour.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+#define DEF_MAX_CACHED_MB 64
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+//! translation must fit into the integer coordinates of marks
+const Real max_translation = 1e9;
+
+inline bool
+equal_vectors(const Vector &a, const Vector &b)
+	{ return a[0] == b[0] && a[1] == b[1]; }
+
+bool
+equal_chunks(const rendering::Contour::ChunkList &a, const rendering::Contour::ChunkList &b)
+{
+	if (a.size() != b.size())
+		return false;
+	for(rendering::Contour::ChunkList::const_iterator i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j)
+		if ( i->type != j->type
+		  || !equal_vectors(i->p1, j->p1)
+		  || !equal_vectors(i->pp0, j->pp0)
+		  || !equal_vectors(i->pp1, j->pp1) )
+			return false;
+	return true;
+}
+
+Rect
+calc_bounds(const rendering::Contour::ChunkList &chunks, const Matrix &transform_matrix)
+{
+	Rect bounds( transform_matrix.get_transformed(chunks.front().p1) );
+	for(rendering::Contour::ChunkList::const_iterator i = chunks.begin(); i != chunks.end(); ++i)
+		switch(i->type) {
+		case rendering::Contour::CUBIC:
+			bounds.expand( transform_matrix.get_transformed(i->pp1) );
+		case rendering::Contour::CONIC:
+			bounds.expand( transform_matrix.get_transformed(i->pp0) );
+		default:
+			bounds.expand( transform_matrix.get_transformed(i->p1) );
+			break;
+		}
+	return bounds;
+}
+
+}
+
+/* === M E T H O D S ======================================================= */
+
+const int software::PolyspanCache::subpixels;
+const int software::PolyspanCache::max_size;
+const size_t software::PolyspanCache::max_seen;
+
+bool
+software::PolyspanCache::Key::operator== (const Key &other) const
+{
+	return hash == other.hash
+		&& m00 == other.m00 && m01 == other.m01
+		&& m10 == other.m10 && m11 == other.m11
+		&& sub_x == other.sub_x && sub_y == other.sub_y
+		&& detail == other.detail;
+}
+
+software::PolyspanCache::PolyspanCache():
+	max_cached((size_t)DEF_MAX_CACHED_MB*1024*1024),
+	generation()
+{
+	if (const char *s = getenv("SYNFIG_POLYSPAN_CACHE_MAX_MEMORY_MB"))
+		max_cached = (size_t)std::max(0, atoi(s))*1024*1024;
+}
+
+software::PolyspanCache::EntryPtr
+software::PolyspanCache::find(const Key &key, const rendering::Contour::ChunkList &chunks)
+{
+	std::pair<Map::iterator, Map::iterator> range = map.equal_range(key);
+	for(Map::iterator i = range.first; i != range.second; ++i)
+		if (equal_chunks((*i->second)->chunks, chunks)) {
+			entries.splice(entries.begin(), entries, i->second);
+			return *i->second;
+		}
+	return EntryPtr();
+}
+
+void
+software::PolyspanCache::insert(const EntryPtr &entry)
+{
+	if (entry->size > max_cached)
+		return;
+	// other thread may flatten the same contour at the same time
+	if (find(entry->key, entry->chunks))
+		return;
+	entries.push_front(entry);
+	map.insert(Map::value_type(entry->key, entries.begin()));
+	statistics.bytes_cached += entry->size;
+	++statistics.stores;
+	while(statistics.bytes_cached > max_cached)
+		remove_last();
+}
+
+void
+software::PolyspanCache::remove_last()
+{
+	const EntryPtr &entry = entries.back();
+	std::pair<Map::iterator, Map::iterator> range = map.equal_range(entry->key);
+	for(Map::iterator i = range.first; i != range.second; ++i)
+		if (*i->second == entry) { map.erase(i); break; }
+	statistics.bytes_cached -= entry->size;
+	++statistics.evictions;
+	entries.pop_back();
+}
+
+bool
+software::PolyspanCache::check_seen(const Key &key)
+{
+	if (seen.size() >= max_seen)
+		seen.clear();
+	std::pair<SeenMap::iterator, bool> i = seen.insert(SeenMap::value_type(key, generation));
+	if (i.second)
+		return false;
+	bool found = i.first->second != generation;
+	i.first->second = generation;
+	return found;
+}
+
+void
+software::PolyspanCache::next_generation()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	++generation;
+}
+
+void
+software::PolyspanCache::build_polyspan(
+	const rendering::Contour::ChunkList &chunks,
+	const Matrix &transform_matrix,
+	Polyspan &out_polyspan,
+	Real detail )
+{
+	const Matrix &m = transform_matrix;
+	bool cacheable = get_max_cached()
+	              && !chunks.empty()
+	              && chunks.front().type == rendering::Contour::MOVE
+	              && m.m02 == 0.0 && m.m12 == 0.0 && m.m22 == 1.0
+	              && std::fabs(m.m20) < max_translation
+	              && std::fabs(m.m21) < max_translation;
+
+	// contour is flattened with subpixel part of translation only,
+	// integer part is added to the coordinates of marks
+	Real x = 0.0, y = 0.0;
+	Matrix relative_matrix = m;
+	Key key;
+	Rect bounds;
+	if (cacheable) {
+		x = std::floor(m.m20);
+		y = std::floor(m.m21);
+		key.sub_x = (int)std::round((m.m20 - x)*subpixels);
+		key.sub_y = (int)std::round((m.m21 - y)*subpixels);
+		if (key.sub_x == subpixels) { key.sub_x = 0; x += 1.0; }
+		if (key.sub_y == subpixels) { key.sub_y = 0; y += 1.0; }
+		relative_matrix.m20 = (Real)key.sub_x/subpixels;
+		relative_matrix.m21 = (Real)key.sub_y/subpixels;
+
+		bounds = calc_bounds(chunks, relative_matrix);
+		cacheable = bounds.is_valid()
+		         && std::fabs(bounds.minx) < max_translation && std::fabs(bounds.maxx) < max_translation
+		         && std::fabs(bounds.miny) < max_translation && std::fabs(bounds.maxy) < max_translation
+		         && bounds.maxx - bounds.minx <= max_size
+		         && bounds.maxy - bounds.miny <= max_size;
+	}
+
+	if (!cacheable) {
+		software::Contour::build_polyspan(chunks, transform_matrix, out_polyspan, detail);
+		out_polyspan.close();
+		return;
+	}
+
+	key.hash = rendering::Contour::calc_hash(chunks);
+	key.m00 = m.m00;
+	key.m01 = m.m01;
+	key.m10 = m.m10;
+	key.m11 = m.m11;
+	key.detail = detail;
+
+	EntryPtr entry;
+	bool store = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		++statistics.lookups;
+		entry = find(key, chunks);
+		if (entry)
+			++statistics.hits;
+		else
+			store = check_seen(key);
+	}
+
+	if (!entry && !store) {
+		// contour may be changed in the next frame, so don't flatten it outside of the window
+		software::Contour::build_polyspan(chunks, transform_matrix, out_polyspan, detail);
+		out_polyspan.close();
+		return;
+	}
+
+	if (!entry) {
+		// flatten into the window which contains the whole contour, so marks are not clipped
+		Polyspan polyspan;
+		polyspan.init(
+			(int)std::floor(bounds.minx) - 2,
+			(int)std::floor(bounds.miny) - 2,
+			(int)std::ceil(bounds.maxx) + 2,
+			(int)std::ceil(bounds.maxy) + 2 );
+		software::Contour::build_polyspan(chunks, relative_matrix, polyspan, detail);
+		polyspan.close();
+		polyspan.sort_marks();
+
+		std::shared_ptr<Entry> new_entry = std::make_shared<Entry>();
+		new_entry->key = key;
+		new_entry->chunks = chunks;
+		new_entry->marks = polyspan.get_covers();
+		new_entry->size = sizeof(Entry)
+		                + new_entry->chunks.capacity()*sizeof(rendering::Contour::Chunk)
+		                + new_entry->marks.capacity()*sizeof(Polyspan::PenMark);
+		entry = new_entry;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		insert(entry);
+	}
+
+	out_polyspan.assign_marks(entry->marks, (int)x, (int)y);
+}
+
+void
+software::PolyspanCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	map.clear();
+	entries.clear();
+	seen.clear();
+	statistics.bytes_cached = 0;
+}
+
+void
+software::PolyspanCache::set_max_cached(size_t size)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	max_cached = size;
+	while(statistics.bytes_cached > max_cached)
+		remove_last();
+}
+
+size_t
+software::PolyspanCache::get_max_cached() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return max_cached;
+}
+
+software::PolyspanCache::Statistics
+software::PolyspanCache::get_statistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+software::PolyspanCache&
+software::PolyspanCache::instance()
+{
+	static PolyspanCache *cache = new PolyspanCache();
+	return *cache;
+}
+
+/* === E N T R Y P O I N T ================================================= */
@@ -0,0 +1,165 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/polyspancache.h
+**	\brief PolyspanCache Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_SOFTWARE_POLYSPANCACHE_H
+#define __SYNFIG_RENDERING_SOFTWARE_POLYSPANCACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <synfig/matrix.h>
+
+#include "../../primitive/contour.h"
+#include "../../primitive/polyspan.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+namespace software
+{
+
+//! Keeps the sorted marks of flattened contours, so static shapes (and shapes moved by whole pixels)
+//! are not flattened and sorted again in the next frames or in the next tiles of the same frame.
+//! Key is the content of contour, the linear part of affine transformation, the subpixel part
+//! of translation (rounded to 1/65536 of pixel) and the detail of flattening.
+//! Marks are kept unclipped and they are clipped by the window of the target polyspan.
+//! Only contours which are found in two different generations (frames) are kept,
+//! contours seen for the first time are flattened into the clipped polyspan without cache.
+//! Least recently used entries are evicted when the memory limit is reached.
+//! Settings are taken from environment:
+//!   SYNFIG_POLYSPAN_CACHE_MAX_MEMORY_MB - limit of memory kept by cache (0 disables cache)
+class PolyspanCache
+{
+public:
+	//! all sizes are in bytes
+	struct Statistics
+	{
+		size_t lookups;      //!< count of the cacheable contours
+		size_t hits;         //!< contours taken from cache
+		size_t stores;       //!< contours put into cache
+		size_t evictions;    //!< entries removed because of the memory limit
+		size_t bytes_cached; //!< memory of entries kept by cache
+
+		Statistics():
+			lookups(), hits(), stores(), evictions(), bytes_cached() { }
+	};
+
+	//! subpixel part of translation is rounded to 1/subpixels
+	static const int subpixels = 65536;
+	//! bigger contours are flattened into the clipped polyspan without cache
+	static const int max_size = 8192;
+	//! contours seen in previous generations are forgotten when this count is reached
+	static const size_t max_seen = 65536;
+
+private:
+	struct Key
+	{
+		uint64_t hash;
+		Real m00, m01, m10, m11;
+		int sub_x, sub_y;
+		Real detail;
+
+		bool operator== (const Key &other) const;
+	};
+
+	struct KeyHash
+		{ size_t operator() (const Key &key) const { return (size_t)key.hash; } };
+
+	struct Entry
+	{
+		Key key;
+		rendering::Contour::ChunkList chunks;
+		Polyspan::cover_array marks;
+		size_t size;
+	};
+
+	typedef std::shared_ptr<const Entry> EntryPtr;
+	typedef std::list<EntryPtr> List;
+	typedef std::unordered_multimap<Key, List::iterator, KeyHash> Map;
+	typedef std::unordered_map<Key, long long, KeyHash> SeenMap;
+
+	mutable std::mutex mutex;
+	List entries; //!< recently used entries are first
+	Map map;
+	SeenMap seen; //!< generation when key was seen last time
+	size_t max_cached;
+	long long generation;
+	Statistics statistics;
+
+	PolyspanCache();
+	PolyspanCache(const PolyspanCache&) = delete;
+	PolyspanCache& operator=(const PolyspanCache&) = delete;
+
+	EntryPtr find(const Key &key, const rendering::Contour::ChunkList &chunks);
+	void insert(const EntryPtr &entry);
+	void remove_last();
+	bool check_seen(const Key &key);
+
+public:
+	//! Starts the new generation, usually one generation per each rendered task list
+	void next_generation();
+
+	//! Flattens the contour into the polyspan (like software::Contour::build_polyspan()
+	//! followed by Polyspan::close()), polyspan must be initialized by the target window.
+	//! Marks of the cached contours are sorted already.
+	void build_polyspan(
+		const rendering::Contour::ChunkList &chunks,
+		const Matrix &transform_matrix,
+		Polyspan &out_polyspan,
+		Real detail = 1.0 );
+
+	//! Removes all entries
+	void clear();
+
+	void set_max_cached(size_t size);
+	size_t get_max_cached() const;
+
+	Statistics get_statistics() const;
+
+	static PolyspanCache& instance();
+};
+
+} /* end namespace software */
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
@@ -0,0 +1,114 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/powtable.cpp
+**	\brief PowTable
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cmath>
+#include <mutex>
+
+#include "powtable.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+namespace {
+
+//! gamma rarely changes, so only a few last tables are kept
+const int cache_size = 8;
+
+struct Cache
+{
+	std::mutex mutex;
+	ColorReal gammas[cache_size];
+	std::shared_ptr<const std::vector<ColorReal> > tables[cache_size];
+	int next;
+
+	Cache(): gammas(), next() { }
+};
+
+}
+
+/* === P R O C E D U R E S ================================================= */
+
+static Cache&
+get_cache()
+{
+	static Cache *cache = new Cache();
+	return *cache;
+}
+
+/* === M E T H O D S ======================================================= */
+
+std::shared_ptr<const std::vector<ColorReal> >
+software::PowTable::get_table(ColorReal gamma)
+{
+	Cache &cache = get_cache();
+	{
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		for(int i = 0; i < cache_size; ++i)
+			if (cache.tables[i] && cache.gammas[i] == gamma)
+				return cache.tables[i];
+	}
+
+	// build outside of lock, values are calculated in double precision
+	std::shared_ptr<Table> table = std::make_shared<Table>(Exponents*(Points + 1));
+	ColorReal *v = &table->front();
+	for(int e = 0; e < Exponents; ++e)
+		for(int i = 0; i <= Points; ++i, ++v)
+			*v = ColorReal(std::pow(std::ldexp(1.0 + double(i)/Points, e + MinExponent), double(gamma)));
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	cache.gammas[cache.next] = gamma;
+	cache.tables[cache.next] = table;
+	cache.next = (cache.next + 1) % cache_size;
+	return table;
+}
+
+software::PowTable::PowTable(ColorReal gamma, bool use_table):
+	gamma(gamma),
+	values(),
+	exponents()
+{
+	if (use_table && is_supported(gamma)) {
+		table = get_table(gamma);
+		values = &table->front();
+		exponents = Exponents;
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
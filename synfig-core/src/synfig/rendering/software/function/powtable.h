@@ -0,0 +1,119 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/powtable.h
+**	\brief PowTable Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_SOFTWARE_POWTABLE_H
+#define __SYNFIG_RENDERING_SOFTWARE_POWTABLE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <synfig/color.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+namespace software
+{
+
+//! Fast sign(x)*pow(|x|, gamma) for the colors in range (-2, 2).
+//! Table keeps the values at 128 points of mantissa for every binary exponent from 2^-24 to 2^0,
+//! values between points are interpolated linearly.
+//! Relative error does not exceed 7.7e-6*|gamma*(gamma - 1)| + 1e-6
+//! (2.2e-5 for gamma 2.2, see test/benchmark_gamma.cpp).
+//! Other values (HDR and very dark colors) and unsupported gammas are calculated by powf().
+class PowTable
+{
+public:
+	enum {
+		MantissaBits = 7,
+		Points       = 1 << MantissaBits,
+		MinExponent  = -24,
+		Exponents    = 1 - MinExponent
+	};
+
+	static bool is_supported(ColorReal gamma)
+		{ return gamma >= ColorReal(0.125) && gamma <= ColorReal(8.0); }
+
+private:
+	typedef std::vector<ColorReal> Table;
+
+	ColorReal gamma;
+	std::shared_ptr<const Table> table;
+	const ColorReal *values;
+	unsigned int exponents; //!< zero when table is not used
+
+	static std::shared_ptr<const Table> get_table(ColorReal gamma);
+
+public:
+	//! Tables are shared between the instances with the same gamma
+	explicit PowTable(ColorReal gamma = ColorReal(1.0), bool use_table = true);
+
+	ColorReal get_gamma() const
+		{ return gamma; }
+	bool is_table_used() const
+		{ return exponents; }
+
+	ColorReal calculate(ColorReal x) const
+	{
+		uint32_t bits;
+		memcpy(&bits, &x, sizeof(bits));
+		uint32_t sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		unsigned int index = (bits >> 23) - (127 + MinExponent);
+		if (index >= exponents)
+			return Gamma::calculate(x, gamma);
+
+		const ColorReal *v = values + index*(Points + 1) + ((bits >> (23 - MantissaBits)) & (Points - 1));
+		const uint32_t frac_mask = (1u << (23 - MantissaBits)) - 1;
+		ColorReal f = ColorReal(bits & frac_mask)*(ColorReal(1.0)/ColorReal(frac_mask + 1));
+		ColorReal y = v[0] + (v[1] - v[0])*f;
+		return sign ? -y : y;
+	}
+
+	ColorReal operator()(ColorReal x) const
+		{ return calculate(x); }
+};
+
+} /* end namespace software */
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
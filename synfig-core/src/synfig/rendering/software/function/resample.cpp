@@ -515,7 +515,38 @@ software::Resample::downscale(
 	bool keep_cooked )
 {
 	typedef software::PackedSurface::Reader Reader;
+	Reader src_reader(src);
 	Helper::Generic<Reader::reader, Reader::reader_cook>::downscale(
+		dest, dest_bounds,
+		&src_reader, src_bounds,
+		keep_cooked );
+}
+
+
+void
+software::Resample::downscale(
+	synfig::Surface &dest,
+	const RectInt &dest_bounds,
+	const software::HalfSurface &src,
+	const RectInt &src_bounds,
+	bool keep_cooked )
+{
+	Helper::Generic<software::HalfSurface::reader, software::HalfSurface::reader_cook>::downscale(
+		dest, dest_bounds,
+		&src, src_bounds,
+		keep_cooked );
+}
+
+
+void
+software::Resample::downscale(
+	synfig::Surface &dest,
+	const RectInt &dest_bounds,
+	const software::ByteSurface &src,
+	const RectInt &src_bounds,
+	bool keep_cooked )
+{
+	Helper::Generic<software::ByteSurface::reader, software::ByteSurface::reader_cook>::downscale(
 		dest, dest_bounds,
 		&src, src_bounds,
 		keep_cooked );
@@ -573,5 +604,53 @@ software::Resample::resample(
 		blend_method );
 }
 
+void
+software::Resample::resample(
+	synfig::Surface &dest,
+	const RectInt &dest_bounds,
+	const software::HalfSurface &src,
+	const RectInt &src_bounds,
+	const Matrix &transformation,
+	Color::Interpolation interpolation,
+	bool blend,
+	ColorReal blend_amount,
+	Color::BlendMethod blend_method )
+{
+	Helper::Generic<software::HalfSurface::reader, software::HalfSurface::reader_cook>::resample_with_downscale(
+		dest,
+		dest_bounds,
+		&src,
+		src_bounds,
+		transformation,
+		interpolation,
+		blend,
+		blend_amount,
+		blend_method );
+}
+
+void
+software::Resample::resample(
+	synfig::Surface &dest,
+	const RectInt &dest_bounds,
+	const software::ByteSurface &src,
+	const RectInt &src_bounds,
+	const Matrix &transformation,
+	Color::Interpolation interpolation,
+	bool blend,
+	ColorReal blend_amount,
+	Color::BlendMethod blend_method )
+{
+	Helper::Generic<software::ByteSurface::reader, software::ByteSurface::reader_cook>::resample_with_downscale(
+		dest,
+		dest_bounds,
+		&src,
+		src_bounds,
+		transformation,
+		interpolation,
+		blend,
+		blend_amount,
+		blend_method );
+}
+
 
 /* === E N T R Y P O I N T ================================================= */
@@ -34,6 +34,7 @@
 #include <synfig/surface.h>
 
 #include "../surfaceswpacked.h"
+#include "compactsurface.h"
 
 /* === M A C R O S ========================================================= */
 
@@ -65,6 +66,20 @@ public:
 		const RectInt &src_bounds,
 		bool keep_cooked = false );
 
+	static void downscale(
+		synfig::Surface &dest,
+		const RectInt &dest_bounds,
+		const HalfSurface &src,
+		const RectInt &src_bounds,
+		bool keep_cooked = false );
+
+	static void downscale(
+		synfig::Surface &dest,
+		const RectInt &dest_bounds,
+		const ByteSurface &src,
+		const RectInt &src_bounds,
+		bool keep_cooked = false );
+
 	static void resample(
 		synfig::Surface &dest,
 		const RectInt &dest_bounds,
@@ -86,6 +101,28 @@ public:
 		bool blend,
 		ColorReal blend_amount,
 		Color::BlendMethod blend_method );
+
+	static void resample(
+		synfig::Surface &dest,
+		const RectInt &dest_bounds,
+		const HalfSurface &src,
+		const RectInt &src_bounds,
+		const Matrix &transformation,
+		Color::Interpolation interpolation,
+		bool blend,
+		ColorReal blend_amount,
+		Color::BlendMethod blend_method );
+
+	static void resample(
+		synfig::Surface &dest,
+		const RectInt &dest_bounds,
+		const ByteSurface &src,
+		const RectInt &src_bounds,
+		const Matrix &transformation,
+		Color::Interpolation interpolation,
+		bool blend,
+		ColorReal blend_amount,
+		Color::BlendMethod blend_method );
 };
 
 } /* end namespace software */
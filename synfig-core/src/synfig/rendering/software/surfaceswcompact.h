@@ -0,0 +1,123 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/surfaceswcompact.h
+**	\brief SurfaceSWHalf and SurfaceSW8 Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_SURFACESWCOMPACT_H
+#define __SYNFIG_RENDERING_SURFACESWCOMPACT_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <vector>
+
+#include <synfig/synfig_export.h>
+
+#include "../surface.h"
+
+#include "function/compactsurface.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+//! Common part of surfaces with compact pixels,
+//! tasks read them directly or lock as SurfaceSW (it converts pixels)
+template<typename T>
+class SurfaceSWCompact: public Surface
+{
+public:
+	typedef software::CompactSurface<T> CompactSurface;
+
+private:
+	CompactSurface surface;
+
+protected:
+	virtual bool create_vfunc(int width, int height)
+		{ surface.create(width, height); return true; }
+
+	virtual bool assign_vfunc(const Surface &other)
+	{
+		if (const SurfaceSWCompact *s = dynamic_cast<const SurfaceSWCompact*>(&other)) {
+			surface.assign(s->surface);
+			return true;
+		}
+		const Color *pixels = other.get_pixels_pointer();
+		std::vector<Color> data;
+		if (!pixels) {
+			data.resize(other.get_pixels_count());
+			if (!other.get_pixels(&data.front()))
+				return false;
+			pixels = &data.front();
+		}
+		surface.set_pixels(pixels, other.get_width(), other.get_height());
+		return true;
+	}
+
+	virtual bool clear_vfunc()
+		{ surface.clear(); return true; }
+	virtual bool reset_vfunc()
+		{ surface.reset(); return true; }
+	virtual bool get_pixels_vfunc(Color *dest) const
+		{ surface.get_pixels(dest); return true; }
+
+public:
+	const CompactSurface& get_surface() const
+		{ return surface; }
+};
+
+//! Surface with half float channels, for renders which does not need float precision
+class SurfaceSWHalf: public SurfaceSWCompact<software::PixelHalf>
+{
+public:
+	typedef etl::handle<SurfaceSWHalf> Handle;
+	SYNFIG_EXPORT static Token token;
+	virtual Token::Handle get_token() const
+		{ return token.handle(); }
+};
+
+//! Surface with 8-bit channels and premultiplied alpha,
+//! colors are clamped to [0, 1], so it is for draft renders only
+class SurfaceSW8: public SurfaceSWCompact<software::PixelUInt8>
+{
+public:
+	typedef etl::handle<SurfaceSW8> Handle;
+	SYNFIG_EXPORT static Token token;
+	virtual Token::Handle get_token() const
+		{ return token.handle(); }
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
@@ -35,6 +35,8 @@
 #include <synfig/debug/debugsurface.h>
 
 #include "../../common/task/taskblend.h"
+#include "../function/blend.h"
+#include "../surfaceswcompact.h"
 #include "tasksw.h"
 
 #endif
@@ -72,6 +74,21 @@ public:
 		}
 	}
 
+	template<typename T>
+	bool blend_b(synfig::Surface &c, const RectInt &rb, const LockReadBase &lb, const VectorInt &ob) const {
+		typename T::Handle surface = lb.cast<T>();
+		if (!surface) return false;
+		const auto &b = surface->get_surface();
+
+		assert( 0 <= rb.minx && rb.minx < rb.maxx && rb.maxx <= c.get_w()
+			 && 0 <= rb.miny && rb.miny < rb.maxy && rb.miny <= c.get_h() );
+		assert( 0 <= rb.minx + ob[0] && rb.maxx + ob[0] <= b.get_w()
+			 && 0 <= rb.miny + ob[1] && rb.maxy + ob[1] <= b.get_h() );
+
+		software::Blend::blend(c, rb, b, ob, blend_method, amount);
+		return true;
+	}
+
 	virtual bool run(RunParams&) const {
 		if (!is_valid()) return true;
 
@@ -122,24 +139,22 @@ public:
 				rect_set_intersect(rb, rb, r);
 				if (rb.is_valid())
 				{
-					LockRead lb(sub_task_b());
-					if (!lb) return false;
-					synfig::Surface &b = lb.cast_handle()->get_surface(); // TODO: make blit_to constant
-
-					assert( 0 <= rb.minx && rb.minx < rb.maxx && rb.maxx <= c.get_w()
-						 && 0 <= rb.miny && rb.miny < rb.maxy && rb.miny <= c.get_h() );
-					assert( 0 <= rb.minx + ob[0] && rb.maxx + ob[0] <= b.get_w()
-						 && 0 <= rb.miny + ob[1] && rb.maxy + ob[1] <= b.get_h() );
-
-					synfig::Surface::alpha_pen ap(c.get_pen(rb.minx, rb.miny));
-					ap.set_blend_method(blend_method);
-					ap.set_alpha(amount);
-					b.blit_to(
-						ap,
-						rb.minx + ob[0],
-						rb.miny + ob[1],
-						rb.maxx - rb.minx,
-						rb.maxy - rb.miny );
+					// surfaces with compact pixels are read directly, when there is no SurfaceSW already
+					LockReadBase lb(sub_task_b());
+					if (lb.convert<TargetSurface>(false)) {
+						if (!blend_b<TargetSurface>(c, rb, lb, ob)) return false;
+					} else
+					if (lb.convert<SurfaceSWHalf>(false)) {
+						if (!blend_b<SurfaceSWHalf>(c, rb, lb, ob)) return false;
+					} else
+					if (lb.convert<SurfaceSW8>(false)) {
+						if (!blend_b<SurfaceSW8>(c, rb, lb, ob)) return false;
+					} else
+					if (lb.convert<TargetSurface>()) {
+						if (!blend_b<TargetSurface>(c, rb, lb, ob)) return false;
+					} else {
+						return false;
+					}
 
 					if (ra.is_valid())
 					{
@@ -164,13 +179,7 @@ public:
 					assert( 0 <= fill[i].minx && fill[i].minx < fill[i].maxx && fill[i].maxx <= c.get_w()
 						 && 0 <= fill[i].miny && fill[i].miny < fill[i].maxy && fill[i].miny <= c.get_h() );
 
-					synfig::Surface::alpha_pen ap(
-						c.get_pen(fill[i].minx, fill[i].miny) );
-					ap.set_blend_method(blend_method);
-					ap.set_alpha(amount);
-					c.fill( Color(0, 0, 0, 0), ap,
-							fill[i].maxx - fill[i].minx,
-							fill[i].maxy - fill[i].miny );
+					software::Blend::fill(c, fill[i], Color(0, 0, 0, 0), blend_method, amount);
 				}
 			}
 		}
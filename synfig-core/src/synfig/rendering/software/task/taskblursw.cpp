@@ -36,6 +36,7 @@
 #include "../../common/task/taskblend.h"
 #include "tasksw.h"
 #include "../function/blur.h"
+#include "../surfaceswcompact.h"
 
 #endif
 
@@ -69,8 +70,25 @@ public:
 			return true;
 
 		LockWrite la(this);
-		LockRead lb(sub_task());
-		if (!la || !lb)
+		if (!la)
+			return false;
+
+		// surfaces with compact pixels are read directly, when there is no SurfaceSW already
+		LockReadBase lb(sub_task());
+		software::Blur::Source src;
+		if (lb.convert<TargetSurface>(false)) {
+			if (TargetSurface::Handle b = lb.cast<TargetSurface>()) src = b->get_surface();
+		} else
+		if (lb.convert<SurfaceSWHalf>(false)) {
+			if (SurfaceSWHalf::Handle b = lb.cast<SurfaceSWHalf>()) src = b->get_surface();
+		} else
+		if (lb.convert<SurfaceSW8>(false)) {
+			if (SurfaceSW8::Handle b = lb.cast<SurfaceSW8>()) src = b->get_surface();
+		} else
+		if (lb.convert<TargetSurface>()) {
+			if (TargetSurface::Handle b = lb.cast<TargetSurface>()) src = b->get_surface();
+		}
+		if (!src.is_valid())
 			return false;
 
 		Vector ppu = get_pixels_per_unit();
@@ -82,7 +100,7 @@ public:
 		software::Blur::blur(
 			software::Blur::Params(
 				la->get_surface(), target_rect,
-				lb->get_surface(), offset,
+				src, offset,
 				blur.type, s,
 				blend, blend_method, amount ));
 
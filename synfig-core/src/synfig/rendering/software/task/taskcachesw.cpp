@@ -0,0 +1,142 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/task/taskcachesw.cpp
+**	\brief TaskCacheSW
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cstring>
+
+#include "../../common/task/taskcache.h"
+#include "../../resultcache.h"
+#include "tasksw.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+namespace {
+
+class TaskCacheSW: public TaskCache, public TaskSW
+{
+public:
+	typedef etl::handle<TaskCacheSW> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+private:
+	static void copy(synfig::Surface &dst, const VectorInt &dst_pos, const synfig::Surface &src, const RectInt &src_rect)
+	{
+		size_t row_size = src_rect.get_width()*sizeof(Color);
+		for(int y = src_rect.miny; y < src_rect.maxy; ++y)
+			memcpy(&dst[dst_pos[1] + y - src_rect.miny][dst_pos[0]], &src[y][src_rect.minx], row_size);
+	}
+
+	bool run_cached() const
+	{
+		SurfaceResource::LockRead<SurfaceSW> lsrc(cached_surface);
+		if (!lsrc) return false;
+		const synfig::Surface &src = lsrc->get_surface();
+		if ( src.get_w() != cached_rect.get_width()
+		  || src.get_h() != cached_rect.get_height()
+		  || cached_rect.minx < 0 || cached_rect.maxx > target_rect.get_width()
+		  || cached_rect.miny < 0 || cached_rect.maxy > target_rect.get_height() )
+			return false;
+		if (!cached_rect.is_valid())
+			return true;
+
+		// only the pixels rendered by the sub-task are copied, as when the sub-task is run
+		LockWrite ldst(this);
+		if (!ldst) return false;
+		copy(ldst->get_surface(), target_rect.get_min() + cached_rect.get_min(), src, RectInt(0, 0, src.get_w(), src.get_h()));
+		return true;
+	}
+
+	bool run_store() const
+	{
+		// pixel of sub-task is placed to (pixel - offset) of this task
+		VectorInt offset = TaskList::calc_target_offset(*this, *sub_task());
+		RectInt rs = sub_task()->target_rect - offset;
+		rect_set_intersect(rs, rs, target_rect);
+
+		if (!rs.is_valid())
+			return true;
+
+		// cache keeps only the area rendered by sub-task, other pixels of target are not touched
+		SurfaceResource::Handle surface = new SurfaceResource();
+		surface->create(rs.get_size());
+
+		{
+			LockRead lsrc(sub_task());
+			if (!lsrc) return false;
+			const synfig::Surface &src = lsrc->get_surface();
+
+			SurfaceResource::LockWrite<SurfaceSW> lcache(surface);
+			if (!lcache) return false;
+			copy(lcache->get_surface(), VectorInt(), src, rs + offset);
+
+			LockWrite ldst(this);
+			if (!ldst) return false;
+			copy(ldst->get_surface(), rs.get_min(), src, rs + offset);
+		}
+
+		ResultCache::instance().insert(hash, surface, rs - target_rect.get_min());
+		return true;
+	}
+
+public:
+	virtual bool run(RunParams&) const {
+		if (!is_valid())
+			return true;
+		if (cached_surface)
+			return run_cached();
+		if (!sub_task() || !sub_task()->is_valid())
+			return true;
+		return run_store();
+	}
+};
+
+
+Task::Token TaskCacheSW::token(
+	DescReal<TaskCacheSW, TaskCache>("CacheSW") );
+
+} // end of anonimous namespace
+
+/* === E N T R Y P O I N T ================================================= */
@@ -39,6 +39,7 @@
 #include "../../common/task/taskblend.h"
 #include "tasksw.h"
 #include "../function/contour.h"
+#include "../function/polyspancache.h"
 
 #endif
 
@@ -79,6 +80,10 @@ public:
 	virtual Color::BlendMethodFlags get_supported_blend_methods() const
 		{ return Color::BLEND_METHODS_ALL & ~Color::BLEND_METHODS_STRAIGHT; }
 
+	//! every part flattens the whole contour
+	virtual Real get_split_overhead() const
+		{ return contour ? 16.0*contour->get_chunks().size() : 0.0; }
+
 	virtual bool run(RunParams&) const {
 		if (!is_valid())
 			return true;
@@ -97,15 +102,14 @@ public:
 
 		Polyspan polyspan;
 		polyspan.init(target_rect);
-		software::Contour::build_polyspan(contour->get_chunks(), matrix, polyspan, detail);
-		polyspan.close();
-		polyspan.sort_marks();
+		software::PolyspanCache::instance().build_polyspan(contour->get_chunks(), matrix, polyspan, detail);
 
 		LockWrite la(this);
 		if (!la)
 			return false;
 
-		software::Contour::render_polyspan(
+		// marks are sorted here, by bands for the big contours
+		software::Contour::render_polyspan_bands(
 			la->get_surface(),
 			polyspan,
 			contour->invert,
@@ -36,6 +36,7 @@
 #include <synfig/general.h>
 
 #include "../../common/task/taskpixelprocessor.h"
+#include "../function/powtable.h"
 #include "tasksw.h"
 
 #endif
@@ -61,7 +62,7 @@ public:
 	virtual Token::Handle get_token() const { return token.handle(); }
 
 private:
-	typedef void Func(ColorReal &dst, const ColorReal &src, const ColorReal &gamma);
+	typedef void Func(ColorReal &dst, const ColorReal &src, const software::PowTable &pow);
 
 	struct Params
 	{
@@ -72,18 +73,12 @@ private:
 		int width;
 		int height;
 
-		union {
-			ColorReal gamma[3];
-			struct {
-				ColorReal gamma_r, gamma_g, gamma_b;
-			};
-		};
+		software::PowTable pow_r, pow_g, pow_b;
 
 		Params():
 			dst(), dst_stride(),
 			src(), src_stride(),
-			width(), height(),
-			gamma_r(1.0), gamma_g(1.0), gamma_b(1.0)
+			width(), height()
 		{ }
 
 		Params(
@@ -100,7 +95,7 @@ private:
 			dst((ColorReal*)dst), dst_stride(dst_stride),
 			src((const ColorReal*)src), src_stride(src_stride),
 			width(width), height(height),
-			gamma_r(gamma_r), gamma_g(gamma_g), gamma_b(gamma_b)
+			pow_r(gamma_r), pow_g(gamma_g), pow_b(gamma_b)
 		{ }
 	};
 
@@ -116,13 +111,13 @@ private:
 		return synfig::clamp(x, real_low_precision<ColorReal>(), max);
 	}
 
-	static inline void func_none(ColorReal&, const ColorReal&, const ColorReal&) { }
-	static inline void func_copy(ColorReal &dst, const ColorReal &src, const ColorReal&)
+	static inline void func_none(ColorReal&, const ColorReal&, const software::PowTable&) { }
+	static inline void func_copy(ColorReal &dst, const ColorReal &src, const software::PowTable&)
 		{ dst = src; }
-	static inline void func_one(ColorReal &dst, const ColorReal &, const ColorReal &)
+	static inline void func_one(ColorReal &dst, const ColorReal &, const software::PowTable&)
 		{ dst = ColorReal(1.0); }
-	static inline void func_pow(ColorReal &dst, const ColorReal &src, const ColorReal &gamma)
-		{ dst = clamp(src < 0 ? -pow(-src, gamma) : pow(src, gamma)); }
+	static inline void func_pow(ColorReal &dst, const ColorReal &src, const software::PowTable &pow)
+		{ dst = clamp(pow(src)); }
 
 	template<Func fr, Func fg, Func fb>
 	static void process_rgb(const Params &p) {
@@ -137,9 +132,9 @@ private:
 			{
 				for(ColorReal *dst_row_end = dst + row_size; dst != dst_row_end; dst += 4)
 				{
-					fr(dst[0], dst[0], p.gamma_r);
-					fg(dst[1], dst[1], p.gamma_g);
-					fb(dst[2], dst[2], p.gamma_b);
+					fr(dst[0], dst[0], p.pow_r);
+					fg(dst[1], dst[1], p.pow_g);
+					fb(dst[2], dst[2], p.pow_b);
 				}
 			}
 		}
@@ -156,9 +151,9 @@ private:
 			{
 				for(ColorReal *dst_row_end = dst + row_size; dst != dst_row_end; dst += 4, src += 4)
 				{
-					fr(dst[0], src[0], p.gamma_r);
-					fg(dst[1], src[1], p.gamma_g);
-					fb(dst[2], src[2], p.gamma_b);
+					fr(dst[0], src[0], p.pow_r);
+					fg(dst[1], src[1], p.pow_g);
+					fb(dst[2], src[2], p.pow_b);
 					dst[3] = src[3];
 				}
 			}
@@ -167,25 +162,25 @@ private:
 
 	template<Func fr, Func fg>
 	static void process_rg(const Params &p) {
-		if ( approximate_equal_lp(p.gamma_b, ColorReal(0.0))) process_rgb<fr, fg, func_one >(p); else
-		if (!approximate_equal_lp(p.gamma_b, ColorReal(1.0))) process_rgb<fr, fg, func_pow >(p); else
-		if (p.src == p.dst)                                   process_rgb<fr, fg, func_none>(p); else
-				                                              process_rgb<fr, fg, func_copy>(p);
+		if ( approximate_equal_lp(p.pow_b.get_gamma(), ColorReal(0.0))) process_rgb<fr, fg, func_one >(p); else
+		if (!approximate_equal_lp(p.pow_b.get_gamma(), ColorReal(1.0))) process_rgb<fr, fg, func_pow >(p); else
+		if (p.src == p.dst)                                             process_rgb<fr, fg, func_none>(p); else
+				                                                        process_rgb<fr, fg, func_copy>(p);
 	}
 
 	template<Func fr>
 	static void process_r(const Params &p) {
-		if ( approximate_equal_lp(p.gamma_g, ColorReal(0.0))) process_rg<fr, func_one >(p); else
-		if (!approximate_equal_lp(p.gamma_g, ColorReal(1.0))) process_rg<fr, func_pow >(p); else
-		if (p.src == p.dst)                                   process_rg<fr, func_none>(p); else
-				                                              process_rg<fr, func_copy>(p);
+		if ( approximate_equal_lp(p.pow_g.get_gamma(), ColorReal(0.0))) process_rg<fr, func_one >(p); else
+		if (!approximate_equal_lp(p.pow_g.get_gamma(), ColorReal(1.0))) process_rg<fr, func_pow >(p); else
+		if (p.src == p.dst)                                             process_rg<fr, func_none>(p); else
+				                                                        process_rg<fr, func_copy>(p);
 	}
 
 	static void process(const Params &p) {
-		if ( approximate_equal_lp(p.gamma_r, ColorReal(0.0))) process_r<func_one >(p); else
-		if (!approximate_equal_lp(p.gamma_r, ColorReal(1.0))) process_r<func_pow >(p); else
-		if (p.src == p.dst)                                   process_r<func_none>(p); else
-				                                              process_r<func_copy>(p);
+		if ( approximate_equal_lp(p.pow_r.get_gamma(), ColorReal(0.0))) process_r<func_one >(p); else
+		if (!approximate_equal_lp(p.pow_r.get_gamma(), ColorReal(1.0))) process_r<func_pow >(p); else
+		if (p.src == p.dst)                                             process_r<func_none>(p); else
+				                                                        process_r<func_copy>(p);
 	}
 
 public:
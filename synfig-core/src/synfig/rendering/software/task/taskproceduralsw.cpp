@@ -0,0 +1,129 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/task/taskproceduralsw.cpp
+**	\brief TaskProceduralSW
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <vector>
+
+#include "../../common/task/taskblend.h"
+#include "../../common/task/taskprocedural.h"
+#include "tasksw.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+namespace {
+
+class TaskProceduralSW: public TaskProcedural, public TaskSW,
+	public TaskInterfaceBlendToTarget,
+	public TaskInterfaceSplit
+{
+public:
+	typedef etl::handle<TaskProceduralSW> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	virtual void on_target_set_as_source() {
+		Task::Handle &subtask = sub_task(0);
+		if ( subtask
+		  && subtask->target_surface == target_surface
+		  && !Color::is_straight(blend_method) )
+		{
+			trunc_by_bounds();
+			subtask->source_rect = source_rect;
+			subtask->target_rect = target_rect;
+		}
+	}
+
+	virtual Color::BlendMethodFlags get_supported_blend_methods() const
+		{ return Color::BLEND_METHODS_ALL; }
+
+	//! generator and blending of the generated row
+	virtual Real get_split_pixel_cost() const
+		{ return generator ? generator->get_pixel_cost() + 1.0 : 1.0; }
+
+	virtual bool run(RunParams&) const {
+		if (!is_valid() || !generator)
+			return true;
+
+		Vector ppu = get_pixels_per_unit();
+
+		Matrix bounds_transfromation;
+		bounds_transfromation.m00 = ppu[0];
+		bounds_transfromation.m11 = ppu[1];
+		bounds_transfromation.m20 = target_rect.minx - ppu[0]*source_rect.minx;
+		bounds_transfromation.m21 = target_rect.miny - ppu[1]*source_rect.miny;
+
+		Matrix matrix = bounds_transfromation * transformation->matrix;
+		Matrix inv_matrix = matrix.get_inverted();
+
+		int tw = target_rect.get_width();
+		Vector dx = inv_matrix.axis_x();
+		Vector dy = inv_matrix.axis_y();
+		Vector p = inv_matrix.get_transformed( Vector((Real)target_rect.minx, (Real)target_rect.miny) );
+		Vector pixel_size(dx.mag(), dy.mag());
+
+		LockWrite la(this);
+		if (!la)
+			return false;
+
+		std::vector<Color> row(tw);
+		synfig::Surface::alpha_pen apen(la->get_surface().get_pen(target_rect.minx, target_rect.miny));
+		ColorReal amount = blend ? this->amount : ColorReal(1.0);
+		apen.set_blend_method(blend ? blend_method : Color::BLEND_COMPOSITE);
+		for(int iy = target_rect.miny; iy < target_rect.maxy; ++iy, p += dy, apen.inc_y(), apen.dec_x(tw)) {
+			generator->fill_row(&row.front(), tw, p, dx, pixel_size);
+			for(std::vector<Color>::const_iterator i = row.begin(); i != row.end(); ++i, apen.inc_x())
+				apen.put_value(*i, amount);
+		}
+
+		return true;
+	}
+};
+
+
+Task::Token TaskProceduralSW::token(
+	DescReal<TaskProceduralSW, TaskProcedural>("ProceduralSW") );
+
+} // end of anonimous namespace
+
+/* === E N T R Y P O I N T ================================================= */
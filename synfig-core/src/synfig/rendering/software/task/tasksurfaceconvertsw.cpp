@@ -0,0 +1,81 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/task/tasksurfaceconvertsw.cpp
+**	\brief TaskSurfaceConvertSW
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "../../common/task/tasksurfaceconvert.h"
+#include "tasksw.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+namespace {
+
+class TaskSurfaceConvertSW: public TaskSurfaceConvert, public TaskSW
+{
+public:
+	typedef etl::handle<TaskSurfaceConvertSW> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	virtual rendering::Surface::Token::Handle get_target_token() const
+		{ return format; }
+	virtual bool get_mode_allow_simultaneous_write() const
+		{ return false; }
+
+	virtual bool run(RunParams&) const {
+		if (!is_valid() || !format)
+			return true;
+
+		// exclusive lock keeps the converted surface only
+		SurfaceResource::LockWriteBase l(target_surface, format);
+		return l.convert(format);
+	}
+};
+
+
+Task::Token TaskSurfaceConvertSW::token(
+	DescReal<TaskSurfaceConvertSW, TaskSurfaceConvert>("SurfaceConvertSW") );
+
+} // end of anonimous namespace
+
+/* === E N T R Y P O I N T ================================================= */
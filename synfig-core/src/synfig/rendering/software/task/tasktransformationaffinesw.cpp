@@ -41,6 +41,7 @@
 #include "../../common/task/taskpixelprocessor.h"
 #include "tasksw.h"
 
+#include "../surfaceswcompact.h"
 #include "../surfaceswpacked.h"
 #include "../function/resample.h"
 
@@ -60,7 +61,8 @@ using namespace rendering;
 namespace {
 
 class TaskTransformationAffineSW: public TaskTransformationAffine, public TaskSW,
-	public TaskInterfaceBlendToTarget
+	public TaskInterfaceBlendToTarget,
+	public TaskInterfaceSplit
 {
 private:
 	class Helper;
@@ -74,6 +76,27 @@ public:
 	virtual Color::BlendMethodFlags get_supported_blend_methods() const
 		{ return Color::BLEND_METHODS_ALL; }
 
+	virtual Real get_split_pixel_cost() const
+	{
+		return interpolation >= Color::INTERPOLATION_CUBIC ? 8.0
+		     : interpolation >= Color::INTERPOLATION_LINEAR ? 4.0 : 2.0;
+	}
+
+	template<typename T>
+	void resample(synfig::Surface &dst, const T &src, const Matrix &matrix) const
+	{
+		software::Resample::resample(
+			dst,
+			target_rect,
+			src,
+			sub_task()->target_rect,
+			matrix,
+			interpolation,
+			blend,
+			amount,
+			blend_method );
+	}
+
 	virtual bool run(RunParams&) const
 	{
 		if (!is_valid() || !sub_task() || !sub_task()->is_valid())
@@ -102,34 +125,33 @@ public:
 		Matrix matrix = dst_units_to_pixels * transformation->matrix * src_pixels_to_units;
 
 		// resample
+		// surfaces with compact pixels are read directly, when there is no SurfaceSW already
+		synfig::Surface &dst = ldst->get_surface();
 		LockReadBase lsrc(sub_task());
 		if (lsrc.convert<SurfaceSWPacked>(false)) {
 			SurfaceSWPacked::Handle src = lsrc.cast<SurfaceSWPacked>();
 			if (!src) return false;
-			software::Resample::resample(
-				ldst->get_surface(),
-				target_rect,
-				src->get_surface(),
-				sub_task()->target_rect,
-				matrix,
-				interpolation,
-				blend,
-				amount,
-				blend_method );
+			resample(dst, src->get_surface(), matrix);
+		} else
+		if (lsrc.convert<TargetSurface>(false)) {
+			TargetSurface::Handle src = lsrc.cast<TargetSurface>();
+			if (!src) return false;
+			resample(dst, src->get_surface(), matrix);
+		} else
+		if (lsrc.convert<SurfaceSWHalf>(false)) {
+			SurfaceSWHalf::Handle src = lsrc.cast<SurfaceSWHalf>();
+			if (!src) return false;
+			resample(dst, src->get_surface(), matrix);
+		} else
+		if (lsrc.convert<SurfaceSW8>(false)) {
+			SurfaceSW8::Handle src = lsrc.cast<SurfaceSW8>();
+			if (!src) return false;
+			resample(dst, src->get_surface(), matrix);
 		} else
 		if (lsrc.convert<TargetSurface>()) {
 			TargetSurface::Handle src = lsrc.cast<TargetSurface>();
 			if (!src) return false;
-			software::Resample::resample(
-				ldst->get_surface(),
-				target_rect,
-				src->get_surface(),
-				sub_task()->target_rect,
-				matrix,
-				interpolation,
-				blend,
-				amount,
-				blend_method );
+			resample(dst, src->get_surface(), matrix);
 		} else {
 			return false;
 		}
@@ -52,7 +52,7 @@ using namespace rendering;
 /* === M E T H O D S ======================================================= */
 
 synfig::Token Surface::token;
-int SurfaceResource::last_id = 0;
+std::atomic<uint64_t> SurfaceResource::last_id(0);
 
 Surface::Surface():
 	blank(true),
@@ -220,6 +220,7 @@ SurfaceResource::SurfaceResource():
 { }
 
 SurfaceResource::SurfaceResource(Surface::Handle surface):
+	id(++last_id),
 	width(),
 	height(),
 	blank(true)
@@ -290,6 +291,7 @@ SurfaceResource::get_surface(
 			{ surfaces.clear(); surfaces[token] = surface; }
 		surface->touch();
 		blank = false;
+		++version;
 	}
 	return surface;
 }
@@ -299,6 +301,7 @@ SurfaceResource::create(int width, int height)
 {
 	Glib::Threads::RWLock::WriterLock lock(rwlock);
 	std::lock_guard<std::mutex> short_lock(mutex);
+	++version;
 	if (width > 0 && height > 0) {
 		this->width  = width;
 		this->height = height;
@@ -315,6 +318,7 @@ SurfaceResource::assign(Surface::Handle surface)
 {
 	Glib::Threads::RWLock::WriterLock lock(rwlock);
 	std::lock_guard<std::mutex> short_lock(mutex);
+	++version;
 
 	for(Map::const_iterator i = surfaces.begin(); i != surfaces.end(); ++i)
 		if (i->second == surface)
@@ -338,6 +342,7 @@ SurfaceResource::clear()
 {
 	Glib::Threads::RWLock::WriterLock lock(rwlock);
 	std::lock_guard<std::mutex> short_lock(mutex);
+	++version;
 	blank = true;
 	surfaces.clear();
 }
@@ -347,6 +352,7 @@ SurfaceResource::reset()
 {
 	Glib::Threads::RWLock::WriterLock lock(rwlock);
 	std::lock_guard<std::mutex> short_lock(mutex);
+	++version;
 	width = 0;
 	height = 0;
 	blank = true;
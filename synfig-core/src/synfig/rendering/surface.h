@@ -30,6 +30,8 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -328,9 +330,10 @@ public:
 	};
 
 private:
-	static int last_id;
+	static std::atomic<uint64_t> last_id;
 
-	int id = 0;
+	uint64_t id = 0;
+	int version = 0; //!< changes on each write access
 	int width;
 	int height;
 	bool blank;
@@ -360,8 +363,10 @@ public:
 	void create(const VectorInt &x)
 		{ create(x[0], x[1]); }
 
-	int get_id() const //!< helps to debug of renderer optimizers
+	uint64_t get_id() const //!< helps to debug of renderer optimizers
 		{ return id; }
+	int get_version() const //!< id and version together identify the content of resource
+		{ std::lock_guard<std::mutex> lock(mutex); return version; }
 	int get_width() const
 		{ std::lock_guard<std::mutex> lock(mutex); return width; }
 	int get_height() const
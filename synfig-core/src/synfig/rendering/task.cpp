@@ -323,6 +323,18 @@ Task::run(RunParams & /* params */) const
 	{ return false; }
 
 
+// TaskSurface
+
+bool
+TaskSurface::add_params_to_hash(Hash &hash) const
+{
+	if (!target_surface)
+		return false;
+	hash.add(target_surface->get_id()).add(target_surface->get_version());
+	return true;
+}
+
+
 // TaskList
 
 VectorInt
@@ -386,6 +398,8 @@ TaskEvent::operator=(const TaskEvent &other)
 	*(Task*)(this) = other;
 	done = (int)other.done;
 	cancelled = (int)other.cancelled;
+	finished = done || cancelled;
+	priority = other.get_priority();
 	signal_finished = other.signal_finished;
 	return *this;
 }
@@ -406,10 +420,7 @@ TaskEvent::is_cancelled() const
 
 bool
 TaskEvent::is_finished() const
-{
-	std::lock_guard<std::mutex> lock(mutex);
-	return done || cancelled;
-}
+	{ return finished; }
 
 void
 TaskEvent::finish(bool success)
@@ -418,6 +429,7 @@ TaskEvent::finish(bool success)
 		std::lock_guard<std::mutex> lock(mutex);
 		if (done || cancelled) return;
 		(success ? done : cancelled) = true;
+		finished = true;
 	}
 	signal_finished(success);
 	cond.notify_one();
@@ -40,6 +40,7 @@
 #include <synfig/vector.h>
 #include <synfig/synfig_export.h>
 
+#include "hash.h"
 #include "surface.h"
 
 /* === M A C R O S ========================================================= */
@@ -54,6 +55,7 @@ namespace rendering
 {
 
 class Renderer;
+class TaskEvent;
 
 
 // Helpers
@@ -295,7 +297,38 @@ public:
 		RunParams params;
 		bool success;
 
-		RendererData(): batch_index(), index(), success() { }
+		//! Count of deps which are not done yet, maintained by RenderQueue
+		std::atomic<int> deps_count;
+		//! Finish event of the batch, task is dispatched with its priority.
+		//! Event is kept alive by back deps while task is in the queue.
+		const TaskEvent *priority_event;
+
+		RendererData(): batch_index(), index(), success(), deps_count(), priority_event() { }
+		RendererData(const RendererData &other):
+			batch_index(other.batch_index),
+			index(other.index),
+			deps(other.deps),
+			back_deps(other.back_deps),
+			tmp_deps(other.tmp_deps),
+			tmp_back_deps(other.tmp_back_deps),
+			params(other.params),
+			success(other.success),
+			deps_count(other.deps_count.load()),
+			priority_event(other.priority_event) { }
+
+		RendererData& operator=(const RendererData &other) {
+			batch_index = other.batch_index;
+			index = other.index;
+			deps = other.deps;
+			back_deps = other.back_deps;
+			tmp_deps = other.tmp_deps;
+			tmp_back_deps = other.tmp_back_deps;
+			params = other.params;
+			success = other.success;
+			deps_count = other.deps_count.load();
+			priority_event = other.priority_event;
+			return *this;
+		}
 	};
 
 	class LockReadBase: public SurfaceResource::LockReadBase
@@ -472,6 +505,12 @@ public:
 	void set_coords_zero();
 	virtual void set_coords_sub_tasks();
 	virtual bool run(RunParams &params) const;
+
+	/// Adds own parameters of the task to the hash, coordinates and sub-tasks are not included.
+	/// Result of the task should be fully defined by them (see OptimizerCache).
+	/// \return false when the task can not be identified by hash (default)
+	virtual bool add_params_to_hash(Hash & /* hash */) const
+		{ return false; }
 };
 
 
@@ -492,6 +531,12 @@ class TaskInterfaceSplit
 public:
 	virtual bool is_splittable() const
 		{ return true; }
+	//! estimated time to process one pixel, relative to the simple blending
+	virtual Real get_split_pixel_cost() const
+		{ return 1.0; }
+	//! estimated time which every part spends regardless of its size (in pixels of unit cost)
+	virtual Real get_split_overhead() const
+		{ return 0.0; }
 	virtual ~TaskInterfaceSplit() { }
 };
 
@@ -529,6 +574,9 @@ public:
 	typedef etl::handle<TaskSurface> Handle;
 	SYNFIG_EXPORT static Token token;
 	virtual Token::Handle get_token() const { return token.handle(); }
+
+	//! surface is identified by the id and the version of resource
+	virtual bool add_params_to_hash(Hash &hash) const;
 };
 
 
@@ -589,11 +637,14 @@ private:
 	mutable std::mutex mutex;
 	std::condition_variable cond;
 	bool done, cancelled;
+	//! done || cancelled, checked by RenderQueue without locking
+	std::atomic<bool> finished;
+	std::atomic<int> priority;
 
 public:
 	sigc::signal<void, bool> signal_finished;
 
-	TaskEvent(): done(), cancelled() { }
+	TaskEvent(): done(), cancelled(), finished(), priority() { }
 
 	TaskEvent& operator=(const TaskEvent &other);
 
@@ -601,6 +652,11 @@ public:
 	bool is_cancelled() const;
 	bool is_finished() const;
 
+	//! Tasks of the batch with greater priority are started first.
+	//! Use Renderer::set_priority() for already enqueued events.
+	int get_priority() const { return priority; }
+	void set_priority(int priority) { this->priority = priority; }
+
 	virtual void finish(bool success);
 	virtual void wait();
 
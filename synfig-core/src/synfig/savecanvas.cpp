@@ -53,6 +53,7 @@
 #include "valuenodes/valuenode_bone.h"
 #include "valuenodes/valuenode_wplist.h"
 #include "valuenodes/valuenode_dilist.h"
+#include "canvasbinary.h"
 #include "dashitem.h"
 #include "time.h"
 #include "keyframe.h"
@@ -1099,7 +1100,16 @@ synfig::save_canvas(const FileSystem::Identifier &identifier, Canvas::ConstHandl
 		if (filename_extension(identifier.filename) == ".sifz")
 			stream = FileSystem::WriteStream::Handle(new ZWriteStream(stream));
 
-		document.write_to_stream_formatted(*stream, "UTF-8");
+		if (filename_extension(identifier.filename) == ".sifb")
+		{
+			if (!CanvasBinary::write(document, *stream))
+			{
+				synfig::error("synfig::save_canvas(): Unable to write binary file");
+				return false;
+			}
+		}
+		else
+			document.write_to_stream_formatted(*stream, "UTF-8");
 
 		// close stream
 		stream.reset();
@@ -32,9 +32,11 @@
 
 #include <algorithm>
 #include <cstring>
+#include <type_traits>
 
 #include <synfig/misc.h>
 #include <synfig/pen.h>
+#include <synfig/surfacepool.h>
 
 /* === M A C R O S ========================================================= */
 
@@ -206,7 +208,8 @@ public:
 
 private:
 	/** a contiguous memory space.
-	 *  If it is deletable, it is expected to be allocated by `new value_type[]` allocator
+	 *  If it is deletable, it is expected to be allocated by `new value_type[]` allocator,
+	 *  or by SurfacePool if it is pooled
 	 */
 	value_type *data_;
 	/** the byte length of a row, possibly including some padding for byte-alignment.
@@ -219,50 +222,82 @@ private:
 	int h_;
 	/** if the data is dynamically allocated and can be deleted (on destructor too) */
 	bool deletable_;
+	/** if the data is allocated by SurfacePool (all the data allocated by surface itself) */
+	bool pooled_;
 
 	value_prep_type cooker_;
 
+	void allocate_data(size_t size)
+	{
+		data_=(pointer)SurfacePool::instance().allocate(size);
+		deletable_=true;
+		pooled_=true;
+	}
+
+	void free_data()
+	{
+		if(!deletable_)
+			return;
+		if(pooled_)
+			SurfacePool::instance().deallocate(data_);
+		else
+			delete [] data_;
+		data_=nullptr;
+		deletable_=false;
+		pooled_=false;
+	}
+
+	/** pooled buffer is not initialized, zero it like `new value_type[]` did for the types with constructors */
+	void init_data()
+		{ if (!std::is_trivial<value_type>::value) clear(); }
+
 public:
 	surface():
 		data_(nullptr),
 		pitch_(0),
 		w_(0),h_(0),
-		deletable_(false) { }
+		deletable_(false),
+		pooled_(false) { }
 
 	surface(value_type* data, int w, int h, bool deletable=false):
 		data_(data),
 		pitch_(sizeof(value_type)*w),
 		w_(w),h_(h),
-		deletable_(deletable) { }
+		deletable_(deletable),
+		pooled_(false) { }
 
 	surface(value_type* data, int w, int h, typename difference_type::value_type pitch, bool deletable=false):
 		data_(data),
 		pitch_(pitch),
 		w_(w),h_(h),
-		deletable_(deletable) { }
+		deletable_(deletable),
+		pooled_(false) { }
 	
 	surface(const typename size_type::value_type &w, const typename size_type::value_type &h):
-		data_(new value_type[w*h]),
 		pitch_(sizeof(value_type)*w),
-		w_(w),h_(h),
-		deletable_(true) { }
+		w_(w),h_(h)
+	{
+		allocate_data(pitch_*h_);
+		init_data();
+	}
 
 	surface(const size_type &s):
-		data_(new value_type[s.x*s.y]),
 		pitch_(sizeof(value_type)*s.x),
-		w_(s.x),h_(s.y),
-		deletable_(true) { }
+		w_(s.x),h_(s.y)
+	{
+		allocate_data(pitch_*h_);
+		init_data();
+	}
 
 	template <typename _pen>
 	surface(const _pen &_begin, const _pen &_end)
 	{
 		typename _pen::difference_type size=_end-_begin;
 
-		data_=new value_type[size.x*size.y];
 		w_=size.x;
 		h_=size.y;
 		pitch_=sizeof(value_type)*w_;
-		deletable_=true;
+		allocate_data(pitch_*h_);
 
 		for(int y = 0; y < h_; y++)
 			for(int x = 0; x < w_; x++)
@@ -270,26 +305,24 @@ public:
 	}
 
 	surface(const surface &s):
-		data_(s.data_?(pointer)(new char[s.pitch_*s.h_]):0),
+		data_(nullptr),
 		pitch_(s.pitch_),
 		w_(s.w_),
 		h_(s.h_),
-		deletable_(s.data_?true:false)
+		deletable_(false),
+		pooled_(false)
 	{
 		assert(&s);
 		if(s.data_)
 		{
-			assert(data_);
+			allocate_data(pitch_*h_);
 			memcpy(data_, s.data_, pitch_ * h_);
 		}
 	}
 
 public:
 	~surface()
-	{
-		if(deletable_)
-			delete [] data_;
-	}
+		{ free_data(); }
 
 	size_type
 	size()const
@@ -301,9 +334,7 @@ public:
 
 	const surface &operator=(const surface &rhs)
 	{
-		set_wh(rhs.w_,rhs.h_);
-		pitch_=rhs.pitch_;
-		deletable_=true;
+		set_wh(rhs.w_,rhs.h_,rhs.pitch_);
 
 		memcpy(data_,rhs.data_,pitch_*h_);
 
@@ -324,10 +355,9 @@ public:
 	{
 		if(data_)
 		{
-			if(w==w_ && h==h_ && deletable_)
+			if(w==w_ && h==h_ && (!pitch || pitch==pitch_) && deletable_)
 				return;
-			if(deletable_)
-				delete [] data_;
+			free_data();
 		}
 
 		w_=w;
@@ -336,8 +366,7 @@ public:
 			pitch_=pitch;
 		else
 			pitch_=sizeof(value_type)*w_;
-		data_=(pointer)(new char[pitch_*h_]);
-		deletable_=true;
+		allocate_data(pitch_*h_);
 	}
 
 
@@ -0,0 +1,259 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file surfacepool.cpp
+**	\brief SurfacePool File
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "surfacepool.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#define DEF_MAX_CACHED_MB 256
+
+/* === G L O B A L S ======================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+const size_t SurfacePool::alignment;
+const size_t SurfacePool::huge_page_size;
+
+SurfacePool::SurfacePool():
+	max_cached((size_t)DEF_MAX_CACHED_MB*1024*1024),
+	huge_pages(false)
+{
+	if (const char *s = getenv("SYNFIG_SURFACE_POOL_MAX_MEMORY_MB"))
+		max_cached = (size_t)std::max(0, atoi(s))*1024*1024;
+	if (const char *s = getenv("SYNFIG_SURFACE_POOL_HUGE_PAGES"))
+		huge_pages = atoi(s) != 0;
+}
+
+size_t
+SurfacePool::get_class_size(size_t size)
+{
+	if (size <= alignment)
+		return alignment;
+	// four classes between the powers of two
+	size_t power = alignment;
+	while(power*2 < size) power *= 2;
+	size_t step = std::max(alignment, power/4);
+	return (size + step - 1)/step*step;
+}
+
+void*
+SurfacePool::allocate_block(size_t class_size, bool huge)
+{
+	// block starts from the header with the size of class,
+	// buffer follows it at the next aligned address
+	size_t block_alignment = huge ? huge_page_size : alignment;
+	size_t block_size = class_size + alignment;
+
+	void *block = nullptr;
+#ifdef _WIN32
+	block = _aligned_malloc(block_size, block_alignment);
+#else
+	if (posix_memalign(&block, block_alignment, block_size))
+		block = nullptr;
+#endif
+	if (!block)
+		throw std::bad_alloc();
+
+#if defined(MADV_HUGEPAGE)
+	if (huge)
+		madvise(block, block_size, MADV_HUGEPAGE);
+#endif
+
+	*(size_t*)block = class_size;
+	return (char*)block + alignment;
+}
+
+void
+SurfacePool::free_block(void *buffer)
+{
+	void *block = (char*)buffer - alignment;
+#ifdef _WIN32
+	_aligned_free(block);
+#else
+	free(block);
+#endif
+}
+
+void*
+SurfacePool::allocate(size_t size)
+{
+	size_t class_size = get_class_size(size);
+	bool huge;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		huge = huge_pages && class_size >= huge_page_size;
+		++statistics.allocations;
+		statistics.bytes_used += class_size;
+		statistics.bytes_peak = std::max(statistics.bytes_peak, statistics.bytes_used);
+
+		FreeMap::iterator i = free_buffers.find(class_size);
+		if (i != free_buffers.end() && !i->second.empty()) {
+			void *buffer = i->second.back();
+			i->second.pop_back();
+			++statistics.reuses;
+			statistics.bytes_cached -= class_size;
+			return buffer;
+		}
+	}
+
+	try {
+		return allocate_block(class_size, huge);
+	} catch(...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		--statistics.allocations;
+		statistics.bytes_used -= class_size;
+		throw;
+	}
+}
+
+void
+SurfacePool::deallocate(void *buffer)
+{
+	if (!buffer)
+		return;
+
+	size_t class_size = *(size_t*)((char*)buffer - alignment);
+	std::vector<void*> evicted;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		assert(statistics.bytes_used >= class_size);
+		statistics.bytes_used -= class_size;
+
+		// make room by the biggest buffers of other classes,
+		// so pool follows the sizes which are used now
+		for(FreeMap::reverse_iterator i = free_buffers.rbegin();
+			i != free_buffers.rend() && statistics.bytes_cached + class_size > max_cached; ++i)
+		{
+			if (i->first == class_size) continue;
+			while(!i->second.empty() && statistics.bytes_cached + class_size > max_cached) {
+				evicted.push_back(i->second.back());
+				i->second.pop_back();
+				statistics.bytes_cached -= i->first;
+				++statistics.evictions;
+			}
+		}
+
+		if (statistics.bytes_cached + class_size <= max_cached) {
+			free_buffers[class_size].push_back(buffer);
+			statistics.bytes_cached += class_size;
+			buffer = nullptr;
+		} else {
+			++statistics.evictions;
+		}
+	}
+
+	// system calls are outside of lock
+	for(std::vector<void*>::const_iterator i = evicted.begin(); i != evicted.end(); ++i)
+		free_block(*i);
+	if (buffer)
+		free_block(buffer);
+}
+
+void
+SurfacePool::trim()
+{
+	FreeMap buffers;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		buffers.swap(free_buffers);
+		statistics.bytes_cached = 0;
+	}
+	for(FreeMap::const_iterator i = buffers.begin(); i != buffers.end(); ++i)
+		for(std::vector<void*>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+			free_block(*j);
+}
+
+void
+SurfacePool::set_max_cached(size_t size)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		max_cached = size;
+		if (statistics.bytes_cached <= max_cached)
+			return;
+	}
+	trim();
+}
+
+size_t
+SurfacePool::get_max_cached() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return max_cached;
+}
+
+void
+SurfacePool::set_huge_pages(bool enabled)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	huge_pages = enabled;
+}
+
+bool
+SurfacePool::get_huge_pages() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return huge_pages;
+}
+
+SurfacePool::Statistics
+SurfacePool::get_statistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+SurfacePool&
+SurfacePool::instance()
+{
+	static SurfacePool *pool = new SurfacePool();
+	return *pool;
+}
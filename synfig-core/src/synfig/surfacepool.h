@@ -0,0 +1,117 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file surfacepool.h
+**	\brief SurfacePool Header
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_SURFACEPOOL_H
+#define __SYNFIG_SURFACEPOOL_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+//! Keeps the pixel buffers of freed surfaces to give them to the next surfaces.
+//! Rendering creates and frees a lot of surfaces of the same sizes for every frame,
+//! so buffers are taken from the pool instead of the heap and the page faults of fresh memory.
+//! Sizes are rounded up to size classes (not more than 25% of waste),
+//! buffers are aligned by 64 bytes (cache line), big buffers may be backed by huge pages.
+//! Settings are taken from environment:
+//!   SYNFIG_SURFACE_POOL_MAX_MEMORY_MB - limit of memory kept by pool (0 disables pool)
+//!   SYNFIG_SURFACE_POOL_HUGE_PAGES - use transparent huge pages for big buffers
+class SurfacePool
+{
+public:
+	//! all sizes are in bytes
+	struct Statistics
+	{
+		size_t allocations;  //!< count of allocate() calls
+		size_t reuses;       //!< allocations served by the cached buffers
+		size_t evictions;    //!< buffers returned to system because of the memory limit
+		size_t bytes_used;   //!< memory of buffers given to surfaces now
+		size_t bytes_peak;   //!< max value of bytes_used
+		size_t bytes_cached; //!< memory of free buffers kept by pool
+
+		Statistics():
+			allocations(), reuses(), evictions(), bytes_used(), bytes_peak(), bytes_cached() { }
+	};
+
+	static const size_t alignment = 64;
+	static const size_t huge_page_size = 2*1024*1024;
+
+private:
+	typedef std::map<size_t, std::vector<void*> > FreeMap;
+
+	mutable std::mutex mutex;
+	FreeMap free_buffers;
+	size_t max_cached;
+	bool huge_pages;
+	Statistics statistics;
+
+	SurfacePool();
+	SurfacePool(const SurfacePool&) = delete;
+	SurfacePool& operator=(const SurfacePool&) = delete;
+
+	static size_t get_class_size(size_t size);
+	static void* allocate_block(size_t class_size, bool huge);
+	static void free_block(void *buffer);
+
+public:
+	//! Returns buffer of at least 'size' bytes aligned by SurfacePool::alignment,
+	//! contents of buffer are undefined. Throws std::bad_alloc on failure.
+	void* allocate(size_t size);
+	//! Takes back the buffer returned by allocate()
+	void deallocate(void *buffer);
+
+	//! Returns all cached buffers to system
+	void trim();
+
+	void set_max_cached(size_t size);
+	size_t get_max_cached() const;
+
+	void set_huge_pages(bool enabled);
+	bool get_huge_pages() const;
+
+	Statistics get_statistics() const;
+
+	//! Pool is never destroyed, because static surfaces may be freed after the end of main()
+	static SurfacePool& instance();
+};
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
@@ -68,6 +68,7 @@ using namespace rendering;
 
 const unsigned int	DEF_TILE_WIDTH = TILE_SIZE / 2;
 const unsigned int	DEF_TILE_HEIGHT = TILE_SIZE / 2;
+const size_t		DEF_MAX_TILES_MEMORY = 512*1024*1024;
 
 #ifdef _DEBUG
 //#define DEBUG_MEASURE
@@ -77,18 +78,53 @@ const unsigned int	DEF_TILE_HEIGHT = TILE_SIZE / 2;
 
 /* === P R O C E D U R E S ================================================= */
 
+static void
+apply_alpha_mode(synfig::Surface &s, TargetAlphaMode alpha_mode, const Color &bg_color)
+{
+	int cnt = s.get_w() * s.get_h();
+
+	switch(alpha_mode)
+	{
+		case TARGET_ALPHA_MODE_FILL:
+			for(int i = 0; i < cnt; ++i)
+				s[0][i] = Color::blend(s[0][i], bg_color, 1.0f);
+			break;
+		case TARGET_ALPHA_MODE_EXTRACT:
+			for(int i = 0; i< cnt; ++i)
+			{
+				float a = s[0][i].get_a();
+				s[0][i] = Color(a,a,a,a);
+			}
+			break;
+		case TARGET_ALPHA_MODE_REDUCE:
+			for(int i = 0; i < cnt; ++i)
+				s[0][i].set_a(1.0f);
+			break;
+		default:
+			break;
+	}
+}
+
 /* === M E T H O D S ======================================================= */
 
 Target_Tile::Target_Tile():
-	threads_(2),
+	threads_(0),
+	max_tiles_memory_(DEF_MAX_TILES_MEMORY),
 	tile_w_(DEF_TILE_WIDTH),
 	tile_h_(DEF_TILE_HEIGHT),
 	curr_tile_(0),
-	clipping_(true)
+	clipping_(true),
+	tiles_in_flight_(0),
+	tiles_memory_(0),
+	tiles_failed_(false)
 {
 	curr_frame_=0;
 	if (const char *s = getenv("SYNFIG_TARGET_DEFAULT_ENGINE"))
 		set_engine(s);
+	if (const char *s = getenv("SYNFIG_TARGET_TILE_THREADS"))
+		set_threads(atoi(s));
+	if (const char *s = getenv("SYNFIG_TARGET_TILE_MAX_MEMORY_MB"))
+		set_max_tiles_memory((size_t)std::max(0, atoi(s))*1024*1024);
 }
 
 int
@@ -117,59 +153,136 @@ Target_Tile::next_tile(RectInt& rect)
 	return (tw*th)-curr_tile_+1;
 }
 
-bool
-synfig::Target_Tile::call_renderer(
-	const etl::handle<rendering::SurfaceResource> &surface,
+rendering::Task::Handle
+synfig::Target_Tile::build_frame_task(
 	Canvas &canvas,
 	const ContextParams &context_params,
 	const RendDesc &renddesc )
 {
 	#ifdef DEBUG_MEASURE
-	debug::Measure t("Target_Tile::call_renderer");
+	debug::Measure t("Target_Tile::build_frame_task");
 	#endif
 
-	surface->create(renddesc.get_w(), renddesc.get_h());
-	rendering::Task::Handle task;
-	{
-		#ifdef DEBUG_MEASURE
-		debug::Measure t("build rendering task");
-		#endif
-		task = canvas.build_rendering_task(context_params);
+	rendering::Task::Handle task = canvas.build_rendering_task(context_params);
+
+	// add transformation task to flip result if needed
+	Vector p0 = renddesc.get_tl();
+	Vector p1 = renddesc.get_br();
+	if (task && (p0[0] > p1[0] || p0[1] > p1[1])) {
+		Matrix m;
+		if (p0[0] > p1[0]) { m.m00 = -1.0; m.m20 = p0[0] + p1[0]; }
+		if (p0[1] > p1[1]) { m.m11 = -1.0; m.m21 = p0[1] + p1[1]; }
+		TaskTransformationAffine::Handle t = new TaskTransformationAffine();
+		t->transformation->matrix = m;
+		t->sub_task() = task;
+		task = t;
 	}
 
-	if (task)
+	// TaskSurface assumed as valid non-trivial task by renderer
+	// and TaskTransformationAffine of TaskSurface will not be optimized.
+	// To avoid this construction place creation of dummy TaskSurface here.
+	if (!task) task = new TaskSurface();
+
+	return task;
+}
+
+int
+synfig::Target_Tile::get_max_tiles_in_flight() const
+{
+	if (threads_ > 0)
+		return threads_;
+
+	// keep all rendering threads busy, while the next tiles are optimizing
+	rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(get_engine());
+	return renderer ? 2*std::max(1, renderer->get_max_simultaneous_threads()) : 2;
+}
+
+void
+synfig::Target_Tile::on_tile_finished(bool success, PendingTile tile)
+{
+	if (!success)
 	{
-		rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(get_engine());
-		if (!renderer)
-			throw "Renderer '" + get_engine() + "' not found";
-
-		Vector p0 = renddesc.get_tl();
-		Vector p1 = renddesc.get_br();
-		if (p0[0] > p1[0] || p0[1] > p1[1]) {
-			Matrix m;
-			if (p0[0] > p1[0]) { m.m00 = -1.0; m.m20 = p0[0] + p1[0]; std::swap(p0[0], p1[0]); }
-			if (p0[1] > p1[1]) { m.m11 = -1.0; m.m21 = p0[1] + p1[1]; std::swap(p0[1], p1[1]); }
-			TaskTransformationAffine::Handle t = new TaskTransformationAffine();
-			t->transformation->matrix = m;
-			t->sub_task() = task;
-			task = t;
-		}
+		// For some reason, the accelerated renderer failed.
+		tile.error = _("Accelerated Renderer Failure");
+	}
+	else
+	if (get_alpha_mode() != TARGET_ALPHA_MODE_KEEP)
+	{
+		SurfaceResource::LockWrite<SurfaceSW> lock(tile.surface);
+		if (lock)
+			apply_alpha_mode(lock->get_surface(), get_alpha_mode(), desc.get_bg_color());
+		else
+			tile.error = _("Bad surface");
+	}
 
-		task->target_surface = surface;
-		task->target_rect = RectInt( VectorInt(), surface->get_size() );
-		task->source_rect = Rect(p0, p1);
+	std::lock_guard<std::mutex> lock(tiles_mutex_);
+	ready_tiles_.push_back(tile);
+	tiles_cond_.notify_all();
+}
 
-		rendering::Task::List list;
-		list.push_back(task);
+bool
+synfig::Target_Tile::flush_tiles(bool all, size_t memory, ProgressCallback *cb)
+{
+	std::lock_guard<std::mutex> add_tile_lock(add_tile_mutex_);
+	std::unique_lock<std::mutex> lock(tiles_mutex_);
 
+	int max_tiles_in_flight = all ? 0 : get_max_tiles_in_flight();
+	while(true)
+	{
+		while(!ready_tiles_.empty())
 		{
-			#ifdef DEBUG_MEASURE
-			debug::Measure t("run renderer");
-			#endif
-			renderer->run(list);
+			PendingTile tile = ready_tiles_.front();
+			ready_tiles_.pop_front();
+			lock.unlock();
+
+			bool success = tile.error.empty();
+			if (success)
+			{
+				SurfaceResource::LockRead<SurfaceSW> surface_lock(tile.surface);
+				if (!surface_lock)
+				{
+					tile.error = _("Bad surface");
+				}
+				else
+				// Add the tile to the target
+				if (add_tile(surface_lock->get_surface(), tile.rect.minx, tile.rect.miny))
+				{
+					signal_progress()();
+				}
+				else
+				{
+					tile.error = _("add_tile(): Unable to put surface on target");
+				}
+			}
+
+			if (!tile.error.empty())
+			{
+				// report only the first error
+				if (cb && !tiles_failed_)
+					cb->error(tile.error);
+			}
+			tile.surface.reset();
+
+			lock.lock();
+			if (!tile.error.empty())
+				tiles_failed_ = true;
+			--tiles_in_flight_;
+			tiles_memory_ -= tile.memory;
 		}
+
+		bool ready = all
+				   ? tiles_in_flight_ == 0
+				   : tiles_in_flight_ < max_tiles_in_flight
+				  && (tiles_in_flight_ == 0 || tiles_memory_ + memory <= max_tiles_memory_);
+		if (ready)
+			break;
+		tiles_cond_.wait(lock);
 	}
-	return true;
+
+	bool success = !tiles_failed_;
+	if (all)
+		tiles_failed_ = false;
+	return success;
 }
 
 bool
@@ -190,6 +303,33 @@ synfig::Target_Tile::render_frame_(Canvas::Handle canvas, ContextParams context_
 		tiles.push_back(rect);
 	}
 
+	// Build the task tree once, all tiles of the frame will use the copies of it
+	rendering::Task::Handle frame_task = build_frame_task(*canvas, context_params, rend_desc);
+
+	// Tiles are cut from the unflipped frame,
+	// flipping is already done by transformation in frame_task
+	RendDesc frame_desc = rend_desc;
+	Vector p0 = frame_desc.get_tl();
+	Vector p1 = frame_desc.get_br();
+	if (p0[0] > p1[0] || p0[1] > p1[1]) {
+		if (p0[0] > p1[0]) std::swap(p0[0], p1[0]);
+		if (p0[1] > p1[1]) std::swap(p0[1], p1[1]);
+		frame_desc.clear_flags();
+		frame_desc.set_tl_br(p0, p1);
+	}
+
+	// Tiles in flight refer to this target, so they should be finished at every exit
+	struct TilesGuard {
+		Target_Tile &target;
+		bool active;
+		explicit TilesGuard(Target_Tile &target): target(target), active(true) { }
+		~TilesGuard()
+		{
+			if (active)
+				try { target.wait_render_tiles(nullptr); } catch(...) { }
+		}
+	} tiles_guard(*this);
+
 	// Render tiles
 	for(std::vector<RectInt>::iterator i = tiles.begin(); i != tiles.end(); ++i)
 	{
@@ -210,12 +350,14 @@ synfig::Target_Tile::render_frame_(Canvas::Handle canvas, ContextParams context_
 		if (!rect.valid())
 			continue;
 
-		RendDesc tile_desc=rend_desc;
+		RendDesc tile_desc=frame_desc;
 		tile_desc.set_subwindow(rect.minx, rect.miny, rect.maxx - rect.minx, rect.maxy - rect.miny);
 
-		async_render_tile(canvas, context_params, rect, tile_desc, &super);
+		if (!async_render_tile(frame_task, rect, tile_desc, &super))
+			return false;
 	}
 
+	tiles_guard.active = false;
 	if (!wait_render_tiles(cb))
 		return false;
 
@@ -227,68 +369,53 @@ synfig::Target_Tile::render_frame_(Canvas::Handle canvas, ContextParams context_
 
 bool
 synfig::Target_Tile::async_render_tile(
-	Canvas::Handle canvas,
-	ContextParams context_params,
+	rendering::Task::Handle frame_task,
 	RectInt rect,
 	RendDesc tile_desc,
 	ProgressCallback *cb)
 {
-	SurfaceResource::Handle surface = new rendering::SurfaceResource();
+	#ifdef DEBUG_MEASURE
+	debug::Measure t("Target_Tile::async_render_tile");
+	#endif
 
-	if (!call_renderer(surface, *canvas, context_params, tile_desc))
-	{
-		// For some reason, the accelerated renderer failed.
-		if(cb)cb->error(_("Accelerated Renderer Failure"));
-		return false;
-	}
+	rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(get_engine());
+	if (!renderer)
+		throw "Renderer '" + get_engine() + "' not found";
 
-	SurfaceResource::LockWrite<SurfaceSW> lock(surface);
+	PendingTile tile;
+	tile.rect = rect;
+	tile.memory = (size_t)tile_desc.get_w()*(size_t)tile_desc.get_h()*sizeof(Color);
 
-	if(!lock)
-	{
-		if(cb)cb->error(_("Bad surface"));
+	// wait for the free slot, and put already rendered tiles on the target meanwhile
+	if (!flush_tiles(false, tile.memory, cb))
 		return false;
-	}
 
-	synfig::Surface &s = lock->get_surface();
-	int cnt = s.get_w() * s.get_h();
+	tile.surface = new SurfaceResource();
+	tile.surface->create(tile_desc.get_w(), tile_desc.get_h());
 
-	switch(get_alpha_mode())
-	{
-		case TARGET_ALPHA_MODE_FILL:
-			for(int i = 0; i < cnt; ++i)
-				s[0][i] = Color::blend(s[0][i], desc.get_bg_color(), 1.0f);
-			break;
-		case TARGET_ALPHA_MODE_EXTRACT:
-			for(int i = 0; i< cnt; ++i)
-			{
-				float a = s[0][i].get_a();
-				s[0][i] = Color(a,a,a,a);
-			}
-			break;
-		case TARGET_ALPHA_MODE_REDUCE:
-			for(int i = 0; i < cnt; ++i)
-				s[0][i].set_a(1.0f);
-			break;
-		default:
-			break;
-	}
+	// tile task shares nothing with other tiles, so it may be optimized independently
+	rendering::Task::Handle task = frame_task->clone_recursive();
+	task->target_surface = tile.surface;
+	task->target_rect = RectInt( VectorInt(), tile.surface->get_size() );
+	task->source_rect = Rect(tile_desc.get_tl(), tile_desc.get_br());
 
-	// Add the tile to the target
-	if (!add_tile(s, rect.minx, rect.miny))
 	{
-		if(cb)cb->error(_("add_tile(): Unable to put surface on target"));
-		return false;
+		std::lock_guard<std::mutex> lock(tiles_mutex_);
+		++tiles_in_flight_;
+		tiles_memory_ += tile.memory;
 	}
 
-	signal_progress()();
+	TaskEvent::Handle event = new TaskEvent();
+	event->signal_finished.connect( sigc::bind(
+		sigc::mem_fun(*this, &Target_Tile::on_tile_finished), tile ));
+	renderer->enqueue(task, event);
 	return true;
 }
 
 bool
-synfig::Target_Tile::wait_render_tiles(ProgressCallback* /* cb */)
+synfig::Target_Tile::wait_render_tiles(ProgressCallback *cb)
 {
-	return true;
+	return flush_tiles(true, 0, cb);
 }
 
 
@@ -32,6 +32,10 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
 #include "target.h"
 
 /* === M A C R O S ========================================================= */
@@ -52,8 +56,11 @@ namespace rendering { class SurfaceResource; }
 */
 class Target_Tile : public Target
 {
-	//! Number of threads
+	//! Max number of tiles rendered simultaneously,
+	//! zero means to choose it by number of rendering threads
 	int threads_;
+	//! Max size in bytes of surfaces of the tiles rendered simultaneously
+	size_t max_tiles_memory_;
 	//! Tile width in pixels
 	int tile_w_;
 	//! Tile height in pixles
@@ -66,14 +73,43 @@ class Target_Tile : public Target
 
 	String engine_;
 
-	struct TileGroup;
-
-	bool call_renderer(
-		const etl::handle<rendering::SurfaceResource> &surface,
+	//! Tile enqueued to the renderer but not yet passed to add_tile()
+	struct PendingTile
+	{
+		RectInt rect;
+		size_t memory;
+		etl::handle<rendering::SurfaceResource> surface;
+		String error;
+		PendingTile(): memory() { }
+	};
+
+	//! Rendered tiles in order of completion
+	std::deque<PendingTile> ready_tiles_;
+	int tiles_in_flight_;
+	size_t tiles_memory_;
+	bool tiles_failed_;
+	std::mutex tiles_mutex_;
+	std::condition_variable tiles_cond_;
+	//! add_tile() calls are serialized by this mutex
+	std::mutex add_tile_mutex_;
+
+	//! Builds the task tree of the whole frame, it is shared by all tiles of the frame
+	rendering::Task::Handle build_frame_task(
 		Canvas &canvas,
 		const ContextParams &context_params,
 		const RendDesc &renddesc );
 
+	int get_max_tiles_in_flight() const;
+
+	//! Applies alpha mode to the rendered tile,
+	//! called from the rendering thread which finished the tile
+	void on_tile_finished(bool success, PendingTile tile);
+
+	//! Passes the rendered tiles to add_tile() in order of completion.
+	//! If \a all is true then waits for all enqueued tiles,
+	//! otherwise waits until new tile with size \a memory may be enqueued.
+	bool flush_tiles(bool all, size_t memory, ProgressCallback *cb);
+
 public:
 	typedef etl::handle<Target_Tile> Handle;
 	typedef etl::loose_handle<Target_Tile> LooseHandle;
@@ -84,9 +120,11 @@ public:
 	//! Renders the canvas to the target
 	virtual bool render(ProgressCallback* cb = nullptr);
 
+	//! Enqueues rendering of the tile, frame_task is the task tree built for the whole frame.
+	//! Blocks while the limits of simultaneously rendered tiles are reached.
+	//! The finished tiles are passed to add_tile() in order of completion
 	virtual bool async_render_tile(
-		Canvas::Handle canvas,
-		ContextParams context_params,
+		rendering::Task::Handle frame_task,
 		RectInt rect,
 		RendDesc tile_desc,
 		ProgressCallback *cb);
@@ -117,10 +155,14 @@ public:
 	//! Marks the end of a frame
 	/*! \see start_frame() */
 	virtual void end_frame()=0;
-	//!Sets the number of threads
+	//!Sets the max number of tiles rendered simultaneously
 	void set_threads(int x) { threads_=x; }
-	//!Gets the number of threads
+	//!Gets the max number of tiles rendered simultaneously
 	int get_threads()const { return threads_; }
+	//!Sets the memory limit (in bytes) for the tiles rendered simultaneously
+	void set_max_tiles_memory(size_t x) { max_tiles_memory_=x; }
+	//!Gets the memory limit (in bytes) for the tiles rendered simultaneously
+	size_t get_max_tiles_memory()const { return max_tiles_memory_; }
 	//!Sets the tile width
 	void set_tile_w(int w) { tile_w_=w; }
 	//!Gets the tile width
@@ -42,6 +42,9 @@
 #include "canvas.h"
 #include "layer.h"
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
 
 #endif
 
@@ -55,6 +58,25 @@ using namespace synfig;
 
 static int value_node_count(0);
 
+// nodes are exported (id is changed from empty) before they are added into ValueNodeList,
+// so only changes of non-empty ids can make the index of ValueNodeList outdated
+static std::atomic<int> renames_count(0);
+
+static bool cache_enabled_by_env()
+{
+	const char *s = getenv("SYNFIG_VALUENODE_CACHE");
+	return s && atoi(s) != 0;
+}
+
+static std::atomic<bool> cache_enabled(cache_enabled_by_env());
+static std::atomic<unsigned long long> cache_last_frame(0);
+static std::atomic<long long> cache_hits(0);
+static std::atomic<long long> cache_misses(0);
+
+// frame of the outermost ValueNode::Cache::Scope of the thread, zero if cache is not active
+static thread_local int cache_scope_depth(0);
+static thread_local unsigned long long cache_frame(0);
+
 /* === P R O C E D U R E S ================================================= */
 
 ValueNode::LooseHandle
@@ -65,13 +87,55 @@ synfig::find_value_node(const GUID& guid)
 
 /* === M E T H O D S ======================================================= */
 
+struct ValueNode::CacheEntry
+{
+	std::mutex mutex;
+	unsigned long long frame;
+	Time time;
+	ValueBase value;
+
+	CacheEntry(): frame(0) { }
+};
+
+ValueNode::Cache::Scope::Scope()
+{
+	if (!cache_scope_depth++ && cache_enabled)
+		cache_frame = ++cache_last_frame;
+}
+
+ValueNode::Cache::Scope::~Scope()
+{
+	if (!--cache_scope_depth)
+		cache_frame = 0;
+}
+
+void
+ValueNode::Cache::set_enabled(bool x)
+	{ cache_enabled = x; }
+
+bool
+ValueNode::Cache::is_enabled()
+	{ return cache_enabled; }
+
+long long
+ValueNode::Cache::get_hits()
+	{ return cache_hits; }
+
+long long
+ValueNode::Cache::get_misses()
+	{ return cache_misses; }
+
+void
+ValueNode::Cache::reset_counters()
+	{ cache_hits = 0; cache_misses = 0; }
+
 void
 ValueNode::breakpoint()
 {
 	return;
 }
 
-ValueNode::ValueNode(Type &type):type(&type)
+ValueNode::ValueNode(Type &type):type(&type), cache_entry_(nullptr)
 {
 	value_node_count++;
 }
@@ -134,6 +198,8 @@ ValueNode::~ValueNode()
 	value_node_count--;
 
 	begin_delete();
+
+	delete cache_entry_.load();
 }
 
 void
@@ -142,6 +208,12 @@ ValueNode::on_changed()
 	DEBUG_LOG("SYNFIG_DEBUG_ON_CHANGED",
 		"%s:%d ValueNode::on_changed()\n", __FILE__, __LINE__);
 
+	if (CacheEntry *entry = cache_entry_.load()) {
+		std::lock_guard<std::mutex> lock(entry->mutex);
+		entry->frame = 0;
+		entry->value = ValueBase();
+	}
+
 	Canvas::LooseHandle parent_canvas = get_parent_canvas();
 	if(parent_canvas)
 		do						// signal to all the ancestor canvases
@@ -153,6 +225,42 @@ ValueNode::on_changed()
 	Node::on_changed();
 }
 
+ValueBase
+ValueNode::get_value_cached(Time t)const
+{
+	const unsigned long long frame = cache_frame;
+	if (!frame)
+		return (*this)(t);
+
+	CacheEntry *entry = cache_entry_.load();
+	if (!entry) {
+		// several threads may create entry at once, only one of them is kept
+		CacheEntry *new_entry = new CacheEntry();
+		if (cache_entry_.compare_exchange_strong(entry, new_entry))
+			entry = new_entry;
+		else
+			delete new_entry;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(entry->mutex);
+		// times are compared exactly, without Time::epsilon()
+		if (entry->frame == frame && Time::value_type(entry->time) == Time::value_type(t)) {
+			++cache_hits;
+			return entry->value;
+		}
+	}
+
+	++cache_misses;
+	ValueBase value = (*this)(t);
+
+	std::lock_guard<std::mutex> lock(entry->mutex);
+	entry->frame = frame;
+	entry->time = t;
+	entry->value = value;
+	return value;
+}
+
 int
 ValueNode::replace(ValueNode::Handle x)
 {
@@ -176,11 +284,19 @@ ValueNode::set_id(const String &x)
 {
 	if(name!=x)
 	{
+		if(!name.empty())
+			++renames_count;
 		name=x;
 		signal_id_changed_();
 	}
 }
 
+int
+ValueNode::get_renames_count()
+{
+	return renames_count;
+}
+
 String
 ValueNode::get_description(bool show_exported_name)const
 {
@@ -354,37 +470,95 @@ ValueNode::get_values_vfunc(std::map<Time, ValueBase> &x) const
 
 
 ValueNodeList::ValueNodeList():
-	placeholder_count_(0)
+	placeholder_count_(0),
+	index_size_(0),
+	index_renames_count_(0),
+	index_valid_(false)
 {
 }
 
-bool
-ValueNodeList::count(const String &id)const
+ValueNodeList::ValueNodeList(const ValueNodeList &other):
+	std::list<ValueNode::RHandle>(other),
+	placeholder_count_(other.placeholder_count_),
+	index_size_(0),
+	index_renames_count_(0),
+	index_valid_(false)
 {
-	const_iterator iter;
+}
 
-	if(id.empty())
-		return false;
+ValueNodeList&
+ValueNodeList::operator=(const ValueNodeList &other)
+{
+	std::list<ValueNode::RHandle>::operator=(other);
+	placeholder_count_ = other.placeholder_count_;
+	std::lock_guard<std::mutex> lock(index_mutex_);
+	index_.clear();
+	index_valid_ = false;
+	return *this;
+}
 
-	for(iter=begin();iter!=end() && id!=(*iter)->get_id();++iter)
-		;
+ValueNodeList::const_iterator
+ValueNodeList::find_iter(const String &id)const
+{
+	std::lock_guard<std::mutex> lock(index_mutex_);
+	while(true)
+	{
+		// list is public, so it may be changed without index,
+		// also ids of the nodes may be changed by ValueNode::set_id()
+		if ( !index_valid_
+		  || index_size_ != size()
+		  || index_renames_count_ != ValueNode::get_renames_count() )
+		{
+			index_.clear();
+			index_renames_count_ = ValueNode::get_renames_count();
+			for(const_iterator iter = begin(); iter != end(); ++iter)
+				if (*iter && !(*iter)->get_id().empty())
+					index_.insert(Index::value_type((*iter)->get_id(), iter)); // keep the first one like linear search did
+			index_size_ = size();
+			index_valid_ = true;
+		}
 
-	if(iter==end())
+		Index::const_iterator i = index_.find(id);
+		if (i == index_.end())
+			return end();
+		// node may be replaced by other node with the different id (see ValueNode::replace())
+		if (*i->second && (*i->second)->get_id() == id)
+			return i->second;
+		index_valid_ = false;
+	}
+}
+
+void
+ValueNodeList::index_add(const_iterator iter)
+{
+	std::lock_guard<std::mutex> lock(index_mutex_);
+	if (index_valid_ && index_size_ + 1 == size())
+	{
+		index_.insert(Index::value_type((*iter)->get_id(), iter));
+		index_size_ = size();
+	}
+	else
+	{
+		index_valid_ = false;
+	}
+}
+
+bool
+ValueNodeList::count(const String &id)const
+{
+	if(id.empty())
 		return false;
 
-	return true;
+	return find_iter(id) != end();
 }
 
 ValueNode::Handle
 ValueNodeList::find(const String &id, bool might_fail)
 {
-	iterator iter;
-
 	if(id.empty())
 		throw Exception::IDNotFound("Empty ID");
 
-	for(iter=begin();iter!=end() && id!=(*iter)->get_id();++iter)
-		;
+	const_iterator iter = find_iter(id);
 
 	if(iter==end())
 	{
@@ -398,13 +572,10 @@ ValueNodeList::find(const String &id, bool might_fail)
 ValueNode::ConstHandle
 ValueNodeList::find(const String &id, bool might_fail)const
 {
-	const_iterator iter;
-
 	if(id.empty())
 		throw Exception::IDNotFound("Empty ID");
 
-	for(iter=begin();iter!=end() && id!=(*iter)->get_id();++iter)
-		;
+	const_iterator iter = find_iter(id);
 
 	if(iter==end())
 	{
@@ -432,6 +603,7 @@ ValueNodeList::surefind(const String &id)
 		value_node=PlaceholderValueNode::create();
 		value_node->set_id(id);
 		push_back(value_node);
+		index_add(--end());
 		placeholder_count_++;
 	}
 
@@ -443,17 +615,30 @@ ValueNodeList::erase(ValueNode::Handle value_node)
 {
 	assert(value_node);
 
-	iterator iter;
+	const_iterator iter = end();
+	if(!value_node->get_id().empty())
+		iter = find_iter(value_node->get_id());
+	if(iter==end() || iter->get()!=value_node.get())
+		for(iter=begin();iter!=end() && iter->get()!=value_node.get();++iter)
+			;
 
-	for(iter=begin();iter!=end();++iter)
-		if(value_node.get()==iter->get())
-		{
-			std::list<ValueNode::RHandle>::erase(iter);
-			if(PlaceholderValueNode::Handle::cast_dynamic(value_node))
-				placeholder_count_--;
-			return true;
-		}
-	return false;
+	if(iter==end())
+		return false;
+
+	std::lock_guard<std::mutex> lock(index_mutex_);
+	if(index_valid_)
+	{
+		Index::iterator i = index_.find(value_node->get_id());
+		if(i != index_.end() && i->second == iter)
+			index_.erase(i);
+		else
+			index_valid_ = false;
+	}
+	std::list<ValueNode::RHandle>::erase(iter);
+	index_size_ = size();
+	if(PlaceholderValueNode::Handle::cast_dynamic(value_node))
+		placeholder_count_--;
+	return true;
 }
 
 bool
@@ -479,6 +664,7 @@ ValueNodeList::add(ValueNode::Handle value_node)
 	catch(Exception::IDNotFound&)
 	{
 		push_back(value_node);
+		index_add(--end());
 		return true;
 	}
 
@@ -493,6 +679,9 @@ ValueNodeList::audit()
 	for(next=begin(),iter=next++;iter!=end();iter=next++)
 		if(iter->count()==1)
 			std::list<ValueNode::RHandle>::erase(iter);
+
+	std::lock_guard<std::mutex> lock(index_mutex_);
+	index_valid_ = false;
 }
 
 
@@ -45,9 +45,12 @@
 
 #include <sigc++/signal.h>
 
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <set>
 #include <memory>
+#include <unordered_map>
 
 /* === M A C R O S ========================================================= */
 
@@ -113,6 +116,33 @@ public:
 
 	typedef etl::rhandle<ValueNode> RHandle;
 
+	//! Per-frame memoization of the values of ValueNodes
+	/*!	Disabled by default, see set_enabled() or SYNFIG_VALUENODE_CACHE environment variable.
+	**	When enabled, every value requested by get_value_cached() inside of a Scope
+	**	is calculated at most once per node and time. Cached values never outlive
+	**	the outermost Scope of the thread, and ValueNode::on_changed() drops them.
+	*/
+	class Cache
+	{
+	public:
+		//! Opens a frame for the current thread, nested scopes share the outermost frame
+		class Scope
+		{
+		public:
+			Scope();
+			~Scope();
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+		};
+
+		static void set_enabled(bool x);
+		static bool is_enabled();
+
+		static long long get_hits();
+		static long long get_misses();
+		static void reset_counters();
+	};
+
 	static void breakpoint();
 
 	/*
@@ -131,6 +161,11 @@ private:
 	//! The root canvas this Value Node belongs to
 	etl::loose_handle<Canvas> root_canvas_;
 
+	struct CacheEntry;
+	//! Value cached by get_value_cached(), created by the first cached request,
+	//! so nodes do not pay for the cache while it is disabled
+	mutable std::atomic<CacheEntry*> cache_entry_;
+
 	/*
  -- ** -- S I G N A L S -------------------------------------------------------
 	*/
@@ -201,6 +236,10 @@ public:
 	virtual ValueBase operator()(Time /*t*/)const
 		{ return ValueBase(); }
 
+	//! Returns the value of the ValueNode at time \a t,
+	//! memoized while ValueNode::Cache::Scope is open
+	ValueBase get_value_cached(Time t)const;
+
 	//! \internal Sets the id of the ValueNode
 	void set_id(const String &x);
 
@@ -209,6 +248,10 @@ public:
 	**	specific instance of a ValueNode. */
 	const String &get_id()const { return name; }
 
+	//! Returns count of changes of non-empty ids of all ValueNodes,
+	//! lets ValueNodeList know when ids of nodes in list were changed
+	static int get_renames_count();
+
 	//! Returns the name of the ValueNode type
 	virtual String get_name()const=0;
 
@@ -478,9 +521,25 @@ protected:
 */
 class ValueNodeList : public std::list<ValueNode::RHandle>
 {
+	typedef std::unordered_map<String, const_iterator> Index;
+
 	int placeholder_count_;
+
+	//! Position of node in list by id, it is rebuilt when list or ids was changed outside
+	//! (lookups are const, so the index is guarded by index_mutex_ for concurrent readers)
+	mutable std::mutex index_mutex_;
+	mutable Index index_;
+	mutable size_t index_size_;
+	mutable int index_renames_count_;
+	mutable bool index_valid_;
+
+	const_iterator find_iter(const String &id)const;
+	void index_add(const_iterator iter);
+
 public:
 	ValueNodeList();
+	ValueNodeList(const ValueNodeList &other);
+	ValueNodeList& operator=(const ValueNodeList &other);
 
 	//! Finds the ValueNode in the list with the given \a name
 	/*!	\return If found, returns a handle to the ValueNode.
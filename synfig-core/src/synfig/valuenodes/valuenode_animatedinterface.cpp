@@ -36,6 +36,7 @@
 #include <cmath>
 
 #include <algorithm>
+#include <atomic>
 #include <typeinfo>
 #include <vector>
 #include <list>
@@ -232,10 +233,15 @@ clamped_tangent<Gradient>(Gradient p1, Gradient p2, Gradient p3, Time t1, Time t
 
 class ValueNode_AnimatedInterfaceConst::Interpolator
 {
+private:
+	// Index found by the last call of upper_bound(),
+	// it is only a hint, so relaxed access from the render threads is enough
+	mutable std::atomic<size_t> last_index;
+
 public:
 	ValueNode_AnimatedInterfaceConst &animated;
 
-	explicit Interpolator(ValueNode_AnimatedInterfaceConst &animated): animated(animated) { }
+	explicit Interpolator(ValueNode_AnimatedInterfaceConst &animated): last_index(0), animated(animated) { }
 	virtual ~Interpolator() { }
 
 	virtual Interpolator* create(ValueNode_AnimatedInterfaceConst &node) const = 0;
@@ -244,6 +250,31 @@ public:
 	virtual void on_changed() = 0;
 	virtual ValueBase operator()(Time t) const = 0;
 
+	//! Returns index of the first element of the sorted \a list with t < key(element),
+	//! same as std::upper_bound. The element found by the previous call and the next one
+	//! are checked first, so sequential evaluation of frames takes O(1) instead of O(log n).
+	template<typename List, typename Key>
+	size_t upper_bound(const List &list, const Time &t, Key key) const
+	{
+		const size_t count = list.size();
+		const size_t hint = last_index.load(std::memory_order_relaxed);
+		for(size_t i = hint; i < count && i <= hint + 1; ++i)
+		{
+			if (t < key(list[i]) && (i == 0 || !(t < key(list[i - 1]))))
+			{
+				if (i != hint)
+					last_index.store(i, std::memory_order_relaxed);
+				return i;
+			}
+		}
+
+		typedef typename List::value_type value_type;
+		const size_t index = std::upper_bound(list.begin(), list.end(), t,
+			[&key](const Time &t, const value_type &x) { return t < key(x); } ) - list.begin();
+		last_index.store(index, std::memory_order_relaxed);
+		return index;
+	}
+
 	virtual void get_values_vfunc(std::map<Time, ValueBase> &x) const
 	{
 		// TODO: special case for discrete interpolation mode
@@ -658,15 +689,12 @@ public:
 			if(t>=s)
 				return animated.waypoint_list_.back().get_value(t);
 
-			typename curve_list_type::const_iterator iter;
-
-			// This next line will set iter to the
-			// correct iterator for the given time.
-			for(iter=curve_list.begin();iter<curve_list.end() && t>=iter->first.get_s();++iter)
-				continue;
-			if(iter==curve_list.end())
+			// First segment which ends after the given time
+			size_t index = upper_bound(curve_list, t,
+				[](const PathSegment &x) { return x.first.get_s(); } );
+			if(index >= curve_list.size())
 				return animated.waypoint_list_.back().get_value(t);
-			return iter->resolve(t);
+			return curve_list[index].resolve(t);
 		}
 	}; // END of class Hermite
 
@@ -749,15 +777,11 @@ public:
 			if(t>=s)
 				return animated.waypoint_list_.back().get_value(t);
 
-			WaypointList::const_iterator iter;
-			WaypointList::const_iterator next;
-
-			// This next line will set iter to the
-			// correct iterator for the given time.
-			for(next=animated.waypoint_list_.begin(),iter=next++;next!=animated.waypoint_list_.end() && t>=next->get_time();iter=next++)
-				continue;
-
-			return iter->get_value(t);
+			// Last waypoint at or before the given time,
+			// t > r here, so the index is never zero
+			size_t index = upper_bound(animated.waypoint_list_, t,
+				[](const Waypoint &x) { return x.get_time(); } );
+			return animated.waypoint_list_[index - 1].get_value(t);
 		}
 
 		virtual void get_values_vfunc(std::map<Time, ValueBase> &x) const
@@ -840,13 +864,14 @@ public:
 			if(t>=s)
 				return animated.waypoint_list_.back().get_value(t);
 
-			WaypointList::const_iterator iter = animated.waypoint_list_.begin();
-
-			// A waypoint sets the boolean value until next waypoint
-			for (auto next = iter+1; next != animated.waypoint_list_.end(); iter = next++)
-				if (iter->get_time()==t || t < next->get_time())
-					return iter->get_value(t);
-			return iter->get_value(t);
+			// A waypoint sets the boolean value until next waypoint,
+			// t > r here, so the index is never zero
+			size_t index = upper_bound(animated.waypoint_list_, t,
+				[](const Waypoint &x) { return x.get_time(); } ) - 1;
+			// the first of the waypoints with the same time wins
+			while(index > 0 && animated.waypoint_list_[index - 1].get_time() == t)
+				--index;
+			return animated.waypoint_list_[index].get_value(t);
 		}
 
 		virtual void get_values_vfunc(std::map<Time, ValueBase> &x) const
@@ -51,10 +51,10 @@ using namespace synfig;
 
 // #define HIDE_BONE_FIELDS
 
-#define GET_NODE_PARENT_NODE(node,t) (*node->get_link("parent"))(t).get(ValueNode_Bone::Handle())
+#define GET_NODE_PARENT_NODE(node,t) node->get_link("parent")->get_value_cached(t).get(ValueNode_Bone::Handle())
 #define GET_NODE_PARENT(node,t) GET_NODE_PARENT_NODE(node,t)->get_guid()
 #define GET_NODE_NAME(node,t) node->get_bone_name(t)
-#define GET_NODE_BONE(node,t) (*node)(t).get(Bone())
+#define GET_NODE_BONE(node,t) node->get_value_cached(t).get(Bone())
 
 // how many hex digits of the guid string to show in debug messages
 #define GUID_PREFIX_LEN 6
@@ -405,7 +405,7 @@ ValueNode_Bone::ConstHandle
 ValueNode_Bone::get_parent(Time t)const
 {
 	// check if we are an ancestor of the proposed parent
-	ValueNode_Bone::ConstHandle parent((*parent_)(t).get(ValueNode_Bone::Handle()));
+	ValueNode_Bone::ConstHandle parent(parent_->get_value_cached(t).get(ValueNode_Bone::Handle()));
 	if (ValueNode_Bone::ConstHandle result = is_ancestor_of(parent,t))
 	{
 		if (result == ValueNode_Bone::ConstHandle(this))
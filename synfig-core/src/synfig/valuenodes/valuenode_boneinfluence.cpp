@@ -233,7 +233,7 @@ ValueNode_BoneInfluence::calculate_transform(Time t)const
 {
 	Matrix transform;
 	transform *= 0.0;
-	std::vector<ValueBase> bone_weight_list((*bone_weight_list_)(t).get_list());
+	std::vector<ValueBase> bone_weight_list(bone_weight_list_->get_value_cached(t).get_list());
 	Real total_weight = 0;
 	for (std::vector<ValueBase>::iterator iter = bone_weight_list.begin(); iter != bone_weight_list.end(); iter++)
 	{
@@ -148,7 +148,7 @@ Transformation
 ValueNode_BoneLink::get_bone_transformation(Time t)const
 {
 	Transformation transformation;
-	ValueNode_Bone::Handle bone_node = (*bone_)(t).get(ValueNode_Bone::Handle());
+	ValueNode_Bone::Handle bone_node = bone_->get_value_cached(t).get(ValueNode_Bone::Handle());
 	if (bone_node)
 	{
 		Bone bone      = (*bone_node) (t).get(Bone());
@@ -178,7 +178,7 @@ ValueNode_BoneLink::operator()(Time t)const
 	DEBUG_LOG("SYNFIG_DEBUG_VALUENODE_OPERATORS",
 		"%s:%d operator()\n", __FILE__, __LINE__);
 	return ValueTransformation::transform(
-		get_bone_transformation(t), (*base_value_)(t) );
+		get_bone_transformation(t), base_value_->get_value_cached(t) );
 }
 
 
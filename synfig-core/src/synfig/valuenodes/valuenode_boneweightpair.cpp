@@ -107,7 +107,7 @@ ValueNode_BoneWeightPair::operator()(Time t)const
 		"%s:%d operator()\n", __FILE__, __LINE__);
 
 	ValueNode_Bone::Handle bone_node((*bone_)(t).get(ValueNode_Bone::Handle()));
-	Bone bone((*bone_node)(t).get(Bone()));
+	Bone bone(bone_node->get_value_cached(t).get(Bone()));
 	Real weight((*weight_)(t).get(Real()));
 	return BoneWeightPair(bone, weight);
 }
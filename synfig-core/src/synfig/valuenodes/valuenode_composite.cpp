@@ -225,8 +225,8 @@ synfig::ValueNode_Composite::operator()(Time t)const
 	{
 		Vector vect;
 		assert(components[0] && components[1]);
-		vect[0]=(*components[0])(t).get(Vector::value_type());
-		vect[1]=(*components[1])(t).get(Vector::value_type());
+		vect[0]=components[0]->get_value_cached(t).get(Vector::value_type());
+		vect[1]=components[1]->get_value_cached(t).get(Vector::value_type());
 		return vect;
 	}
 	else
@@ -234,10 +234,10 @@ synfig::ValueNode_Composite::operator()(Time t)const
 	{
 		Color color;
 		assert(components[0] && components[1] && components[2] && components[3]);
-		color.set_r((*components[0])(t).get(Vector::value_type()));
-		color.set_g((*components[1])(t).get(Vector::value_type()));
-		color.set_b((*components[2])(t).get(Vector::value_type()));
-		color.set_a((*components[3])(t).get(Vector::value_type()));
+		color.set_r(components[0]->get_value_cached(t).get(Vector::value_type()));
+		color.set_g(components[1]->get_value_cached(t).get(Vector::value_type()));
+		color.set_b(components[2]->get_value_cached(t).get(Vector::value_type()));
+		color.set_a(components[3]->get_value_cached(t).get(Vector::value_type()));
 		return color;
 	}
 	else
@@ -245,10 +245,10 @@ synfig::ValueNode_Composite::operator()(Time t)const
 	{
 		Segment seg;
 		assert(components[0] && components[1] && components[2] && components[3]);
-		seg.p1=(*components[0])(t).get(Point());
-		seg.t1=(*components[1])(t).get(Vector());
-		seg.p2=(*components[2])(t).get(Point());
-		seg.t2=(*components[3])(t).get(Vector());
+		seg.p1=components[0]->get_value_cached(t).get(Point());
+		seg.t1=components[1]->get_value_cached(t).get(Vector());
+		seg.p2=components[2]->get_value_cached(t).get(Point());
+		seg.t2=components[3]->get_value_cached(t).get(Vector());
 		return seg;
 	}
 	else
@@ -256,14 +256,14 @@ synfig::ValueNode_Composite::operator()(Time t)const
 	{
 		BLinePoint ret;
 		assert(components[0] && components[1] && components[2] && components[3] && components[4] && components[5] && components[6] && components[7]);
-		ret.set_vertex((*components[0])(t).get(Point()));
-		ret.set_width((*components[1])(t).get(Real()));
-		ret.set_origin((*components[2])(t).get(Real()));
-		ret.set_split_tangent_both((*components[3])(t).get(bool()));
-		ret.set_split_tangent_radius((*components[6])(t).get(bool()));
-		ret.set_split_tangent_angle((*components[7])(t).get(bool()));
-		ret.set_tangent1((*components[4])(t).get(Vector()));
-		ret.set_tangent2((*components[5])(t).get(Vector()));
+		ret.set_vertex(components[0]->get_value_cached(t).get(Point()));
+		ret.set_width(components[1]->get_value_cached(t).get(Real()));
+		ret.set_origin(components[2]->get_value_cached(t).get(Real()));
+		ret.set_split_tangent_both(components[3]->get_value_cached(t).get(bool()));
+		ret.set_split_tangent_radius(components[6]->get_value_cached(t).get(bool()));
+		ret.set_split_tangent_angle(components[7]->get_value_cached(t).get(bool()));
+		ret.set_tangent1(components[4]->get_value_cached(t).get(Vector()));
+		ret.set_tangent2(components[5]->get_value_cached(t).get(Vector()));
 		return ret;
 	}
 	else
@@ -271,12 +271,12 @@ synfig::ValueNode_Composite::operator()(Time t)const
 	{
 		WidthPoint ret;
 		assert(components[0] && components[1] && components[2] && components[3] && components[4] && components[5]);
-		ret.set_position((*components[0])(t).get(Real()));
-		ret.set_width((*components[1])(t).get(Real()));
-		ret.set_side_type_before((*components[2])(t).get(int()));
-		ret.set_side_type_after((*components[3])(t).get(int()));
-		ret.set_lower_bound((*components[4])(t).get(Real()));
-		ret.set_upper_bound((*components[5])(t).get(Real()));
+		ret.set_position(components[0]->get_value_cached(t).get(Real()));
+		ret.set_width(components[1]->get_value_cached(t).get(Real()));
+		ret.set_side_type_before(components[2]->get_value_cached(t).get(int()));
+		ret.set_side_type_after(components[3]->get_value_cached(t).get(int()));
+		ret.set_lower_bound(components[4]->get_value_cached(t).get(Real()));
+		ret.set_upper_bound(components[5]->get_value_cached(t).get(Real()));
 		return ret;
 	}
 	else
@@ -284,14 +284,14 @@ synfig::ValueNode_Composite::operator()(Time t)const
 	{
 		DashItem ret;
 		assert(components[0] && components[1] && components[2] && components[3]);
-		Real offset((*components[0])(t).get(Real()));
+		Real offset(components[0]->get_value_cached(t).get(Real()));
 		if(offset < 0.0) offset=0.0;
-		Real length((*components[1])(t).get(Real()));
+		Real length(components[1]->get_value_cached(t).get(Real()));
 		if(length < 0.0) length=0.0;
 		ret.set_offset(offset);
 		ret.set_length(length);
-		ret.set_side_type_before((*components[2])(t).get(int()));
-		ret.set_side_type_after((*components[3])(t).get(int()));
+		ret.set_side_type_before(components[2]->get_value_cached(t).get(int()));
+		ret.set_side_type_after(components[3]->get_value_cached(t).get(int()));
 		return ret;
 	}
 	else
@@ -299,28 +299,28 @@ synfig::ValueNode_Composite::operator()(Time t)const
 	{
 		Transformation ret;
 		assert(components[0] && components[1] && components[2] && components[3]);
-		ret.offset    = (*components[0])(t).get(Vector());
-		ret.angle     = (*components[1])(t).get(Angle());
-		ret.skew_angle = (*components[2])(t).get(Angle());
-		ret.scale     = (*components[3])(t).get(Vector());
+		ret.offset    = components[0]->get_value_cached(t).get(Vector());
+		ret.angle     = components[1]->get_value_cached(t).get(Angle());
+		ret.skew_angle = components[2]->get_value_cached(t).get(Angle());
+		ret.scale     = components[3]->get_value_cached(t).get(Vector());
 		return ret;
 	}
 	else
 	if (types_namespace::TypeWeightedValueBase *tp = dynamic_cast<types_namespace::TypeWeightedValueBase*>(&type))
 	{
 		assert(components[0] && components[1]);
-		return tp->create_weighted_value((*components[0])(t).get(Real()), (*components[1])(t));
+		return tp->create_weighted_value(components[0]->get_value_cached(t).get(Real()), components[1]->get_value_cached(t));
 	}
 	else
 	if (types_namespace::TypePairBase *tp =dynamic_cast<types_namespace::TypePairBase*>(&type))
 	{
 		assert(components[0] && components[1]);
-		return tp->create_value((*components[0])(t), (*components[1])(t));
+		return tp->create_value(components[0]->get_value_cached(t), components[1]->get_value_cached(t));
 	}
 
 	synfig::error(std::string("ValueNode_Composite::operator():")+_("Bad type for composite"));
 	assert(components[0]);
-	return (*components[0])(t);
+	return components[0]->get_value_cached(t);
 }
 
 bool
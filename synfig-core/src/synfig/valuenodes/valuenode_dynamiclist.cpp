@@ -668,7 +668,7 @@ ValueNode_DynamicList::operator()(Time t)const
 		if(state)
 		{
 			if(iter->value_node->get_type()==*container_type)
-				ret_list.push_back((*iter->value_node)(t));
+				ret_list.push_back(iter->value_node->get_value_cached(t));
 			else
 			{
 				synfig::warning(std::string("ValueNode_DynamicList::operator()():")+_("List type/item type mismatch, throwing away mismatch"));
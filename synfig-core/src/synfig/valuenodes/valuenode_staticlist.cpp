@@ -355,7 +355,7 @@ ValueNode_StaticList::operator()(Time t)const // line 596
 
 	for(iter=list.begin();iter!=list.end();++iter)
 		if((*iter)->get_type()==*container_type)
-			ret_list.push_back((**iter)(t));
+			ret_list.push_back((*iter)->get_value_cached(t));
 		else
 			synfig::warning(std::string("ValueNode_StaticList::operator()():")+_("List type/item type mismatch, throwing away mismatch"));
 
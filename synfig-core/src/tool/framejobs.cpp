@@ -0,0 +1,309 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/framejobs.cpp
+**	\brief Renders frames of one job in several processes at once
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <glibmm/miscutils.h>
+#include <glibmm/spawn.h>
+
+#include <synfig/general.h>
+#include <synfig/localization.h>
+#include <synfig/surface.h>
+#include <synfig/target_scanline.h>
+
+#include "definitions.h"
+#include "framejobs.h"
+#include "synfigtoolexception.h"
+
+#endif
+
+using namespace synfig;
+
+#ifndef _WIN32
+
+namespace {
+
+int
+get_frame_count(const RendDesc& desc)
+{
+	int count = desc.get_frame_end() - desc.get_frame_start() + 1;
+	return count <= 0 ? 1 : count;
+}
+
+//! Same time as Target::next_frame() gives for the frame
+Time
+get_frame_time(const RendDesc& desc, int frame)
+{
+	int count = get_frame_count(desc);
+	if (count == 1)
+		return desc.get_time_start();
+	return (desc.get_time_end() - desc.get_time_start())*frame/(count - 1) + desc.get_time_start();
+}
+
+bool
+write_all(int fd, const void* data, size_t size)
+{
+	const char* p = static_cast<const char*>(data);
+	while(size) {
+		ssize_t written = write(fd, p, size);
+		if (written < 0 && errno == EINTR) continue;
+		if (written <= 0) return false;
+		p += written;
+		size -= size_t(written);
+	}
+	return true;
+}
+
+bool
+read_all(int fd, void* data, size_t size)
+{
+	char* p = static_cast<char*>(data);
+	while(size) {
+		ssize_t count = read(fd, p, size);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) return false;
+		p += count;
+		size -= size_t(count);
+	}
+	return true;
+}
+
+//! Writes unprocessed rows of the rendered frame into the pipe
+class FrameStreamTarget : public Target_Scanline
+{
+	int fd;
+	std::vector<Color> line;
+	bool failed;
+
+public:
+	explicit FrameStreamTarget(int fd): fd(fd), failed(false) { }
+
+	virtual bool start_frame(ProgressCallback* /*cb*/)
+	{
+		line.resize(desc.get_w());
+		return !failed;
+	}
+
+	virtual void end_frame()
+	{ }
+
+	virtual Color* start_scanline(int /*scanline*/)
+		{ return failed ? nullptr : &line.front(); }
+
+	virtual bool end_scanline()
+	{
+		if (!write_all(fd, &line.front(), line.size()*sizeof(Color)))
+			failed = true;
+		return !failed;
+	}
+};
+
+//! Frames of workers are in the same place only if the target did not adjust the render description
+bool
+same_frames(const RendDesc& a, const RendDesc& b)
+{
+	return a.get_w() == b.get_w()
+		&& a.get_h() == b.get_h()
+		&& a.get_tl() == b.get_tl()
+		&& a.get_br() == b.get_br()
+		&& a.get_frame_rate() == b.get_frame_rate()
+		&& a.get_time_start() == b.get_time_start()
+		&& a.get_time_end() == b.get_time_end();
+}
+
+}
+
+bool
+can_render_frame_jobs(const Job& job)
+{
+	if (job.frame_jobs <= 1 || job.sifout || job.arguments.empty())
+		return false;
+
+	Target_Scanline::Handle target = Target_Scanline::Handle::cast_dynamic(job.target);
+	if (!target || get_frame_count(target->rend_desc()) <= 1)
+		return false;
+
+	if (!same_frames(target->rend_desc(), job.desc)) {
+		VERBOSE_OUT(1) << _("Target changes the render settings, frames are rendered by one process") << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool
+render_frame_jobs(Job& job, ProgressCallback* callback)
+{
+	Target_Scanline::Handle target = Target_Scanline::Handle::cast_dynamic(job.target);
+	assert(target);
+	const RendDesc desc = target->rend_desc();
+	const int w = desc.get_w(), h = desc.get_h();
+	const int frame_count = get_frame_count(desc);
+	const int worker_count = std::min(job.frame_jobs, frame_count);
+
+	// frames are counted by the target like in Target_Scanline::render(),
+	// some targets (e.g. trgt_av) look at the number of the current frame
+	target->curr_frame_ = 0;
+	if (!target->init()) {
+		if (callback) callback->error(_("Target initialization failure"));
+		return false;
+	}
+
+	// every worker renders every N-th frame, so frames are read from workers in turn,
+	// and pipe keeps the worker waiting until its frame is put onto the target
+	std::vector<Glib::Pid> pids;
+	std::vector<int> pipes;
+	bool success = true;
+	try
+	{
+		for(int i = 0; i < worker_count; ++i) {
+			std::vector<std::string> args = job.arguments;
+			args[0] = SynfigToolGeneralOptions::instance()->get_binary_path();
+			args.push_back("--frame-jobs");
+			args.push_back(strprintf("%d", worker_count));
+			args.push_back("--frame-worker");
+			args.push_back(strprintf("%d", i + 1));
+
+			Glib::Pid pid;
+			int output = -1;
+			Glib::spawn_async_with_pipes(
+				Glib::get_current_dir(), args, Glib::SPAWN_DO_NOT_REAP_CHILD,
+				Glib::SlotSpawnChildSetup(), &pid, nullptr, &output, nullptr );
+			pids.push_back(pid);
+			pipes.push_back(output);
+		}
+		VERBOSE_OUT(1) << strprintf(_("Rendering by %d processes"), worker_count) << std::endl;
+
+		Surface surface(w, h);
+		for(int frame = 0; frame < frame_count && success; ++frame) {
+			Time time;
+			int remaining = target->next_frame(time);
+			if (callback && !callback->amount_complete(frame_count - remaining, frame_count)) {
+				success = false;
+				break;
+			}
+
+			int fd = pipes[frame % worker_count];
+			for(int y = 0; y < h && success; ++y)
+				if (!read_all(fd, surface[y], w*sizeof(Color))) {
+					if (callback) callback->error(strprintf(_("Frame %d is not rendered"), frame + desc.get_frame_start()));
+					success = false;
+				}
+
+			if (success && !target->add_frame(&surface, callback)) {
+				if (callback) callback->error(_("Unable to put surface on target"));
+				success = false;
+			}
+		}
+	}
+	catch(const Glib::SpawnError& e)
+	{
+		if (callback) callback->error(e.what());
+		success = false;
+	}
+
+	for(int fd : pipes)
+		close(fd);
+	for(Glib::Pid pid : pids) {
+		// workers are not needed anymore if something failed
+		if (!success)
+			kill(pid, SIGTERM);
+		int status = 0;
+		while(waitpid(pid, &status, 0) < 0 && errno == EINTR) { }
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != SYNFIGTOOL_OK)
+			success = false;
+		Glib::spawn_close_pid(pid);
+	}
+
+	return success;
+}
+
+void
+run_frame_worker(Job& job)
+{
+	// frames go to the pipe, messages must not be mixed with them
+	fflush(stdout);
+	std::cout.flush();
+	int fd = dup(1);
+	dup2(2, 1);
+
+	const RendDesc desc = job.desc;
+	const int frame_count = get_frame_count(desc);
+
+	etl::handle<FrameStreamTarget> target(new FrameStreamTarget(fd));
+	target->set_canvas(job.canvas);
+	target->set_quality(job.quality);
+	target->set_threads(SynfigToolGeneralOptions::instance()->get_threads());
+
+	for(int frame = job.frame_worker - 1; frame < frame_count; frame += job.frame_jobs) {
+		RendDesc frame_desc = desc;
+		frame_desc.set_time(get_frame_time(desc, frame));
+		target->set_rend_desc(&frame_desc);
+		if (!target->render()) {
+			close(fd);
+			throw SynfigToolException(SYNFIGTOOL_RENDERFAILURE, _("Render Failure."));
+		}
+	}
+
+	close(fd);
+}
+
+#else
+
+// workers need pipes and descriptors of POSIX
+
+bool
+can_render_frame_jobs(const Job& job)
+{
+	if (job.frame_jobs > 1)
+		VERBOSE_OUT(1) << _("Rendering by several processes is not supported on this platform") << std::endl;
+	return false;
+}
+
+bool
+render_frame_jobs(Job& job, ProgressCallback* callback)
+	{ return job.target->render(callback); }
+
+void
+run_frame_worker(Job& /*job*/)
+	{ throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT, _("Rendering by several processes is not supported on this platform")); }
+
+#endif
@@ -0,0 +1,44 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/framejobs.h
+**	\brief Renders frames of one job in several processes at once
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifndef __SYNFIG_FRAMEJOBS_H
+#define __SYNFIG_FRAMEJOBS_H
+
+#include <synfig/progresscallback.h>
+#include "job.h"
+
+/// Whether frames of the job can be rendered by worker processes (--frame-jobs)
+bool can_render_frame_jobs(const Job& job);
+
+/// Renders the job by job.frame_jobs worker processes.
+/// Every worker loads the file by itself and renders every N-th frame,
+/// frames are put onto the target of the job in their order.
+/// \return false on failure, like synfig::Target::render()
+bool render_frame_jobs(Job& job, synfig::ProgressCallback* callback);
+
+/// Renders the frames of worker job.frame_worker and writes raw pixels to the standard output
+void run_frame_worker(Job& job);
+
+#endif // __SYNFIG_FRAMEJOBS_H
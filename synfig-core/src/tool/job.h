@@ -27,6 +27,8 @@
 
 #ifndef __SYNFIG_JOB_H
 #define __SYNFIG_JOB_H
+#include <string>
+#include <vector>
 #include "synfig/target.h"
 
 struct Job
@@ -42,6 +44,13 @@ struct Job
 	synfig::Canvas::Handle canvas;
 	synfig::Target::Handle target;
 
+	/// Command line of the job, workers of frame jobs are started with it
+	std::vector<std::string> arguments;
+	/// Number of processes which render frames of the job
+	int frame_jobs;
+	/// Index of the frame worker starting from 1, or 0 if this process renders the job itself
+	int frame_worker;
+
 	int quality;
 	bool sifout;
 	bool list_canvases;
@@ -78,6 +87,8 @@ struct Job
 
     Job():
 		alpha_mode(synfig::TARGET_ALPHA_MODE_KEEP),
+		frame_jobs(1),
+		frame_worker(0),
 		quality(DEFAULT_QUALITY),
 		sifout(false),
 		list_canvases(),
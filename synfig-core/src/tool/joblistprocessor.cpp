@@ -50,6 +50,7 @@
 #include "definitions.h"
 #include "synfigtoolexception.h"
 #include "renderprogress.h"
+#include "framejobs.h"
 #include "joblistprocessor.h"
 
 #include <giomm/file.h>
@@ -64,6 +65,27 @@
 
 using namespace synfig;
 
+static std::string append_alpha_to_filename(const std::string& input_filename)
+{
+	std::size_t found = input_filename.rfind('.');
+	if (found == std::string::npos) return input_filename + "-alpha"; // extension not found, just add to the end
+
+	return input_filename.substr(0, found) + "-alpha" + input_filename.substr(found);
+}
+
+void add_job(std::list<Job>& job_list, Job job)
+{
+	if (job.extract_alpha) {
+		job.alpha_mode = synfig::TARGET_ALPHA_MODE_REDUCE;
+		job_list.push_front(job);
+		job.alpha_mode = synfig::TARGET_ALPHA_MODE_EXTRACT;
+		job.outfilename = append_alpha_to_filename(job.outfilename);
+		job_list.push_front(job);
+	} else {
+		job_list.push_front(job);
+	}
+}
+
 void process_job_list(std::list<Job>& job_list, const TargetParam& target_params)
 {
 	if (job_list.empty())
@@ -220,7 +242,7 @@ bool setup_job(Job& job, const TargetParam& target_parameters)
 	return true;
 }
 
-void process_job (Job& job)
+void process_job (Job& job, synfig::ProgressCallback* callback)
 {
 	VERBOSE_OUT(3) << job.filename.c_str() << " -- " << std::endl;
 	synfig::info("\tw: %d, h: %d, a: %d, pxaspect: %f, imaspect: %f, span: %f", 
@@ -253,7 +275,9 @@ void process_job (Job& job)
                     << std::endl;*/
 
 	RenderProgress p;
-	p.task(job.filename + " ==> " + job.outfilename);
+	if (!callback)
+		callback = &p;
+	callback->task(job.filename + " ==> " + job.outfilename);
 
 	if(job.sifout)
 	{
@@ -268,7 +292,13 @@ void process_job (Job& job)
             std::chrono::system_clock::now();
 
 		// Call the render member of the target
-		if(!job.target->render(&p))
+		if (can_render_frame_jobs(job))
+		{
+			if (!render_frame_jobs(job, callback))
+				throw (SynfigToolException(SYNFIGTOOL_RENDERFAILURE, _("Render Failure.")));
+		}
+		else
+		if(!job.target->render(callback))
 			throw (SynfigToolException(SYNFIGTOOL_RENDERFAILURE, _("Render Failure.")));
 
 		if(SynfigToolGeneralOptions::instance()->should_print_benchmarks())
@@ -29,9 +29,13 @@
 #define __SYNFIG_JOBLISTPROCESSOR_H
 
 #include <list>
+#include <synfig/progresscallback.h>
 #include <synfig/targetparam.h>
 #include "job.h"
 
+/// Add the job to the list, or two jobs (color and alpha) if alpha should be extracted
+void add_job(std::list<Job>& job_list, Job job);
+
 /// Process a Job list setting up and processing each job
 void process_job_list(std::list<Job>& job_list,
 						const synfig::TargetParam& target_parameters);
@@ -41,7 +45,8 @@ void process_job_list(std::list<Job>& job_list,
 bool setup_job(Job& job, const synfig::TargetParam& target_parameters);
 
 /// Process an individual job
-void process_job(Job& job);
+/// Progress is printed to the console, if \a callback is not set
+void process_job(Job& job, synfig::ProgressCallback* callback = nullptr);
 
 std::string get_absolute_path(std::string relative_path);
 
@@ -57,24 +57,12 @@
 #include "optionsprocessor.h"
 #include "joblistprocessor.h"
 #include "printing_functions.h"
+#include "renderserver.h"
+#include "framejobs.h"
 
 #endif
 
 
-std::string _appendAlphaToFilename(std::string input_filename)
-{
-
-	std::size_t found = input_filename.rfind('.');
-	if (found == std::string::npos) return input_filename + "-alpha"; // extension not found, just add to the end
-	
-	return input_filename.substr(0, found) + "-alpha" + input_filename.substr(found);
-
-    /*bfs::path filename(input_filename);
-    bfs::path alpha_filename(filename.stem().string() + "-alpha" +
-        filename.extension().string());
-    return bfs::path(filename.parent_path() / alpha_filename).string();*/
-}
-
 int main(int argc, char* argv[])
 {
 	setlocale(LC_ALL, "");
@@ -274,6 +262,17 @@ int main(int argc, char* argv[])
 		// Info options -----------------------------------------------
 		parser.process_info_options();
 
+		// Render server ----------------------------------------------
+		if (parser.should_run_server())
+		{
+			RenderServer server;
+			if (parser.get_server_socket().empty())
+				server.serve_stdio();
+			else
+				server.serve_socket(parser.get_server_socket());
+			return SYNFIGTOOL_OK;
+		}
+
 		std::list<Job> job_list;
 
 		// Processing --------------------------------------------------
@@ -281,16 +280,15 @@ int main(int argc, char* argv[])
 		job = parser.extract_job();
 		job.desc = job.canvas->rend_desc() = parser.extract_renddesc(job.canvas->rend_desc());
 
-		if (job.extract_alpha) {
-			job.alpha_mode = synfig::TARGET_ALPHA_MODE_REDUCE;
-			job_list.push_front(job);
-			job.alpha_mode = synfig::TARGET_ALPHA_MODE_EXTRACT;
-			job.outfilename = _appendAlphaToFilename(job.outfilename);
-			job_list.push_front(job);
-		} else {
-			job_list.push_front(job);
+		// process started by --frame-jobs renders its frames only
+		if (job.frame_worker > 0)
+		{
+			run_frame_worker(job);
+			return SYNFIGTOOL_OK;
 		}
 
+		add_job(job_list, job);
+
 		process_job_list(job_list, parser.extract_targetparam());
 
 		return SYNFIGTOOL_OK;
@@ -107,17 +107,21 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	set_dpi(),
 	set_dpi_x(),
 	set_dpi_y(),
+	set_frame_jobs(),
+	set_frame_worker(),
 
 	// Switch group
 	sw_verbosity(),
 	sw_quiet(),
 	sw_print_benchmarks(),
 	sw_extract_alpha(),
+	sw_server(),
 
 	// Misc group
 	misc_append_filename(),
 	misc_canvas_info(),
 	misc_canvases(),
+	misc_server_socket(),
 
 	//FFMPEG group
 	video_codec(),
@@ -165,6 +169,13 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	add_option(og_set, "dpi",         ' ', set_dpi, 		_("Set the physical resolution (Dots-per-inch)"), "NUM");
 	add_option(og_set, "dpi-x",       ' ', set_dpi_x, 		_("Set the physical X resolution (Dots-per-inch)"), "NUM");
 	add_option(og_set, "dpi-y",       ' ', set_dpi_y, 		_("Set the physical Y resolution (Dots-per-inch)"), "NUM");
+	add_option(og_set, "frame-jobs",  ' ', set_frame_jobs,	_("Render several frames at once in separate processes"), "NUM");
+
+	// internal option for the processes started by --frame-jobs
+	Glib::OptionEntry entry_frame_worker;
+	entry_frame_worker.set_long_name("frame-worker");
+	entry_frame_worker.set_flags(Glib::OptionEntry::FLAG_HIDDEN);
+	og_set.add_entry(entry_frame_worker, set_frame_worker);
 
 	// Switch options
 	//og_switch("switch", _("Switch options"), "Show switch help");
@@ -172,11 +183,13 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	add_option(og_switch, "quiet",         'q', sw_quiet, 				_("Quiet mode (No progress/time-remaining display)"), "");
 	add_option(og_switch, "benchmarks",    'b', sw_print_benchmarks,	_("Print benchmarks"), "");
 	add_option(og_switch, "extract-alpha", 'x', sw_extract_alpha, 		_("Extract alpha"), "");
+	add_option(og_switch, "server",        ' ', sw_server, 				_("Keep running and render jobs read line by line from the standard input"), "");
 
 	//SynfigOptionGroup og_misc("misc", _("Misc options"), "Show Misc options help");
 	add_option_filename(og_misc, "append", ' ', misc_append_filename, 	_("Append layers in <filename> to composition"), _("filename"));
 	add_option(og_misc, "canvas-info",     ' ', misc_canvas_info, 			_("Print out specified details of the root canvas"), _("fields"));
 	add_option(og_misc, "canvases",		   ' ', misc_canvases,				_("Print out the list of exported canvases in the composition"), "");
+	add_option_filename(og_misc, "server-socket", ' ', misc_server_socket, _("Keep running and render jobs read line by line from the local socket"), _("filename"));
 
 	//SynfigOptionGroup og_ffmpeg("ffmpeg", _("FFMPEG target options"), "Show FFMPEG target options help");
 	add_option(og_ffmpeg, "video-codec",   ' ', video_codec, 	_("Set the codec for the video. See --target-video-codecs"), _("codec"));
@@ -237,6 +250,8 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 
 bool SynfigCommandLineParser::parse(int argc, char* argv[])
 {
+	for (char** arg = argv; *arg; ++arg)
+		arguments.push_back(*arg);
 
 #ifdef GLIBMM_EXCEPTIONS_ENABLED
 	try
@@ -268,6 +283,29 @@ bool SynfigCommandLineParser::parse(int argc, char* argv[])
 	return true;
 }
 
+void SynfigCommandLineParser::parse(std::vector<std::string> args)
+{
+	arguments = args;
+
+	std::vector<char*> argv;
+	for (std::string& arg : args)
+		argv.push_back(&arg[0]);
+	argv.push_back(nullptr);
+
+	int argc = int(args.size());
+	char **argv_pointer = argv.data();
+	try
+	{
+		context.parse(argc, argv_pointer);
+	}
+	catch(const Glib::Error& ex)
+	{
+		throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT, ex.what());
+	}
+
+	if (!remaining_options_list.empty() && set_input_file.empty()) set_input_file = remaining_options_list.front();
+}
+
 void SynfigCommandLineParser::extract_canvas_info(Job& job)
 {
 	job.canvas_info = true;
@@ -636,7 +674,7 @@ TargetParam SynfigCommandLineParser::extract_targetparam()
 	return params;
 }
 
-Job SynfigCommandLineParser::extract_job()
+Job SynfigCommandLineParser::extract_job(const Canvas::Handle& root)
 {
 	Job job;
 
@@ -647,22 +685,29 @@ Job SynfigCommandLineParser::extract_job()
 
 		// Open the composition
 		std::string errors, warnings;
-		try
+		if (root)
+		{
+			job.root = root;
+		}
+		else
 		{
-			if (FileSystem::Handle file_system = CanvasFileNaming::make_filesystem(job.filename))
+			try
 			{
-				FileSystem::Identifier identifier = file_system->get_identifier(CanvasFileNaming::project_file(job.filename));
-				job.root = open_canvas_as(identifier, job.filename, errors, warnings);
+				if (FileSystem::Handle file_system = CanvasFileNaming::make_filesystem(job.filename))
+				{
+					FileSystem::Identifier identifier = file_system->get_identifier(CanvasFileNaming::project_file(job.filename));
+					job.root = open_canvas_as(identifier, job.filename, errors, warnings);
+				}
+				else
+				{
+					errors.append("Cannot open container " + job.filename + "\n");
+				}
 			}
-			else
+			catch(std::runtime_error& /*x*/)
 			{
-				errors.append("Cannot open container " + job.filename + "\n");
+				job.root = nullptr;
 			}
 		}
-		catch(std::runtime_error& /*x*/)
-		{
-			job.root = nullptr;
-		}
 
 		// By default, the canvas to render is the root canvas
 		// This can be changed through --canvas option
@@ -699,6 +744,16 @@ Job SynfigCommandLineParser::extract_job()
 		job.extract_alpha = true;
 	}
 
+	job.arguments = arguments;
+	if (set_frame_jobs > 1)
+		job.frame_jobs = set_frame_jobs;
+	if (set_frame_worker > 0)
+	{
+		if (set_frame_worker > job.frame_jobs)
+			throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT, _("Frame worker index is out of the range of frame jobs"));
+		job.frame_worker = set_frame_worker;
+	}
+
 	if (set_quality > 0)
 		job.quality = set_quality;
 	else
@@ -42,6 +42,10 @@ public:
 	SynfigCommandLineParser();
 	bool parse(int argc, char* argv[]);
 
+	/// Parse the arguments of one job of the render server
+	/// \throw SynfigToolException if arguments are wrong
+	void parse(std::vector<std::string> args);
+
 	/// Settings options
 	/// verbose, quiet, threads, benchmarks
 	void process_settings_options() const;
@@ -57,8 +61,9 @@ public:
 
 	/// Extract the necessary options to create a job
 	/// After this, it is necessary to overwrite the necessary RendDesc options
-	/// and set the target parameters, if provided. Then can be processed
-	Job extract_job();
+	/// and set the target parameters, if provided. Then can be processed.
+	/// If \a root is given then it is used instead of loading the input file
+	Job extract_job(const synfig::Canvas::Handle& root = synfig::Canvas::Handle());
 
 	/// Overwrite the input RendDesc object with the options given in the command line
 	synfig::RendDesc extract_renddesc(const synfig::RendDesc& renddesc);
@@ -73,6 +78,16 @@ public:
 
 	void print_target_video_codecs_help() const;
 
+	/// Whether jobs should be read by the render server instead of rendering one job
+	/// server, server-socket
+	bool should_run_server() const { return sw_server || !misc_server_socket.empty(); }
+	std::string get_server_socket() const { return misc_server_socket; }
+
+	std::string get_input_file() const { return set_input_file; }
+
+	/// Whether the loaded canvas is changed by the job (append)
+	bool modifies_canvas() const { return !misc_append_filename.empty(); }
+
 #ifdef _DEBUG
 	void process_debug_options();
 #endif
@@ -116,17 +131,21 @@ private:
 	double			set_dpi;
 	double			set_dpi_x;
 	double			set_dpi_y;
+	int				set_frame_jobs;
+	int				set_frame_worker;
 
 	// Switch group
 	int				sw_verbosity;
 	bool			sw_quiet;
 	bool			sw_print_benchmarks;
 	bool			sw_extract_alpha;
+	bool			sw_server;
 
 	// Misc group
 	std::string		misc_append_filename;
 	Glib::ustring	misc_canvas_info;
 	bool			misc_canvases;
+	std::string		misc_server_socket;
 
 	//FFMPEG group
 	Glib::ustring	video_codec;
@@ -153,6 +172,9 @@ private:
 	
 	Glib::OptionGroup::vecustrings remaining_options_list;
 
+	/// Arguments as they were given, before parsing
+	std::vector<std::string> arguments;
+
 	struct VideoCodec
 	{
 		VideoCodec(const std::string& name_, const std::string& description_)
@@ -0,0 +1,357 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/renderserver.cpp
+**	\brief Persistent render process, reads jobs line by line
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glibmm/shell.h>
+#include <giomm/datainputstream.h>
+#include <giomm/init.h>
+#include <giomm/socketlistener.h>
+#ifndef _WIN32
+#include <giomm/unixsocketaddress.h>
+#endif
+#include <glib/gstdio.h>
+
+#include <ETL/stringf>
+
+#include <synfig/general.h>
+#include <synfig/localization.h>
+#include <synfig/progresscallback.h>
+
+#include "definitions.h"
+#include "job.h"
+#include "joblistprocessor.h"
+#include "optionsprocessor.h"
+#include "renderserver.h"
+#include "synfigtoolexception.h"
+
+#endif
+
+using namespace synfig;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef std::chrono::duration<double> Duration;
+
+class ServerProgress : public ProgressCallback
+{
+	int id;
+	const RenderServer::Sender& send;
+	int last_current;
+
+public:
+	ServerProgress(int id, const RenderServer::Sender& send):
+		id(id), send(send), last_current(-1) { }
+
+	virtual bool task(const std::string& /*task*/)
+		{ return true; }
+
+	virtual bool error(const std::string& task)
+		{ synfig::error("job %d: %s", id, task.c_str()); return true; }
+
+	virtual bool warning(const std::string& task)
+		{ synfig::warning("job %d: %s", id, task.c_str()); return true; }
+
+	virtual bool amount_complete(int current, int total)
+	{
+		if (current != last_current) {
+			last_current = current;
+			send(strprintf("job %d progress %d %d", id, current, total));
+		}
+		return true;
+	}
+};
+
+std::time_t
+get_modification_time(const std::string& filename)
+{
+	GStatBuf buf;
+	return g_stat(filename.c_str(), &buf) ? 0 : buf.st_mtime;
+}
+
+//! Answer must fit into one line
+std::string
+single_line(std::string text)
+{
+	std::replace(text.begin(), text.end(), '\n', ' ');
+	std::replace(text.begin(), text.end(), '\r', ' ');
+	return text;
+}
+
+}
+
+RenderServer::RenderServer():
+	max_cached_canvases(8),
+	last_job_id(0),
+	quit_requested(false)
+{
+	if (const char *s = getenv("SYNFIG_SERVER_CANVAS_CACHE"))
+		max_cached_canvases = std::max(0, atoi(s));
+}
+
+RenderServer::~RenderServer()
+{ }
+
+void
+RenderServer::drop_modified_canvases()
+{
+	for(std::list<CachedCanvas>::iterator i = cached_canvases.begin(); i != cached_canvases.end(); )
+		if (get_modification_time(i->filename) != i->modification_time) {
+			VERBOSE_OUT(2) << _("File is changed, dropping the loaded canvas: ") << i->filename << std::endl;
+			i = cached_canvases.erase(i);
+		} else ++i;
+}
+
+Canvas::Handle
+RenderServer::find_cached_canvas(const std::string& filename)
+{
+	for(std::list<CachedCanvas>::iterator i = cached_canvases.begin(); i != cached_canvases.end(); ++i)
+		if (i->filename == filename) {
+			cached_canvases.splice(cached_canvases.begin(), cached_canvases, i);
+			return i->root;
+		}
+	return Canvas::Handle();
+}
+
+void
+RenderServer::cache_canvas(const std::string& filename, const Canvas::Handle& root)
+{
+	cached_canvases.remove_if([&filename](const CachedCanvas& c) { return c.filename == filename; });
+
+	if (!max_cached_canvases)
+		return;
+	CachedCanvas cached;
+	cached.filename = filename;
+	cached.root = root;
+	cached.modification_time = get_modification_time(filename);
+	cached_canvases.push_front(cached);
+	while(cached_canvases.size() > max_cached_canvases)
+		cached_canvases.pop_back();
+}
+
+void
+RenderServer::process_job_line(int id, const std::string& line, const Sender& send)
+{
+	std::vector<std::string> args = Glib::shell_parse_argv(line);
+	args.insert(args.begin(), "synfig");
+
+	SynfigCommandLineParser parser;
+	parser.parse(args);
+
+	// canvas loaded by the previous jobs is reused while the file is not modified,
+	// appended layers stay in the canvas, so such jobs always load their own copy
+	drop_modified_canvases();
+	const std::string filename = etl::absolute_path(parser.get_input_file());
+	Canvas::Handle root;
+	if (!parser.modifies_canvas() && !parser.get_input_file().empty())
+		root = find_cached_canvas(filename);
+
+	Clock::time_point load_start = Clock::now();
+	Job job = parser.extract_job(root);
+	Duration load_time = Clock::now() - load_start;
+	send(strprintf("job %d started %s", id, job.filename.c_str()));
+
+	if (root) {
+		++statistics.canvas_reuses;
+	} else {
+		++statistics.canvas_loads;
+		if (!parser.modifies_canvas())
+			cache_canvas(filename, job.root);
+	}
+
+	// render description of the cached canvas must be the same for the next jobs
+	const RendDesc original_desc = job.canvas->rend_desc();
+	Clock::time_point render_start = Clock::now();
+	try
+	{
+		job.desc = job.canvas->rend_desc() = parser.extract_renddesc(original_desc);
+
+		// targets are finished when they are destroyed, so jobs are dropped before the answer
+		std::list<Job> job_list;
+		add_job(job_list, job);
+		const TargetParam target_params = parser.extract_targetparam();
+		ServerProgress progress(id, send);
+		for(; !job_list.empty(); job_list.pop_front())
+		{
+			if (!setup_job(job_list.front(), target_params))
+				throw SynfigToolException(SYNFIGTOOL_INVALIDJOB, _("Unable to set up the job"));
+			process_job(job_list.front(), &progress);
+		}
+	}
+	catch(...)
+	{
+		job.canvas->rend_desc() = original_desc;
+		throw;
+	}
+	job.canvas->rend_desc() = original_desc;
+	Duration render_time = Clock::now() - render_start;
+
+	send(strprintf("job %d done %f %f", id, load_time.count(), render_time.count()));
+}
+
+bool
+RenderServer::process_line(const std::string& line, const Sender& send)
+{
+	std::string::size_type begin = line.find_first_not_of(" \t\r");
+	if (begin == std::string::npos || line[begin] == '#')
+		return true;
+	std::string::size_type end = line.find_last_not_of(" \t\r");
+	if (line.substr(begin, end - begin + 1) == "quit") {
+		quit_requested = true;
+		return false;
+	}
+
+	int id = ++last_job_id;
+	++statistics.jobs;
+	try
+	{
+		process_job_line(id, line, send);
+	}
+	catch(const SynfigToolException& e)
+	{
+		// informational options (like --canvases) finish job without rendering
+		if (e.get_exit_code() == SYNFIGTOOL_OK || e.get_exit_code() == SYNFIGTOOL_HELP)
+			send(strprintf("job %d done 0 0", id));
+		else
+			send(strprintf("job %d failed %s", id, single_line(e.get_message()).c_str()));
+	}
+	catch(const Glib::Error& e)
+	{
+		send(strprintf("job %d failed %s", id, single_line(e.what()).c_str()));
+	}
+	catch(const std::exception& e)
+	{
+		send(strprintf("job %d failed %s", id, single_line(e.what()).c_str()));
+	}
+	return true;
+}
+
+void
+RenderServer::serve(std::istream& in, std::ostream& out)
+{
+	serve(in, [&out](const std::string& answer) { out << answer << std::endl; });
+}
+
+void
+RenderServer::serve(std::istream& in, const Sender& send)
+{
+	std::string line;
+	while(std::getline(in, line))
+		if (!process_line(line, send))
+			break;
+}
+
+void
+RenderServer::serve_stdio()
+{
+	// answers must not be mixed with the info options, help or images written to stdout by the jobs
+	fflush(stdout);
+	std::cout.flush();
+	int fd = dup(1);
+	dup2(2, 1);
+
+	FILE *out = fdopen(fd, "w");
+	if (!out)
+		throw SynfigToolException(SYNFIGTOOL_UNKNOWNERROR, _("Unable to open output for answers"));
+
+	serve(std::cin, [out](const std::string& answer) {
+		fprintf(out, "%s\n", answer.c_str());
+		fflush(out);
+	});
+	fclose(out);
+}
+
+void
+RenderServer::serve_socket(const std::string& path)
+{
+#ifdef _WIN32
+	throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT, _("Local sockets are not supported on this platform"));
+#else
+	Gio::init();
+
+	// socket file may be left by the previous server,
+	// but other files are never removed
+	GStatBuf st;
+	if (g_lstat(path.c_str(), &st) == 0) {
+		if (!S_ISSOCK(st.st_mode))
+			throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT,
+				strprintf(_("Unable to listen at %s: file exists and it is not a socket"), path.c_str()));
+		g_unlink(path.c_str());
+	}
+
+	Glib::RefPtr<Gio::SocketListener> listener = Gio::SocketListener::create();
+	listener->add_address(Gio::UnixSocketAddress::create(path), Gio::SOCKET_TYPE_STREAM, Gio::SOCKET_PROTOCOL_DEFAULT);
+	VERBOSE_OUT(1) << _("Waiting for jobs at ") << path << std::endl;
+
+	while(!quit_requested)
+	{
+		Glib::RefPtr<Gio::SocketConnection> connection = listener->accept();
+		Glib::RefPtr<Gio::DataInputStream> input = Gio::DataInputStream::create(connection->get_input_stream());
+		Glib::RefPtr<Gio::OutputStream> output = connection->get_output_stream();
+
+		bool connected = true;
+		Sender send = [&output, &connected](const std::string& answer) {
+			if (!connected) return;
+			try { output->write(answer + "\n"); }
+			catch(const Glib::Error&) { connected = false; }
+		};
+
+		std::string line;
+		try
+		{
+			while(connected && input->read_line(line))
+				if (!process_line(line, send))
+					break;
+		}
+		catch(const Glib::Error& e)
+		{
+			synfig::warning("render server: %s", e.what().c_str());
+		}
+		connection->close();
+	}
+
+	listener->close();
+	g_unlink(path.c_str());
+#endif
+}
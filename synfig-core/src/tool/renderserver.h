@@ -0,0 +1,105 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/renderserver.h
+**	\brief Persistent render process, reads jobs line by line
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifndef __SYNFIG_RENDERSERVER_H
+#define __SYNFIG_RENDERSERVER_H
+
+#include <ctime>
+#include <functional>
+#include <iosfwd>
+#include <list>
+#include <string>
+
+#include <synfig/canvas.h>
+
+/// Renders jobs until the end of input, so modules are initialized once
+/// and loaded canvases (with their imported files) are reused by the next jobs.
+///
+/// Every input line is a job given by the same arguments as the synfig command line,
+/// e.g. `scene.sif -o out.png --begin-time 10 --end-time 20`.
+/// Empty lines and lines started with '#' are ignored, line `quit` stops the server.
+/// Every job is answered by the lines:
+///   job <id> started <input file>
+///   job <id> progress <current> <total>
+///   job <id> done <load seconds> <render seconds>
+///   job <id> failed <message>
+class RenderServer
+{
+public:
+	typedef std::function<void(const std::string&)> Sender;
+
+	struct Statistics
+	{
+		size_t jobs;           ///< job lines received
+		size_t canvas_loads;   ///< input files parsed
+		size_t canvas_reuses;  ///< jobs which took the loaded canvas from cache
+
+		Statistics():
+			jobs(), canvas_loads(), canvas_reuses() { }
+	};
+
+	RenderServer();
+	~RenderServer();
+
+	/// Reads jobs from \a in and writes answers to \a out
+	void serve(std::istream& in, std::ostream& out);
+	/// Reads jobs from \a in and passes answers to \a send
+	void serve(std::istream& in, const Sender& send);
+
+	/// Reads jobs from stdin and writes answers to stdout,
+	/// everything else printed by the jobs to stdout goes to stderr
+	void serve_stdio();
+
+	/// Listens on the local socket and serves the connected clients one after another
+	void serve_socket(const std::string& path);
+
+	const Statistics& get_statistics() const { return statistics; }
+
+private:
+	struct CachedCanvas
+	{
+		std::string filename;
+		synfig::Canvas::Handle root;
+		std::time_t modification_time;
+	};
+
+	/// Most recently used canvases first
+	std::list<CachedCanvas> cached_canvases;
+	size_t max_cached_canvases;
+	int last_job_id;
+	bool quit_requested;
+	Statistics statistics;
+
+	/// Returns false if server should stop
+	bool process_line(const std::string& line, const Sender& send);
+	void process_job_line(int id, const std::string& line, const Sender& send);
+
+	void drop_modified_canvases();
+	/// Returns the cached canvas of the file, \a filename must be absolute
+	synfig::Canvas::Handle find_cached_canvas(const std::string& filename);
+	void cache_canvas(const std::string& filename, const synfig::Canvas::Handle& root);
+};
+
+#endif // __SYNFIG_RENDERSERVER_H
@@ -0,0 +1,135 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file benchmark_clonecanvas.cpp
+**	\brief Benchmark of cloning and destroying of canvases by several threads
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <ETL/stringf>
+
+#include <synfig/canvas.h>
+#include <synfig/clock.h>
+#include <synfig/layer.h>
+#include <synfig/main.h>
+#include <synfig/node.h>
+#include <synfig/valuenodes/valuenode_const.h>
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Inline canvas with groups of layers, colors of layers are linked to value nodes,
+//! so every clone creates and registers canvases, layers and value nodes
+static Canvas::Handle
+build_canvas(const Canvas::Handle &root, int groups, int layers)
+{
+	Canvas::Handle canvas = Canvas::create_inline(root);
+	for(int i = 0; i < groups; ++i) {
+		Canvas::Handle group_canvas = Canvas::create_inline(root);
+		for(int j = 0; j < layers; ++j) {
+			Layer::Handle layer = Layer::create("solid_color");
+			layer->connect_dynamic_param("color", ValueNode_Const::create(Color(0.1*j, 0.2, 0.3, 1.0)));
+			group_canvas->push_back(layer);
+		}
+		Layer::Handle group = Layer::create("group");
+		group->set_param("canvas", group_canvas);
+		canvas->push_back(group);
+	}
+	return canvas;
+}
+
+//! Clones the canvas and destroys the clone, checks that all of the clones are registered while they are alive
+static void
+clone_and_destroy(Canvas::Handle canvas, int iterations, std::atomic<int> *errors)
+{
+	for(int i = 0; i < iterations; ++i) {
+		GUID guid;
+		{
+			Canvas::Handle clone = canvas->clone(GUID());
+			guid = clone->get_guid();
+			if (find_node(guid) != clone.get())
+				++*errors;
+			for(Canvas::const_iterator j = clone->begin(); j != clone->end(); ++j)
+				if (find_node((*j)->get_guid()) != j->get())
+					++*errors;
+		}
+		if (find_node(guid))
+			++*errors;
+	}
+}
+
+static bool
+measure(int threads, int groups, int layers, int iterations)
+{
+	// every thread clones its own canvas
+	std::vector<Canvas::Handle> roots, canvases;
+	for(int i = 0; i < threads; ++i) {
+		roots.push_back(Canvas::create());
+		canvases.push_back(build_canvas(roots.back(), groups, layers));
+	}
+
+	std::atomic<int> errors(0);
+	synfig::clock timer;
+	std::vector<std::thread> pool;
+	for(int i = 0; i < threads; ++i)
+		pool.push_back(std::thread(clone_and_destroy, canvases[i], iterations, &errors));
+	for(std::vector<std::thread>::iterator i = pool.begin(); i != pool.end(); ++i)
+		i->join();
+	float t = timer();
+
+	// canvas, groups, their canvases, layers and value nodes
+	long long nodes = (long long)threads*iterations*(1 + 2*groups + 2*groups*layers);
+	fprintf(stderr, "threads=%2d groups=%3d layers=%3d: clones=%d time=%f milliseconds (%f microseconds per node)\n",
+		threads, groups, layers, threads*iterations, t*1000, t*1000000/nodes);
+
+	if (errors) {
+		fprintf(stderr, "  failed: %d nodes are not found (or not removed) in the global node map\n", (int)errors);
+		return false;
+	}
+	return true;
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int /* argc */, char **argv)
+{
+	synfig::Main synfig_main(etl::dirname(argv[0]));
+
+	int max_threads = std::max(2, (int)std::thread::hardware_concurrency());
+
+	int error = 0;
+	for(int threads = 1; threads <= max_threads; threads *= 2) {
+		if (!measure(threads, 10, 100, 20)) ++error;
+		if (!measure(threads, 100, 2, 100)) ++error;
+	}
+
+	return error;
+}
@@ -0,0 +1,149 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file benchmark_gamma.cpp
+**	\brief Compares gamma correction by PowTable with powf()
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <synfig/clock.h>
+#include <synfig/color.h>
+#include <synfig/rendering/software/function/powtable.h>
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+using namespace rendering;
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Error bound documented in PowTable
+static double
+max_relative_error(double gamma)
+	{ return 7.7e-6*std::fabs(gamma*(gamma - 1.0)) + 1e-6; }
+
+//! Checks all values with the step of 'step' floats in range (-4, 4)
+static bool
+check_accuracy(ColorReal gamma, int step)
+{
+	software::PowTable pow(gamma);
+	double max_error = 0.0, max_error_x = 0.0;
+	uint32_t max_bits;
+	ColorReal max_x = 4.0;
+	memcpy(&max_bits, &max_x, sizeof(max_bits));
+
+	for(uint32_t bits = 0; bits < max_bits; bits += step)
+		for(int sign = -1; sign <= 1; sign += 2)
+		{
+			ColorReal x;
+			memcpy(&x, &bits, sizeof(x));
+			x *= sign;
+			double expected = (x < 0 ? -1.0 : 1.0)*std::pow(std::fabs(double(x)), double(gamma));
+			double actual = pow(x);
+			if (expected == 0.0 || !std::isnormal(float(expected)))
+				continue; // underflow
+			double error = std::fabs(actual - expected)/std::fabs(expected);
+			if (error > max_error)
+				{ max_error = error; max_error_x = x; }
+		}
+
+	bool success = max_error <= max_relative_error(gamma);
+	fprintf(stderr, "gamma=%8f: max relative error=%e at x=%e (bound %e)%s\n",
+		gamma, max_error, max_error_x, max_relative_error(gamma), success ? "" : " failed");
+	return success;
+}
+
+//! Same channels which TaskPixelGammaSW processes
+template<typename Func>
+static float
+measure(std::vector<Color> &dst, const std::vector<Color> &src, const Func &func)
+{
+	synfig::clock timer;
+	for(size_t i = 0; i < src.size(); ++i)
+	{
+		dst[i].set_r(func(0, src[i].get_r()));
+		dst[i].set_g(func(1, src[i].get_g()));
+		dst[i].set_b(func(2, src[i].get_b()));
+		dst[i].set_a(src[i].get_a());
+	}
+	return timer();
+}
+
+struct ExactFunc
+{
+	Gamma gamma;
+	explicit ExactFunc(const Gamma &gamma): gamma(gamma) { }
+	ColorReal operator()(int channel, ColorReal x) const
+		{ return gamma.apply(channel, x); }
+};
+
+struct TableFunc
+{
+	software::PowTable pow[3];
+	explicit TableFunc(const Gamma &gamma)
+		{ for(int i = 0; i < 3; ++i) pow[i] = software::PowTable(gamma.get(i)); }
+	ColorReal operator()(int channel, ColorReal x) const
+		{ return pow[channel](x); }
+};
+
+//! 4K frame, 'hdr' is the part of the values out of range [0, 1]
+static void
+run_benchmark(const Gamma &gamma, double hdr)
+{
+	const int width = 3840, height = 2160;
+	std::vector<Color> src(width*height), dst(width*height);
+	srand(0);
+	ColorReal *channels = (ColorReal*)&src.front();
+	for(ColorReal *c = channels, *end = c + 4*src.size(); c < end; ++c)
+	{
+		*c = ColorReal(rand())/ColorReal(RAND_MAX);
+		if (rand() < hdr*RAND_MAX) *c *= 16;
+	}
+
+	float exact = measure(dst, src, ExactFunc(gamma));
+	float table = measure(dst, src, TableFunc(gamma));
+	fprintf(stderr, "4K frame, gamma=%f, out of range values=%3d%%: powf %8.3f ms, table %8.3f ms, speedup %5.2f\n",
+		gamma.get(), int(hdr*100 + 0.5), exact*1000, table*1000, exact/table);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main()
+{
+	int error = 0;
+
+	const ColorReal gammas[] = { 1/2.2, 2.2, 0.125, 0.5, 1.5, 3.0, 8.0 };
+	for(int i = 0; i < (int)(sizeof(gammas)/sizeof(gammas[0])); ++i)
+		if (!check_accuracy(gammas[i], 7)) ++error;
+
+	run_benchmark(Gamma(2.2), 0.0);
+	run_benchmark(Gamma(1/2.2, 1/2.0, 1/1.8), 0.0);
+	run_benchmark(Gamma(2.2), 0.1);
+
+	return error;
+}
@@ -0,0 +1,162 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file benchmark_loadcanvas.cpp
+**	\brief Compares streaming and DOM loading of sif files
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <ETL/stringf>
+
+#include <synfig/clock.h>
+#include <synfig/filesystemnative.h>
+#include <synfig/loadcanvas.h>
+#include <synfig/main.h>
+#include <synfig/savecanvas.h>
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+static void
+find_files(const String &dir, std::vector<String> &files)
+{
+	FileSystem::FileList list;
+	FileSystemNative::instance()->directory_scan(dir, list);
+	for(const String &name : list) {
+		String path = dir + "/" + name;
+		if (FileSystemNative::instance()->is_directory(path))
+			find_files(path, files);
+		else
+		if (etl::filename_extension(path) == ".sif" || etl::filename_extension(path) == ".sifz")
+			files.push_back(path);
+	}
+}
+
+static Canvas::Handle
+load(const String &filename, bool streaming, String &errors)
+{
+	CanvasParser parser;
+	parser.set_allow_errors(true).set_streaming(streaming);
+	Canvas::Handle canvas = parser.parse_from_file_as(
+		FileSystemNative::instance()->get_identifier(filename), filename, errors );
+	errors += parser.get_errors_text() + parser.get_warnings_text();
+	return canvas;
+}
+
+//! Loads file in both modes and compares saved canvases and reported errors
+static bool
+check_same(const String &filename)
+{
+	String dom_errors, stream_errors, dom_text, stream_text;
+
+	// canvases must be released before the next load, loaded canvases are cached by the parser
+	if (Canvas::Handle canvas = load(filename, false, dom_errors))
+		dom_text = canvas_to_string(canvas);
+	if (Canvas::Handle canvas = load(filename, true, stream_errors))
+		stream_text = canvas_to_string(canvas);
+
+	if (dom_text != stream_text || dom_errors != stream_errors) {
+		fprintf(stderr, "%s: streaming result differs from DOM result\n", filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+//! Loads all files, prints time and peak memory
+static void
+measure(const std::vector<String> &files, bool streaming)
+{
+	synfig::clock timer;
+	for(const String &filename : files) {
+		String errors;
+		load(filename, streaming, errors);
+	}
+	float t = timer();
+
+	long max_rss = 0;
+#ifndef _WIN32
+	struct rusage usage;
+	if (!getrusage(RUSAGE_SELF, &usage))
+		max_rss = usage.ru_maxrss;
+#endif
+
+	fprintf(stderr, "%s: files=%zu time=%f milliseconds peak_rss=%ld KiB\n",
+		streaming ? "streaming" : "dom", files.size(), t*1000, max_rss);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int argc, char **argv)
+{
+	std::vector<String> dirs(argv + 1, argv + argc);
+	if (dirs.empty())
+		if (const char *s = getenv("SYNFIG_EXAMPLES_DIR"))
+			dirs.push_back(s);
+	if (dirs.empty()) {
+		fprintf(stderr, "usage: %s <directory with sif files>\n", argv[0]);
+		return 1;
+	}
+
+	synfig::Main synfig_main(etl::dirname(argv[0]));
+
+	std::vector<String> files;
+	for(const String &dir : dirs)
+		find_files(dir, files);
+
+	// measure before anything is loaded into this process
+	for(int streaming = 0; streaming <= 1; ++streaming) {
+#ifndef _WIN32
+		// separate process for each mode, otherwise peak RSS of the second mode is hidden by the first one
+		fflush(stderr);
+		pid_t pid = fork();
+		if (pid == 0) {
+			measure(files, streaming);
+			fflush(stderr);
+			_exit(0);
+		}
+		if (pid > 0)
+			waitpid(pid, nullptr, 0);
+#else
+		measure(files, streaming);
+#endif
+	}
+
+	int error = 0;
+	for(const String &filename : files)
+		if (!check_same(filename))
+			++error;
+
+	return error;
+}
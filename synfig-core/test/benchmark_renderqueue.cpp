@@ -0,0 +1,277 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file benchmark_renderqueue.cpp
+**	\brief Runs synthetic task graphs through rendering::RenderQueue
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include <glib.h>
+
+#include <synfig/clock.h>
+#include <synfig/rendering/renderqueue.h>
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+using namespace rendering;
+
+/* === C L A S S E S ======================================================= */
+
+struct Stats
+{
+	std::atomic<int> tasks_run;
+	std::atomic<int> order_errors;
+	Stats(): tasks_run(0), order_errors(0) { }
+};
+
+//! Spends some time and checks that its inputs are done before it
+class TaskSynthetic: public Task
+{
+public:
+	typedef etl::handle<TaskSynthetic> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	//! deps are cleared by queue before run, so they are duplicated here
+	std::vector<Handle> inputs;
+	int work;
+	Stats *stats;
+	//! if set, task must not start before 'after_count' tasks of 'after' are run
+	const Stats *after;
+	int after_count;
+	//! if set, task waits until it becomes true
+	const std::atomic<bool> *latch;
+	mutable std::atomic<bool> started;
+	mutable std::atomic<bool> finished;
+
+	TaskSynthetic(): work(), stats(), after(), after_count(), latch(), started(false), finished(false) { }
+
+	TaskSynthetic& operator=(const TaskSynthetic &other)
+	{
+		*(Task*)(this) = other;
+		inputs = other.inputs;
+		work = other.work;
+		stats = other.stats;
+		after = other.after;
+		after_count = other.after_count;
+		latch = other.latch;
+		started = other.started.load();
+		finished = other.finished.load();
+		return *this;
+	}
+
+	virtual bool run(RunParams & /* params */) const
+	{
+		started = true;
+		if (latch)
+			while(!*latch)
+				std::this_thread::yield();
+
+		for(std::vector<Handle>::const_iterator i = inputs.begin(); i != inputs.end(); ++i)
+			if (!(*i)->finished)
+				++stats->order_errors;
+		if (after && after->tasks_run < after_count)
+			++stats->order_errors;
+
+		volatile unsigned int x = 1;
+		for(int i = 0; i < work; ++i)
+			x = x*1103515245u + 12345u;
+
+		finished = true;
+		++stats->tasks_run;
+		return true;
+	}
+};
+
+Task::Token TaskSynthetic::token(
+	DescSpecial<TaskSynthetic>("Synthetic") );
+
+/* === P R O C E D U R E S ================================================= */
+
+static void
+add_dep(const Task::Handle &task, const TaskSynthetic::Handle &dep)
+{
+	task->renderer_data.deps.insert(dep);
+	dep->renderer_data.back_deps.insert(task);
+	if (TaskSynthetic::Handle synthetic = TaskSynthetic::Handle::cast_dynamic(task))
+		synthetic->inputs.push_back(dep);
+}
+
+//! Every task of layer depends on up to 'links' random tasks of the previous layer,
+//! all tasks are deps of the finish event
+static Task::List
+build_graph(int width, int depth, int links, int work, Stats &stats, const TaskEvent::Handle &event)
+{
+	static int last_batch_index = 0;
+	++last_batch_index;
+
+	Task::List list;
+	std::vector<TaskSynthetic::Handle> prev, layer;
+	for(int d = 0; d < depth; ++d) {
+		layer.clear();
+		for(int w = 0; w < width; ++w) {
+			TaskSynthetic::Handle task(new TaskSynthetic());
+			task->work = work;
+			task->stats = &stats;
+			for(int l = 0; l < links && !prev.empty(); ++l)
+				add_dep(task, prev[rand() % prev.size()]);
+			add_dep(event, task);
+			// Renderer::enqueue() does the same
+			task->renderer_data.batch_index = last_batch_index;
+			task->renderer_data.priority_event = event.get();
+			layer.push_back(task);
+			list.push_back(task);
+		}
+		prev.swap(layer);
+	}
+	event->renderer_data.priority_event = event.get();
+	list.push_back(event);
+	return list;
+}
+
+static bool
+run_graph(RenderQueue &queue, int width, int depth, int links, int work)
+{
+	Stats stats;
+	TaskEvent::Handle event(new TaskEvent());
+	Task::List list = build_graph(width, depth, links, work, stats, event);
+
+	synfig::clock timer;
+	queue.enqueue(list, Task::RunParams());
+	event->wait();
+	float t = timer();
+
+	int count = width*depth;
+	fprintf(stderr, "width=%5d depth=%5d links=%d work=%6d: tasks=%d time=%f milliseconds (%f microseconds per task)\n",
+		width, depth, links, work, count, t*1000, t*1000000/count);
+
+	if (!event->is_done() || stats.tasks_run != count || stats.order_errors) {
+		fprintf(stderr, "  failed: done=%d tasks run=%d order errors=%d\n",
+			(int)event->is_done(), (int)stats.tasks_run, (int)stats.order_errors);
+		return false;
+	}
+	return true;
+}
+
+//! Tasks of the cancelled graph must not block the next graphs
+static bool
+run_cancelled_graph(RenderQueue &queue)
+{
+	// skipped tasks are released later, so stats must stay alive
+	static Stats stats;
+	TaskEvent::Handle event(new TaskEvent());
+	Task::List list = build_graph(16, 64, 2, 10000, stats, event);
+	queue.enqueue(list, Task::RunParams());
+	queue.cancel(event);
+	event->wait();
+	if (!event->is_cancelled()) {
+		fprintf(stderr, "cancelled graph: event is not cancelled\n");
+		return false;
+	}
+	return run_graph(queue, 16, 16, 2, 100);
+}
+
+//! Background graph is enqueued first (older batches go first by default),
+//! but tasks of the urgent one must be run before it.
+//! Queue has the only worker, which is held by latch until both graphs are enqueued,
+//! so the order of tasks does not depend on timing.
+static bool
+run_prioritized_graphs(bool reprioritize)
+{
+	g_setenv("SYNFIG_RENDERING_THREADS", "1", TRUE);
+	RenderQueue queue;
+	g_unsetenv("SYNFIG_RENDERING_THREADS");
+
+	std::atomic<bool> released(false);
+	Stats latch_stats;
+	TaskEvent::Handle latch_event(new TaskEvent());
+	Task::List latch_list = build_graph(1, 1, 0, 0, latch_stats, latch_event);
+	TaskSynthetic::Handle::cast_dynamic(latch_list.front())->latch = &released;
+	queue.enqueue(latch_list, Task::RunParams());
+	while(!TaskSynthetic::Handle::cast_dynamic(latch_list.front())->started)
+		std::this_thread::yield();
+
+	Stats background_stats, urgent_stats;
+	TaskEvent::Handle background(new TaskEvent());
+	TaskEvent::Handle urgent(new TaskEvent());
+	if (!reprioritize)
+		urgent->set_priority(1);
+
+	const int urgent_width = 4, urgent_depth = 4;
+	Task::List background_list = build_graph(64, 32, 2, 1000, background_stats, background);
+	Task::List urgent_list = build_graph(urgent_width, urgent_depth, 2, 1000, urgent_stats, urgent);
+	for(Task::List::const_iterator i = background_list.begin(); i != background_list.end(); ++i)
+		if (TaskSynthetic::Handle task = TaskSynthetic::Handle::cast_dynamic(*i)) {
+			task->after = &urgent_stats;
+			task->after_count = urgent_width*urgent_depth;
+		}
+
+	queue.enqueue(background_list, Task::RunParams());
+	queue.enqueue(urgent_list, Task::RunParams());
+	if (reprioritize)
+		queue.set_priority(urgent, 1);
+	released = true;
+
+	latch_event->wait();
+	urgent->wait();
+	background->wait();
+
+	fprintf(stderr, "%s: background tasks run before urgent graph is finished: %d\n",
+		reprioritize ? "reprioritized" : "prioritized",
+		(int)background_stats.order_errors);
+	return urgent->is_done() && background->is_done()
+	    && !urgent_stats.order_errors && !background_stats.order_errors;
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main()
+{
+	RenderQueue queue;
+	fprintf(stderr, "threads: %d\n", queue.get_threads_count());
+
+	int error = 0;
+
+	// many small tasks, dependencies bound the parallelism
+	if (!run_graph(queue, 1, 2000, 1, 100)) ++error;
+	if (!run_graph(queue, 8, 250, 2, 100)) ++error;
+	if (!run_graph(queue, 64, 32, 2, 100)) ++error;
+	if (!run_graph(queue, 2000, 1, 0, 100)) ++error;
+	if (!run_graph(queue, 20000, 1, 0, 100)) ++error;
+
+	// heavier tasks
+	if (!run_graph(queue, 64, 32, 3, 10000)) ++error;
+	if (!run_graph(queue, 512, 4, 3, 10000)) ++error;
+
+	if (!run_cancelled_graph(queue)) ++error;
+
+	if (!run_prioritized_graphs(false)) ++error;
+	if (!run_prioritized_graphs(true)) ++error;
+
+	return error;
+}
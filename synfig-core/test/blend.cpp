@@ -0,0 +1,159 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file blend.cpp
+**	\brief Test software blend row functions
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cmath>
+#include <vector>
+
+#include <synfig/general.h>
+#include <synfig/rendering/software/function/blend.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+using namespace synfig::rendering::software;
+
+/* === P R O C E D U R E S ================================================= */
+
+static const ColorReal amounts[] = { 1.0, 0.5, 0.25, 0.0, -0.5, 1.5 };
+
+static std::vector<Color>
+make_row(int count, unsigned int seed)
+{
+	std::vector<Color> row(count);
+	for(int i = 0; i < count; ++i) {
+		// values slightly out of [0, 1] range and zero alpha are included
+		seed = seed*1103515245 + 12345;
+		ColorReal r = ColorReal((seed >> 8) % 1400)/1000 - 0.2;
+		seed = seed*1103515245 + 12345;
+		ColorReal g = ColorReal((seed >> 8) % 1400)/1000 - 0.2;
+		seed = seed*1103515245 + 12345;
+		ColorReal b = ColorReal((seed >> 8) % 1400)/1000 - 0.2;
+		seed = seed*1103515245 + 12345;
+		ColorReal a = i % 7 == 0 ? 0.0 : ColorReal((seed >> 8) % 1000)/1000;
+		row[i] = Color(r, g, b, a);
+	}
+	return row;
+}
+
+static bool
+same_color(const Color &a, const Color &b)
+{
+	// both NaN is fine, some of blend methods are not defined for invalid input
+	return (a.get_r() == b.get_r() || (std::isnan(a.get_r()) && std::isnan(b.get_r())))
+		&& (a.get_g() == b.get_g() || (std::isnan(a.get_g()) && std::isnan(b.get_g())))
+		&& (a.get_b() == b.get_b() || (std::isnan(a.get_b()) && std::isnan(b.get_b())))
+		&& (a.get_a() == b.get_a() || (std::isnan(a.get_a()) && std::isnan(b.get_a())));
+}
+
+static void
+check_row_func(bool reference)
+{
+	const int count = 1000;
+	const std::vector<Color> src = make_row(count, 1);
+	const std::vector<Color> dest = make_row(count, 2);
+
+	for(int method = 0; method < Color::BLEND_END; ++method) {
+		Blend::RowFunc func = reference
+		                    ? Blend::get_reference_row_func(Color::BlendMethod(method))
+		                    : Blend::get_row_func(Color::BlendMethod(method));
+		for(ColorReal amount : amounts) {
+			std::vector<Color> row = dest;
+			func(&row.front(), &src.front(), count, amount);
+			for(int i = 0; i < count; ++i) {
+				Color expected = Color::blend(src[i], dest[i], amount, Color::BlendMethod(method));
+				if (!same_color(expected, row[i])) {
+					ERROR_MESSAGE_TWO_VALUES(
+						strprintf("method %d, amount %f: (%f, %f, %f, %f)", method, amount,
+							expected.get_r(), expected.get_g(), expected.get_b(), expected.get_a()),
+						strprintf("(%f, %f, %f, %f)",
+							row[i].get_r(), row[i].get_g(), row[i].get_b(), row[i].get_a()) )
+				}
+			}
+		}
+	}
+}
+
+void test_reference_row_funcs_match_color_blend()
+{
+	check_row_func(true);
+}
+
+void test_row_funcs_match_color_blend()
+{
+	check_row_func(false);
+}
+
+void test_blend_surface_region()
+{
+	const Color a(0.2, 0.4, 0.6, 0.5);
+	const Color b(1.0, 0.5, 0.0, 0.8);
+
+	synfig::Surface dest(8, 8);
+	synfig::Surface src(4, 4);
+	dest.fill(a);
+	src.fill(b);
+
+	Blend::blend(dest, RectInt(2, 3, 5, 6), src, VectorInt(-1, -2), Color::BLEND_COMPOSITE, 0.5);
+
+	const Color blended = Color::blend(b, a, 0.5, Color::BLEND_COMPOSITE);
+	for(int y = 0; y < 8; ++y)
+		for(int x = 0; x < 8; ++x) {
+			bool inside = x >= 2 && x < 5 && y >= 3 && y < 6;
+			ASSERT(same_color(inside ? blended : a, dest[y][x]));
+		}
+}
+
+void test_fill_surface_region()
+{
+	const Color a(0.2, 0.4, 0.6, 0.5);
+
+	synfig::Surface dest(8, 8);
+	dest.fill(a);
+
+	Blend::fill(dest, RectInt(0, 0, 8, 4), Color(0, 0, 0, 0), Color::BLEND_STRAIGHT, 0.75);
+
+	const Color blended = Color::blend(Color(0, 0, 0, 0), a, 0.75, Color::BLEND_STRAIGHT);
+	for(int y = 0; y < 8; ++y)
+		for(int x = 0; x < 8; ++x)
+			ASSERT(same_color(y < 4 ? blended : a, dest[y][x]));
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_reference_row_funcs_match_color_blend)
+	TEST_FUNCTION(test_row_funcs_match_color_blend)
+	TEST_FUNCTION(test_blend_surface_region)
+	TEST_FUNCTION(test_fill_surface_region)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -0,0 +1,128 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file blur.cpp
+**	\brief Test software blur
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cmath>
+
+#include <synfig/general.h>
+#include <synfig/threadpool.h>
+#include <synfig/rendering/software/function/blur.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+using namespace synfig::rendering;
+
+/* === P R O C E D U R E S ================================================= */
+
+//! types which are processed by the separable passes (box and pattern)
+static const rendering::Blur::Type separable_types[] = {
+	rendering::Blur::BOX,
+	rendering::Blur::CROSS,
+	rendering::Blur::FASTGAUSSIAN,
+	rendering::Blur::GAUSSIAN };
+
+static void
+blur(synfig::Surface &dest, const synfig::Surface &src, rendering::Blur::Type type, Real size)
+{
+	software::Blur::blur(software::Blur::Params(
+		dest, RectInt(0, 0, dest.get_w(), dest.get_h()), src, VectorInt(0, 0),
+		type, Vector(size, size), false, Color::BLEND_COMPOSITE, 1.0 ));
+}
+
+static Real
+max_difference(const Color &a, const Color &b)
+{
+	return std::max(
+		std::max(std::fabs(a.get_r() - b.get_r()), std::fabs(a.get_g() - b.get_g())),
+		std::max(std::fabs(a.get_b() - b.get_b()), std::fabs(a.get_a() - b.get_a())) );
+}
+
+void test_blur_keeps_uniform_surface()
+{
+	const int w = 300, h = 200;
+	const Color color(0.25, 0.5, 0.75, 0.5);
+	synfig::Surface src(w, h);
+	src.fill(color);
+
+	for(int i = 0; i < 4; ++i) {
+		synfig::Surface dest(w, h);
+		dest.fill(Color::alpha());
+		blur(dest, src, separable_types[i], 5.0);
+
+		// borders are not blurred, they have not enough of source pixels
+		int border = software::Blur::get_extra_size(separable_types[i], Vector(5.0, 5.0))[0];
+		for(int y = border; y < h - border; ++y)
+			for(int x = border; x < w - border; ++x)
+				ASSERT(max_difference(color, dest[y][x]) < 1e-4);
+	}
+}
+
+void test_blur_rows_and_columns_are_equal()
+{
+	// columns of surface are not multiple of column block
+	const int w = 333, h = 271;
+	synfig::Surface src(w, h), src_transposed(h, w);
+	unsigned int seed = 3;
+	for(int y = 0; y < h; ++y)
+		for(int x = 0; x < w; ++x) {
+			ColorReal c[4];
+			for(int i = 0; i < 4; ++i) {
+				seed = seed*1103515245 + 12345;
+				c[i] = ColorReal((seed >> 8) % 1000)/999;
+			}
+			src[y][x] = src_transposed[x][y] = Color(c[0], c[1], c[2], c[3]);
+		}
+
+	for(int i = 0; i < 4; ++i) {
+		synfig::Surface dest(w, h), dest_transposed(h, w);
+		dest.fill(Color::alpha());
+		dest_transposed.fill(Color::alpha());
+		blur(dest, src, separable_types[i], 7.0);
+		blur(dest_transposed, src_transposed, separable_types[i], 7.0);
+
+		for(int y = 0; y < h; ++y)
+			for(int x = 0; x < w; ++x)
+				ASSERT(max_difference(dest[y][x], dest_transposed[x][y]) < 1e-4);
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+	ThreadPool::subsys_init();
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_blur_keeps_uniform_surface)
+	TEST_FUNCTION(test_blur_rows_and_columns_are_equal)
+	TEST_SUITE_END()
+
+	ThreadPool::subsys_stop();
+
+	return tst_exit_status;
+}
@@ -0,0 +1,154 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file canvasbinary.cpp
+**	\brief Test .sif to .sifb round trip
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+#include <glib/gstdio.h>
+
+#include <ETL/stringf>
+
+#include <synfig/canvasbinary.h>
+#include <synfig/filesystemnative.h>
+#include <synfig/loadcanvas.h>
+#include <synfig/main.h>
+#include <synfig/savecanvas.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Files are copied, so files referenced by examples (like logo.sif) are found next to them
+static const char *work_dir = "test_canvasbinary_files";
+
+static String examples_dir;
+
+static std::vector<String>
+copy_examples()
+{
+	std::vector<String> files;
+	FileSystem::FileList list;
+	ASSERT(FileSystemNative::instance()->directory_scan(examples_dir, list));
+	g_mkdir_with_parents(work_dir, 0755);
+	for(const String &name : list) {
+		if (etl::filename_extension(name) != ".sif")
+			continue;
+		std::ifstream src((examples_dir + "/" + name).c_str(), std::ios::binary);
+		std::ofstream dst((String(work_dir) + "/" + name).c_str(), std::ios::binary);
+		dst << src.rdbuf();
+		ASSERT(dst.good());
+		files.push_back(String(work_dir) + "/" + name);
+	}
+	ASSERT(!files.empty());
+	return files;
+}
+
+static Canvas::Handle
+load(const String &filename)
+{
+	CanvasParser parser;
+	parser.set_allow_errors(true);
+	String errors;
+	return parser.parse_from_file_as(
+		FileSystemNative::instance()->get_identifier(filename), filename, errors );
+}
+
+static void
+test_examples_round_trip()
+{
+	std::vector<String> files = copy_examples();
+
+	size_t values = 0, animated = 0, blines = 0;
+	for(const String &filename : files) {
+		const String binary_filename = etl::filename_sans_extension(filename) + ".sifb";
+
+		// canvases must be released before the next load, loaded canvases are found by GUID
+		String text, binary_text;
+		{
+			Canvas::Handle canvas = load(filename);
+			ASSERT(canvas);
+			text = canvas_to_string(canvas);
+			ASSERT(save_canvas(FileSystemNative::instance()->get_identifier(binary_filename), canvas));
+		}
+		if (Canvas::Handle canvas = load(binary_filename))
+			binary_text = canvas_to_string(canvas);
+		if (text != binary_text)
+			fprintf(stderr, "%s: canvas loaded from .sifb differs from .sif\n", filename.c_str());
+		ASSERT(text == binary_text);
+
+		CanvasBinary binary;
+		ASSERT(binary.open(FileSystemNative::instance()->get_identifier(binary_filename)));
+		for(uint32_t i = 0; i < binary.get_node_count(); ++i) {
+			switch(binary.get_node(i).type) {
+			case CanvasBinary::NODE_VALUE:    ++values;   break;
+			case CanvasBinary::NODE_ANIMATED: ++animated; break;
+			case CanvasBinary::NODE_BLINE:    ++blines;   break;
+			}
+		}
+		binary.close();
+
+		g_unlink(binary_filename.c_str());
+	}
+
+	// typed records are really used
+	ASSERT(values > 0);
+	ASSERT(animated > 0);
+	ASSERT(blines > 0);
+
+	for(const String &filename : files)
+		g_unlink(filename.c_str());
+	g_rmdir(work_dir);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int argc, char **argv)
+{
+	if (argc > 1)
+		examples_dir = argv[1];
+	else
+	if (const char *s = getenv("SYNFIG_EXAMPLES_DIR"))
+		examples_dir = s;
+	if (examples_dir.empty()) {
+		fprintf(stderr, "usage: %s <examples directory>\n", argv[0]);
+		return 1;
+	}
+
+	synfig::Main synfig_main(etl::dirname(argv[0]));
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_examples_round_trip)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
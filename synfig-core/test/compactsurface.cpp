@@ -0,0 +1,265 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file compactsurface.cpp
+**	\brief Test compact pixel formats of intermediate surfaces
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cmath>
+
+#include <ETL/stringf>
+
+#include <synfig/main.h>
+#include <synfig/rendering/common/optimizer/optimizersurfacecompact.h>
+#include <synfig/rendering/common/task/taskblend.h>
+#include <synfig/rendering/common/task/tasksurfaceconvert.h>
+#include <synfig/rendering/software/function/compactsurface.h>
+#include <synfig/rendering/software/surfaceswcompact.h>
+#include <synfig/rendering/software/task/tasksw.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+using namespace synfig::rendering;
+using namespace synfig::rendering::software;
+
+/* === P R O C E D U R E S ================================================= */
+
+static float
+half_round_trip(float x)
+	{ return PixelHalf::unpack(PixelHalf::pack(x)); }
+
+static void
+test_half_exact_values()
+{
+	ASSERT_EQUAL(0x0000, PixelHalf::pack(0.f));
+	ASSERT_EQUAL(0x3c00, PixelHalf::pack(1.f));
+	ASSERT_EQUAL(0xb800, PixelHalf::pack(-0.5f));
+	ASSERT_EQUAL(0x4100, PixelHalf::pack(2.5f));
+	ASSERT_EQUAL(0x7bff, PixelHalf::pack(65504.f));
+	ASSERT_EQUAL(0x0400, PixelHalf::pack(std::ldexp(1.f, -14)));
+
+	ASSERT_EQUAL(1.f, half_round_trip(1.f));
+	ASSERT_EQUAL(-0.5f, half_round_trip(-0.5f));
+	ASSERT_EQUAL(2.5f, half_round_trip(2.5f));
+	ASSERT_EQUAL(65504.f, half_round_trip(65504.f));
+}
+
+static void
+test_half_every_value_round_trips()
+{
+	// covers denormals, negatives and infinities
+	for(int i = 0; i < 0x10000; ++i) {
+		uint16_t h = uint16_t(i);
+		float f = PixelHalf::unpack(h);
+		if (std::isnan(f)) {
+			ASSERT(std::isnan(PixelHalf::unpack(PixelHalf::pack(f))));
+			continue;
+		}
+		ASSERT_EQUAL(h, PixelHalf::pack(f));
+	}
+}
+
+static void
+test_half_rounding_error()
+{
+	// normal numbers keep 11 significant bits
+	for(float x = std::ldexp(1.f, -14); x < 65504.f; x *= 1.001f) {
+		ASSERT(std::fabs(half_round_trip(x) - x) <= x*std::ldexp(1.f, -11));
+		ASSERT(std::fabs(half_round_trip(-x) + x) <= x*std::ldexp(1.f, -11));
+	}
+
+	// denormals have the fixed step 2^-24
+	for(float x = 0.f; x < std::ldexp(1.f, -14); x += std::ldexp(1.f, -30))
+		ASSERT(std::fabs(half_round_trip(x) - x) <= std::ldexp(1.f, -25));
+	ASSERT_EQUAL(std::ldexp(1.f, -24), half_round_trip(std::ldexp(1.f, -24)));
+}
+
+static void
+test_half_special_values()
+{
+	// float denormals are too small for half, sign is kept
+	ASSERT_EQUAL(0x0000, PixelHalf::pack(1e-40f));
+	ASSERT_EQUAL(0x8000, PixelHalf::pack(-1e-40f));
+
+	// too big values become infinities
+	ASSERT_EQUAL(0x7c00, PixelHalf::pack(70000.f));
+	ASSERT_EQUAL(0xfc00, PixelHalf::pack(-70000.f));
+	ASSERT(std::isinf(half_round_trip(INFINITY)));
+	ASSERT(half_round_trip(-INFINITY) < 0.f);
+
+	ASSERT(std::isnan(half_round_trip(NAN)));
+}
+
+static void
+test_half_color()
+{
+	Color c(0.25f, 1.5f, -0.75f, 0.5f);
+	Color d = PixelHalf::encode(c).decode();
+	ASSERT_EQUAL(c.get_r(), d.get_r());
+	ASSERT_EQUAL(c.get_g(), d.get_g());
+	ASSERT_EQUAL(c.get_b(), d.get_b());
+	ASSERT_EQUAL(c.get_a(), d.get_a());
+}
+
+static void
+test_uint8_rounding_error()
+{
+	const float max_error = 0.5f/255.f + 1e-6f;
+	for(int i = 0; i <= 1000; ++i) {
+		float x = i/1000.f;
+		Color d = PixelUInt8::encode(Color(x, 1.f - x, x*x, 1.f)).decode();
+		ASSERT(std::fabs(d.get_r() - x) <= max_error);
+		ASSERT(std::fabs(d.get_g() - (1.f - x)) <= max_error);
+		ASSERT(std::fabs(d.get_b() - x*x) <= max_error);
+		ASSERT_EQUAL(1.f, d.get_a());
+	}
+
+	// every byte value round-trips
+	for(int i = 0; i < 256; ++i)
+		ASSERT_EQUAL(i, (int)PixelUInt8::pack(PixelUInt8::unpack(uint8_t(i))));
+}
+
+static void
+test_uint8_special_values()
+{
+	// values are clamped to [0, 1]
+	Color d = PixelUInt8::encode(Color(2.f, -1.f, 1e-40f, 3.f)).decode();
+	ASSERT_EQUAL(1.f, d.get_r());
+	ASSERT_EQUAL(0.f, d.get_g());
+	ASSERT_EQUAL(0.f, d.get_b());
+	ASSERT_EQUAL(1.f, d.get_a());
+
+	// NaN becomes zero
+	ASSERT_EQUAL(0, (int)PixelUInt8::pack(NAN));
+	d = PixelUInt8::encode(Color(NAN, 0.5f, 0.5f, 1.f)).decode();
+	ASSERT_EQUAL(0.f, d.get_r());
+	d = PixelUInt8::encode(Color(0.5f, 0.5f, 0.5f, NAN)).decode();
+	ASSERT_EQUAL(0.f, d.get_a());
+
+	// transparent pixel has no color
+	d = PixelUInt8::encode(Color(1.f, 1.f, 1.f, -1.f)).decode();
+	ASSERT_EQUAL(0.f, d.get_r());
+	ASSERT_EQUAL(0.f, d.get_a());
+}
+
+//! Software task which writes into its own surface
+static Task::Handle
+create_task(int size)
+{
+	TaskBlend blend;
+	blend.target_surface = new SurfaceResource();
+	blend.target_surface->create(size, size);
+	blend.target_rect = RectInt(0, 0, size, size);
+	blend.source_rect = Rect(0.0, 0.0, 1.0, 1.0);
+	Task::Handle task = blend.convert_to(TaskSW::mode_token.handle());
+	ASSERT(task);
+	ASSERT(task->is_valid());
+	return task;
+}
+
+//! Runs optimizer for list [a, b, blend(a, b)] and counts inserted conversions
+static int
+count_conversions(int size_a, int size_b)
+{
+	Task::Handle a = create_task(size_a);
+	Task::Handle b = create_task(size_b);
+	Task::Handle blend = create_task(256);
+	blend->sub_task(0) = a;
+	blend->sub_task(1) = b;
+
+	Task::List list;
+	list.push_back(a);
+	list.push_back(b);
+	list.push_back(blend);
+
+	OptimizerSurfaceCompact optimizer(SurfaceSWHalf::token.handle());
+	optimizer.run(Optimizer::RunParams(Optimizer::CATEGORY_ID_LIST, list));
+
+	int count = 0;
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i)
+		if (i->type_is<TaskSurfaceConvert>()) {
+			// conversion goes right after the task which writes the surface
+			ASSERT(i != list.begin());
+			ASSERT((*i)->target_surface == (*(i - 1))->target_surface);
+			ASSERT((*i)->target_surface == b->target_surface);
+			++count;
+		}
+	return count;
+}
+
+static void
+test_optimizer_compacts_eligible_surfaces()
+{
+	// source b of blend is read directly in compact format, source a is not
+	int count = count_conversions(256, 256);
+	ASSERT_EQUAL(1, count);
+}
+
+static void
+test_optimizer_skips_small_surfaces()
+{
+	int count = count_conversions(256, 64);
+	ASSERT_EQUAL(0, count);
+}
+
+static void
+test_optimizer_skips_surfaces_with_other_readers()
+{
+	Task::Handle a = create_task(256);
+	Task::Handle blend = create_task(256);
+	blend->sub_task(0) = a;
+	blend->sub_task(1) = a;
+
+	Task::List list;
+	list.push_back(a);
+	list.push_back(blend);
+
+	OptimizerSurfaceCompact optimizer(SurfaceSWHalf::token.handle());
+	optimizer.run(Optimizer::RunParams(Optimizer::CATEGORY_ID_LIST, list));
+	ASSERT_EQUAL(2u, list.size());
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int, char **argv)
+{
+	synfig::Main synfig_main(etl::dirname(argv[0]));
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_half_exact_values)
+	TEST_FUNCTION(test_half_every_value_round_trips)
+	TEST_FUNCTION(test_half_rounding_error)
+	TEST_FUNCTION(test_half_special_values)
+	TEST_FUNCTION(test_half_color)
+	TEST_FUNCTION(test_uint8_rounding_error)
+	TEST_FUNCTION(test_uint8_special_values)
+	TEST_FUNCTION(test_optimizer_compacts_eligible_surfaces)
+	TEST_FUNCTION(test_optimizer_skips_small_surfaces)
+	TEST_FUNCTION(test_optimizer_skips_surfaces_with_other_readers)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
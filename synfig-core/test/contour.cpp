@@ -0,0 +1,230 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file contour.cpp
+**	\brief Test software contour rasterization
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cmath>
+#include <cstring>
+
+#include <synfig/general.h>
+#include <synfig/threadpool.h>
+#include <synfig/rendering/software/function/contour.h>
+#include <synfig/rendering/software/function/polyspancache.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+using namespace synfig::rendering;
+
+/* === P R O C E D U R E S ================================================= */
+
+//! Star-like outline with many segments, it crosses itself a lot,
+//! rows at the top and at the bottom are empty
+static void
+build_polyspan(Polyspan &polyspan, int w, int h, int segments)
+{
+	unsigned int seed = 5;
+	polyspan.init(RectInt(0, 0, w, h));
+	polyspan.move_to(w/2, h/2);
+	for(int i = 0; i < segments; ++i) {
+		seed = seed*1103515245 + 12345;
+		Real r = (0.05 + 0.25*Real((seed >> 8) % 1000)/1000)*w;
+		polyspan.line_to(w/2 + r*std::cos(i*0.37), h/2 + r*std::sin(i*0.37), 0.25);
+		if (i % 97 == 0)
+			polyspan.cubic_to(w*0.9, h*0.3, w*0.1, h*0.2, w*0.5, h*0.7, 0.25);
+	}
+	polyspan.close();
+}
+
+static void
+check_bands_equal_to_single_pass(bool invert, bool antialias, Contour::WindingStyle winding_style, Color::BlendMethod blend_method)
+{
+	const int w = 512, h = 512;
+	const Color background(0.2, 0.3, 0.4, 0.5);
+	const Color color(1.0, 0.5, 0.25, 1.0);
+
+	synfig::Surface expected(w, h), actual(w, h);
+	expected.fill(background);
+	actual.fill(background);
+
+	Polyspan polyspan;
+	build_polyspan(polyspan, w, h, 4000);
+	polyspan.sort_marks();
+	software::Contour::render_polyspan(expected, polyspan, invert, antialias, winding_style, color, 0.8, blend_method);
+
+	build_polyspan(polyspan, w, h, 4000);
+	ASSERT(polyspan.get_covers().size() > 4*16384); // enough for the four bands at least
+	software::Contour::render_polyspan_bands(actual, polyspan, invert, antialias, winding_style, color, 0.8, blend_method, 4);
+
+	for(int y = 0; y < h; ++y)
+		ASSERT(memcmp(expected[y], actual[y], w*sizeof(Color)) == 0);
+}
+
+void test_render_polyspan_bands_is_equal_to_single_pass()
+{
+	for(int invert = 0; invert < 2; ++invert)
+	for(int antialias = 0; antialias < 2; ++antialias) {
+		check_bands_equal_to_single_pass(invert, antialias, Contour::WINDING_NON_ZERO, Color::BLEND_COMPOSITE);
+		check_bands_equal_to_single_pass(invert, antialias, Contour::WINDING_EVEN_ODD, Color::BLEND_ADD);
+	}
+}
+
+//! Same star in the contour units, first chunk is MOVE
+static void
+build_contour(Contour &contour, int segments)
+{
+	unsigned int seed = 7;
+	contour.move_to(Vector(0, 0));
+	for(int i = 0; i < segments; ++i) {
+		seed = seed*1103515245 + 12345;
+		Real r = 10 + 40*Real((seed >> 8) % 1000)/1000;
+		contour.line_to(Vector(r*std::cos(i*0.37), r*std::sin(i*0.37)));
+		if (i % 31 == 0)
+			contour.cubic_to(Vector(-20, 30), Vector(45, -40), Vector(-35, -10));
+	}
+	contour.close();
+}
+
+static void
+render_contour(synfig::Surface &surface, const Contour &contour, const Matrix &matrix, const RectInt &window, bool invert, bool cached)
+{
+	Polyspan polyspan;
+	polyspan.init(window);
+	if (cached) {
+		software::PolyspanCache::instance().build_polyspan(contour.get_chunks(), matrix, polyspan, 0.5);
+	} else {
+		software::Contour::build_polyspan(contour.get_chunks(), matrix, polyspan, 0.5);
+		polyspan.close();
+	}
+	software::Contour::render_polyspan_bands(
+		surface, polyspan, invert, true, Contour::WINDING_NON_ZERO, Color(1.0, 0.5, 0.25, 1.0), 1.0, Color::BLEND_COMPOSITE, 1 );
+}
+
+static Real
+max_difference(const synfig::Surface &a, const synfig::Surface &b)
+{
+	Real diff = 0;
+	for(int y = 0; y < a.get_h(); ++y)
+		for(int x = 0; x < a.get_w(); ++x)
+		{
+			const Color &ca = a[y][x], &cb = b[y][x];
+			diff = std::max(diff, (Real)std::fabs(ca.get_r() - cb.get_r()));
+			diff = std::max(diff, (Real)std::fabs(ca.get_g() - cb.get_g()));
+			diff = std::max(diff, (Real)std::fabs(ca.get_b() - cb.get_b()));
+			diff = std::max(diff, (Real)std::fabs(ca.get_a() - cb.get_a()));
+		}
+	return diff;
+}
+
+void test_polyspan_cache_is_equal_to_flattening()
+{
+	const int w = 256, h = 256;
+	Contour contour;
+	build_contour(contour, 1000);
+	Matrix matrix;
+	matrix.m00 = 2.5;
+	matrix.m11 = 2.0;
+	matrix.m20 = 120.25;
+	matrix.m21 = 130.5;
+
+	// whole shape, tile on the edge of shape, tile inside of shape
+	const RectInt windows[] = { RectInt(0, 0, w, h), RectInt(150, 60, 240, 140), RectInt(110, 120, 130, 140) };
+	software::PolyspanCache &cache = software::PolyspanCache::instance();
+	cache.clear();
+	software::PolyspanCache::Statistics stats = cache.get_statistics();
+	// contour is not cached in the first frame and it is taken from cache in the second one
+	for(int frame = 0; frame < 2; ++frame) {
+		cache.next_generation();
+		for(int i = 0; i < 3; ++i)
+		for(int invert = 0; invert < 2; ++invert) {
+			synfig::Surface expected(w, h), actual(w, h);
+			expected.fill(Color(0.2, 0.3, 0.4, 0.5));
+			actual.fill(Color(0.2, 0.3, 0.4, 0.5));
+			render_contour(expected, contour, matrix, windows[i], invert, false);
+			render_contour(actual, contour, matrix, windows[i], invert, true);
+			ASSERT(max_difference(expected, actual) < 1e-4);
+		}
+		if (!frame)
+			ASSERT_EQUAL(stats.stores, cache.get_statistics().stores);
+	}
+	ASSERT_EQUAL(stats.stores + 1, cache.get_statistics().stores);
+	ASSERT(cache.get_statistics().hits >= stats.hits + 5);
+}
+
+void test_polyspan_cache_reuses_marks_for_integer_translation()
+{
+	const int w = 256, h = 256;
+	software::PolyspanCache &cache = software::PolyspanCache::instance();
+	Contour contour;
+	build_contour(contour, 200);
+
+	cache.clear();
+	software::PolyspanCache::Statistics stats = cache.get_statistics();
+	synfig::Surface first(w, h), moved(w, h);
+	first.fill(Color::alpha());
+	moved.fill(Color::alpha());
+	cache.next_generation();
+	render_contour(first, contour, Matrix().set_translate(100.3, 110.7), RectInt(0, 0, w, h), false, true);
+	ASSERT_EQUAL(stats.stores, cache.get_statistics().stores);
+	// contour is seen in the previous frame
+	cache.next_generation();
+	first.fill(Color::alpha());
+	render_contour(first, contour, Matrix().set_translate(100.3, 110.7), RectInt(0, 0, w, h), false, true);
+	ASSERT_EQUAL(stats.stores + 1, cache.get_statistics().stores);
+	render_contour(moved, contour, Matrix().set_translate(107.3, 107.7), RectInt(0, 0, w, h), false, true);
+	ASSERT_EQUAL(stats.lookups + 3, cache.get_statistics().lookups);
+	ASSERT_EQUAL(stats.hits + 1, cache.get_statistics().hits);
+
+	for(int y = 0; y < h - 3; ++y)
+		ASSERT(memcmp(first[y + 3], moved[y] + 7, (w - 7)*sizeof(Color)) == 0);
+
+	// subpixel offset is changed
+	render_contour(moved, contour, Matrix().set_translate(107.4, 107.7), RectInt(0, 0, w, h), false, true);
+	ASSERT_EQUAL(stats.hits + 1, cache.get_statistics().hits);
+
+	// limit of memory
+	size_t max_cached = cache.get_max_cached();
+	cache.set_max_cached(0);
+	ASSERT_EQUAL(size_t(0), cache.get_statistics().bytes_cached);
+	cache.set_max_cached(max_cached);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+	ThreadPool::subsys_init();
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_render_polyspan_bands_is_equal_to_single_pass)
+	TEST_FUNCTION(test_polyspan_cache_is_equal_to_flattening)
+	TEST_FUNCTION(test_polyspan_cache_reuses_marks_for_integer_translation)
+	TEST_SUITE_END()
+
+	ThreadPool::subsys_stop();
+
+	return tst_exit_status;
+}
@@ -0,0 +1,189 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file fft.cpp
+**	\brief Test cache of FFT plans and FFTW wisdom
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cmath>
+#include <vector>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <ETL/stringf>
+
+#include <synfig/angle.h>
+#include <synfig/main.h>
+#include <synfig/rendering/software/function/fft.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+using namespace synfig::rendering;
+using namespace synfig::rendering::software;
+
+/* === P R O C E D U R E S ================================================= */
+
+static const char *wisdom_filename = "test_fft_wisdom";
+
+//! Restarts FFT with the given planner and wisdom file
+static void
+restart(const char *planner, const char *wisdom_file = nullptr)
+{
+	FFT::deinitialize();
+	g_setenv("SYNFIG_FFT_PLANNER", planner, TRUE);
+	g_setenv("SYNFIG_FFT_TIME_LIMIT", "1", TRUE);
+	if (wisdom_file)
+		g_setenv("SYNFIG_FFT_WISDOM_FILE", wisdom_file, TRUE);
+	else
+		g_unsetenv("SYNFIG_FFT_WISDOM_FILE");
+	FFT::initialize();
+}
+
+static std::vector<Complex>
+create_data(int count)
+{
+	std::vector<Complex> data;
+	for(int i = 0; i < count; ++i)
+		data.push_back(Complex(std::sin(0.3*i) + 0.1*i, std::cos(0.7*i)));
+	return data;
+}
+
+//! Direct computation of discrete Fourier transform
+static std::vector<Complex>
+dft(const std::vector<Complex> &data)
+{
+	const int count = (int)data.size();
+	std::vector<Complex> result(count);
+	for(int k = 0; k < count; ++k)
+		for(int i = 0; i < count; ++i)
+			result[k] += data[i]*std::polar(1.0, Real(-2.0*PI*k*i/count));
+	return result;
+}
+
+static Real
+max_difference(const std::vector<Complex> &a, const std::vector<Complex> &b)
+{
+	Real diff = 0.0;
+	for(size_t i = 0; i < a.size(); ++i)
+		diff = std::max(diff, std::abs(a[i] - b[i]));
+	return diff;
+}
+
+static void
+fft(std::vector<Complex> &data, bool invert)
+	{ FFT::fft(Array<Complex, 1>(&data.front(), (int)data.size(), 1), invert); }
+
+static void
+test_plans_are_reused()
+{
+	restart("estimate");
+	ASSERT_EQUAL(0u, FFT::get_plan_count());
+
+	std::vector<Complex> data = create_data(64);
+	const std::vector<Complex> expected = dft(data);
+	const std::vector<Complex> source = data;
+
+	fft(data, false);
+	ASSERT_EQUAL(1u, FFT::get_plan_count());
+	ASSERT(max_difference(expected, data) < 1e-9);
+
+	fft(data, true);
+	ASSERT_EQUAL(2u, FFT::get_plan_count());
+	ASSERT(max_difference(source, data) < 1e-9);
+
+	// the same geometry and direction, other array
+	std::vector<Complex> other = create_data(64);
+	fft(other, false);
+	fft(data, false);
+	ASSERT_EQUAL(2u, FFT::get_plan_count());
+	ASSERT(max_difference(expected, other) < 1e-9);
+	ASSERT(max_difference(expected, data) < 1e-9);
+
+	std::vector<Complex> larger = create_data(128);
+	fft(larger, false);
+	ASSERT_EQUAL(3u, FFT::get_plan_count());
+}
+
+static void
+test_measured_plan_keeps_data()
+{
+	restart("measure");
+
+	// measuring planner must not overwrite the array which is transformed
+	std::vector<Complex> data = create_data(96);
+	const std::vector<Complex> expected = dft(data);
+	fft(data, false);
+	ASSERT(max_difference(expected, data) < 1e-9);
+	ASSERT_EQUAL(1u, FFT::get_plan_count());
+}
+
+static void
+test_wisdom_is_saved_and_loaded()
+{
+	g_unlink(wisdom_filename);
+
+	restart("measure", wisdom_filename);
+	ASSERT_FALSE(FFT::is_wisdom_loaded());
+	std::vector<Complex> data = create_data(80);
+	fft(data, false);
+
+	// wisdom is saved by deinitialize()
+	restart("measure", wisdom_filename);
+	ASSERT(FFT::is_wisdom_loaded());
+	data = create_data(80);
+	const std::vector<Complex> expected = dft(data);
+	fft(data, false);
+	ASSERT(max_difference(expected, data) < 1e-9);
+
+	// estimated plans are not saved
+	restart("estimate");
+	g_unlink(wisdom_filename);
+	restart("estimate", wisdom_filename);
+	fft(data, false);
+	restart("estimate", wisdom_filename);
+	ASSERT_FALSE(FFT::is_wisdom_loaded());
+
+	restart("estimate");
+	g_unlink(wisdom_filename);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int, char **argv)
+{
+	synfig::Main synfig_main(etl::dirname(argv[0]));
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_plans_are_reused)
+	TEST_FUNCTION(test_measured_plan_keeps_data)
+	TEST_FUNCTION(test_wisdom_is_saved_and_loaded)
+	TEST_SUITE_END()
+
+	restart("estimate");
+
+	return tst_exit_status;
+}
@@ -0,0 +1,212 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file framejobs.cpp
+**	\brief Test rendering of frames by worker processes (--frame-jobs)
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <glib/gstdio.h>
+
+#include <ETL/stringf>
+
+#include <synfig/main.h>
+#include <synfig/surface.h>
+#include <synfig/target_scanline.h>
+
+#include <tool/definitions.h>
+#include <tool/framejobs.h>
+#include <tool/job.h>
+#include <tool/optionsprocessor.h>
+#include <tool/synfigtoolexception.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+static const char *sif_filename = "test_framejobs.sif";
+
+static std::string binary_path;
+
+//! Canvas of 6 frames with animated color
+static void
+write_sif()
+{
+	FILE *f = fopen(sif_filename, "w");
+	ASSERT(f);
+	fprintf(f,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<canvas version=\"1.2\" width=\"8\" height=\"8\" xres=\"2834.645669\" yres=\"2834.645669\""
+		" view-box=\"-1 1 1 -1\" antialias=\"1\" fps=\"24\" begin-time=\"0f\" end-time=\"5f\""
+		" bgcolor=\"0.5 0.5 0.5 1\">\n"
+		"  <layer type=\"solid_color\" active=\"true\" version=\"0.1\">\n"
+		"    <param name=\"color\">\n"
+		"      <animated type=\"color\">\n"
+		"        <waypoint time=\"0f\" before=\"linear\" after=\"linear\"><color><r>1</r><g>0</g><b>0</b><a>1</a></color></waypoint>\n"
+		"        <waypoint time=\"5f\" before=\"linear\" after=\"linear\"><color><r>0</r><g>0</g><b>1</b><a>0.5</a></color></waypoint>\n"
+		"      </animated>\n"
+		"    </param>\n"
+		"  </layer>\n"
+		"</canvas>\n" );
+	fclose(f);
+}
+
+//! Keeps the frames and the number of the current frame at the end of every frame
+class RecordingTarget : public Target_Scanline
+{
+	synfig::Surface surface;
+
+public:
+	std::vector<synfig::Surface> frames;
+	std::vector<int> frame_numbers;
+
+	virtual bool start_frame(ProgressCallback* /*cb*/)
+	{
+		surface.set_wh(desc.get_w(), desc.get_h());
+		return true;
+	}
+
+	virtual void end_frame()
+	{
+		frames.push_back(surface);
+		frame_numbers.push_back(curr_frame_);
+	}
+
+	virtual Color* start_scanline(int scanline)
+		{ return surface[scanline]; }
+
+	virtual bool end_scanline()
+		{ return true; }
+};
+
+//! Job created from the command line, like synfig tool does
+static Job
+create_job(const etl::handle<RecordingTarget> &target)
+{
+	std::vector<std::string> args;
+	args.push_back(binary_path);
+	args.push_back(sif_filename);
+	args.push_back("-t");
+	args.push_back("null");
+
+	SynfigCommandLineParser parser;
+	parser.parse(args);
+	Job job = parser.extract_job();
+	job.desc = job.canvas->rend_desc() = parser.extract_renddesc(job.canvas->rend_desc());
+
+	target->set_canvas(job.canvas);
+	target->set_quality(job.quality);
+	target->set_rend_desc(&job.desc);
+	job.target = target;
+	return job;
+}
+
+static bool
+equal(const synfig::Surface &a, const synfig::Surface &b)
+{
+	if (a.get_w() != b.get_w() || a.get_h() != b.get_h())
+		return false;
+	for(int y = 0; y < a.get_h(); ++y)
+		for(int x = 0; x < a.get_w(); ++x)
+			if (a[y][x] != b[y][x])
+				return false;
+	return true;
+}
+
+static void
+test_workers_render_same_frames()
+{
+	write_sif();
+
+	etl::handle<RecordingTarget> single(new RecordingTarget());
+	Job single_job = create_job(single);
+	ASSERT(single->render());
+
+	etl::handle<RecordingTarget> multi(new RecordingTarget());
+	Job multi_job = create_job(multi);
+	multi_job.frame_jobs = 2;
+	ASSERT(can_render_frame_jobs(multi_job));
+	ASSERT(render_frame_jobs(multi_job, nullptr));
+
+	ASSERT_EQUAL(6u, single->frames.size());
+	ASSERT_EQUAL(single->frames.size(), multi->frames.size());
+	for(size_t i = 0; i < single->frames.size(); ++i) {
+		ASSERT(equal(single->frames[i], multi->frames[i]));
+		// targets see the same current frame as when they render by themselves
+		ASSERT_EQUAL(single->frame_numbers[i], multi->frame_numbers[i]);
+	}
+	ASSERT_FALSE(equal(single->frames.front(), single->frames.back()));
+
+	g_unlink(sif_filename);
+}
+
+//! Worker process started by render_frame_jobs(), like synfig tool does with --frame-worker
+static int
+run_worker(int argc, char **argv)
+{
+	try
+	{
+		SynfigCommandLineParser parser;
+		if (!parser.parse(argc, argv))
+			return SYNFIGTOOL_UNKNOWNARGUMENT;
+		parser.process_settings_options();
+
+		synfig::Main synfig_main(etl::dirname(argv[0]));
+		Job job = parser.extract_job();
+		job.desc = job.canvas->rend_desc() = parser.extract_renddesc(job.canvas->rend_desc());
+		if (job.frame_worker <= 0)
+			return SYNFIGTOOL_UNKNOWNARGUMENT;
+		run_frame_worker(job);
+	}
+	catch(SynfigToolException& e)
+	{
+		return e.get_exit_code();
+	}
+	return SYNFIGTOOL_OK;
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int argc, char **argv)
+{
+	SynfigToolGeneralOptions::instance()->set_binary_path(argv[0]);
+	binary_path = argv[0];
+
+	if (argc > 1)
+		return run_worker(argc, argv);
+
+	synfig::Main synfig_main(etl::dirname(argv[0]));
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_workers_render_same_frames)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
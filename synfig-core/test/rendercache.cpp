@@ -0,0 +1,200 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file rendercache.cpp
+**	\brief Test cache of rendered task sub-trees
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <vector>
+
+#include <ETL/stringf>
+
+#include <synfig/canvas.h>
+#include <synfig/context.h>
+#include <synfig/layer.h>
+#include <synfig/main.h>
+#include <synfig/surface.h>
+#include <synfig/valuenodes/valuenode_animated.h>
+#include <synfig/rendering/renderer.h>
+#include <synfig/rendering/resultcache.h>
+#include <synfig/rendering/software/surfacesw.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+using namespace synfig::rendering;
+
+/* === P R O C E D U R E S ================================================= */
+
+static const int size = 128;
+static const size_t cache_memory = 64*1024*1024;
+
+//! Canvas with a static triangle and a triangle moved by animation
+struct Scene
+{
+	Canvas::Handle canvas;
+	Layer::Handle static_layer;
+
+	Scene()
+	{
+		canvas = Canvas::create();
+
+		std::vector<Point> points;
+		points.push_back(Point( 0.0,  1.5));
+		points.push_back(Point(-1.5, -1.0));
+		points.push_back(Point( 1.5, -1.0));
+		ValueBase vector_list = ValueBase(ValueBase::List());
+		vector_list.set_list_of(points);
+
+		static_layer = Layer::create("polygon");
+		static_layer->set_param("vector_list", vector_list);
+		static_layer->set_param("color", Color(1.0, 0.0, 0.0, 1.0));
+		canvas->push_back(static_layer);
+
+		ValueNode_Animated::Handle origin = ValueNode_Animated::create(type_vector);
+		origin->new_waypoint(Time(0), ValueBase(Vector(-0.5, 0.0)));
+		origin->new_waypoint(Time(1), ValueBase(Vector( 0.5, 0.0)));
+
+		Layer::Handle animated_layer = Layer::create("polygon");
+		animated_layer->set_param("vector_list", vector_list);
+		animated_layer->set_param("color", Color(0.0, 0.0, 1.0, 0.5));
+		animated_layer->connect_dynamic_param("origin", ValueNode::LooseHandle(origin));
+		canvas->push_front(animated_layer);
+	}
+
+	synfig::Surface render(Time time) const
+	{
+		canvas->set_time(time);
+		Task::Handle task = canvas->build_rendering_task(ContextParams());
+		ASSERT(task);
+
+		SurfaceResource::Handle surface = new SurfaceResource();
+		surface->create(size, size);
+		task->target_surface = surface;
+		task->target_rect = RectInt(0, 0, size, size);
+		task->source_rect = Rect(-2.0, -2.0, 2.0, 2.0);
+		ASSERT(Renderer::get_renderer("software-preview")->run(task));
+
+		SurfaceResource::LockRead<SurfaceSW> lock(surface);
+		ASSERT(lock);
+		const synfig::Surface &src = lock->get_surface();
+		synfig::Surface result(size, size);
+		for(int y = 0; y < size; ++y)
+			for(int x = 0; x < size; ++x)
+				result[y][x] = src[y][x];
+		return result;
+	}
+
+	//! Renders without cache, cache becomes empty
+	synfig::Surface render_uncached(Time time) const
+	{
+		ResultCache::instance().set_max_cached(0);
+		synfig::Surface result = render(time);
+		ResultCache::instance().set_max_cached(cache_memory);
+		return result;
+	}
+};
+
+static bool
+equal(const synfig::Surface &a, const synfig::Surface &b)
+{
+	for(int y = 0; y < size; ++y)
+		for(int x = 0; x < size; ++x)
+			if (a[y][x] != b[y][x])
+				return false;
+	return true;
+}
+
+static void
+test_cached_frame_equals_uncached()
+{
+	Scene scene;
+	ResultCache &cache = ResultCache::instance();
+	cache.clear();
+	cache.set_max_cached(cache_memory);
+
+	// first frame marks sub-trees as seen, second one stores them, third one takes them from cache
+	std::vector<synfig::Surface> frames;
+	for(int i = 0; i < 3; ++i)
+		frames.push_back(scene.render(Time(0)));
+	ASSERT(cache.get_statistics().stores > 0);
+	ASSERT(cache.get_statistics().hits > 0);
+
+	synfig::Surface uncached = scene.render_uncached(Time(0));
+	for(int i = 0; i < 3; ++i)
+		ASSERT(equal(uncached, frames[i]));
+}
+
+static void
+test_changed_parameter_misses_cache()
+{
+	Scene scene;
+	ResultCache &cache = ResultCache::instance();
+	cache.clear();
+	cache.set_max_cached(cache_memory);
+
+	for(int i = 0; i < 3; ++i)
+		scene.render(Time(0));
+	synfig::Surface before = scene.render(Time(0));
+
+	scene.static_layer->set_param("color", Color(0.0, 1.0, 0.0, 1.0));
+	synfig::Surface after = scene.render(Time(0));
+	ASSERT_FALSE(equal(before, after));
+	ASSERT(equal(scene.render_uncached(Time(0)), after));
+}
+
+static void
+test_changed_time_misses_cache()
+{
+	Scene scene;
+	ResultCache &cache = ResultCache::instance();
+	cache.clear();
+	cache.set_max_cached(cache_memory);
+
+	for(int i = 0; i < 3; ++i)
+		scene.render(Time(0));
+	synfig::Surface before = scene.render(Time(0));
+
+	synfig::Surface after = scene.render(Time(0.5));
+	ASSERT_FALSE(equal(before, after));
+	ASSERT(equal(scene.render_uncached(Time(0.5)), after));
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int, char **argv)
+{
+	synfig::Main synfig_main(etl::dirname(argv[0]));
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_cached_frame_equals_uncached)
+	TEST_FUNCTION(test_changed_parameter_misses_cache)
+	TEST_FUNCTION(test_changed_time_misses_cache)
+	TEST_SUITE_END()
+
+	ResultCache::instance().set_max_cached(0);
+
+	return tst_exit_status;
+}
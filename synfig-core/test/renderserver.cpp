@@ -0,0 +1,173 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file renderserver.cpp
+**	\brief Test protocol of the render server
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <ETL/stringf>
+
+#include <synfig/main.h>
+
+#include <tool/renderserver.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+static const char *sif_filename = "test_renderserver.sif";
+
+static void
+write_sif(int width)
+{
+	FILE *f = fopen(sif_filename, "w");
+	ASSERT(f);
+	fprintf(f,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<canvas version=\"1.2\" width=\"%d\" height=\"8\" xres=\"2834.645669\" yres=\"2834.645669\""
+		" view-box=\"-1 1 1 -1\" antialias=\"1\" fps=\"24\" begin-time=\"0f\" end-time=\"1f\""
+		" bgcolor=\"0.5 0.5 0.5 1\">\n"
+		"  <layer type=\"solid_color\" active=\"true\" version=\"0.1\">\n"
+		"    <param name=\"color\"><color><r>1</r><g>0</g><b>0</b><a>1</a></color></param>\n"
+		"  </layer>\n"
+		"</canvas>\n",
+		width );
+	fclose(f);
+}
+
+//! Serves the lines and returns the answers
+static std::vector<std::string>
+serve(RenderServer &server, const std::string &input)
+{
+	std::vector<std::string> answers;
+	std::istringstream in(input);
+	server.serve(in, [&answers](const std::string &answer) { answers.push_back(answer); });
+	return answers;
+}
+
+static bool
+has_answer(const std::vector<std::string> &answers, const std::string &prefix)
+{
+	for(const std::string &answer : answers)
+		if (answer.compare(0, prefix.size(), prefix) == 0)
+			return true;
+	return false;
+}
+
+static void
+test_server_reuses_loaded_canvas()
+{
+	write_sif(8);
+	const std::string job = std::string(sif_filename) + " -t null\n";
+
+	RenderServer server;
+	std::vector<std::string> answers = serve(server,
+		"# comment\n"
+		"\n"
+		+ job
+		+ job
+		+ "quit\n"
+		+ job );
+
+	ASSERT(has_answer(answers, "job 1 started"));
+	ASSERT(has_answer(answers, "job 1 progress"));
+	ASSERT(has_answer(answers, "job 1 done"));
+	ASSERT(has_answer(answers, "job 2 done"));
+	ASSERT_FALSE(has_answer(answers, "job 3"));
+	ASSERT_FALSE(has_answer(answers, "job 1 failed"));
+
+	ASSERT_EQUAL(2u, server.get_statistics().jobs);
+	ASSERT_EQUAL(1u, server.get_statistics().canvas_loads);
+	ASSERT_EQUAL(1u, server.get_statistics().canvas_reuses);
+
+	g_unlink(sif_filename);
+}
+
+static void
+test_server_reloads_modified_file()
+{
+	write_sif(8);
+	const std::string job = std::string(sif_filename) + " -t null\n";
+
+	RenderServer server;
+	serve(server, job);
+
+	// modification time has the resolution of seconds, so it is moved explicitly
+	write_sif(16);
+	struct utimbuf times;
+	times.actime = times.modtime = 1000000000;
+	ASSERT_EQUAL(0, g_utime(sif_filename, &times));
+
+	std::vector<std::string> answers = serve(server, job);
+	ASSERT(has_answer(answers, "job 2 done"));
+	ASSERT_EQUAL(2u, server.get_statistics().canvas_loads);
+	ASSERT_EQUAL(0u, server.get_statistics().canvas_reuses);
+
+	g_unlink(sif_filename);
+}
+
+static void
+test_server_reports_failed_job()
+{
+	RenderServer server;
+	std::vector<std::string> answers = serve(server,
+		"test_renderserver_missing.sif -t null\n"
+		"test_renderserver_missing.sif -t null\n" );
+
+	ASSERT_EQUAL(2u, answers.size());
+	ASSERT(has_answer(answers, "job 1 failed"));
+	ASSERT(has_answer(answers, "job 2 failed"));
+	ASSERT_EQUAL(0u, server.get_statistics().canvas_loads);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int, char **argv)
+{
+	synfig::Main synfig_main(etl::dirname(argv[0]));
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_server_reuses_loaded_canvas)
+	TEST_FUNCTION(test_server_reloads_modified_file)
+	TEST_FUNCTION(test_server_reports_failed_job)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
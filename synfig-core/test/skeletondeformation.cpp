@@ -0,0 +1,178 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file skeletondeformation.cpp
+**	\brief Test cache of bind pose of Skeleton Deformation layer
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cmath>
+#include <vector>
+
+#include <ETL/stringf>
+
+#include <synfig/bone.h>
+#include <synfig/main.h>
+#include <synfig/layers/layer_skeletondeformation.h>
+
+#include "test_base.h"
+
+/* === M A C R O S ========================================================= */
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+typedef Layer_SkeletonDeformation::BonePair BonePair;
+
+//! Gives access to the deformed mesh
+class TestLayer : public Layer_SkeletonDeformation
+{
+public:
+	typedef etl::handle<TestLayer> Handle;
+	const rendering::Mesh::Handle& get_mesh() const { return mesh; }
+};
+
+static Bone
+create_bone(const Point &origin, const Point &tip, Real depth = 0.0)
+{
+	Bone bone(origin, tip);
+	bone.set_width(0.5);
+	bone.set_tipwidth(0.3);
+	bone.set_depth(depth);
+	return bone;
+}
+
+//! Two bones, the pose of the second one is rotated by \a angle and moved by \a offset
+static ValueBase
+create_bones(Real angle, const Vector &offset, Real rest_length = 2.0, Real depth = 0.0)
+{
+	std::vector<BonePair> pairs;
+
+	Bone rest0 = create_bone(Point(-2.0, 0.0), Point(0.0, 0.0));
+	pairs.push_back(BonePair(rest0, rest0));
+
+	Bone rest1 = create_bone(Point(0.0, 0.0), Point(rest_length, 0.0));
+	Bone pose1 = create_bone(
+		Point(0.0, 0.0) + offset,
+		Point(rest_length*std::cos(angle), rest_length*std::sin(angle)) + offset,
+		depth );
+	pairs.push_back(BonePair(rest1, pose1));
+
+	ValueBase bones;
+	bones.set_list_of(pairs);
+	return bones;
+}
+
+static bool
+equal(const rendering::Mesh &a, const rendering::Mesh &b)
+{
+	if (a.vertices.size() != b.vertices.size() || a.triangles.size() != b.triangles.size())
+		return false;
+	for(size_t i = 0; i < a.vertices.size(); ++i)
+		if ( a.vertices[i].position != b.vertices[i].position
+		  || a.vertices[i].tex_coords != b.vertices[i].tex_coords )
+			return false;
+	for(size_t i = 0; i < a.triangles.size(); ++i)
+		for(int j = 0; j < 3; ++j)
+			if (a.triangles[i].vertices[j] != b.triangles[i].vertices[j])
+				return false;
+	return true;
+}
+
+//! Mesh of the layer which had other bones before equals to mesh built from scratch
+static void
+check_same_as_uncached(const TestLayer::Handle &cached, const ValueBase &bones)
+{
+	rendering::Mesh::Handle before = cached->get_mesh();
+	ASSERT(cached->set_param("bones", bones));
+	ASSERT_FALSE(equal(*before, *cached->get_mesh()));
+
+	TestLayer::Handle uncached(new TestLayer());
+	ASSERT(uncached->set_param("bones", bones));
+	ASSERT(equal(*uncached->get_mesh(), *cached->get_mesh()));
+}
+
+static void
+test_changed_pose_uses_cache()
+{
+	TestLayer::Handle layer(new TestLayer());
+	ASSERT(layer->set_param("bones", create_bones(0.0, Vector())));
+
+	// the rest bones are the same, so the weights are reused
+	check_same_as_uncached(layer, create_bones(0.5, Vector()));
+	check_same_as_uncached(layer, create_bones(0.5, Vector(0.3, -0.2)));
+	check_same_as_uncached(layer, create_bones(-1.0, Vector(0.0, 0.5)));
+}
+
+static void
+test_changed_depth_sorts_triangles()
+{
+	TestLayer::Handle layer(new TestLayer());
+	ASSERT(layer->set_param("bones", create_bones(2.5, Vector(), 2.0, 0.0)));
+
+	// the second bone is folded over the first one, so the order of triangles depends on depth
+	check_same_as_uncached(layer, create_bones(2.5, Vector(), 2.0, 1.0));
+	check_same_as_uncached(layer, create_bones(2.5, Vector(), 2.0, -1.0));
+}
+
+static void
+test_changed_rest_bones_rebuild_cache()
+{
+	TestLayer::Handle layer(new TestLayer());
+	ASSERT(layer->set_param("bones", create_bones(0.5, Vector())));
+
+	check_same_as_uncached(layer, create_bones(0.5, Vector(), 3.0));
+	check_same_as_uncached(layer, create_bones(0.5, Vector(), 1.5));
+}
+
+static void
+test_changed_grid_rebuilds_cache()
+{
+	const ValueBase bones = create_bones(0.5, Vector(0.3, -0.2));
+	TestLayer::Handle cached(new TestLayer());
+	ASSERT(cached->set_param("bones", bones));
+	ASSERT(cached->set_param("x_subdivisions", 16));
+	ASSERT(cached->set_param("point1", Point(-3.0, 3.0)));
+
+	TestLayer::Handle uncached(new TestLayer());
+	ASSERT(uncached->set_param("x_subdivisions", 16));
+	ASSERT(uncached->set_param("point1", Point(-3.0, 3.0)));
+	ASSERT(uncached->set_param("bones", bones));
+	ASSERT(equal(*uncached->get_mesh(), *cached->get_mesh()));
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int, char **argv)
+{
+	synfig::Main synfig_main(etl::dirname(argv[0]));
+
+	TEST_SUITE_BEGIN()
+	TEST_FUNCTION(test_changed_pose_uses_cache)
+	TEST_FUNCTION(test_changed_depth_sorts_triangles)
+	TEST_FUNCTION(test_changed_rest_bones_rebuild_cache)
+	TEST_FUNCTION(test_changed_grid_rebuilds_cache)
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -23,6 +23,8 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <cstdint>
+
 #include <synfig/surface_etl.h>
 
 #include "test_base.h"
@@ -314,6 +316,38 @@ void test_surface_copy_assignment_operator_does_not_share_data_with_non_deletabl
 	ASSERT_EQUAL(  5, my_surface2[2][2]);
 }
 
+void test_surface_copy_assignment_operator_keeps_non_compact_pitch()
+{
+	std::vector<int> data(40);
+	surface<int> my_surface(data.data(), 3, 4, 10*sizeof(int), false);
+	my_surface.fill(5);
+	surface<int> my_surface2;
+	my_surface2 = my_surface;
+	ASSERT_EQUAL(10*int(sizeof(int)), my_surface2.get_pitch());
+	ASSERT_EQUAL(5, my_surface2[3][2]);
+}
+
+void test_surface_data_is_aligned()
+{
+	surface<float> my_surface(3, 5);
+	ASSERT_EQUAL(0, int(uintptr_t(&my_surface[0][0]) % SurfacePool::alignment));
+	my_surface.set_wh(7, 11);
+	ASSERT_EQUAL(0, int(uintptr_t(&my_surface[0][0]) % SurfacePool::alignment));
+}
+
+void test_freed_surface_data_is_reused()
+{
+	float *data;
+	{
+		surface<float> my_surface(100, 100);
+		data = &my_surface[0][0];
+	}
+	SurfacePool::Statistics stats = SurfacePool::instance().get_statistics();
+	surface<float> my_surface(100, 100);
+	ASSERT(&my_surface[0][0] == data);
+	ASSERT_EQUAL(stats.reuses + 1, SurfacePool::instance().get_statistics().reuses);
+}
+
 void test_fill_all_surface_with_same_data()
 {
 	surface<int> my_surface(30, 3);
@@ -824,6 +858,10 @@ int main()
 		TEST_FUNCTION(test_surface_copy_assignment_operator_from_non_deletable_surface)
 		TEST_FUNCTION(test_surface_copy_assignment_operator_does_not_share_data_with_deletable_data)
 		TEST_FUNCTION(test_surface_copy_assignment_operator_does_not_share_data_with_non_deletable_data)
+		TEST_FUNCTION(test_surface_copy_assignment_operator_keeps_non_compact_pitch)
+
+		TEST_FUNCTION(test_surface_data_is_aligned)
+		TEST_FUNCTION(test_freed_surface_data_is_reused)
 
 		TEST_FUNCTION(test_fill_all_surface_with_same_data);
 		TEST_FUNCTION(test_fill_surface_rectangle_with_same_data);
@@ -0,0 +1,158 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file valuenode_animated.cpp
+**	\brief Test ValueNode_Animated evaluation
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <synfig/general.h>
+#include <synfig/real.h>
+#include <synfig/string.h>
+#include <synfig/type.h>
+#include <synfig/value.h>
+#include <synfig/valuenodes/valuenode_animated.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+static const int waypoint_count = 200;
+static const int time_count = 2000;
+
+static Time
+time_at(int i)
+	{ return Time(Real(i)*waypoint_count/time_count - 0.5); }
+
+static std::vector<int>
+make_order()
+{
+	// forward, backward and pseudo-random evaluation
+	std::vector<int> order;
+	for(int i = 0; i < time_count; ++i)
+		order.push_back(i);
+	for(int i = time_count - 1; i >= 0; --i)
+		order.push_back(i);
+	unsigned int seed = 1;
+	for(int i = 0; i < time_count; ++i) {
+		seed = seed*1103515245 + 12345;
+		order.push_back((seed >> 8) % time_count);
+	}
+	return order;
+}
+
+void test_real_evaluation_does_not_depend_on_order()
+{
+	ValueNode_Animated::Handle node = ValueNode_Animated::create(type_real);
+	for(int i = 0; i < waypoint_count; ++i)
+		node->new_waypoint(Time(i), ValueBase(Real(i % 7) - 3.0));
+
+	std::vector<Real> values(time_count);
+	for(int i = 0; i < time_count; ++i)
+		values[i] = (*node)(time_at(i)).get(Real());
+
+	for(int i : make_order())
+		ASSERT_EQUAL(values[i], (*node)(time_at(i)).get(Real()));
+
+	for(int i = 0; i < waypoint_count; ++i)
+		ASSERT_APPROX_EQUAL(Real(i % 7) - 3.0, (*node)(Time(i)).get(Real()));
+}
+
+void test_string_evaluation_is_constant_between_waypoints()
+{
+	ValueNode_Animated::Handle node = ValueNode_Animated::create(type_string);
+	for(int i = 0; i < waypoint_count; ++i)
+		node->new_waypoint(Time(i), ValueBase(strprintf("%d", i)));
+
+	for(int i : make_order()) {
+		Time t = time_at(i);
+		int expected = std::max(0, std::min(waypoint_count - 1, int(std::floor(Real(t)))));
+		ASSERT_EQUAL(strprintf("%d", expected), (*node)(t).get(String()));
+	}
+}
+
+void test_bool_evaluation_is_constant_between_waypoints()
+{
+	ValueNode_Animated::Handle node = ValueNode_Animated::create(type_bool);
+	for(int i = 0; i < waypoint_count; ++i)
+		node->new_waypoint(Time(i), ValueBase(i % 3 == 0));
+
+	for(int i : make_order()) {
+		Time t = time_at(i);
+		int expected = std::max(0, std::min(waypoint_count - 1, int(std::floor(Real(t)))));
+		ASSERT_EQUAL(expected % 3 == 0, (*node)(t).get(bool()));
+	}
+}
+
+void test_cached_value_is_reused_inside_scope()
+{
+	ValueNode_Animated::Handle node = ValueNode_Animated::create(type_real);
+	node->new_waypoint(Time(0), ValueBase(Real(0)));
+	node->new_waypoint(Time(1), ValueBase(Real(1)));
+
+	ValueNode::Cache::set_enabled(true);
+	ValueNode::Cache::reset_counters();
+
+	// no scope, no cache
+	ASSERT_APPROX_EQUAL(0.5, node->get_value_cached(Time(0.5)).get(Real()));
+	ASSERT_EQUAL(0, ValueNode::Cache::get_hits() + ValueNode::Cache::get_misses());
+
+	{
+		ValueNode::Cache::Scope scope;
+		ASSERT_APPROX_EQUAL(0.5, node->get_value_cached(Time(0.5)).get(Real()));
+		ASSERT_APPROX_EQUAL(0.5, node->get_value_cached(Time(0.5)).get(Real()));
+		ASSERT_EQUAL(1, ValueNode::Cache::get_hits());
+		ASSERT_EQUAL(1, ValueNode::Cache::get_misses());
+
+		// changed node drops the cached value
+		node->new_waypoint(Time(0.5), ValueBase(Real(2)));
+		ASSERT_APPROX_EQUAL(2.0, node->get_value_cached(Time(0.5)).get(Real()));
+		ASSERT_EQUAL(1, ValueNode::Cache::get_hits());
+		ASSERT_EQUAL(2, ValueNode::Cache::get_misses());
+	}
+
+	{
+		// values are not reused by the next frame
+		ValueNode::Cache::Scope scope;
+		node->get_value_cached(Time(0.5));
+		ASSERT_EQUAL(3, ValueNode::Cache::get_misses());
+	}
+
+	ValueNode::Cache::set_enabled(false);
+}
+
+int main() {
+	Type::subsys_init();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_real_evaluation_does_not_depend_on_order)
+		TEST_FUNCTION(test_string_evaluation_is_constant_between_waypoints)
+		TEST_FUNCTION(test_bool_evaluation_is_constant_between_waypoints)
+		TEST_FUNCTION(test_cached_value_is_reused_inside_scope)
+	TEST_SUITE_END()
+
+	Type::subsys_stop();
+
+	return tst_exit_status;
+}
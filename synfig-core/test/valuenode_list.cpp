@@ -0,0 +1,145 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file valuenode_list.cpp
+**	\brief Test ValueNodeList lookup by id
+**
+**	\legal
+**	Copyright (c) 2023 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#include <thread>
+#include <vector>
+
+#include <synfig/exception.h>
+#include <synfig/general.h>
+#include <synfig/real.h>
+#include <synfig/string.h>
+#include <synfig/string_helper.h>
+#include <synfig/type.h>
+#include <synfig/value.h>
+#include <synfig/valuenode.h>
+#include <synfig/valuenodes/valuenode_const.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+static const int node_count = 1000;
+
+static String
+id_of(int i)
+	{ return strprintf("node%d", i); }
+
+static ValueNode::Handle
+create_node(const String &id)
+{
+	ValueNode::Handle node = ValueNode_Const::create(Real(1));
+	node->set_id(id);
+	return node;
+}
+
+void test_find_returns_added_nodes() {
+	ValueNodeList list;
+	std::vector<ValueNode::Handle> nodes;
+	for(int i = 0; i < node_count; ++i) {
+		nodes.push_back(create_node(id_of(i)));
+		ASSERT(list.add(nodes.back()));
+	}
+
+	ASSERT_FALSE(list.add(create_node(id_of(0))));
+	for(int i = 0; i < node_count; ++i) {
+		ASSERT(list.find(id_of(i), true) == nodes[i]);
+		ASSERT(list.count(id_of(i)));
+	}
+	ASSERT_FALSE(list.count(id_of(node_count)));
+	ASSERT_EXCEPTION_THROWN(Exception::IDNotFound, list.find(id_of(node_count), true));
+}
+
+void test_find_follows_renamed_and_erased_nodes() {
+	ValueNodeList list;
+	std::vector<ValueNode::Handle> nodes;
+	for(int i = 0; i < 10; ++i) {
+		nodes.push_back(create_node(id_of(i)));
+		list.add(nodes.back());
+	}
+	list.find(id_of(0), true);
+
+	nodes[3]->set_id("renamed");
+	ASSERT(list.find("renamed", true) == nodes[3]);
+	ASSERT_FALSE(list.count(id_of(3)));
+
+	ASSERT(list.erase(nodes[5]));
+	ASSERT_FALSE(list.count(id_of(5)));
+	ASSERT_FALSE(list.erase(nodes[5]));
+	ASSERT(list.find(id_of(6), true) == nodes[6]);
+
+	ValueNode::Handle node = create_node(id_of(5));
+	ASSERT(list.add(node));
+	ASSERT(list.find(id_of(5), true) == node);
+}
+
+void test_placeholder_is_replaced_by_added_node() {
+	ValueNodeList list;
+	ValueNode::Handle placeholder = list.surefind("later");
+	ASSERT_EQUAL(1, list.placeholder_count());
+	ASSERT(list.surefind("later") == placeholder);
+
+	ValueNode::Handle node = create_node("later");
+	ASSERT(list.add(node));
+	ASSERT_EQUAL(0, list.placeholder_count());
+	ASSERT(list.find("later", true) == node);
+}
+
+void test_concurrent_const_lookups() {
+	// nodes are pushed without index, so the first lookups of every thread rebuild it
+	ValueNodeList list;
+	for(int i = 0; i < node_count; ++i)
+		list.push_back(create_node(id_of(i)));
+	const ValueNodeList &const_list = list;
+
+	const int thread_count = 4;
+	std::vector<int> found(thread_count, 0);
+	std::vector<std::thread> threads;
+	for(int t = 0; t < thread_count; ++t)
+		threads.push_back(std::thread([&const_list, &found, t]() {
+			for(int i = 0; i < node_count; ++i)
+				if (const_list.count(id_of(i)) && const_list.find(id_of(i), true)->get_id() == id_of(i))
+					++found[t];
+		}));
+	for(std::thread &thread : threads)
+		thread.join();
+
+	for(int t = 0; t < thread_count; ++t)
+		ASSERT_EQUAL(node_count, found[t]);
+}
+
+int main() {
+	Type::subsys_init();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_find_returns_added_nodes)
+		TEST_FUNCTION(test_find_follows_renamed_and_erased_nodes)
+		TEST_FUNCTION(test_placeholder_is_replaced_by_added_node)
+		TEST_FUNCTION(test_concurrent_const_lookups)
+	TEST_SUITE_END()
+
+	Type::subsys_stop();
+
+	return tst_exit_status;
+}
@@ -102,6 +102,7 @@ public:
 		set_quality(warm_target->get_quality());
 		set_alpha_mode(warm_target->get_alpha_mode());
 		set_threads(warm_target->get_threads());
+		set_max_tiles_memory(warm_target->get_max_tiles_memory());
 		set_clipping(warm_target->get_clipping());
 		set_rend_desc(&warm_target->rend_desc());
 		set_engine(warm_target->get_engine());
@@ -122,8 +123,7 @@ public:
 	}
 
 	virtual bool async_render_tile(
-		Canvas::Handle canvas,
-		ContextParams context_params,
+		rendering::Task::Handle frame_task,
 		RectInt rect,
 		RendDesc tile_desc,
 		ProgressCallback */*cb*/ )
@@ -135,7 +135,7 @@ public:
 			sigc::hide_return(
 				sigc::bind(
 					sigc::mem_fun(*this, &AsyncTarget_Tile::sync_render_tile),
-					canvas, context_params, rect, tile_desc, (synfig::ProgressCallback*)nullptr )),
+					frame_task, rect, tile_desc, (synfig::ProgressCallback*)nullptr )),
 				true
 			);
 		assert(thread);
@@ -149,24 +149,22 @@ public:
 	}
 
 	bool sync_render_tile(
-		Canvas::Handle canvas,
-		ContextParams context_params,
+		rendering::Task::Handle frame_task,
 		RectInt rect,
 		RendDesc tile_desc,
 		ProgressCallback *cb )
 	{
 		if(!alive_flag)
 			return false;
-		bool r = warm_target->async_render_tile(canvas, context_params, rect, tile_desc, cb);
+		bool r = warm_target->async_render_tile(frame_task, rect, tile_desc, cb);
 		if (!r) { Glib::Mutex::Lock lock(mutex); err = true; }
 		return r;
 	}
 
 	virtual bool wait_render_tiles(ProgressCallback* cb = nullptr)
 	{
-		if(!alive_flag)
-			return false;
-
+		// threads and tiles in flight refer to both targets,
+		// so they should be finished even if rendering is already stopped
 		while(true)
 		{
 			Glib::Thread *thread;
@@ -180,8 +178,9 @@ public:
 			thread->join();
 		}
 
-		{ Glib::Mutex::Lock lock(mutex); if (err) return false; }
-		return warm_target->wait_render_tiles(cb);
+		bool success = warm_target->wait_render_tiles(alive_flag ? cb : nullptr);
+		Glib::Mutex::Lock lock(mutex);
+		return success && !err && alive_flag;
 	}
 
 	virtual int next_tile(RectInt& rect)
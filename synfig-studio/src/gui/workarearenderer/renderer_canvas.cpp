@@ -35,6 +35,8 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <valarray>
 
@@ -456,6 +458,35 @@ Renderer_Canvas::build_onion_frames()
 		visible_frames.insert(i->id);
 }
 
+int
+Renderer_Canvas::calc_frame_priority(const FrameId &id) const
+{
+	// mutex must be already locked
+
+	if (id == current_frame)
+		return 0;
+	if (visible_frames.count(id))
+		return -1;
+	if (id == current_thumb)
+		return -2;
+
+	Real frames = frame_duration > 0 ? std::fabs((Real)(id.time - current_frame.time)/(Real)frame_duration) : 0.0;
+	return -3 - (int)std::min(frames, 1000000.0);
+}
+
+void
+Renderer_Canvas::update_tile_priorities()
+{
+	// mutex must be already locked
+
+	for(TileMap::const_iterator i = tiles.begin(); i != tiles.end(); ++i) {
+		int priority = calc_frame_priority(i->first);
+		for(TileList::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+			if (*j && (*j)->event && !(*j)->event->is_finished())
+				rendering::Renderer::set_priority((*j)->event, priority);
+	}
+}
+
 bool
 Renderer_Canvas::enqueue_render_frame(
 	const rendering::Renderer::Handle &renderer,
@@ -559,6 +590,7 @@ Renderer_Canvas::enqueue_render_frame(
 		tile->surface = tile_task->target_surface;
 
 		tile->event = new rendering::TaskEvent();
+		tile->event->set_priority(calc_frame_priority(id));
 		tile->event->signal_finished.connect( sigc::bind(
 			sigc::ptr_fun(&on_tile_finished_callback), this, tile ));
 
@@ -595,6 +627,7 @@ Renderer_Canvas::enqueue_render()
 		bool			is_bounded = time_model->get_play_bounds_enabled();
 
 		build_onion_frames();
+		update_tile_priorities();
 
 		rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(renderer_name);
 		
@@ -207,6 +207,15 @@ private:
 	//! mutex must be locked before call
 	FrameStatus calc_frame_status(const FrameId &id, const synfig::RectInt &window_rect);
 
+	//! mutex must be locked before call
+	//! frame under the time cursor is rendered first, then other visible frames,
+	//! and then frames nearest to the time cursor
+	int calc_frame_priority(const FrameId &id) const;
+
+	//! mutex must be locked before call
+	//! time cursor may be moved, so enqueued tiles are reordered
+	void update_tile_priorities();
+
 	//! mutex must be locked before call
 	//! returns true if rendering task actually enqueued
 	//! function can change the canvas time